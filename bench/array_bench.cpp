@@ -0,0 +1,134 @@
+#include "simd_kernels.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+// Small enough to stay in L2, so the kernels rather than memory set the pace
+constexpr int64_t kElements = 1 << 16;
+
+std::vector<int64_t> randomInts(size_t count) {
+    std::mt19937_64 random(42);
+    std::vector<int64_t> values(count);
+    for (auto& value : values) {
+        value = static_cast<int64_t>(random() % 2000001) - 1000000;
+    }
+    return values;
+}
+
+std::vector<double> randomDoubles(size_t count) {
+    std::mt19937_64 random(43);
+    std::uniform_real_distribution<double> distribution(-1000.0, 1000.0);
+    std::vector<double> values(count);
+    for (auto& value : values) {
+        value = distribution(random);
+    }
+    return values;
+}
+
+// The argument selects the kernels: 1 vectorized, 0 the scalar loops
+class KernelMode {
+public:
+    explicit KernelMode(benchmark::State& state) {
+        simd::setEnabled(state.range(0) != 0);
+        if (state.range(0) && !simd::isAvailable()) {
+            state.SkipWithError("no AVX2");
+        }
+    }
+    ~KernelMode() { simd::setEnabled(true); }
+};
+
+void BM_ArraySumInt(benchmark::State& state) {
+    KernelMode mode(state);
+    auto values = randomInts(kElements);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(simd::sum(values.data(), values.size()));
+    }
+    state.SetItemsProcessed(state.iterations() * kElements);
+}
+BENCHMARK(BM_ArraySumInt)->Arg(0)->Arg(1);
+
+void BM_ArrayDotInt(benchmark::State& state) {
+    KernelMode mode(state);
+    auto left = randomInts(kElements);
+    auto right = randomInts(kElements);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(simd::dot(left.data(), right.data(), left.size()));
+    }
+    state.SetItemsProcessed(state.iterations() * kElements);
+}
+BENCHMARK(BM_ArrayDotInt)->Arg(0)->Arg(1);
+
+void BM_ArrayDotDouble(benchmark::State& state) {
+    KernelMode mode(state);
+    auto left = randomDoubles(kElements);
+    auto right = randomDoubles(kElements);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(simd::dot(left.data(), right.data(), left.size()));
+    }
+    state.SetItemsProcessed(state.iterations() * kElements);
+}
+BENCHMARK(BM_ArrayDotDouble)->Arg(0)->Arg(1);
+
+void BM_ArrayMaxInt(benchmark::State& state) {
+    KernelMode mode(state);
+    auto values = randomInts(kElements);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(simd::max(values.data(), values.size()));
+    }
+    state.SetItemsProcessed(state.iterations() * kElements);
+}
+BENCHMARK(BM_ArrayMaxInt)->Arg(0)->Arg(1);
+
+void BM_ArrayMapMultiplyInt(benchmark::State& state) {
+    KernelMode mode(state);
+    auto values = randomInts(kElements);
+    std::vector<int64_t> out(values.size());
+    for (auto _ : state) {
+        simd::map(simd::Arithmetic::Multiply, values.data(), 3, out.data(), values.size());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kElements);
+}
+BENCHMARK(BM_ArrayMapMultiplyInt)->Arg(0)->Arg(1);
+
+// Keeps about half of the elements, the worst case for branchy filters
+void BM_ArrayFilterInt(benchmark::State& state) {
+    KernelMode mode(state);
+    auto values = randomInts(kElements);
+    std::vector<int64_t> out(values.size() + 4);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(simd::filter(simd::Comparison::Greater, values.data(), 0, out.data(), values.size()));
+    }
+    state.SetItemsProcessed(state.iterations() * kElements);
+}
+BENCHMARK(BM_ArrayFilterInt)->Arg(0)->Arg(1);
+
+void BM_ArraySortInt(benchmark::State& state) {
+    auto values = randomInts(kElements);
+    std::vector<int64_t> work(values.size());
+    for (auto _ : state) {
+        work = values;
+        simd::sort(work.data(), work.size());
+    }
+    state.SetItemsProcessed(state.iterations() * kElements);
+}
+BENCHMARK(BM_ArraySortInt);
+
+// Baseline for BM_ArraySortInt
+void BM_StdSortInt(benchmark::State& state) {
+    auto values = randomInts(kElements);
+    std::vector<int64_t> work(values.size());
+    for (auto _ : state) {
+        work = values;
+        std::sort(work.begin(), work.end());
+    }
+    state.SetItemsProcessed(state.iterations() * kElements);
+}
+BENCHMARK(BM_StdSortInt);
+
+} // namespace
@@ -0,0 +1,92 @@
+#include "bench_util.h"
+#include "lexer.h"
+#include "parser.h"
+#include "output_buffer.h"
+#include "standard_library.h"
+#include "type_checker.h"
+#include "module_manager.h"
+
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace bench
+{
+    std::unique_ptr<ASTNode> parseSource(const std::string &source, bool typeCheck, bool lazy)
+    {
+        auto text = lazy ? std::make_shared<const std::string>(source) : nullptr;
+        Lexer lexer(source);
+        Parser parser(lexer, source);
+        if (lazy)
+            parser.setLazyBodies(text);
+        auto ast = parser.parse();
+        if (!typeCheck)
+            return ast;
+
+        ensureStandardModules();
+        auto checker = std::make_shared<TypeChecker>();
+        if (!checker->check(ast.get()))
+            std::cerr << "Type error: " << checker->getErrors().front() << std::endl;
+        auto &mm = ModuleManager::getInstance();
+        mm.registerProgram(ast.get());
+        if (lazy)
+        {
+            mm.setBodyLoader([checker](const std::string &module, FunctionNode &function) {
+                std::vector<Diagnostic> diagnostics;
+                if (!Parser::parseLazyBody(function, diagnostics) || !checker->checkBody(module, function))
+                    throw std::runtime_error("could not load " + module + "." + function.name);
+            });
+        }
+        return ast;
+    }
+
+    void ensureStandardModules()
+    {
+        static bool registered = false;
+        if (!registered)
+        {
+            registerStandardModules();
+            registered = true;
+        }
+    }
+
+    const FunctionNode *findFunction(const ASTNode *program, const std::string &module, const std::string &function)
+    {
+        auto root = dynamic_cast<const ModuleNode *>(program);
+        if (!root)
+            return nullptr;
+
+        for (const auto &child : root->body)
+        {
+            auto moduleNode = dynamic_cast<const ModuleNode *>(child.get());
+            if (!moduleNode || moduleNode->name != module)
+                continue;
+            for (const auto &member : moduleNode->body)
+            {
+                auto functionNode = dynamic_cast<const FunctionNode *>(member.get());
+                if (functionNode && functionNode->name == function)
+                    return functionNode;
+            }
+        }
+        return nullptr;
+    }
+
+    SilenceStdout::SilenceStdout()
+    {
+        OutputBuffer::getInstance().flush();
+        savedFd_ = dup(STDOUT_FILENO);
+        int devNull = open("/dev/null", O_WRONLY);
+        dup2(devNull, STDOUT_FILENO);
+        close(devNull);
+    }
+
+    SilenceStdout::~SilenceStdout()
+    {
+        OutputBuffer::getInstance().flush();
+        dup2(savedFd_, STDOUT_FILENO);
+        close(savedFd_);
+    }
+}
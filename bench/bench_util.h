@@ -0,0 +1,31 @@
+#pragma once
+
+#include "ast_node.h"
+
+#include <memory>
+#include <string>
+
+namespace bench
+{
+    // Lexes, parses and (unless `typeCheck` is false) type checks `source`,
+    // registering its functions with the ModuleManager. `lazy` skips function
+    // bodies until they are called, like --lazy.
+    std::unique_ptr<ASTNode> parseSource(const std::string &source, bool typeCheck = true, bool lazy = false);
+
+    // Registers the std.* builtins once per process
+    void ensureStandardModules();
+
+    // Finds `Module.function` in a parsed program
+    const FunctionNode *findFunction(const ASTNode *program, const std::string &module, const std::string &function);
+
+    // Redirects stdout to /dev/null for the lifetime of the object
+    class SilenceStdout
+    {
+    public:
+        SilenceStdout();
+        ~SilenceStdout();
+
+    private:
+        int savedFd_;
+    };
+}
@@ -0,0 +1,79 @@
+#include "channel.h"
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr size_t kMessages = 1 << 20;
+constexpr size_t kBoundedCapacity = 1024;
+
+// Moves kMessages through one channel. With one thread it sends and
+// receives in turn; otherwise half of the threads send and half receive.
+void runChannel(benchmark::State& state, size_t capacity) {
+    size_t threads = static_cast<size_t>(state.range(0));
+    const Value message("42");
+    for (auto _ : state) {
+        Channel channel(capacity);
+        std::atomic<size_t> received{0};
+        if (threads == 1) {
+            Value value;
+            for (size_t i = 0; i < kMessages; i++) {
+                channel.trySend(value = message);
+                channel.tryReceive(value);
+                received.fetch_add(value.str().size(), std::memory_order_relaxed);
+            }
+        }
+        else {
+            size_t producers = threads / 2;
+            size_t consumers = threads - producers;
+            std::atomic<size_t> producing{producers};
+            std::vector<std::thread> workers;
+            for (size_t p = 0; p < producers; p++) {
+                workers.emplace_back([&, p] {
+                    size_t count = kMessages / producers + (p < kMessages % producers);
+                    for (size_t i = 0; i < count; i++) {
+                        channel.send(message);
+                    }
+                    if (producing.fetch_sub(1) == 1) {
+                        channel.close();
+                    }
+                });
+            }
+            for (size_t c = 0; c < consumers; c++) {
+                workers.emplace_back([&] {
+                    Value value;
+                    size_t bytes = 0;
+                    while (channel.receive(value)) {
+                        bytes += value.str().size();
+                    }
+                    received.fetch_add(bytes, std::memory_order_relaxed);
+                });
+            }
+            for (auto& worker : workers) {
+                worker.join();
+            }
+        }
+        if (received.load() != kMessages * message.str().size()) {
+            state.SkipWithError("messages were lost");
+            break;
+        }
+    }
+    // items_per_second is messages per second
+    state.SetItemsProcessed(state.iterations() * kMessages);
+}
+
+void BM_ChannelBounded(benchmark::State& state) {
+    runChannel(state, kBoundedCapacity);
+}
+BENCHMARK(BM_ChannelBounded)->Arg(1)->Arg(4)->Arg(16)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+void BM_ChannelUnbounded(benchmark::State& state) {
+    runChannel(state, 0);
+}
+BENCHMARK(BM_ChannelUnbounded)->Arg(1)->Arg(4)->Arg(16)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+}
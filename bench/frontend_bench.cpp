@@ -0,0 +1,114 @@
+#include "bench_util.h"
+#include "incremental_parser.h"
+#include "lexer.h"
+#include "module_manager.h"
+#include "workloads.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <unistd.h>
+
+namespace {
+
+void lexAll(benchmark::State& state, const std::string& source) {
+    uint64_t tokens = 0;
+    for (auto _ : state) {
+        Lexer lexer(source);
+        while (lexer.getNextToken().type != END_OF_FILE) {
+            tokens++;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * source.size());
+    state.counters["tokens/s"] = benchmark::Counter(static_cast<double>(tokens), benchmark::Counter::kIsRate);
+}
+
+// Streaming lexer reading a generated file with a fixed refill window
+void BM_LexStreamManyFunctions(benchmark::State& state) {
+    std::string source = workloads::manyFunctions(10000);
+    char path[] = "/tmp/nexis_bench_XXXXXX";
+    int tmp = mkstemp(path);
+    if (tmp < 0) {
+        state.SkipWithError("mkstemp failed");
+        return;
+    }
+    close(tmp);
+    std::ofstream(path) << source;
+
+    uint64_t tokens = 0;
+    for (auto _ : state) {
+        int fd = open(path, O_RDONLY);
+        Lexer lexer(fd, static_cast<size_t>(state.range(0)));
+        while (lexer.getNextToken().type != END_OF_FILE) {
+            tokens++;
+        }
+        close(fd);
+    }
+    std::remove(path);
+    state.SetBytesProcessed(state.iterations() * source.size());
+    state.counters["tokens/s"] = benchmark::Counter(static_cast<double>(tokens), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_LexStreamManyFunctions)->Arg(4 * 1024)->Arg(64 * 1024);
+
+void parseAll(benchmark::State& state, const std::string& source) {
+    for (auto _ : state) {
+        auto ast = bench::parseSource(source);
+        benchmark::DoNotOptimize(ast);
+    }
+    state.SetBytesProcessed(state.iterations() * source.size());
+}
+
+void BM_LexManyFunctions(benchmark::State& state) {
+    lexAll(state, workloads::manyFunctions(static_cast<int>(state.range(0))));
+}
+BENCHMARK(BM_LexManyFunctions)->Arg(100)->Arg(1000)->Arg(10000);
+
+void BM_LexConcatChain(benchmark::State& state) {
+    lexAll(state, workloads::concatChain(static_cast<int>(state.range(0))));
+}
+BENCHMARK(BM_LexConcatChain)->Arg(1000);
+
+void BM_ParseManyFunctions(benchmark::State& state) {
+    parseAll(state, workloads::manyFunctions(static_cast<int>(state.range(0))));
+}
+BENCHMARK(BM_ParseManyFunctions)->Arg(100)->Arg(1000)->Arg(10000);
+
+// Parse, check and run a program that calls one of its functions; with
+// lazy bodies (second argument 1) only that function's body is parsed
+void BM_StartupManyFunctions(benchmark::State& state) {
+    std::string source = workloads::manyFunctions(static_cast<int>(state.range(0)));
+    bool lazy = state.range(1) != 0;
+    for (auto _ : state) {
+        auto ast = bench::parseSource(source, true, lazy);
+        benchmark::DoNotOptimize(ModuleManager::getInstance().callFunction("Main.main", {}));
+    }
+    state.SetBytesProcessed(state.iterations() * source.size());
+}
+BENCHMARK(BM_StartupManyFunctions)->ArgsProduct({{1000, 10000}, {0, 1}})->Unit(benchmark::kMillisecond);
+
+// One keystroke inside a function body of a large document, then undo it;
+// compare with BM_ParseManyFunctions for the cost of a full reparse
+void BM_IncrementalEditManyFunctions(benchmark::State& state) {
+    int functions = static_cast<int>(state.range(0));
+    IncrementalDocument document(workloads::manyFunctions(functions));
+    std::string marker = "func f" + std::to_string(functions / 2) + "(";
+    size_t offset = document.getText().find("return", document.getText().find(marker));
+
+    for (auto _ : state) {
+        document.applyEdit({offset, 0, " "});
+        document.applyEdit({offset, 1, ""});
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+    state.counters["full_reparses"] = static_cast<double>(document.getStats().fullReparses);
+}
+BENCHMARK(BM_IncrementalEditManyFunctions)->Arg(100)->Arg(1000)->Arg(10000);
+
+void BM_ParseMathCalls(benchmark::State& state) {
+    bench::ensureStandardModules();
+    parseAll(state, workloads::mathCalls(static_cast<int>(state.range(0))));
+}
+BENCHMARK(BM_ParseMathCalls)->Arg(1000);
+
+} // namespace
@@ -0,0 +1,187 @@
+#include "mapped_file.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr size_t kFileBytes = 64 << 20;
+
+// Log-like lines of 30 to 130 bytes, the same on every run
+const std::vector<std::string>& logLines() {
+    static const std::vector<std::string> lines = [] {
+        std::vector<std::string> result;
+        std::mt19937_64 random(42);
+        size_t bytes = 0;
+        while (bytes < kFileBytes) {
+            std::string line = "2026-10-18T12:00:" + std::to_string(random() % 60) + " INFO request " +
+                               std::to_string(random() % 1000000) + " took " + std::to_string(random() % 500) + "ms";
+            line.append(random() % 100, 'x');
+            line += '\n';
+            bytes += line.size();
+            result.push_back(std::move(line));
+        }
+        return result;
+    }();
+    return lines;
+}
+
+// A temporary file holding logLines(). The static LogFile is destroyed at
+// exit, which removes the file.
+class LogFile {
+public:
+    LogFile() {
+        char name[] = "/tmp/nexis_fs_bench_XXXXXX";
+        int fd = mkstemp(name);
+        if (fd < 0) {
+            return;
+        }
+        path_ = name;
+        for (const std::string& line : logLines()) {
+            if (write(fd, line.data(), line.size()) != static_cast<ssize_t>(line.size())) {
+                close(fd);
+                std::remove(path_.c_str());
+                path_.clear();
+                return;
+            }
+        }
+        close(fd);
+    }
+
+    ~LogFile() {
+        if (!path_.empty()) {
+            std::remove(path_.c_str());
+        }
+    }
+
+    LogFile(const LogFile&) = delete;
+    LogFile& operator=(const LogFile&) = delete;
+
+    // Empty if the file could not be written
+    const std::string& path() const { return path_; }
+
+private:
+    std::string path_;
+};
+
+const std::string& logFile() {
+    static const LogFile file;
+    return file.path();
+}
+
+size_t fileBytes() {
+    size_t bytes = 0;
+    for (const std::string& line : logLines()) {
+        bytes += line.size();
+    }
+    return bytes;
+}
+
+// std.fs: map the file and index its lines, as fs.lines does
+void BM_FsLineIndex(benchmark::State& state) {
+    if (logFile().empty()) {
+        state.SkipWithError("could not write the input file");
+        return;
+    }
+    for (auto _ : state) {
+        MappedFile file(logFile());
+        if (file.lineCount() != logLines().size()) {
+            state.SkipWithError("wrong line count");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * fileBytes());
+}
+BENCHMARK(BM_FsLineIndex)->Unit(benchmark::kMillisecond);
+
+// What `wc -l` does: read(2) into a buffer and count the newlines
+void BM_FsWcBaseline(benchmark::State& state) {
+    if (logFile().empty()) {
+        state.SkipWithError("could not write the input file");
+        return;
+    }
+    std::vector<char> buffer(128 * 1024);
+    for (auto _ : state) {
+        int fd = open(logFile().c_str(), O_RDONLY);
+        size_t lines = 0;
+        ssize_t count;
+        while ((count = read(fd, buffer.data(), buffer.size())) > 0) {
+            const char* end = buffer.data() + count;
+            for (const char* next = buffer.data();
+                 (next = static_cast<const char*>(std::memchr(next, '\n', static_cast<size_t>(end - next))));
+                 next++) {
+                lines++;
+            }
+        }
+        close(fd);
+        if (lines != logLines().size()) {
+            state.SkipWithError("wrong line count");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * fileBytes());
+}
+BENCHMARK(BM_FsWcBaseline)->Unit(benchmark::kMillisecond);
+
+// fs.read_all: one copy out of the mapping
+void BM_FsReadAll(benchmark::State& state) {
+    if (logFile().empty()) {
+        state.SkipWithError("could not write the input file");
+        return;
+    }
+    for (auto _ : state) {
+        MappedFile file(logFile());
+        std::string contents(file.contents());
+        benchmark::DoNotOptimize(contents.data());
+    }
+    state.SetBytesProcessed(state.iterations() * fileBytes());
+}
+BENCHMARK(BM_FsReadAll)->Unit(benchmark::kMillisecond);
+
+// fs.write_line for every line, through the 64 KiB buffer (range 1) or
+// with one write(2) per line (range 0)
+void BM_FsWriteLines(benchmark::State& state) {
+    bool buffered = state.range(0) != 0;
+    char name[] = "/tmp/nexis_fs_bench_out_XXXXXX";
+    int fd = mkstemp(name);
+    if (fd < 0) {
+        state.SkipWithError("could not create the output file");
+        return;
+    }
+    close(fd);
+    // A quarter of the input keeps the unbuffered runs short
+    const auto& lines = logLines();
+    size_t count = lines.size() / 4;
+    size_t bytes = 0;
+    for (size_t i = 0; i < count; i++) {
+        bytes += lines[i].size();
+    }
+    for (auto _ : state) {
+        if (buffered) {
+            FileWriter writer(name, false);
+            for (size_t i = 0; i < count; i++) {
+                writer.write(lines[i]);
+            }
+            writer.close();
+        }
+        else {
+            fd = open(name, O_WRONLY | O_TRUNC);
+            for (size_t i = 0; i < count; i++) {
+                benchmark::DoNotOptimize(write(fd, lines[i].data(), lines[i].size()));
+            }
+            close(fd);
+        }
+    }
+    std::remove(name);
+    state.SetBytesProcessed(state.iterations() * bytes);
+}
+BENCHMARK(BM_FsWriteLines)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+}
@@ -0,0 +1,112 @@
+#include "bench_util.h"
+#include "heap.h"
+#include "module_manager.h"
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Churn.loop allocates two 1000-element arrays and a map per step, about
+// 16 KB, and keeps only the last array in `keep`; Churn.window keeps the
+// last 2000 maps alive, so survivors reach the old generation and major
+// collections free them again.
+constexpr const char* kChurnSource = R"(
+module Churn {
+    import std.array;
+    import std.map;
+
+    func loop(n: int, keep: string, total: int) -> int {
+        if (n == 0) {
+            return total;
+        } else {
+            let a: string = array.range(0, 1000);
+            let b: string = array.map(a, "*", 2);
+            let m: string = map.new();
+            map.set(m, "x", b);
+            map.set(keep, "last", a);
+            return Churn.loop(n - 1, keep, total + array.length(map.get(m, "x")));
+        }
+    }
+
+    func run(n: int) -> int {
+        return Churn.loop(n, map.new(), 0);
+    }
+
+    func fill(keep: string, n: int, total: int) -> int {
+        if (n == 0) {
+            return total;
+        } else {
+            let inner: string = map.new();
+            map.set(inner, "a", array.range(0, 1000));
+            let old: int = n + 2000;
+            map.set(keep, n, inner);
+            map.remove(keep, old);
+            return Churn.fill(keep, n - 1, total + array.length(map.get(inner, "a")));
+        }
+    }
+
+    func window(n: int) -> int {
+        return Churn.fill(map.new(), n, 0);
+    }
+}
+)";
+
+std::unique_ptr<ASTNode> literal(const std::string& value) {
+    auto node = std::make_unique<LiteralNode>();
+    node->value = value;
+    node->type = "value";
+    return node;
+}
+
+// Runs `function` with state.range(0) steps and reports what the collector
+// did per iteration: collections, pause times and the bytes it freed
+void runChurn(benchmark::State& state, const std::string& function) {
+    bench::ensureStandardModules();
+    static auto program = bench::parseSource(kChurnSource);
+    auto& mm = ModuleManager::getInstance();
+    auto& heap = Heap::getInstance();
+
+    std::vector<std::unique_ptr<ASTNode>> args;
+    args.push_back(literal(std::to_string(state.range(0))));
+    const std::string expected = std::to_string(state.range(0) * 1000);
+
+    const Heap::Stats before = heap.stats();
+    for (auto _ : state) {
+        if (mm.callFunction(function, args) != expected) {
+            state.SkipWithError("wrong result");
+            break;
+        }
+    }
+    const Heap::Stats& after = heap.stats();
+    double iterations = static_cast<double>(state.iterations());
+    auto perIteration = [&](uint64_t total) { return benchmark::Counter(static_cast<double>(total) / iterations); };
+    state.counters["minor"] = perIteration(after.minorCollections - before.minorCollections);
+    state.counters["major"] = perIteration(after.majorCollections - before.majorCollections);
+    state.counters["pause_ms"] =
+        benchmark::Counter(std::chrono::duration<double, std::milli>(after.totalPause - before.totalPause).count() /
+                           iterations);
+    state.counters["max_pause_ms"] = std::chrono::duration<double, std::milli>(after.maxPause).count();
+    state.counters["collected/s"] = benchmark::Counter(static_cast<double>(after.collectedBytes - before.collectedBytes),
+                                                       benchmark::Counter::kIsRate, benchmark::Counter::kIs1024);
+    state.counters["promoted_MB"] = perIteration((after.promotedBytes - before.promotedBytes) >> 20);
+    // items_per_second is interpreter steps per second
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// About 3 GB of short-lived arrays and maps at 200000 steps
+void BM_HeapChurn(benchmark::State& state) {
+    runChurn(state, "Churn.run");
+}
+BENCHMARK(BM_HeapChurn)->Arg(200000)->Unit(benchmark::kMillisecond);
+
+// Objects that survive minor collections and die old
+void BM_HeapWindow(benchmark::State& state) {
+    runChurn(state, "Churn.window");
+}
+BENCHMARK(BM_HeapWindow)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+}
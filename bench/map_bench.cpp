@@ -0,0 +1,102 @@
+#include "string_map.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+constexpr size_t kKeys = 1 << 20;
+
+// Distinct keys in random order, so neither table sees them sorted
+const std::vector<std::string>& keys() {
+    static const std::vector<std::string> keys = [] {
+        std::vector<std::string> result;
+        result.reserve(kKeys);
+        for (size_t i = 0; i < kKeys; i++) {
+            result.push_back("key" + std::to_string(i * 2654435761u % 1000000007u));
+        }
+        std::shuffle(result.begin(), result.end(), std::mt19937_64(42));
+        return result;
+    }();
+    return keys;
+}
+
+// Keys from keys() in another order, so lookups do not follow insertion
+const std::vector<std::string>& lookupKeys() {
+    static const std::vector<std::string> lookups = [] {
+        std::vector<std::string> result = keys();
+        std::shuffle(result.begin(), result.end(), std::mt19937_64(43));
+        return result;
+    }();
+    return lookups;
+}
+
+void BM_StringMapInsert(benchmark::State& state) {
+    const auto& input = keys();
+    for (auto _ : state) {
+        StringMap map;
+        for (const auto& key : input) {
+            map[key].number = 1;
+        }
+        benchmark::DoNotOptimize(map.size());
+    }
+    state.SetItemsProcessed(state.iterations() * kKeys);
+}
+BENCHMARK(BM_StringMapInsert)->Unit(benchmark::kMillisecond);
+
+// Baseline for BM_StringMapInsert
+void BM_UnorderedMapInsert(benchmark::State& state) {
+    const auto& input = keys();
+    for (auto _ : state) {
+        std::unordered_map<std::string, MapValue> map;
+        for (const auto& key : input) {
+            map[key].number = 1;
+        }
+        benchmark::DoNotOptimize(map.size());
+    }
+    state.SetItemsProcessed(state.iterations() * kKeys);
+}
+BENCHMARK(BM_UnorderedMapInsert)->Unit(benchmark::kMillisecond);
+
+// Half of the lookups miss
+void BM_StringMapLookup(benchmark::State& state) {
+    StringMap map;
+    for (size_t i = 0; i < kKeys; i += 2) {
+        map[keys()[i]].number = 1;
+    }
+    const auto& lookups = lookupKeys();
+    for (auto _ : state) {
+        size_t found = 0;
+        for (const auto& key : lookups) {
+            found += map.find(key) != nullptr;
+        }
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetItemsProcessed(state.iterations() * kKeys);
+}
+BENCHMARK(BM_StringMapLookup)->Unit(benchmark::kMillisecond);
+
+// Baseline for BM_StringMapLookup
+void BM_UnorderedMapLookup(benchmark::State& state) {
+    std::unordered_map<std::string, MapValue> map;
+    for (size_t i = 0; i < kKeys; i += 2) {
+        map[keys()[i]].number = 1;
+    }
+    const auto& lookups = lookupKeys();
+    for (auto _ : state) {
+        size_t found = 0;
+        for (const auto& key : lookups) {
+            found += map.find(key) != map.end();
+        }
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetItemsProcessed(state.iterations() * kKeys);
+}
+BENCHMARK(BM_UnorderedMapLookup)->Unit(benchmark::kMillisecond);
+
+} // namespace
@@ -0,0 +1,57 @@
+#include "big_integer.h"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+namespace {
+
+// A `digits`-long decimal number with a varied digit pattern
+std::string decimal(int digits, int seed) {
+    std::string text;
+    for (int i = 0; i < digits; i++) {
+        text += static_cast<char>('1' + (i * 7 + seed) % 9);
+    }
+    return text;
+}
+
+// std.math.add on operands of `digits` digits: up to 18 stays on the int64
+// fast path, beyond that it is promoted to BigInteger
+void BM_MathAdd(benchmark::State& state) {
+    std::string left = decimal(static_cast<int>(state.range(0)), 1);
+    std::string right = decimal(static_cast<int>(state.range(0)), 2);
+    std::string result;
+    for (auto _ : state) {
+        computeInteger(IntegerOperation::Add, left, right, result);
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MathAdd)->Arg(9)->Arg(18)->Arg(40)->Arg(1000);
+
+// std.math.multiply including the decimal conversions
+void BM_MathMultiply(benchmark::State& state) {
+    std::string left = decimal(static_cast<int>(state.range(0)), 3);
+    std::string right = decimal(static_cast<int>(state.range(0)), 4);
+    std::string result;
+    for (auto _ : state) {
+        computeInteger(IntegerOperation::Multiply, left, right, result);
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MathMultiply)->Arg(9)->Arg(40)->Arg(1000);
+
+// BigInteger products alone, in digits; operands of 32 limbs (~300 digits)
+// and more use Karatsuba
+void BM_BigIntegerMultiply(benchmark::State& state) {
+    BigInteger left, right;
+    BigInteger::parse(decimal(static_cast<int>(state.range(0)), 5), left);
+    BigInteger::parse(decimal(static_cast<int>(state.range(0)), 6), right);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(left * right);
+    }
+}
+BENCHMARK(BM_BigIntegerMultiply)->RangeMultiplier(4)->Range(64, 16384);
+
+} // namespace
@@ -0,0 +1,155 @@
+#include "bench_util.h"
+#include "c_emitter.h"
+#include "module_manager.h"
+#include "native_build.h"
+#include "workloads.h"
+
+#include "../runtime/nexis_runtime.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <dlfcn.h>
+#include <fstream>
+#include <sstream>
+#include <string_view>
+#include <unistd.h>
+
+namespace {
+
+// A workload lowered with CEmitter and built as a shared object, so the
+// native code runs in-process just like the interpreter does
+class NativeProgram {
+public:
+    explicit NativeProgram(const ASTNode* program) {
+        CEmitter emitter;
+        std::ostringstream code;
+        if (!emitter.emit(program, code)) {
+            error_ = "emit failed: " + emitter.getErrors().front();
+            return;
+        }
+
+        char directory[] = "/tmp/nexis-bench-XXXXXX";
+        if (!mkdtemp(directory)) {
+            error_ = "could not create a temporary directory";
+            return;
+        }
+        directory_ = directory;
+        std::ofstream(directory_ + "/program.c") << code.str();
+        if (!compileNative(directory_ + "/program.c", directory_ + "/program.so",
+                           {"-shared", "-fPIC", "-DNEXIS_NO_MAIN"})) {
+            error_ = "C compiler failed";
+            return;
+        }
+
+        handle_ = dlopen((directory_ + "/program.so").c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (!handle_) {
+            error_ = dlerror();
+            return;
+        }
+        main_ = reinterpret_cast<nx_string (*)()>(dlsym(handle_, "nexis_main"));
+        reset_ = reinterpret_cast<void (*)()>(dlsym(handle_, "nx_runtime_reset"));
+        if (!main_ || !reset_) {
+            error_ = "missing nexis_main";
+        }
+    }
+
+    ~NativeProgram() {
+        if (handle_) {
+            dlclose(handle_);
+        }
+        if (!directory_.empty()) {
+            std::remove((directory_ + "/program.c").c_str());
+            std::remove((directory_ + "/program.so").c_str());
+            rmdir(directory_.c_str());
+        }
+    }
+
+    const std::string& error() const { return error_; }
+
+    // Runs Main.main and returns its value; the string stays valid until reset()
+    std::string_view run() {
+        nx_string result = main_();
+        return std::string_view(result.data, result.length);
+    }
+
+    // Releases every string built so far
+    void reset() { reset_(); }
+
+private:
+    std::string directory_;
+    std::string error_;
+    void* handle_ = nullptr;
+    nx_string (*main_)() = nullptr;
+    void (*reset_)() = nullptr;
+};
+
+// Each workload runs once through the interpreter and once as native code
+void interpret(benchmark::State& state, const std::string& source, int64_t itemsPerRun) {
+    bench::ensureStandardModules();
+    auto ast = bench::parseSource(source);
+    auto& mm = ModuleManager::getInstance();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(mm.callFunction("Main.main", {}));
+    }
+    state.SetItemsProcessed(state.iterations() * itemsPerRun);
+}
+
+void native(benchmark::State& state, const std::string& source, int64_t itemsPerRun) {
+    bench::ensureStandardModules();
+    auto ast = bench::parseSource(source);
+    NativeProgram program(ast.get());
+    if (!program.error().empty()) {
+        state.SkipWithError(program.error().c_str());
+        return;
+    }
+
+    // Both backends must agree before their timings mean anything
+    std::string expected = ModuleManager::getInstance().callFunction("Main.main", {});
+    if (program.run() != expected) {
+        state.SkipWithError("native result differs from the interpreter");
+        return;
+    }
+    program.reset();
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(program.run());
+        program.reset();
+    }
+    state.SetItemsProcessed(state.iterations() * itemsPerRun);
+}
+
+void BM_InterpretSumRecursion(benchmark::State& state) {
+    interpret(state, workloads::sumRecursion(static_cast<int>(state.range(0))), state.range(0));
+}
+BENCHMARK(BM_InterpretSumRecursion)->Arg(1000);
+
+void BM_NativeSumRecursion(benchmark::State& state) {
+    native(state, workloads::sumRecursion(static_cast<int>(state.range(0))), state.range(0));
+}
+BENCHMARK(BM_NativeSumRecursion)->Arg(1000);
+
+void BM_InterpretConcatChain(benchmark::State& state) {
+    interpret(state, workloads::concatChain(static_cast<int>(state.range(0))), state.range(0));
+}
+BENCHMARK(BM_InterpretConcatChain)->Arg(1000);
+
+void BM_NativeConcatChain(benchmark::State& state) {
+    native(state, workloads::concatChain(static_cast<int>(state.range(0))), state.range(0));
+}
+BENCHMARK(BM_NativeConcatChain)->Arg(1000);
+
+void BM_InterpretPrintHeavy(benchmark::State& state) {
+    bench::SilenceStdout silence;
+    interpret(state, workloads::printHeavy(static_cast<int>(state.range(0))), state.range(0));
+}
+BENCHMARK(BM_InterpretPrintHeavy)->Arg(1000);
+
+void BM_NativePrintHeavy(benchmark::State& state) {
+    bench::SilenceStdout silence;
+    native(state, workloads::printHeavy(static_cast<int>(state.range(0))), state.range(0));
+}
+BENCHMARK(BM_NativePrintHeavy)->Arg(1000);
+
+} // namespace
@@ -0,0 +1,56 @@
+#include "output_buffer.h"
+
+#include <benchmark/benchmark.h>
+
+#include <fcntl.h>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+namespace {
+
+const std::string kLine = "Sum of 10 and 5 is: 15";
+
+// Lines per second through OutputBuffer, which is what io.println uses
+void BM_OutputBufferLines(benchmark::State& state) {
+    int fd = open("/dev/null", O_WRONLY);
+    {
+        OutputBuffer out(fd, static_cast<size_t>(state.range(0)));
+        out.setMode(OutputBuffer::Mode::Full);
+        for (auto _ : state) {
+            out.writeLine(kLine);
+        }
+        out.flush();
+    }
+    close(fd);
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * (kLine.size() + 1));
+}
+BENCHMARK(BM_OutputBufferLines)->Arg(4 * 1024)->Arg(64 * 1024)->Arg(1024 * 1024);
+
+// Line-buffered mode, as used when stdout is a terminal
+void BM_OutputBufferLinesLineMode(benchmark::State& state) {
+    int fd = open("/dev/null", O_WRONLY);
+    {
+        OutputBuffer out(fd);
+        out.setMode(OutputBuffer::Mode::Line);
+        for (auto _ : state) {
+            out.writeLine(kLine);
+        }
+    }
+    close(fd);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_OutputBufferLinesLineMode);
+
+// Baseline: the previous `std::cout << ... << std::endl` pattern
+void BM_OstreamEndlLines(benchmark::State& state) {
+    std::ofstream out("/dev/null");
+    for (auto _ : state) {
+        out << kLine << std::endl;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_OstreamEndlLines);
+
+} // namespace
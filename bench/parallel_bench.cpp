@@ -0,0 +1,66 @@
+#include "bench_util.h"
+#include "module_manager.h"
+#include "thread_pool.h"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr const char* kFibSource = R"(
+module Work {
+    func fib(n: int) -> int {
+        if (n < 2) {
+            return n;
+        } else {
+            return Work.fib(n - 1) + Work.fib(n - 2);
+        }
+    }
+
+    func body(i: int, n: int) -> int {
+        return Work.fib(n);
+    }
+}
+)";
+
+constexpr int kCalls = 64;
+
+std::unique_ptr<ASTNode> literal(const std::string& value) {
+    auto node = std::make_unique<LiteralNode>();
+    node->value = value;
+    node->type = "value";
+    return node;
+}
+
+// parallel.range over kCalls independent fib(18) calls on 1 to 8 threads.
+// Each call is CPU-bound and allocates little, so the speedup shows how well
+// the interpreter's per-thread state scales.
+void BM_ParallelRange(benchmark::State& state) {
+    bench::ensureStandardModules();
+    static auto program = bench::parseSource(kFibSource);
+    auto& pool = ThreadPool::getInstance();
+    size_t savedThreads = pool.threads();
+    pool.setThreads(static_cast<size_t>(state.range(0)));
+
+    std::vector<std::unique_ptr<ASTNode>> args;
+    for (const std::string& value : {std::string("0"), std::to_string(kCalls), std::string("Work.body"),
+                                     std::string("sum"), std::string("18")}) {
+        args.push_back(literal(value));
+    }
+    const std::string expected = std::to_string(kCalls * 2584);
+    auto& mm = ModuleManager::getInstance();
+    for (auto _ : state) {
+        if (mm.callFunction("parallel.range", args) != expected) {
+            state.SkipWithError("wrong sum");
+            break;
+        }
+    }
+    pool.setThreads(savedThreads);
+    // items_per_second is fib calls per second
+    state.SetItemsProcessed(state.iterations() * kCalls);
+}
+BENCHMARK(BM_ParallelRange)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+}
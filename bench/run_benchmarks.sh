@@ -0,0 +1,16 @@
+#!/bin/bash
+# Builds nexis_bench and writes results to bench/results/<commit>.json.
+# Compare two runs with Google Benchmark's tools/compare.py.
+
+set -e
+
+cd "$(dirname "$0")/.."
+cmake -S . -B build -DCMAKE_BUILD_TYPE=Release
+cmake --build build --target nexis_bench
+
+mkdir -p bench/results
+commit=$(git rev-parse --short HEAD 2>/dev/null || echo local)
+out="bench/results/${commit}.json"
+
+./build/nexis_bench --benchmark_out="$out" --benchmark_out_format=json "$@"
+echo "Results written to $out"
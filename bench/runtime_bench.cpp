@@ -0,0 +1,181 @@
+#include "bench_util.h"
+#include "evaluator.h"
+#include "module_manager.h"
+#include "symbol_table.h"
+#include "workloads.h"
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+// Evaluator only: the concatenation chain expression of Main.build
+void BM_EvaluateConcatChain(benchmark::State& state) {
+    auto ast = bench::parseSource(workloads::concatChain(static_cast<int>(state.range(0))));
+    const FunctionNode* build = bench::findFunction(ast.get(), "Main", "build");
+    if (!build || build->body.empty()) {
+        state.SkipWithError("Main.build not found");
+        return;
+    }
+
+    auto& symbols = SymbolTable::getInstance();
+    symbols.pushScope();
+    symbols.setValue("n", "42");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(evaluateNode(build->body.front().get()));
+    }
+    symbols.popScope();
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EvaluateConcatChain)->Arg(10)->Arg(100)->Arg(1000);
+
+// Evaluator only: a long int expression, unchecked (runtime stoi on every
+// operator) and type checked (resolved int operations)
+void BM_EvaluateArithmeticChain(benchmark::State& state) {
+    auto ast = bench::parseSource(workloads::arithmeticChain(static_cast<int>(state.range(0))), state.range(1) != 0);
+    const FunctionNode* calc = bench::findFunction(ast.get(), "Main", "calc");
+    if (!calc || calc->body.empty()) {
+        state.SkipWithError("Main.calc not found");
+        return;
+    }
+
+    auto& symbols = SymbolTable::getInstance();
+    symbols.pushScope();
+    symbols.setValue("n", "3");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(evaluateNode(calc->body.front().get()));
+    }
+    symbols.popScope();
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_EvaluateArithmeticChain)->Args({1000, 0})->Args({1000, 1});
+
+// ModuleManager only: registering user-defined functions
+void BM_ModuleManagerRegister(benchmark::State& state) {
+    auto ast = bench::parseSource(workloads::manyFunctions(1));
+    const FunctionNode* function = bench::findFunction(ast.get(), "Gen0", "f0");
+    auto& mm = ModuleManager::getInstance();
+    int64_t count = state.range(0);
+    for (auto _ : state) {
+        for (int64_t i = 0; i < count; i++) {
+            mm.registerUserDefinedFunction("BenchRegister", "f" + std::to_string(i), function->parameters,
+                                           function->returnType, function->clone());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_ModuleManagerRegister)->Arg(1000);
+
+// ModuleManager only: name resolution and dispatch of a builtin call
+void BM_ModuleManagerDispatch(benchmark::State& state) {
+    bench::ensureStandardModules();
+    auto& mm = ModuleManager::getInstance();
+    std::vector<std::unique_ptr<ASTNode>> args;
+    for (const char* value : {"1", "2"}) {
+        auto literal = std::make_unique<LiteralNode>();
+        literal->value = value;
+        literal->type = "int";
+        args.push_back(std::move(literal));
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(mm.callFunction("math.add", args));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ModuleManagerDispatch);
+
+void BM_ModuleManagerHasFunction(benchmark::State& state) {
+    bench::ensureStandardModules();
+    auto& mm = ModuleManager::getInstance();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(mm.hasFunction("math.subtract"));
+    }
+}
+BENCHMARK(BM_ModuleManagerHasFunction);
+
+// End-to-end execution of Main.main for a parsed workload
+void runMain(benchmark::State& state, const std::string& source, int64_t itemsPerRun) {
+    bench::ensureStandardModules();
+    auto ast = bench::parseSource(source);
+    auto& mm = ModuleManager::getInstance();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(mm.callFunction("Main.main", {}));
+    }
+    state.SetItemsProcessed(state.iterations() * itemsPerRun);
+}
+
+void BM_ExecuteDeepRecursion(benchmark::State& state) {
+    runMain(state, workloads::deepRecursion(static_cast<int>(state.range(0))), state.range(0));
+}
+BENCHMARK(BM_ExecuteDeepRecursion)->Arg(100)->Arg(1000);
+
+// Deeper than the native stack allowed before calls got heap frames
+void BM_ExecuteNonTailRecursion(benchmark::State& state) {
+    runMain(state, workloads::nonTailRecursion(static_cast<int>(state.range(0))), state.range(0));
+}
+BENCHMARK(BM_ExecuteNonTailRecursion)->Arg(1000)->Arg(1000000)->Unit(benchmark::kMicrosecond);
+
+// Second argument is the JIT threshold; 0 keeps Main.sum interpreted
+void BM_ExecuteSumRecursion(benchmark::State& state) {
+    auto& mm = ModuleManager::getInstance();
+    uint32_t previous = mm.getJitThreshold();
+    mm.setJitThreshold(static_cast<uint32_t>(state.range(1)));
+    runMain(state, workloads::sumRecursion(static_cast<int>(state.range(0))), state.range(0));
+    mm.setJitThreshold(previous);
+}
+BENCHMARK(BM_ExecuteSumRecursion)->Args({1000, 0})->Args({1000, ModuleManager::kDefaultJitThreshold});
+
+// Same with step and time limits that are never reached, for the cost of
+// checking them
+void BM_ExecuteSumRecursionLimited(benchmark::State& state) {
+    auto& mm = ModuleManager::getInstance();
+    uint32_t previous = mm.getJitThreshold();
+    mm.setJitThreshold(static_cast<uint32_t>(state.range(1)));
+    ExecutionLimits limits;
+    limits.steps = UINT64_MAX / 2;
+    limits.time = std::chrono::hours(1);
+    mm.setLimits(limits);
+    runMain(state, workloads::sumRecursion(static_cast<int>(state.range(0))), state.range(0));
+    mm.setLimits({});
+    mm.setJitThreshold(previous);
+}
+BENCHMARK(BM_ExecuteSumRecursionLimited)->Args({1000, 0})->Args({1000, ModuleManager::kDefaultJitThreshold});
+
+// Second argument 1 sums with array.sum, 0 with a scripted math.add loop
+void BM_ExecuteArraySum(benchmark::State& state) {
+    auto& mm = ModuleManager::getInstance();
+    uint32_t previous = mm.getJitThreshold();
+    mm.setJitThreshold(0);
+    runMain(state, workloads::arraySum(static_cast<int>(state.range(0)), state.range(1) != 0), state.range(0));
+    mm.setJitThreshold(previous);
+}
+BENCHMARK(BM_ExecuteArraySum)->Args({1000, 0})->Args({1000, 1});
+
+// A 1 MB string passed down 1 or 1000 calls; the difference is the cost of
+// binding and returning it
+void BM_ExecutePassLargeString(benchmark::State& state) {
+    runMain(state, workloads::passLargeString(20, static_cast<int>(state.range(0))), state.range(0));
+}
+BENCHMARK(BM_ExecutePassLargeString)->Arg(1)->Arg(1000)->Unit(benchmark::kMicrosecond);
+
+void BM_ExecuteConcatChain(benchmark::State& state) {
+    runMain(state, workloads::concatChain(static_cast<int>(state.range(0))), state.range(0));
+}
+BENCHMARK(BM_ExecuteConcatChain)->Arg(100)->Arg(1000);
+
+void BM_ExecuteMathCalls(benchmark::State& state) {
+    runMain(state, workloads::mathCalls(static_cast<int>(state.range(0))), state.range(0) * 3);
+}
+BENCHMARK(BM_ExecuteMathCalls)->Arg(1000);
+
+void BM_ExecutePrintHeavy(benchmark::State& state) {
+    bench::SilenceStdout silence;
+    runMain(state, workloads::printHeavy(static_cast<int>(state.range(0))), state.range(0));
+}
+BENCHMARK(BM_ExecutePrintHeavy)->Arg(1000);
+
+void BM_ExecuteManyFunctions(benchmark::State& state) {
+    runMain(state, workloads::manyFunctions(static_cast<int>(state.range(0))), 1);
+}
+BENCHMARK(BM_ExecuteManyFunctions)->Arg(1000);
+
+} // namespace
@@ -0,0 +1,144 @@
+#include "bench_util.h"
+#include "module_manager.h"
+#include "simd_kernels.h"
+#include "string_map.h"
+
+#include <benchmark/benchmark.h>
+
+#include <map>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+constexpr size_t kMaxBytes = 100 << 20;
+
+// Comma-separated words of 1 to 12 letters, 100 MiB of them; smaller inputs
+// are prefixes
+const std::string& text() {
+    static const std::string text = [] {
+        std::string result;
+        result.reserve(kMaxBytes);
+        std::mt19937_64 random(42);
+        while (result.size() < kMaxBytes) {
+            size_t letters = 1 + random() % 12;
+            for (size_t i = 0; i < letters; i++) {
+                result += static_cast<char>('a' + random() % 26);
+            }
+            result += ',';
+        }
+        result.resize(kMaxBytes);
+        return result;
+    }();
+    return text;
+}
+
+std::string_view input(const benchmark::State& state) {
+    return std::string_view(text()).substr(0, static_cast<size_t>(state.range(0)));
+}
+
+// Range 0 is the input size, range 1 whether the AVX2 kernels are used
+void applySimd(const benchmark::State& state) {
+    simd::setEnabled(state.range(1) != 0);
+}
+
+void sizes(benchmark::internal::Benchmark* benchmark) {
+    for (int64_t size : {int64_t(1) << 10, int64_t(64) << 10, int64_t(1) << 20, int64_t(kMaxBytes)}) {
+        benchmark->Args({size, 0})->Args({size, 1});
+    }
+}
+
+// string.count on a single-byte needle
+void BM_StringCountByte(benchmark::State& state) {
+    applySimd(state);
+    std::string_view haystack = input(state);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(simd::countByte(haystack.data(), haystack.size(), ','));
+    }
+    simd::setEnabled(true);
+    state.SetBytesProcessed(state.iterations() * haystack.size());
+}
+BENCHMARK(BM_StringCountByte)->Apply(sizes);
+
+// string.find for a needle that is not there, so the whole input is scanned
+void BM_StringFind(benchmark::State& state) {
+    applySimd(state);
+    std::string_view haystack = input(state);
+    const std::string needle = "needle,haystack";
+    for (auto _ : state) {
+        if (simd::find(haystack.data(), haystack.size(), needle.data(), needle.size()) != haystack.size()) {
+            state.SkipWithError("found the needle");
+            break;
+        }
+    }
+    simd::setEnabled(true);
+    state.SetBytesProcessed(state.iterations() * haystack.size());
+}
+BENCHMARK(BM_StringFind)->Apply(sizes);
+
+// The scan behind string.split on ",": the parts as views into the input.
+// string.split then copies each part into its map.
+void BM_StringSplitScan(benchmark::State& state) {
+    applySimd(state);
+    std::string_view haystack = input(state);
+    std::vector<std::string_view> parts;
+    size_t positions[256];
+    for (auto _ : state) {
+        parts.clear();
+        size_t start = 0;
+        size_t found;
+        do {
+            size_t offset = start;
+            found = simd::findBytes(haystack.data() + offset, haystack.size() - offset, ',', positions, 256);
+            for (size_t i = 0; i < found; i++) {
+                parts.push_back(haystack.substr(start, offset + positions[i] - start));
+                start = offset + positions[i] + 1;
+            }
+        } while (found == 256);
+        parts.push_back(haystack.substr(start));
+        benchmark::DoNotOptimize(parts.data());
+    }
+    simd::setEnabled(true);
+    state.SetBytesProcessed(state.iterations() * haystack.size());
+}
+BENCHMARK(BM_StringSplitScan)->Apply(sizes);
+
+std::unique_ptr<ASTNode> literal(const std::string& value) {
+    auto node = std::make_unique<LiteralNode>();
+    node->value = value;
+    node->type = "value";
+    return node;
+}
+
+// string.join of the parts of the input, which is the input again. The map
+// is made by string.split once per size.
+void BM_StringJoin(benchmark::State& state) {
+    bench::ensureStandardModules();
+    auto& mm = ModuleManager::getInstance();
+    static std::map<int64_t, std::string> splitMaps;
+    std::string_view joined = input(state);
+    std::string& handle = splitMaps[state.range(0)];
+    if (handle.empty()) {
+        std::vector<std::unique_ptr<ASTNode>> splitArgs;
+        splitArgs.push_back(literal(std::string(joined)));
+        splitArgs.push_back(literal(","));
+        handle = mm.callFunction("string.split", splitArgs);
+    }
+
+    std::vector<std::unique_ptr<ASTNode>> args;
+    args.push_back(literal(handle));
+    args.push_back(literal(","));
+    for (auto _ : state) {
+        std::string result = mm.callFunction("string.join", args);
+        if (result.size() != joined.size()) {
+            state.SkipWithError("wrong length");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * joined.size());
+}
+BENCHMARK(BM_StringJoin)->Arg(1 << 10)->Arg(64 << 10)->Arg(1 << 20)->Arg(kMaxBytes)->Unit(benchmark::kMicrosecond);
+
+}
@@ -0,0 +1,197 @@
+#include "workloads.h"
+
+#include <sstream>
+
+namespace workloads
+{
+    std::string manyFunctions(int functions)
+    {
+        std::ostringstream out;
+        const int perModule = 100;
+        int modules = (functions + perModule - 1) / perModule;
+        for (int m = 0; m < modules; m++)
+        {
+            out << "module Gen" << m << " {\n    import std.math;\n\n";
+            for (int f = m * perModule; f < functions && f < (m + 1) * perModule; f++)
+            {
+                out << "    func f" << f << "(x: int, y: int) -> int {\n"
+                    << "        // generated function " << f << "\n"
+                    << "        return x * " << f << " + math.add(y, " << f << ");\n"
+                    << "    }\n\n";
+            }
+            out << "}\n\n";
+        }
+        // f0 exists whenever any function does
+        out << "module Main {\n"
+            << (functions > 0 ? "    import Gen0;\n\n" : "\n")
+            << "    func main() -> int {\n"
+            << (functions > 0 ? "        return Gen0.f0(2, 3);\n" : "        return 0;\n")
+            << "    }\n}\n";
+        return out.str();
+    }
+
+    std::string deepRecursion(int depth)
+    {
+        std::ostringstream out;
+        out << "module Main {\n"
+            << "    import std.math;\n\n"
+            << "    func down(n: int) -> int {\n"
+            << "        if (n) {\n"
+            << "            Main.down(math.subtract(n, 1));\n"
+            << "        }\n"
+            << "    }\n\n"
+            << "    func main() -> int {\n"
+            << "        return Main.down(" << depth << ");\n"
+            << "    }\n}\n";
+        return out.str();
+    }
+
+    std::string sumRecursion(int depth)
+    {
+        std::ostringstream out;
+        out << "module Main {\n"
+            << "    import std.math;\n\n"
+            << "    func sum(n: int, acc: int) -> int {\n"
+            << "        if (n) {\n"
+            << "            Main.sum(math.subtract(n, 1), acc + n);\n"
+            << "        } else {\n"
+            << "            acc;\n"
+            << "        }\n"
+            << "    }\n\n"
+            << "    func main() -> int {\n"
+            << "        return Main.sum(" << depth << ", 0);\n"
+            << "    }\n}\n";
+        return out.str();
+    }
+
+    std::string nonTailRecursion(int depth)
+    {
+        std::ostringstream out;
+        out << "module Main {\n"
+            << "    func count(n: int) -> int {\n"
+            << "        if (n == 0) {\n"
+            << "            return 0;\n"
+            << "        } else {\n"
+            << "            return 1 + Main.count(n - 1);\n"
+            << "        }\n"
+            << "    }\n\n"
+            << "    func main() -> int {\n"
+            << "        return Main.count(" << depth << ");\n"
+            << "    }\n}\n";
+        return out.str();
+    }
+
+    std::string concatChain(int parts)
+    {
+        std::ostringstream out;
+        out << "module Main {\n"
+            << "    func build(n: int) -> string {\n"
+            << "        return \"start\"";
+        for (int i = 0; i < parts; i++)
+        {
+            if (i % 2 == 0)
+                out << " + \" part " << i << " \"";
+            else
+                out << " + n";
+        }
+        out << ";\n    }\n\n"
+            << "    func main() -> string {\n"
+            << "        return Main.build(42);\n"
+            << "    }\n}\n";
+        return out.str();
+    }
+
+    std::string arithmeticChain(int terms)
+    {
+        std::ostringstream out;
+        out << "module Main {\n"
+            << "    func calc(n: int) -> int {\n"
+            << "        return n";
+        for (int i = 0; i < terms; i++)
+            out << (i % 2 ? " + " : " * ") << (i % 7 + 1);
+        out << ";\n    }\n\n"
+            << "    func main() -> int {\n"
+            << "        return Main.calc(3);\n"
+            << "    }\n}\n";
+        return out.str();
+    }
+
+    std::string mathCalls(int calls)
+    {
+        std::ostringstream out;
+        out << "module Main {\n"
+            << "    import std.math;\n\n"
+            << "    func main() -> int {\n";
+        for (int i = 0; i < calls; i++)
+        {
+            out << "        math.add(math.subtract(" << i << ", 1), math.add(" << i << ", 2));\n";
+        }
+        out << "        return 0;\n"
+            << "    }\n}\n";
+        return out.str();
+    }
+
+    std::string arraySum(int elements, bool vectorized)
+    {
+        std::ostringstream out;
+        out << "module Main {\n"
+            << "    import std.array;\n"
+            << "    import std.math;\n\n"
+            << "    func total(a, i: int, n: int, acc: int) -> int {\n"
+            << "        if (math.subtract(n, i)) {\n"
+            << "            Main.total(a, math.add(i, 1), n, math.add(acc, array.get(a, i)));\n"
+            << "        } else {\n"
+            << "            acc;\n"
+            << "        }\n"
+            << "    }\n\n"
+            << "    func main() -> int {\n"
+            << "        let a = array.range(0, " << elements << ");\n";
+        if (vectorized)
+            out << "        return array.sum(a);\n";
+        else
+            out << "        return Main.total(a, 0, array.length(a), 0);\n";
+        out << "    }\n}\n";
+        return out.str();
+    }
+
+    std::string passLargeString(int doublings, int calls)
+    {
+        std::ostringstream out;
+        out << "module Main {\n"
+            << "    import std.math;\n\n"
+            << "    func grow(s: string, n: int) -> string {\n"
+            << "        if (n) {\n"
+            << "            Main.grow(s + s, math.subtract(n, 1));\n"
+            << "        } else {\n"
+            << "            s;\n"
+            << "        }\n"
+            << "    }\n\n"
+            << "    func pass(s: string, n: int) -> string {\n"
+            << "        if (n) {\n"
+            << "            Main.pass(s, math.subtract(n, 1));\n"
+            << "        } else {\n"
+            << "            s;\n"
+            << "        }\n"
+            << "    }\n\n"
+            << "    func main() -> string {\n"
+            << "        let big: string = Main.grow(\"x\", " << doublings << ");\n"
+            << "        return Main.pass(big, " << calls << ");\n"
+            << "    }\n}\n";
+        return out.str();
+    }
+
+    std::string printHeavy(int lines)
+    {
+        std::ostringstream out;
+        out << "module Main {\n"
+            << "    import std.io;\n\n"
+            << "    func main() -> int {\n";
+        for (int i = 0; i < lines; i++)
+        {
+            out << "        io.println(\"line \" + " << i << " + \" of output\");\n";
+        }
+        out << "        return 0;\n"
+            << "    }\n}\n";
+        return out.str();
+    }
+}
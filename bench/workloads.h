@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+
+// Generators for large synthetic Nexis programs used by nexis_bench.
+// Every generated program has a Main.main entry point.
+namespace workloads
+{
+    // `functions` small int functions spread over modules of 100 functions each
+    std::string manyFunctions(int functions);
+
+    // Main.down recursing `depth` times through std.math
+    std::string deepRecursion(int depth);
+
+    // Main.sum adding 1..depth through an accumulator parameter
+    std::string sumRecursion(int depth);
+
+    // Main.count adding 1 after each recursive call returns, so no call is
+    // in tail position
+    std::string nonTailRecursion(int depth);
+
+    // A single return expression joining `parts` string/int operands with '+'
+    std::string concatChain(int parts);
+
+    // Main.calc returning one int expression of `terms` products of n
+    std::string arithmeticChain(int terms);
+
+    // `calls` sequential math.add/math.subtract calls nested three deep
+    std::string mathCalls(int calls);
+
+    // Main.main summing array.range(0, elements), either with array.sum or
+    // by recursing over array.get and math.add
+    std::string arraySum(int elements, bool vectorized);
+
+    // Main.pass handing a string of 2^`doublings` characters to itself
+    // `calls` times, then returning it
+    std::string passLargeString(int doublings, int calls);
+
+    // `lines` io.println statements
+    std::string printHeavy(int lines);
+}
@@ -0,0 +1,104 @@
+#include "evaluator.h"
+#include "lexer.h"
+#include "module_manager.h"
+#include "output_buffer.h"
+#include "parser.h"
+#include "standard_library.h"
+#include "symbol_table.h"
+#include "type_checker.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+namespace
+{
+    // Plenty for the programs fuzzing finds; endless recursion stops at the
+    // step limit and inputs such as array.range(0, 2000000000) at the heap
+    // limit instead of getting the process killed
+    ExecutionLimits limits()
+    {
+        ExecutionLimits limits;
+        limits.steps = 100000;
+        limits.callDepth = 10000;
+        limits.heapBytes = uint64_t(256) << 20;
+        return limits;
+    }
+
+    // Module-level lets, evaluated before Main.main as the compiler does
+    void registerGlobals(ASTNode *program)
+    {
+        auto root = dynamic_cast<ModuleNode *>(program);
+        if (!root)
+            return;
+        for (const auto &child : root->body)
+        {
+            auto module = dynamic_cast<ModuleNode *>(child.get());
+            if (!module)
+                continue;
+            ModuleManager::getInstance().registerModule(module->name);
+            for (const auto &member : module->body)
+            {
+                auto declaration = dynamic_cast<VariableDeclarationNode *>(member.get());
+                if (declaration && declaration->initializer)
+                    SymbolTable::getInstance().setValue(declaration->symbol, evaluateNode(declaration->initializer.get()));
+            }
+        }
+    }
+}
+
+extern "C" int LLVMFuzzerInitialize(int *, char ***)
+{
+    registerStandardModules();
+    // Tasks would outlive the input that spawned them
+    ModuleManager::getInstance().registerFunction("std.chan", "spawn", [](const auto &) -> std::string {
+        throw std::runtime_error("chan.spawn: not available while fuzzing");
+    });
+    // Inputs must not touch the file system
+    ModuleManager::getInstance().registerFunction("std.fs", "open", [](const auto &) -> std::string {
+        throw std::runtime_error("fs.open: not available while fuzzing");
+    });
+
+    // Program output is of no interest; the fuzzer reports on stderr
+    int devNull = open("/dev/null", O_WRONLY);
+    dup2(devNull, STDOUT_FILENO);
+    close(devNull);
+    return 0;
+}
+
+// Checks and runs the input like the compiler does, within limits()
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    std::string source(reinterpret_cast<const char *>(data), size);
+    auto &mm = ModuleManager::getInstance();
+    mm.clearUserFunctions();
+    mm.setLimits(limits());
+    SymbolTable::getInstance().clear();
+
+    Lexer lexer(source);
+    lexer.setQuiet(true);
+    Parser parser(lexer, source);
+    parser.setQuiet(true);
+    auto ast = parser.parse();
+    TypeChecker checker;
+    if (!ast || !checker.check(ast.get()))
+        return 0;
+    mm.registerProgram(ast.get());
+
+    try
+    {
+        registerGlobals(ast.get());
+        if (mm.hasFunction("Main.main"))
+            mm.callFunction("Main.main", {});
+    }
+    catch (const std::exception &)
+    {
+        // Runtime errors are expected; only crashes and hangs are findings
+    }
+    OutputBuffer::getInstance().flush();
+    return 0;
+}
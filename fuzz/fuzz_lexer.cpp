@@ -0,0 +1,57 @@
+#include "lexer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+
+namespace
+{
+    // Refill window small enough that tokens straddle many refills
+    constexpr size_t kChunkSize = 7;
+
+    bool sameToken(const Token &a, const Token &b)
+    {
+        return a.type == b.type && a.value == b.value && a.line == b.line && a.column == b.column &&
+               a.offset == b.offset;
+    }
+
+    // File the streaming lexer reads each input from
+    int inputFile()
+    {
+        static FILE *file = std::tmpfile();
+        return file ? fileno(file) : -1;
+    }
+}
+
+// Lexes the input from memory and again through the streaming lexer; both
+// have to produce the same tokens
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    std::string source(reinterpret_cast<const char *>(data), size);
+    Lexer lexer(source);
+    lexer.setQuiet(true);
+
+    int fd = inputFile();
+    if (fd < 0 || ftruncate(fd, 0) != 0 || pwrite(fd, data, size, 0) != static_cast<ssize_t>(size) ||
+        lseek(fd, 0, SEEK_SET) != 0)
+    {
+        while (lexer.getNextToken().type != END_OF_FILE)
+        {
+        }
+        return 0;
+    }
+
+    Lexer streaming(fd, kChunkSize);
+    streaming.setQuiet(true);
+    for (;;)
+    {
+        Token token = lexer.getNextToken();
+        if (!sameToken(token, streaming.getNextToken()))
+            __builtin_trap();
+        if (token.type == END_OF_FILE)
+            break;
+    }
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include "lexer.h"
+#include "module_manager.h"
+#include "parser.h"
+#include "type_checker.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Parses and type checks the input like the compiler does, then parses it
+// again with lazy bodies and builds every skipped body
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    auto source = std::make_shared<const std::string>(reinterpret_cast<const char *>(data), size);
+    auto &mm = ModuleManager::getInstance();
+    mm.clearUserFunctions();
+
+    {
+        Lexer lexer(*source);
+        lexer.setQuiet(true);
+        Parser parser(lexer, *source);
+        parser.setQuiet(true);
+        auto ast = parser.parse();
+        TypeChecker().check(ast.get());
+    }
+
+    Lexer lexer(*source);
+    lexer.setQuiet(true);
+    Parser parser(lexer, *source);
+    parser.setQuiet(true);
+    parser.setLazyBodies(source);
+    auto ast = parser.parse();
+    if (auto root = dynamic_cast<ModuleNode *>(ast.get()))
+    {
+        for (const auto &child : root->body)
+        {
+            auto module = dynamic_cast<ModuleNode *>(child.get());
+            if (!module)
+                continue;
+            for (const auto &member : module->body)
+            {
+                auto function = dynamic_cast<FunctionNode *>(member.get());
+                std::vector<Diagnostic> diagnostics;
+                if (function && function->lazyBody)
+                    Parser::parseLazyBody(*function, diagnostics);
+            }
+        }
+    }
+
+    mm.clearUserFunctions();
+    return 0;
+}
@@ -0,0 +1,160 @@
+// Runs a fuzz target without libFuzzer. Every file named on the command line
+// (directories are read recursively) is executed once, then -runs=N mutated
+// variants of them. Under AFL, pass the input file as @@. The throughput is
+// printed at the end, so front-end speedups show up as more executions per
+// second. Mutations are a function of -seed, which is printed first, so a
+// crashing run can be repeated.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+extern "C" __attribute__((weak)) int LLVMFuzzerInitialize(int *argc, char ***argv);
+
+namespace
+{
+    // Fragments that make mutated inputs more likely to reach past the lexer
+    const char *const kDictionary[] = {
+        "module ", "import ", "func ", "let ", "if ", "else ", "return ", "-> int ", "-> string ",
+        ": int", ": string", "{", "}", "(", ")", ";", ",", ".", "\"", "//", "/*", "*/", "\n",
+        " + ", " - ", " * ", " / ", " == ", " < ", " >= ", "Main.main()", "Main.f(", "io.println(",
+        "math.add(", "array.range(", "map.new()", "map.add(", "2147483647", "-1", "0",
+    };
+
+    void readInputs(const std::filesystem::path &path, std::vector<std::string> &inputs)
+    {
+        if (std::filesystem::is_directory(path))
+        {
+            for (const auto &entry : std::filesystem::recursive_directory_iterator(path))
+            {
+                if (entry.is_regular_file())
+                    readInputs(entry.path(), inputs);
+            }
+            return;
+        }
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+        {
+            std::cerr << "Cannot read " << path << std::endl;
+            return;
+        }
+        inputs.emplace_back(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    class Mutator
+    {
+    public:
+        Mutator(const std::vector<std::string> &corpus, uint32_t seed, size_t maxLength)
+            : corpus_(corpus), random_(seed), maxLength_(maxLength)
+        {
+        }
+
+        std::string next()
+        {
+            std::string input = corpus_.empty() ? std::string() : corpus_[below(corpus_.size())];
+            for (size_t count = 1 + below(4); count > 0; count--)
+                mutate(input);
+            if (input.size() > maxLength_)
+                input.resize(maxLength_);
+            return input;
+        }
+
+    private:
+        size_t below(size_t bound) { return bound ? random_() % bound : 0; }
+
+        void mutate(std::string &input)
+        {
+            size_t at = below(input.size() + 1);
+            switch (below(6))
+            {
+            case 0: // flip a bit
+                if (!input.empty())
+                    input[below(input.size())] ^= static_cast<char>(1 << below(8));
+                break;
+            case 1: // insert a random byte
+                input.insert(at, 1, static_cast<char>(below(256)));
+                break;
+            case 2: // delete a range
+                input.erase(at, 1 + below(16));
+                break;
+            case 3: // duplicate a range
+                input.insert(at, input.substr(below(input.size() + 1), 1 + below(32)));
+                break;
+            case 4: // splice in part of another input
+                if (!corpus_.empty())
+                {
+                    const std::string &other = corpus_[below(corpus_.size())];
+                    input.insert(at, other.substr(below(other.size() + 1), 1 + below(64)));
+                }
+                break;
+            default:
+                input.insert(at, kDictionary[below(std::size(kDictionary))]);
+                break;
+            }
+        }
+
+        const std::vector<std::string> &corpus_;
+        std::mt19937 random_;
+        size_t maxLength_;
+    };
+}
+
+int main(int argc, char **argv)
+{
+    if (LLVMFuzzerInitialize)
+        LLVMFuzzerInitialize(&argc, &argv);
+
+    uint64_t runs = 0;
+    uint32_t seed = static_cast<uint32_t>(std::random_device()());
+    size_t maxLength = 4096;
+    std::vector<std::string> corpus;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.rfind("-runs=", 0) == 0)
+            runs = std::strtoull(arg.c_str() + 6, nullptr, 10);
+        else if (arg.rfind("-seed=", 0) == 0)
+            seed = static_cast<uint32_t>(std::strtoul(arg.c_str() + 6, nullptr, 10));
+        else if (arg.rfind("-max_len=", 0) == 0)
+            maxLength = std::strtoull(arg.c_str() + 9, nullptr, 10);
+        else
+            readInputs(arg, corpus);
+    }
+
+    std::fprintf(stderr, "%zu inputs, %llu runs, -seed=%u\n", corpus.size(), static_cast<unsigned long long>(runs),
+                 seed);
+    auto run = [](const std::string &input) {
+        LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t *>(input.data()), input.size());
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t bytes = 0;
+    for (const std::string &input : corpus)
+    {
+        run(input);
+        bytes += input.size();
+    }
+    Mutator mutator(corpus, seed, maxLength);
+    for (uint64_t i = 0; i < runs; i++)
+    {
+        std::string input = mutator.next();
+        run(input);
+        bytes += input.size();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t executions = corpus.size() + runs;
+    std::fprintf(stderr, "%llu executions in %.2f s: %.0f exec/s, %.2f MB/s\n",
+                 static_cast<unsigned long long>(executions), seconds,
+                 seconds > 0 ? executions / seconds : 0.0, seconds > 0 ? bytes / seconds / 1e6 : 0.0);
+    return 0;
+}
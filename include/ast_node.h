@@ -1,5 +1,7 @@
 #pragma once
 
+#include "interner.h"
+
 #include <string>
 #include <vector>
 #include <memory>
@@ -15,10 +17,14 @@ class ModuleNode : public ASTNode {
 public:
     std::string name;
     std::vector<std::unique_ptr<ASTNode>> body;
+    size_t startOffset = 0;  // source range from 'module' up to and including '}'
+    size_t endOffset = 0;
     
     std::unique_ptr<ASTNode> clone() const override {
         auto node = std::make_unique<ModuleNode>();
         node->name = name;
+        node->startOffset = startOffset;
+        node->endOffset = endOffset;
         for (const auto& child : body) {
             if (child) {
                 node->body.push_back(child->clone());
@@ -34,16 +40,32 @@ public:
     struct Parameter {
         std::string name;
         std::string type;
+        Symbol symbol = kNoSymbol; // interned name
     };
     std::vector<Parameter> parameters;  // Changed from vector<string> to vector<Parameter>
     std::string returnType;
     std::vector<std::unique_ptr<ASTNode>> body;
+    size_t startOffset = 0;  // source range from 'func' up to and including '}'
+    size_t endOffset = 0;
+
+    // Where the body is while it has not been parsed yet, see
+    // Parser::setLazyBodies; null once `body` holds it
+    struct LazyBody {
+        std::shared_ptr<const std::string> source;
+        size_t begin = 0; // just after '{'
+        size_t end = 0;   // offset of the matching '}'
+        int line = 0;     // line of the '{'
+    };
+    std::shared_ptr<const LazyBody> lazyBody;
     
     std::unique_ptr<ASTNode> clone() const override {
         auto node = std::make_unique<FunctionNode>();
         node->name = name;
         node->parameters = parameters;
         node->returnType = returnType;
+        node->startOffset = startOffset;
+        node->endOffset = endOffset;
+        node->lazyBody = lazyBody;
         for (const auto& child : body) {
             if (child) {
                 node->body.push_back(child->clone());
@@ -59,12 +81,14 @@ public:
     std::string type;
     std::unique_ptr<ASTNode> initializer;
     bool isMutable;
+    Symbol symbol = kNoSymbol; // interned name
     
     std::unique_ptr<ASTNode> clone() const override {
         auto node = std::make_unique<VariableDeclarationNode>();
         node->name = name;
         node->type = type;
         node->isMutable = isMutable;
+        node->symbol = symbol;
         if (initializer) {
             node->initializer = initializer->clone();
         }
@@ -72,15 +96,34 @@ public:
     }
 };
 
+// Operation resolved by the TypeChecker. Dynamic keeps the interpreter's
+// runtime guess (stoi, falling back to concatenation).
+enum class BinaryOperation {
+    Dynamic,
+    IntAdd,
+    IntSubtract,
+    IntMultiply,
+    IntDivide,
+    Concat,
+    IntEquals,
+    IntLess,
+    IntLessEqual,
+    IntGreater,
+    IntGreaterEqual,
+    ValueEquals, // string or bool equality
+};
+
 class BinaryOperationNode : public ASTNode {
 public:
     std::string op;
     std::unique_ptr<ASTNode> left;
     std::unique_ptr<ASTNode> right;
+    BinaryOperation operation = BinaryOperation::Dynamic;
     
     std::unique_ptr<ASTNode> clone() const override {
         auto node = std::make_unique<BinaryOperationNode>();
         node->op = op;
+        node->operation = operation;
         if (left) node->left = left->clone();
         if (right) node->right = right->clone();
         return node;
@@ -91,11 +134,15 @@ class LiteralNode : public ASTNode {
 public:
     std::string value;
     std::string type; // "int", "string", "boolean"
+    int intValue = 0; // parsed value of a checked int literal
+    Symbol symbol = kNoSymbol; // interned name of an identifier
     
     std::unique_ptr<ASTNode> clone() const override {
         auto node = std::make_unique<LiteralNode>();
         node->value = value;
         node->type = type;
+        node->intValue = intValue;
+        node->symbol = symbol;
         return node;
     }
 };
@@ -103,11 +150,13 @@ public:
 class FunctionCallNode : public ASTNode {
 public:
     std::string name;
+    Symbol symbol = kNoSymbol; // interned qualified name, e.g. "io.println"
     std::vector<std::unique_ptr<ASTNode>> arguments;
     
     std::unique_ptr<ASTNode> clone() const override {
         auto node = std::make_unique<FunctionCallNode>();
         node->name = name;
+        node->symbol = symbol;
         for (const auto& arg : arguments) {
             if (arg) {
                 node->arguments.push_back(arg->clone());
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Arbitrary-precision signed integer: sign and magnitude, with the
+// magnitude stored as little-endian base-2^32 limbs. Products of large
+// operands use Karatsuba multiplication.
+class BigInteger
+{
+public:
+    BigInteger() = default;
+    BigInteger(int64_t value);
+
+    // Accepts what std::stoll accepts (leading whitespace, an optional sign,
+    // digits, anything after them ignored) but without a range limit
+    static bool parse(std::string_view text, BigInteger &result);
+
+    std::string toString() const;
+    bool isZero() const { return limbs_.empty(); }
+    bool isNegative() const { return negative_; }
+    bool toInt64(int64_t &value) const;
+
+    friend BigInteger operator+(const BigInteger &left, const BigInteger &right);
+    friend BigInteger operator-(const BigInteger &left, const BigInteger &right);
+    friend BigInteger operator*(const BigInteger &left, const BigInteger &right);
+    BigInteger operator-() const;
+
+    // <0, 0 or >0
+    static int compare(const BigInteger &left, const BigInteger &right);
+
+    // Below this many limbs in the shorter operand products are schoolbook
+    static constexpr size_t kKaratsubaThreshold = 32;
+
+private:
+    using Limbs = std::vector<uint32_t>;
+
+    BigInteger(bool negative, Limbs limbs);
+
+    static int compareMagnitude(const Limbs &left, const Limbs &right);
+    static Limbs addMagnitude(const Limbs &left, const Limbs &right);
+    // Requires left >= right
+    static Limbs subtractMagnitude(const Limbs &left, const Limbs &right);
+    static Limbs multiplyMagnitude(const uint32_t *left, size_t leftSize, const uint32_t *right, size_t rightSize);
+    static void trim(Limbs &limbs);
+
+    bool negative_ = false;
+    Limbs limbs_; // no leading zero limbs; empty for zero
+};
+
+// Exact arithmetic on decimal integer strings, used by std.math and by the
+// interpreter for values that do not fit its 32-bit ints. Stays on int64
+// while the operands and the result fit and promotes to BigInteger
+// otherwise. Returns false if an operand is not an integer.
+enum class IntegerOperation
+{
+    Add,
+    Subtract,
+    Multiply
+};
+bool computeInteger(IntegerOperation operation, const std::string &left, const std::string &right, std::string &result);
+bool compareIntegers(const std::string &left, const std::string &right, int &order);
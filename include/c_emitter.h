@@ -0,0 +1,97 @@
+#pragma once
+
+#include "ast_node.h"
+
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Lowers a parsed program to C that links against runtime/nexis_runtime.c.
+// Locals and parameters get C types from their `: int` / `: string` / `: bool`
+// annotations, or from the initializer when a `let` has none. The generated
+// file exposes `nx_string nexis_main(void)`, which runs Main.main and returns
+// its value, and, unless NEXIS_NO_MAIN is defined, a `main` that calls it.
+class CEmitter
+{
+public:
+    // Returns false and records errors when the program uses something the
+    // C backend cannot express
+    bool emit(const ASTNode *program, std::ostream &out, const std::string &sourceName = "");
+
+    const std::vector<std::string> &getErrors() const { return errors_; }
+
+private:
+    enum class Type
+    {
+        Void,
+        Int,
+        Bool,
+        String
+    };
+
+    struct Signature
+    {
+        std::string cName;
+        std::vector<Type> parameters;
+        Type returnType = Type::Void;
+    };
+
+    struct Variable
+    {
+        std::string cName;
+        Type type;
+    };
+
+    // A string '+' chain keeps its operands in `parts` so the whole chain
+    // becomes one nx_concat call instead of one allocation per operator
+    struct Expression
+    {
+        std::string code;
+        Type type = Type::Void;
+        std::vector<std::string> parts;
+    };
+
+    void collectSignatures(const ModuleNode &module);
+    void collectGlobals(const ModuleNode &module);
+    void emitFunction(const std::string &module, const FunctionNode &function);
+    // Both return true when every path through the code ends in a return
+    bool emitBlock(const std::vector<std::unique_ptr<ASTNode>> &statements, bool tail, int indent);
+    bool emitStatement(const ASTNode *statement, bool tail, int indent);
+    void emitDeclaration(const VariableDeclarationNode &declaration, int indent);
+
+    Expression emitExpression(const ASTNode *node);
+    Expression emitBinary(const BinaryOperationNode &node);
+    Expression emitCall(const FunctionCallNode &node);
+
+    std::string convert(const Expression &value, Type target, const std::string &context);
+    std::string condition(const Expression &value);
+    bool parseType(const std::string &name, Type &type, const std::string &context);
+    const Variable *lookup(const std::string &name) const;
+    std::string declareLocal(const std::string &name, Type type);
+
+    void error(const std::string &message);
+    std::string line(int indent) const { return std::string(indent * 4, ' '); }
+
+    static const char *cType(Type type);
+    static const char *typeName(Type type);
+    static std::string zeroValue(Type type);
+    static std::string codeOf(const Expression &value);
+    static std::string stringLiteral(const std::string &text);
+    static std::string mangle(const std::string &module, const std::string &function);
+
+    std::map<std::string, Signature> functions_; // keyed by "Module.function"
+    std::map<std::string, Variable> globals_;
+    std::vector<std::string> globalInitializers_; // assignments run by nexis_main, in source order
+
+    // State of the function being emitted
+    std::string module_;
+    std::string function_;
+    Type returnType_ = Type::Void;
+    std::vector<std::map<std::string, Variable>> scopes_;
+    std::map<std::string, int> localNames_;
+
+    std::ostringstream body_;
+    std::vector<std::string> errors_;
+};
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "value.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// FIFO queue of Values between threads, behind std.chan. Sending and
+// receiving never take a lock:
+//
+// - A bounded channel is one ring of `capacity` cells (Vyukov's MPMC
+//   queue). Each cell carries a sequence number that says whose turn it is,
+//   so a sender or receiver claims a cell with a single CAS, and one sender
+//   with one receiver never contend on the same cache line. The ring has at
+//   least two cells, since with one the sequence numbers for "full" and
+//   "free again" would be the same.
+// - An unbounded channel is a list of fixed-size segments that are filled
+//   once. Senders and receivers claim slots with fetch_add; a receiver that
+//   gets to a slot before its sender marks it taken, and the sender tries
+//   the next one. Drained segments are freed as soon as no operation is
+//   inside the list.
+//
+// Only a thread that has to wait (a receive on an empty channel, a send to
+// a full one) spins briefly and then sleeps until another operation on the
+// channel wakes it.
+class Channel
+{
+public:
+    // 0 makes the channel unbounded
+    explicit Channel(size_t capacity = 0);
+    ~Channel();
+
+    Channel(const Channel &) = delete;
+    Channel &operator=(const Channel &) = delete;
+
+    size_t capacity() const { return capacity_; }
+    // Bytes the channel takes, not counting its messages' text
+    size_t memoryBytes() const;
+
+    enum class Status
+    {
+        Done,
+        WouldBlock, // empty, or full for a bounded send
+        Closed      // closed, and for receives also drained
+    };
+
+    Status trySend(Value &value);
+    Status tryReceive(Value &value);
+    // Wait while the channel is full or empty; false once it is closed
+    bool send(Value value);
+    bool receive(Value &value);
+
+    // Later sends fail; receives drain what was sent before. A send either
+    // happens before close() and is delivered, or fails.
+    void close();
+    bool isClosed() const { return closed_.load(std::memory_order_acquire); }
+
+    // Receives from whichever channel has a message first and returns its
+    // index, or -1 once every channel is closed and drained
+    static int select(const std::vector<Channel *> &channels, Value &value);
+    // Same without waiting: kWouldBlock while every open channel is empty
+    static constexpr int kWouldBlock = -2;
+    static int trySelect(const std::vector<Channel *> &channels, Value &value);
+
+private:
+    struct Waiter;
+    struct Cell;
+    struct Segment;
+
+    Status pushRing(Value &value);
+    bool popRing(Value &value);
+    Status pushList(Value &value);
+    bool popList(Value &value);
+    void leaveList();
+    // Closed, and every send that got in before close() has published its
+    // message
+    bool sendsFinished() const;
+
+    void addWaiter(Waiter *waiter);
+    void removeWaiter(Waiter *waiter);
+    void wakeWaiters();
+
+    const size_t capacity_;
+
+    // Bounded. close() sets kClosedBit in sendPosition_, so that a sender
+    // claims its cell either before the close or not at all.
+    static constexpr size_t kClosedBit = size_t(1) << 63;
+    const size_t cellCount_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<size_t> sendPosition_{0};
+    alignas(64) std::atomic<size_t> receivePosition_{0};
+
+    // Unbounded
+    alignas(64) std::atomic<Segment *> tail_{nullptr};
+    alignas(64) std::atomic<Segment *> head_{nullptr};
+    std::atomic<size_t> listOperations_{0};
+    std::atomic<Segment *> retired_{nullptr};
+    // Sends between their check of closed_ and publishing their message
+    std::atomic<size_t> sending_{0};
+
+    alignas(64) std::atomic<bool> closed_{false};
+    std::atomic<size_t> waiterCount_{0};
+    std::mutex waitersMutex_;
+    std::vector<Waiter *> waiters_;
+};
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// A lexical or syntax error reported while reading a source file
+struct Diagnostic
+{
+    int line = 0;
+    int column = 0;
+    size_t offset = 0; // absolute byte offset into the source
+    std::string message;
+};
@@ -1,6 +1,14 @@
 #pragma once
 
 #include "ast_node.h"
+#include "value.h"
 #include <string>
 
 std::string evaluateNode(ASTNode* node);
+// Same, but the value of a variable is shared instead of copied
+Value evaluateValue(ASTNode* node);
+
+// Pieces of evaluateNode for callers that evaluate the operands themselves
+std::string evaluateBinary(BinaryOperationNode* node, std::string left, std::string right);
+// Truth value of an if condition
+bool isTrue(const std::string& condition);
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+// Limits for running untrusted scripts, set with ModuleManager::setLimits.
+// A zero leaves that resource unlimited.
+struct ExecutionLimits
+{
+    // Interpreter instructions plus calls made by compiled code
+    uint64_t steps = 0;
+    std::chrono::milliseconds time{0};
+    // Nested user function calls; 0 keeps ModuleManager::kMaxCallDepth
+    size_t callDepth = 0;
+    // Growth of the live heap from the moment the limits were set
+    uint64_t heapBytes = 0;
+
+    bool countsSteps() const { return steps || time.count(); }
+};
+
+// Thrown when a script goes over one of its ExecutionLimits. It unwinds the
+// run like any other runtime error and leaves the interpreter usable.
+class BudgetExceeded : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "ast_node.h"
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Flat code for one function body. ModuleManager runs it on an explicit,
+// heap-allocated frame stack, so a Nexis call never nests C++ calls and
+// recursion depth is limited by memory rather than by the native stack.
+// Only the parts of the body that lead to a user function call are broken
+// up; every other subtree is handed to evaluateNode in one instruction.
+//
+// Every statement and expression leaves exactly one value on the value
+// stack, like evaluateNode returns exactly one string.
+struct FrameInstruction
+{
+    enum class Op : uint8_t
+    {
+        Evaluate,    // push evaluateNode(node)
+        Binary,      // pop right, pop left, push evaluateBinary(node, left, right)
+        Call,        // pop the arguments of the FunctionCallNode, push its result
+        TailCall,    // same, but a user callee replaces the current frame
+        Store,       // move the top value into the variable of node; leaves ""
+        Pop,
+        PushEmpty,
+        JumpIfFalse, // pop a condition, continue at target if !isTrue(condition)
+        Jump,
+        Return       // the top value is the result of the frame
+    };
+
+    Op op;
+    uint32_t target = 0;
+    ASTNode *node = nullptr;
+};
+
+// Whether a call goes to a user-defined function, as ModuleManager resolves it
+using IsUserCall = std::function<bool(const FunctionCallNode &call)>;
+
+std::vector<FrameInstruction> compileFrameCode(const FunctionNode &function, const IsUserCall &isUserCall);
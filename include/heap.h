@@ -0,0 +1,228 @@
+#pragma once
+
+#include "typed_array.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+class StringMap;
+class Channel;
+
+// Owns the objects scripts reach through handles: arrays ("array#3"), maps
+// ("map#2") and channels ("chan#1"). Values are strings, so a handle is just
+// text. An object lives while some value that is exactly its handle can be
+// reached; a handle inside a longer string does not keep it alive. Handles
+// are never reused, so a handle to a collected object names nothing.
+//
+// Collection is generational. Objects start out young, and small arrays are
+// bump-allocated in a nursery. A minor collection marks young objects from
+// the roots and from the remembered old maps (those a handle was stored in
+// since the last collection), frees the young objects it did not reach,
+// copies the surviving nursery arrays out and resets the nursery. Once the
+// old objects have grown by enough, a major collection marks and sweeps all
+// of them instead.
+//
+// Roots are precise: the variables and frame operands of every interpreter
+// thread, task arguments and results, and pinned objects, i.e. channels that
+// tasks wait on and messages in flight. Builtins hold objects in C++
+// variables the collector cannot see, so collections only run at the
+// interpreter's safe points while no thread is inside a builtin (Busy).
+// A thread waiting on a channel or a task is Parked instead: it keeps what
+// it needs pinned and touches nothing else until it runs again.
+class Heap
+{
+public:
+    enum class Kind : uint8_t
+    {
+        Array,
+        Map,
+        Channel
+    };
+
+    struct Stats
+    {
+        uint64_t minorCollections = 0;
+        uint64_t majorCollections = 0;
+        std::chrono::nanoseconds totalPause{0};
+        std::chrono::nanoseconds maxPause{0};
+        uint64_t allocatedBytes = 0; // estimated at allocation and as maps grow
+        uint64_t collectedObjects = 0;
+        uint64_t collectedBytes = 0;
+        uint64_t promotedBytes = 0;
+        uint64_t liveObjects = 0; // after the last collection
+    };
+
+    static Heap &getInstance();
+
+    // New objects with their handles. `capacity` elements are reserved, in
+    // the nursery unless the array is large.
+    std::pair<std::string, TypedArray *> newArray(TypedArray::Kind kind, size_t capacity);
+    std::pair<std::string, StringMap *> newMap();
+    std::pair<std::string, Channel *> newChannel(size_t capacity);
+
+    // nullptr if `handle` does not name a live object of that kind. Arrays
+    // never change, so any number of threads may look them up and read them
+    // at once.
+    const TypedArray *findArray(const std::string &handle);
+    StringMap *findMap(const std::string &handle);
+    Channel *findChannel(const std::string &handle);
+
+    // To be called after map.set and the like: remembers an old map that now
+    // holds a handle, and counts the map's growth towards the next collection
+    void storedInMap(const std::string &map, const std::string &key, const std::string &value);
+
+    // Keeps the object `value` names alive until as many unpin calls;
+    // false, and a no-op, for values that are not handles
+    bool pin(const std::string &value);
+    void unpin(const std::string &value);
+
+    // pin() for as long as it is in scope, unless kept
+    class Pin
+    {
+    public:
+        explicit Pin(const std::string &value);
+        Pin(Pin &&other) noexcept : value_(std::move(other.value_)) { other.value_.clear(); }
+        ~Pin();
+
+        // Leaves the object pinned, for someone else to unpin
+        void keep() { value_.clear(); }
+
+        Pin(const Pin &) = delete;
+        Pin &operator=(const Pin &) = delete;
+        Pin &operator=(Pin &&) = delete;
+
+    private:
+        std::string value_;
+    };
+
+    // Reports the roots of the calling thread (addThreadRoots) or of the
+    // whole program (addRoots) by calling the visitor with each value
+    using RootVisitor = std::function<void(const std::string &value)>;
+    using RootScanner = std::function<void(const RootVisitor &visit)>;
+    void addThreadRoots(RootScanner scanner);
+    void addRoots(RootScanner scanner);
+    // Forgets the calling thread's roots, e.g. before its thread-local
+    // variables go away
+    void detachThread();
+
+    // Marks the calling thread, while in scope, as one that may hold objects
+    // the collector cannot see, e.g. a builtin's arguments
+    class Busy
+    {
+    public:
+        Busy();
+        ~Busy();
+
+        Busy(const Busy &) = delete;
+        Busy &operator=(const Busy &) = delete;
+
+    private:
+        std::atomic<uint32_t> &busy_;
+    };
+
+    // Lets collections run while the calling thread waits, although it is
+    // inside a builtin; everything it uses afterwards must be pinned
+    class Parked
+    {
+    public:
+        Parked();
+        ~Parked();
+
+        Parked(const Parked &) = delete;
+        Parked &operator=(const Parked &) = delete;
+
+    private:
+        std::atomic<uint32_t> &busy_;
+        uint32_t saved_;
+    };
+
+    // Called on an allocating thread once a collection is due, so that it
+    // reaches a safe point soon
+    void setSafepointRequest(std::function<void()> request) { requestSafepoint_ = std::move(request); }
+    // Collects if one is due and every thread is at a safe point. Only the
+    // thread holding the interpreter may call it.
+    void safepoint();
+    // A major collection now, e.g. between runs; the same rules apply
+    void collect();
+
+    const Stats &stats() const { return stats_; }
+
+    // Young objects that trigger a minor collection, in bytes
+    static constexpr size_t kYoungBytes = size_t(8) << 20;
+    // Arrays at least this large skip the nursery
+    static constexpr size_t kLargeArrayBytes = size_t(256) << 10;
+    // Old objects never trigger a major collection below this size
+    static constexpr size_t kMinMajorBytes = size_t(64) << 20;
+
+private:
+    Heap();
+
+    class Nursery;
+
+    struct Object
+    {
+        void *pointer = nullptr;
+        uint64_t id = 0;
+        Kind kind = Kind::Array;
+        bool old = false;
+        bool marked = false;
+        bool remembered = false;
+        bool inNursery = false;
+        uint32_t pins = 0;
+    };
+
+    struct Mutator
+    {
+        std::atomic<uint32_t> busy{0};
+        std::vector<RootScanner> roots;
+    };
+    struct Registration;
+    static Mutator &currentMutator();
+
+    std::string add(Kind kind, void *pointer, size_t bytes, bool inNursery);
+    Object *find(const std::string &handle);
+    Object *find(Kind kind, const std::string &handle);
+    void noteAllocation(size_t bytes);
+    bool allThreadsAtSafepoints();
+
+    void collect(bool major);
+    void mark(Object *object, bool major);
+    void markValue(const std::string &value, bool major);
+    void traceMap(Object *object, bool major);
+    // Moves a young object to the old generation
+    void promote(Object &object);
+    // Frees the object; dead channels are collected in `channels` and
+    // deleted last, since their messages are still pinned
+    void destroy(Object &object, std::vector<Channel *> &channels);
+    static size_t measure(const Object &object);
+
+    std::unordered_map<uint64_t, Object> objects_[3];
+    uint64_t nextId_[3] = {0, 0, 0};
+    std::unique_ptr<Nursery> nursery_;
+    std::vector<Object *> young_;
+    std::vector<Object *> remembered_;
+    std::unordered_set<Object *> pinned_;
+    std::vector<Object *> gray_;
+
+    size_t youngBytes_ = 0;
+    size_t oldBytes_ = 0; // estimated
+    size_t majorThreshold_ = kMinMajorBytes;
+    bool collectionDue_ = false;
+    std::function<void()> requestSafepoint_;
+
+    std::mutex mutatorsMutex_;
+    std::vector<Mutator *> mutators_;
+    std::vector<RootScanner> roots_;
+
+    Stats stats_;
+};
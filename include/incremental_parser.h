@@ -0,0 +1,95 @@
+#pragma once
+
+#include "ast_node.h"
+#include "diagnostic.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Replace `length` bytes at `offset` with `text`
+struct TextEdit
+{
+    size_t offset = 0;
+    size_t length = 0;
+    std::string text;
+};
+
+// A source document that stays parsed across edits, for editor integrations.
+// An edit re-lexes and re-parses only the innermost `func` or `module` that
+// encloses it; every other subtree is kept as is. Edits that do not fit in a
+// single declaration, or that leave it unbalanced, fall back to a wider reparse.
+//
+// The document's functions are registered with the ModuleManager, tagged
+// with the document, and kept current across edits. Destroying the document
+// unregisters them, except those another document has registered since.
+class IncrementalDocument
+{
+public:
+    struct Stats
+    {
+        uint64_t functionReparses = 0;
+        uint64_t moduleReparses = 0;
+        uint64_t fullReparses = 0;
+    };
+
+    explicit IncrementalDocument(std::string text);
+    ~IncrementalDocument();
+
+    IncrementalDocument(const IncrementalDocument &) = delete;
+    IncrementalDocument &operator=(const IncrementalDocument &) = delete;
+
+    // Registers every function again, e.g. after another document that
+    // declared the same ones was closed
+    void registerFunctions() const;
+
+    // Returns false (and changes nothing) if the range is outside the text
+    bool applyEdit(const TextEdit &edit);
+
+    const std::string &getText() const { return text_; }
+    const ModuleNode *getProgram() const { return program_.get(); }
+    // For passes that annotate the tree, such as the TypeChecker
+    ModuleNode *getProgram() { return program_.get(); }
+    // Diagnostics with line and column recomputed from the current text
+    std::vector<Diagnostic> getDiagnostics() const;
+    const Stats &getStats() const { return stats_; }
+
+    // Lookups served from the declaration index, so they stay cheap right
+    // after an edit; the returned nodes are valid until the next edit
+    const FunctionNode *findFunction(const std::string &module, const std::string &name) const;
+    const FunctionNode *functionAt(size_t offset) const;
+
+    // 1-based line and column of a byte offset, and the inverse
+    std::pair<int, int> positionOf(size_t offset) const;
+    size_t offsetOf(int line, int column) const;
+
+private:
+    // Declarations in source order, so edits locate their enclosing
+    // declaration and shift later offsets without walking the tree
+    struct ModuleSpan
+    {
+        size_t slot; // index in program_->body
+        ModuleNode *module;
+        std::vector<size_t> functionSlots; // indices in module->body
+        std::vector<FunctionNode *> functions;
+    };
+
+    static ModuleSpan indexModule(size_t slot, ModuleNode *module);
+    void rebuildIndex();
+    void reparseAll();
+    bool reparseFunction(size_t moduleIndex, size_t functionIndex, ptrdiff_t delta);
+    bool reparseModule(size_t moduleIndex, ptrdiff_t delta);
+    void shiftFrom(size_t moduleIndex, size_t oldOffset, ptrdiff_t delta);
+    bool diagnosticAtBoundary(size_t begin, size_t end) const;
+    void replaceDiagnostics(size_t begin, size_t oldEnd, ptrdiff_t delta, std::vector<Diagnostic> fresh);
+    void updateLineIndex(const TextEdit &edit);
+
+    std::string text_;
+    std::unique_ptr<ModuleNode> program_;
+    std::vector<ModuleSpan> spans_;
+    std::vector<size_t> lineStarts_;
+    std::vector<Diagnostic> diagnostics_; // only offset and message are kept current
+    Stats stats_;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Stable 32-bit id of an interned name. Two names are equal exactly when
+// their symbols are.
+using Symbol = uint32_t;
+
+// The empty name; also what AST nodes built outside the parser carry
+constexpr Symbol kNoSymbol = 0;
+
+// Process-wide table of identifier, module and function names. The lexer
+// interns every identifier once, so the symbol table and the module
+// registry hash and compare integers instead of strings. Names are never
+// released. Not thread-safe, like the other interpreter singletons.
+class Interner
+{
+public:
+    static Interner &getInstance();
+
+    Symbol intern(std::string_view name);
+    // kNoSymbol for names that were never interned, and so cannot be
+    // registered anywhere either
+    Symbol find(std::string_view name) const;
+    const std::string &name(Symbol symbol) const { return names_[symbol]; }
+    size_t size() const { return names_.size(); }
+
+private:
+    Interner();
+
+    std::deque<std::string> names_; // deque: views into it stay valid
+    std::unordered_map<std::string_view, Symbol> symbols_;
+};
+
+inline Symbol intern(std::string_view name) { return Interner::getInstance().intern(name); }
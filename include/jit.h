@@ -0,0 +1,100 @@
+#pragma once
+
+#include "ast_node.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Baseline x86-64 compiler for hot pure-integer functions. Compiled code
+// reproduces the interpreter's string arithmetic exactly: every value is a
+// 32-bit int (as produced by std::stoi/std::to_string) or the empty string.
+namespace jit
+{
+    // Representation of "" in compiled code; any other value is a
+    // sign-extended 32-bit int
+    constexpr int64_t kEmpty = int64_t(1) << 32;
+
+    // Parameters and arguments are passed in registers
+    constexpr size_t kMaxParameters = 6;
+
+    // Native stack a single invoke() may use. Calls in tail position jump
+    // instead of growing the stack.
+    constexpr size_t kStackBudget = 1 << 20;
+
+    // False on targets without a code generator
+    bool isAvailable();
+
+    // Where a call inside a compiled function goes, as ModuleManager resolves it
+    struct CallTarget
+    {
+        std::string builtin;                 // "std.math.add" etc.
+        const FunctionNode *function = nullptr; // user-defined function
+    };
+    using Resolver = std::function<CallTarget(const std::string &qualifiedName)>;
+
+    // Machine code for one function and every user function it calls,
+    // mapped read+execute
+    class CompiledCode
+    {
+    public:
+        CompiledCode(const std::vector<uint8_t> &code, size_t arity);
+        ~CompiledCode();
+
+        CompiledCode(const CompiledCode &) = delete;
+        CompiledCode &operator=(const CompiledCode &) = delete;
+
+        bool isValid() const { return memory_ != nullptr; }
+        size_t arity() const { return arity_; }
+
+        enum class Outcome
+        {
+            Returned,
+            // e.g. math.add of ""; the call has to be interpreted to get the
+            // same behaviour
+            BailedOut,
+            // Recursed through the native stack budget; the interpreter,
+            // which keeps its frames on the heap, has to run it
+            OutOfStack,
+            // Budget::refill declined to give more calls
+            OutOfBudget
+        };
+
+        // Limits of one invoke()
+        struct Budget
+        {
+            size_t stackBytes = kStackBudget;
+            // Calls, tail calls included, that code compiled with countCalls
+            // may make before it asks `refill` for more. refill is called
+            // from compiled code, so it must not throw; it adds to `calls`
+            // or returns false to stop with OutOfBudget. On return, `calls`
+            // holds what was left.
+            uint64_t calls = UINT64_MAX;
+            std::function<bool(uint64_t &calls)> refill;
+        };
+
+        // Runs the code; `result` is only set when it returned
+        Outcome invoke(const std::vector<int64_t> &arguments, int64_t &result) const;
+        Outcome invoke(const std::vector<int64_t> &arguments, int64_t &result, Budget &budget) const;
+
+    private:
+        void *memory_ = nullptr;
+        size_t size_ = 0;
+        size_t arity_;
+    };
+
+    // Compiles `function` if it and everything it calls only use int-typed
+    // parameters, int literals, + and *, math.add/subtract/multiply, if and
+    // calls; otherwise returns nullptr and the function stays interpreted.
+    // With `countCalls` every call is charged to Budget::calls.
+    std::shared_ptr<CompiledCode> compile(const FunctionNode &function, const Resolver &resolve,
+                                          bool countCalls = false);
+
+    // Converts between interpreter strings and compiled values. fromString
+    // only accepts the canonical form std::to_string would produce.
+    bool fromString(const std::string &text, int64_t &value);
+    std::string toString(int64_t value);
+}
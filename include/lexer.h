@@ -1,6 +1,7 @@
 #pragma once
 
 #include "token.h"
+#include "diagnostic.h"
 
 #include <string>
 #include <vector>
@@ -8,27 +9,62 @@
 class Lexer
 {
 private:
-    std::string source_;
+    std::string source_; // whole source, or the current window when streaming
     size_t current_;
     int line_;
     int column_;
     size_t length_;
 
+    // Streaming mode: source_ is refilled from fd_ in chunkSize_ pieces
+    int fd_ = -1;
+    size_t chunkSize_ = 0;
+    size_t windowStart_ = 0; // absolute offset of source_[0]
+    bool eof_ = true;
+
+    std::vector<Diagnostic> diagnostics_;
+    bool quiet_ = false;
+
 public:
+    static constexpr size_t kDefaultChunkSize = 64 * 1024;
+
     Lexer(const std::string &source);
+    // Reads the source incrementally from `fd` (not closed by the lexer).
+    // Memory held by the lexer stays bounded by the chunk size.
+    explicit Lexer(int fd, size_t chunkSize = kDefaultChunkSize);
+    // Lexes source[begin, end) only, reporting offsets and lines as if the
+    // whole source had been lexed; `line` is the line containing `begin`
+    Lexer(const std::string &source, size_t begin, size_t end, int line);
     
     Token getNextToken();
+    // Skips to the '}' matching a '{' that was just returned, without making
+    // tokens; strings and comments are stepped over as getNextToken would.
+    // Returns the offset of that '}' and leaves the cursor behind it, or
+    // std::string::npos at the end of the input.
+    size_t skipBlock();
     std::pair<int, int> getCurrentPosition() const { return {line_, column_}; }
+    size_t getOffset() const { return windowStart_ + current_; }
+    bool isStreaming() const { return fd_ >= 0; }
+
+    const std::vector<Diagnostic> &getDiagnostics() const { return diagnostics_; }
+    // Quiet lexers only record diagnostics instead of printing them
+    void setQuiet(bool quiet) { quiet_ = quiet; }
 
 private:
+    Token scanToken();
+    void lexicalError(const std::string &message);
     void skipWhitespace();
     Token identifier();
     Token number();
     Token stringLiteral();
     Token singleLineComment();
     Token multiLineComment();
+    bool refill(size_t needed);
     void advanceColumn(int count = 1) { column_ += count; }
     void advanceLine() { line_++; column_ = 1; }
-    char peek() const { return current_ < length_ ? source_[current_] : '\0'; }
-    char advance() { column_++; return current_ < length_ ? source_[current_++] : '\0'; }
+    // True if the character `offset` positions ahead of the cursor exists
+    bool hasChar(size_t offset = 0) { return current_ + offset < length_ || refill(current_ + offset + 1); }
+    // Only valid after hasChar(offset) returned true
+    char charAt(size_t offset = 0) const { return source_[current_ + offset]; }
+    char peek() { return hasChar() ? source_[current_] : '\0'; }
+    char advance() { column_++; return hasChar() ? source_[current_++] : '\0'; }
 };
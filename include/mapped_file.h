@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A file opened for reading by std.fs. Regular files are memory-mapped, so
+// reading them copies nothing until a script asks for text; pipes and other
+// files that cannot be mapped are read into memory once.
+class MappedFile
+{
+public:
+    // Throws std::runtime_error if `path` cannot be read
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    std::string_view contents() const { return {data_, size_}; }
+
+    // Lines end at '\n'; a last line without one still counts. The first
+    // call indexes the line starts; any thread may make it.
+    size_t lineCount() const;
+    // Line `index` without its '\n', pointing into the mapping
+    std::string_view line(size_t index) const;
+
+private:
+    void indexLines() const;
+
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+    size_t mappedSize_ = 0; // 0 if data_ points into buffer_
+    std::string buffer_;
+
+    mutable std::once_flag indexed_;
+    mutable std::vector<uint64_t> lineStarts_;
+};
+
+// A file opened for writing by std.fs. Writes are collected in a buffer and
+// handed to write(2) when it fills, on close and when the program exits.
+class FileWriter
+{
+public:
+    static constexpr size_t kBufferSize = 64 * 1024;
+
+    // Truncates the file unless `append`; throws std::runtime_error if it
+    // cannot be opened
+    FileWriter(const std::string &path, bool append);
+    // Flushes, ignoring errors; close() reports them
+    ~FileWriter();
+
+    FileWriter(const FileWriter &) = delete;
+    FileWriter &operator=(const FileWriter &) = delete;
+
+    // Throw std::runtime_error when the system refuses the data
+    void write(std::string_view text);
+    void close();
+
+private:
+    void flush();
+    void writeAll(const char *data, size_t size);
+
+    std::string path_;
+    int fd_;
+    std::string buffer_;
+};
+
+// Owns the files a program opens, behind handles such as "file#2". Files
+// stay open until fs.close or the end of the program, which flushes the
+// writers that are still open.
+class FileStore
+{
+public:
+    static FileStore &getInstance();
+
+    std::string add(std::unique_ptr<MappedFile> file);
+    std::string add(std::unique_ptr<FileWriter> file);
+
+    // nullptr if `handle` does not name a file open for reading / writing
+    const MappedFile *findReader(const std::string &handle) const;
+    FileWriter *findWriter(const std::string &handle);
+
+    // False if `handle` does not name an open file. Throws if the last
+    // writes fail, after closing the file anyway.
+    bool close(const std::string &handle);
+
+private:
+    FileStore() = default;
+
+    struct Entry
+    {
+        std::unique_ptr<MappedFile> reader;
+        std::unique_ptr<FileWriter> writer;
+    };
+
+    // files_.size() if `handle` is not a file handle
+    size_t indexOf(const std::string &handle) const;
+
+    std::vector<Entry> files_;
+};
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <string>
 #include <unordered_set>
 #include <unordered_map>
@@ -7,6 +10,11 @@
 #include <memory>
 #include <vector>
 #include "ast_node.h"
+#include "execution_limits.h"
+#include "frame_code.h"
+#include "interner.h"
+#include "jit.h"
+#include "value.h"
 
 // Function type for module functions
 using ModuleFunction = std::function<std::string(const std::vector<std::unique_ptr<ASTNode>> &)>;
@@ -22,31 +30,183 @@ public:
     // New methods for function management
     void registerFunction(const std::string &moduleName, const std::string &functionName, ModuleFunction func);
     bool hasFunction(const std::string &qualifiedName) const;
+    bool isBuiltinFunction(const std::string &qualifiedName) const;
+    // Full name of the builtin a call resolves to, e.g. "std.io.println" for
+    // "io.println"; empty for user functions and unknown names
+    std::string builtinName(const std::string &qualifiedName) const;
     std::string callFunction(const std::string &qualifiedName, const std::vector<std::unique_ptr<ASTNode>> &args);
+    // Same as above for an interned qualified name such as FunctionCallNode::symbol
+    std::string callFunction(Symbol qualifiedName, const std::vector<std::unique_ptr<ASTNode>> &args);
 
     // Add error handling method
     std::string getLastError() const { return lastError; }
 
     // Add module function registration methods
+    // `owner` tags the registration, e.g. with the IncrementalDocument that
+    // declared the function; a later registration of the same name replaces it
     void registerUserDefinedFunction(const std::string &moduleName, const std::string &functionName,
                                      const std::vector<FunctionNode::Parameter> &params, const std::string &returnType,
-                                     std::unique_ptr<ASTNode> body);
+                                     std::unique_ptr<ASTNode> body, const void *owner = nullptr);
+
+    // With an owner, leaves the function alone unless that owner registered it
+    void unregisterUserDefinedFunction(const std::string &moduleName, const std::string &functionName,
+                                       const void *owner = nullptr);
 
     std::unique_ptr<ASTNode> getUserDefinedFunction(const std::string &qualifiedName) const;
 
+    // Re-registers every function of a parsed program, e.g. once the
+    // TypeChecker has annotated it
+    void registerProgram(const ASTNode *program);
+
+    // Builds the body of a lazily parsed function (FunctionNode::lazyBody)
+    // on its first call; throws if the body has errors
+    using BodyLoader = std::function<void(const std::string &moduleName, FunctionNode &function)>;
+    void setBodyLoader(BodyLoader loader) { bodyLoader = std::move(loader); }
+
+    // User functions called this many times are handed to the JIT; 0 keeps
+    // everything interpreted
+    static constexpr uint32_t kDefaultJitThreshold = 100;
+    void setJitThreshold(uint32_t threshold);
+    uint32_t getJitThreshold() const { return jitThreshold; }
+
+    // Nested user function calls allowed before a runtime error; each one
+    // costs about 100 bytes of heap
+    static constexpr size_t kMaxCallDepth = size_t(1) << 22;
+
+    // Applies `limits` to everything run from now on; the time limit counts
+    // from this call. Going over one throws BudgetExceeded.
+    void setLimits(const ExecutionLimits &limits);
+
+    // Forgets every user-defined function, e.g. between independent programs
+    void clearUserFunctions();
+
+    // Once std.chan tasks exist, interpreted code offers the other tasks a
+    // turn every kStepsPerTaskSwitch steps
+    static constexpr uint64_t kStepsPerTaskSwitch = 4096;
+    void enableTaskSwitching();
+
+    // Calls a user function with arguments that are already evaluated
+    std::string callWithValues(Symbol qualifiedName, std::vector<Value> arguments);
+
+    // Makes `qualifiedName` and every user function it can reach safe to
+    // call on several threads at once: their bodies are loaded, their frame
+    // code is built and their calls are resolved. Throws if one of them
+    // calls a builtin (e.g. "std.io.println") that `isThreadSafe` rejects.
+    void prepareParallelCalls(Symbol qualifiedName, const std::function<bool(const std::string &builtin)> &isThreadSafe);
+
+    // Marks the calling thread, while in scope, as one of several that run
+    // prepared functions at once. Its calls stay interpreted, because
+    // compiled code shares its stack limit and call budget between threads,
+    // and it never switches tasks. Its steps count against the same limit.
+    class ParallelWork
+    {
+    public:
+        ParallelWork();
+        ~ParallelWork();
+
+        ParallelWork(const ParallelWork &) = delete;
+        ParallelWork &operator=(const ParallelWork &) = delete;
+    };
+
 private:
-    ModuleManager() = default;
-    std::unordered_set<std::string> importedModules;
-    std::unordered_map<std::string, std::unordered_map<std::string, ModuleFunction>> moduleFunctions;
+    ModuleManager();
+    std::unordered_set<Symbol> importedModules;
+    std::unordered_map<Symbol, std::unordered_map<Symbol, ModuleFunction>> moduleFunctions;
     mutable std::string lastError;
 
     // Add storage for user-defined functions
     struct UserFunction
     {
+        Symbol module = kNoSymbol;
         std::vector<FunctionNode::Parameter> parameters; // Updated type
         std::string returnType;
         std::unique_ptr<ASTNode> body;
+        const void *owner = nullptr;
+
+        uint32_t callCount = 0;
+        bool jitRejected = false;
+        std::shared_ptr<jit::CompiledCode> compiled;
+
+        std::vector<FrameInstruction> code; // compiled on the first call
     };
 
-    std::unordered_map<std::string, std::unordered_map<std::string, UserFunction>> userDefinedFunctions;
+    // A running call of a user function
+    struct Frame
+    {
+        UserFunction *function;
+        size_t pc;
+    };
+
+    // What a qualified name refers to, looked up once per name and reset
+    // whenever a function is (un)registered
+    struct ResolvedCall
+    {
+        Symbol module = kNoSymbol; // builtin module, e.g. "std.io"
+        Symbol function = kNoSymbol;
+        const ModuleFunction *builtin = nullptr;
+        UserFunction *user = nullptr;
+    };
+    const ResolvedCall &resolve(Symbol qualifiedName) const;
+
+    // Runs `func` and every user function it calls on `frames`; only calls
+    // made by builtins start another execute()
+    std::string execute(UserFunction &func, std::vector<Value> &arguments, size_t argumentCount);
+    std::string run(size_t baseFrame);
+    void pushFrame(UserFunction &func, Value *arguments, size_t count);
+    void bindArguments(UserFunction &func, Value *arguments, size_t count);
+    void buildFrameCode(UserFunction &func);
+
+    // Runs `func` as machine code if it is hot and every argument is an int
+    bool runCompiled(UserFunction &func, const Value *arguments, size_t count, std::string &result);
+    void compileHotFunction(UserFunction &func);
+    // Parses a body the parser skipped; a no-op once it is there
+    void loadBody(UserFunction &func);
+    jit::CallTarget resolveCallTarget(const std::string &qualifiedName) const;
+    void discardCompiledCode();
+
+    uint32_t jitThreshold = kDefaultJitThreshold;
+    // Whether any function has counted calls or has frame code since
+    // discardCompiledCode last ran
+    bool hasRunFunctions = false;
+    BodyLoader bodyLoader;
+
+    // Every interpreter instruction and compiled call adds to the thread's
+    // `steps`; only when it passes `nextCheck` are the limits and the clock
+    // looked at, and the thread's steps added to totalSteps
+    enum class Limit
+    {
+        None,
+        Steps,
+        Time
+    };
+    static constexpr uint64_t kStepsPerClockCheck = 1024;
+    // Native frames of compiled code take at least this much stack
+    static constexpr size_t kMinNativeFrameBytes = 16;
+    // Reschedules nextCheck unless a limit has been exceeded
+    Limit exceededLimit();
+    [[noreturn]] void throwBudgetExceeded(Limit limit) const;
+    std::string callWithHeapLimit(Symbol qualifiedName, const std::vector<std::unique_ptr<ASTNode>> &args);
+
+    ExecutionLimits limits;
+    size_t maxCallDepth = kMaxCallDepth;
+    static thread_local uint64_t steps;
+    static thread_local uint64_t reportedSteps; // part of totalSteps
+    static thread_local uint64_t nextCheck;     // 0 makes a new thread check first
+    std::atomic<uint64_t> totalSteps{0};
+    std::chrono::steady_clock::time_point deadline;
+    bool enforcingHeapLimit = false;
+    bool switchingTasks = false;
+
+    static thread_local bool parallelWorker;
+    std::atomic<size_t> parallelThreads{0};
+
+    std::unordered_map<Symbol, std::unordered_map<Symbol, UserFunction>> userDefinedFunctions;
+    mutable std::unordered_map<Symbol, ResolvedCall> resolvedCalls;
+
+    // Each task runs on its own thread with its own stack
+    static thread_local std::vector<Frame> frames;
+    static thread_local std::vector<Value> values; // operands of every frame, innermost last
+    // Compiled code that ran out of native stack at this depth; deeper calls
+    // stay interpreted until the interpreter returns to it
+    static thread_local size_t jitPausedAbove;
 };
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Directory holding nexis_runtime.h/.c: $NEXIS_RUNTIME_DIR when set,
+// otherwise the runtime/ directory of the source tree the compiler was built from
+std::string runtimeDirectory();
+
+// Compiles C emitted by CEmitter together with the runtime into `output`
+// using the system C compiler ($CC, default "cc"). Extra flags go after the
+// defaults, so callers can ask for e.g. a shared object.
+bool compileNative(const std::string &cFile, const std::string &output,
+                   const std::vector<std::string> &extraFlags = {});
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+// Buffered writer used by the std.io builtins. Output is collected in a
+// user-space buffer and handed to write(2) in large batches instead of
+// flushing on every call.
+class OutputBuffer
+{
+public:
+    enum class Mode
+    {
+        Full, // flush when the buffer fills, on flush() and on exit
+        Line  // additionally flush after every complete line
+    };
+
+    static constexpr size_t kDefaultCapacity = 64 * 1024;
+
+    // Buffer attached to stdout; line-buffered when stdout is a TTY.
+    static OutputBuffer &getInstance();
+
+    explicit OutputBuffer(int fd, size_t capacity = kDefaultCapacity);
+    ~OutputBuffer();
+
+    OutputBuffer(const OutputBuffer &) = delete;
+    OutputBuffer &operator=(const OutputBuffer &) = delete;
+
+    void write(const std::string &text);
+    void writeLine(const std::string &text);
+    void flush();
+
+    void setMode(Mode mode) { mode_ = mode; }
+    Mode getMode() const { return mode_; }
+
+private:
+    void append(const char *data, size_t size);
+    void writeAll(const char *data, size_t size);
+
+    int fd_;
+    size_t capacity_;
+    Mode mode_;
+    std::string buffer_;
+};
@@ -2,21 +2,45 @@
 
 #include "lexer.h"
 #include "ast_node.h"
+#include "diagnostic.h"
 #include <memory>
+#include <vector>
 
 class Parser
 {
 public:
     Parser(Lexer &lexer, const std::string& source);
+    // For streaming lexers: the source is not retained, so errors carry
+    // no source excerpt
+    explicit Parser(Lexer &lexer);
 
     std::unique_ptr<ASTNode> parse();
     std::unique_ptr<ASTNode> parseProgram();  // Add new method
 
-private:
+    // Single-declaration entry points used for incremental reparsing
     std::unique_ptr<ASTNode> parseModule();
+    std::unique_ptr<ASTNode> parseFunctionDeclaration();
+    bool atEnd() const { return current_token_.type == END_OF_FILE; }
+
+    const std::vector<Diagnostic>& getDiagnostics() const { return diagnostics_; }
+    // Quiet parsers only record diagnostics instead of printing them
+    void setQuiet(bool quiet) { quiet_ = quiet; }
+    // Function bodies are only brace-matched and recorded as a range of
+    // `source`, which must be the text being parsed; parseLazyBody builds
+    // them when they are needed
+    void setLazyBodies(std::shared_ptr<const std::string> source) { lazySource_ = std::move(source); }
+    // Tags the functions this parser registers with the ModuleManager
+    void setFunctionOwner(const void *owner) { functionOwner_ = owner; }
+
+    // Parses the statements of a body skipped by a lazy parse into
+    // function.body, leaving function.lazyBody as it is. Returns false and
+    // fills `diagnostics` on lexical or syntax errors.
+    static bool parseLazyBody(FunctionNode &function, std::vector<Diagnostic> &diagnostics);
+
+private:
     std::unique_ptr<ASTNode> parseStatement();
+    std::unique_ptr<ASTNode> parseBlockStatement();
     std::unique_ptr<ASTNode> parseVariableDeclaration();
-    std::unique_ptr<ASTNode> parseFunctionDeclaration();
     std::unique_ptr<ASTNode> parseReturnStatement();
     std::unique_ptr<ASTNode> parseExpression();
     std::unique_ptr<ASTNode> parsePrimaryExpression();
@@ -25,6 +49,8 @@ private:
     void parseImportStatement();
 
     void consume(TokenType type);
+    void recordDiagnostic(const std::string& message);
+    void syntaxError(const std::string& message);
     void reportError(const std::string& message);
 
     // tokenToString helper function
@@ -36,4 +62,8 @@ private:
     Lexer &lexer_;
     Token current_token_;
     const std::string& source_;
+    std::vector<Diagnostic> diagnostics_;
+    bool quiet_ = false;
+    std::shared_ptr<const std::string> lazySource_;
+    const void *functionOwner_ = nullptr;
 };
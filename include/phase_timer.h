@@ -0,0 +1,45 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Wall time, allocations and peak RSS for the driver phases (--time-phases)
+class PhaseTimer
+{
+public:
+    struct Phase
+    {
+        std::string name;
+        std::chrono::nanoseconds elapsed{0};
+        uint64_t allocations = 0;
+        uint64_t allocatedBytes = 0;
+        long peakRssKb = 0;
+        std::vector<std::pair<std::string, uint64_t>> counters;
+    };
+
+    explicit PhaseTimer(bool enabled = true) : enabled_(enabled) {}
+
+    bool isEnabled() const { return enabled_; }
+
+    // begin/end/addCounter are no-ops on a disabled timer
+    void begin(const std::string &name);
+    void end();
+    // Attaches a counter (tokens, nodes, ...) to the most recent phase
+    void addCounter(const std::string &name, uint64_t value);
+
+    const std::vector<Phase> &getPhases() const { return phases_; }
+
+    void writeReport(std::ostream &out) const;
+    void writeJson(std::ostream &out) const;
+
+private:
+    bool enabled_;
+    std::vector<Phase> phases_;
+    std::chrono::steady_clock::time_point start_;
+    uint64_t startAllocations_ = 0;
+    uint64_t startBytes_ = 0;
+};
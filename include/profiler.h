@@ -0,0 +1,118 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <new>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Process-wide heap allocation counters. Counting is switched off by
+// default so the replaced operator new only pays for one relaxed load.
+namespace AllocationStats
+{
+    void setTracking(bool enabled);
+    bool isTracking();
+    uint64_t count();
+    uint64_t bytes();
+
+    // Live heap accounting for ExecutionLimits::heapBytes. A non-zero limit
+    // starts measuring every allocation and free from zero; while the limit
+    // is enforced, an allocation that takes the live heap over it throws
+    // HeapLimitExceeded.
+    void setHeapLimit(uint64_t bytes);
+    void enforceHeapLimit(bool enforce);
+    int64_t liveBytes();
+
+    class HeapLimitExceeded : public std::bad_alloc
+    {
+    public:
+        const char *what() const noexcept override;
+    };
+}
+
+// Tracing profiler for Nexis function calls, fed by ModuleManager::callFunction.
+class Profiler
+{
+public:
+    struct FunctionStats
+    {
+        uint64_t calls = 0;
+        std::chrono::nanoseconds inclusive{0};
+        std::chrono::nanoseconds exclusive{0};
+        uint64_t allocations = 0; // exclusive
+    };
+
+    static Profiler &getInstance();
+
+    // Only calls on the enabling thread are profiled
+    void enable();
+    bool isEnabled() const { return enabled_ && std::this_thread::get_id() == thread_; }
+
+    void enter(const std::string &functionName);
+    void exit();
+
+    // Flat report sorted by exclusive time
+    void writeReport(std::ostream &out) const;
+    // One "caller;callee <nanoseconds>" line per unique stack, as consumed
+    // by flamegraph.pl and speedscope
+    bool writeCollapsedStacks(const std::string &path) const;
+
+    const std::unordered_map<std::string, FunctionStats> &getStats() const { return stats_; }
+
+private:
+    Profiler() = default;
+
+    // Calls form a tree with one node per unique stack; node 0 is the root.
+    // The collapsed "caller;callee" names are only built when written.
+    struct StackNode
+    {
+        uint32_t parent = 0;
+        const std::string *function = nullptr;
+        std::unordered_map<const FunctionStats *, uint32_t> children;
+        std::chrono::nanoseconds self{0};
+    };
+
+    struct Frame
+    {
+        FunctionStats *stats;
+        uint32_t node;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::nanoseconds childTime{0};
+        uint64_t startAllocations = 0;
+        uint64_t childAllocations = 0;
+    };
+
+    bool enabled_ = false;
+    std::thread::id thread_;
+    std::vector<Frame> frames_;
+    std::unordered_map<std::string, FunctionStats> stats_;
+    std::unordered_map<const FunctionStats *, int> activeDepth_;
+    std::vector<StackNode> stacks_{1};
+};
+
+// RAII helper used at call sites; costs a single branch when profiling is off
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const std::string &functionName)
+        : active_(Profiler::getInstance().isEnabled())
+    {
+        if (active_)
+            Profiler::getInstance().enter(functionName);
+    }
+
+    ~ProfileScope()
+    {
+        if (active_)
+            Profiler::getInstance().exit();
+    }
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+    bool active_;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Kernels behind std.array and std.string. On x86-64 CPUs with AVX2 they
+// process four elements (or 32 bytes) per instruction; elsewhere (or after
+// setEnabled(false)) they fall back to scalar loops with the same results,
+// except that double sums and dot products add in a different order. int64
+// arithmetic wraps around.
+namespace simd
+{
+    bool isAvailable();
+    // For benchmarks comparing against the scalar loops
+    void setEnabled(bool enabled);
+
+    enum class Arithmetic
+    {
+        Add,
+        Subtract,
+        Multiply,
+        Divide
+    };
+
+    enum class Comparison
+    {
+        Less,
+        LessEqual,
+        Greater,
+        GreaterEqual,
+        Equal,
+        NotEqual
+    };
+
+    int64_t sum(const int64_t *values, size_t count);
+    double sum(const double *values, size_t count);
+    int64_t dot(const int64_t *left, const int64_t *right, size_t count);
+    double dot(const double *left, const double *right, size_t count);
+
+    // count must be at least 1
+    int64_t min(const int64_t *values, size_t count);
+    int64_t max(const int64_t *values, size_t count);
+    double min(const double *values, size_t count);
+    double max(const double *values, size_t count);
+
+    // out[i] = values[i] <op> operand. Integer division by zero is the
+    // caller's to rule out.
+    void map(Arithmetic operation, const int64_t *values, int64_t operand, int64_t *out, size_t count);
+    void map(Arithmetic operation, const double *values, double operand, double *out, size_t count);
+
+    // Copies the values for which `value <comparison> operand` holds to out,
+    // keeping their order; returns how many. out needs room for count + 4.
+    size_t filter(Comparison comparison, const int64_t *values, int64_t operand, int64_t *out, size_t count);
+    size_t filter(Comparison comparison, const double *values, double operand, double *out, size_t count);
+
+    // Ascending, in place, by LSD radix sort. Doubles are ordered by their
+    // IEEE bits, so NaNs end up at the ends.
+    void sort(int64_t *values, size_t count);
+    void sort(double *values, size_t count);
+
+    // Byte search. Positions are offsets into data, and `size` means there
+    // is no match.
+    size_t findByte(const char *data, size_t size, char byte);
+    // Stores the positions of the first `capacity` bytes equal to `byte`
+    // and returns how many there were
+    size_t findBytes(const char *data, size_t size, char byte, size_t *positions, size_t capacity);
+    size_t countByte(const char *data, size_t size, char byte);
+    // First occurrence of the needle; 0 for an empty one
+    size_t find(const char *data, size_t size, const char *needle, size_t needleSize);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+// Registers the built-in std.* modules with the ModuleManager
+void registerStandardModules();
+
+// std.array: int64/double arrays with vectorized kernels (array_module.cpp)
+void registerArrayModule();
+
+// std.map: mutable string-keyed hash maps (map_module.cpp)
+void registerMapModule();
+
+// std.chan: channels between tasks, and chan.spawn/join (chan_module.cpp)
+void registerChanModule();
+
+// std.parallel: reductions over ranges and arrays on a thread pool (parallel_module.cpp)
+void registerParallelModule();
+
+// std.fs: memory-mapped file reading and buffered writing (fs_module.cpp)
+void registerFsModule();
+
+// std.string: searching, splitting and joining with SIMD byte search (string_module.cpp)
+void registerStringModule();
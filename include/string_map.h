@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Value stored in a std.map. Canonical int64 text is kept as a number so
+// counters do not round-trip through strings.
+struct MapValue
+{
+    bool isInt = false;
+    int64_t number = 0;
+    std::string text;
+
+    static MapValue from(const std::string &value);
+    std::string toString() const { return isInt ? std::to_string(number) : text; }
+};
+
+// Open-addressing hash table from strings to MapValues in the style of
+// SwissTable. Every slot has a control byte (empty, deleted, or 7 bits of
+// the key's hash), and lookups compare a whole group of 16 control bytes
+// at once (SSE2), so only slots whose hash bits match are compared by key.
+// Slots point into a dense entry vector, which makes iteration by index
+// O(1). Entries keep insertion order until a removal moves the last entry
+// into the freed place.
+class StringMap
+{
+public:
+    struct Entry
+    {
+        std::string key;
+        MapValue value;
+        size_t hash;
+    };
+
+    StringMap();
+
+    MapValue *find(const std::string &key);
+    // Inserts a default value when the key is missing
+    MapValue &operator[](const std::string &key);
+    bool remove(const std::string &key);
+
+    size_t size() const { return entries_.size(); }
+    const Entry &entryAt(size_t index) const { return entries_[index]; }
+    // Bytes the map takes, including its keys and values
+    size_t memoryBytes() const;
+
+    static constexpr size_t kGroupWidth = 16;
+
+private:
+    static constexpr size_t kNotFound = SIZE_MAX;
+
+    // Slot holding `key`, or kNotFound
+    size_t findSlot(const std::string &key, size_t hash) const;
+    // First empty or deleted slot on the probe sequence of `hash`
+    size_t findFreeSlot(size_t hash) const;
+    void rehash(size_t capacity);
+    bool groupHasEmpty(size_t group) const;
+
+    std::vector<int8_t> control_; // one byte per slot
+    std::vector<uint32_t> slots_; // index into entries_ of full slots
+    std::vector<Entry> entries_;
+    size_t groupMask_ = 0;        // number of groups - 1
+    size_t growthLeft_ = 0;       // insertions into empty slots before the next rehash
+};
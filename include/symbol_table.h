@@ -1,47 +1,111 @@
 #pragma once
+#include "interner.h"
+#include "value.h"
+
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+// Variables keyed by interned name. Globals live in a hash map; each
+// function call's variables are a run of `bindings` starting at its scope's
+// offset, so calls allocate nothing once the vector has grown. Lookups see
+// the innermost scope and the globals only. Every thread has its own
+// table, so std.chan tasks do not see each other's variables.
 class SymbolTable {
 public:
     static SymbolTable& getInstance() {
-        static SymbolTable instance;
+        static thread_local SymbolTable instance;
         return instance;
     }
 
     void pushScope() {
-        scopes.push_back({});
+        scopes.push_back(bindings.size());
     }
 
     void popScope() {
         if (!scopes.empty()) {
+            bindings.resize(scopes.back());
             scopes.pop_back();
         }
     }
 
-    void setValue(const std::string& name, const std::string& value) {
-        if (!scopes.empty()) {
-            scopes.back()[name] = value;
-        } else {
-            variables[name] = value;
+    void setValue(Symbol name, Value value) {
+        if (scopes.empty()) {
+            variables[name] = std::move(value);
+            return;
         }
+        for (size_t i = scopes.back(); i < bindings.size(); i++) {
+            if (bindings[i].name == name) {
+                bindings[i].value = std::move(value);
+                return;
+            }
+        }
+        bindings.push_back({name, std::move(value)});
+    }
+
+    // "" for unknown variables
+    const std::string& getValue(Symbol name) const {
+        return getShared(name).str();
     }
 
-    std::string getValue(const std::string& name) const {
-        // Search from innermost scope to outermost
-        for (auto it = scopes.rbegin(); it != scopes.rend(); ++it) {
-            auto found = it->find(name);
-            if (found != it->end()) {
-                return found->second;
+    // The value itself, for callers that keep it without copying the string
+    const Value& getShared(Symbol name) const {
+        if (!scopes.empty()) {
+            for (size_t i = bindings.size(); i-- > scopes.back();) {
+                if (bindings[i].name == name) {
+                    return bindings[i].value;
+                }
             }
         }
         auto it = variables.find(name);
-        return it != variables.end() ? it->second : "";
+        return it != variables.end() ? it->second : empty;
+    }
+
+    // Every global and every variable of every scope
+    template <typename Function>
+    void forEachValue(Function function) const {
+        for (const auto& global : variables) {
+            function(global.second);
+        }
+        for (const Binding& binding : bindings) {
+            function(binding.value);
+        }
+    }
+
+    // Drops every variable, e.g. between independent programs
+    void clear() {
+        variables.clear();
+        bindings.clear();
+        scopes.clear();
+    }
+
+    // A task starts with a copy of its spawner's globals
+    const std::unordered_map<Symbol, Value>& globals() const {
+        return variables;
+    }
+    void setGlobals(std::unordered_map<Symbol, Value> globals) {
+        variables = std::move(globals);
+    }
+
+    void setValue(const std::string& name, const std::string& value) {
+        setValue(intern(name), value);
+    }
+
+    const std::string& getValue(const std::string& name) const {
+        Symbol symbol = Interner::getInstance().find(name);
+        return symbol != kNoSymbol ? getValue(symbol) : empty.str();
     }
 
 private:
     SymbolTable() = default;
-    std::unordered_map<std::string, std::string> variables;
-    std::vector<std::unordered_map<std::string, std::string>> scopes;
+
+    struct Binding {
+        Symbol name;
+        Value value;
+    };
+
+    std::unordered_map<Symbol, Value> variables;
+    std::vector<Binding> bindings;
+    std::vector<size_t> scopes; // offset of each scope's first binding
+    const Value empty;
 };
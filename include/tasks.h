@@ -0,0 +1,88 @@
+#pragma once
+
+#include "interner.h"
+#include "value.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Tasks started by chan.spawn. Each one runs on its own thread with its own
+// variables and call stack, but the interpreter's shared state (functions,
+// output, limits) is not thread-safe, so tasks take turns: a task holds the
+// interpreter lock while it runs and offers it to the others every few
+// thousand steps and whenever it waits on a channel or a join. Channels
+// themselves need no lock, so native code that holds Channel pointers can
+// use them from any thread.
+//
+// The lock is only used once the first task is spawned; until then nothing
+// changes for single-threaded programs. When the main program ends it keeps
+// the lock, so unfinished tasks stop where they are.
+class Tasks
+{
+public:
+    static Tasks &getInstance();
+
+    // Calls `function` (a qualified name) with `arguments` on a new thread;
+    // returns its handle, e.g. "task#0"
+    std::string spawn(Symbol function, std::vector<Value> arguments);
+    // Waits for a task and returns its result; throws if it failed
+    std::string join(const std::string &handle);
+
+    // Whether any spawned task is still running
+    bool hasRunningTasks() const { return running_.load(std::memory_order_acquire) > 0; }
+
+    // Lets a waiting task run first
+    void yield();
+
+    // Gives up the interpreter while it is in scope, e.g. around a wait on a
+    // channel
+    class Unlocked
+    {
+    public:
+        Unlocked();
+        ~Unlocked();
+
+        Unlocked(const Unlocked &) = delete;
+        Unlocked &operator=(const Unlocked &) = delete;
+
+    private:
+        bool locked_;
+    };
+
+private:
+    Tasks();
+
+    struct Task
+    {
+        // Until the task starts; roots for the collector meanwhile
+        std::vector<Value> arguments;
+        std::unordered_map<Symbol, Value> globals;
+
+        std::mutex mutex;
+        std::condition_variable finished;
+        bool done = false;
+        bool failed = false;
+        std::string result; // or the error
+    };
+
+    // A ticket lock, so that a task that yields gets back in line behind
+    // the ones already waiting
+    void lock();
+    void unlock();
+
+    std::mutex mutex_;
+    std::condition_variable turn_;
+    size_t nextTicket_ = 0;
+    size_t serving_ = 0;
+    std::atomic<size_t> waiting_{0};
+    bool active_ = false;
+
+    std::atomic<size_t> running_{0};
+    std::vector<std::shared_ptr<Task>> tasks_;
+};
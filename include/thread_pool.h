@@ -0,0 +1,49 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+// Worker threads for std.parallel. A job is split into numbered chunks that
+// the pool's threads and the calling thread claim one at a time, so a
+// thread that finishes early takes over the work left.
+class ThreadPool
+{
+public:
+    static ThreadPool &getInstance();
+
+    // Threads that run a job, counting the caller; the hardware's by default
+    size_t threads() const { return threads_; }
+    void setThreads(size_t count);
+
+    // Calls work(0) to work(chunks - 1) and returns once they are done. If
+    // one throws, the chunks not yet claimed are skipped and the first
+    // exception is rethrown here. One job runs at a time.
+    void run(size_t chunks, const std::function<void(size_t chunk)> &work);
+
+private:
+    ThreadPool();
+
+    void startWorkers();
+    void workerLoop();
+    void runChunks(const std::function<void(size_t)> &work);
+
+    size_t threads_;
+    size_t started_ = 0; // workers, which never exit
+
+    std::mutex jobMutex_; // held for a whole run
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    const std::function<void(size_t)> *work_ = nullptr;
+    uint64_t job_ = 0;
+    size_t busy_ = 0; // workers inside the current job
+    size_t chunks_ = 0;
+    std::atomic<size_t> nextChunk_{0};
+    std::atomic<bool> failed_{false};
+    std::exception_ptr error_;
+};
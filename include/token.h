@@ -1,5 +1,8 @@
 #pragma once
 
+#include "interner.h"
+
+#include <cstddef>
 #include <string>
 
 enum TokenType
@@ -40,4 +43,6 @@ struct Token
     std::string value;
     int line;
     int column;  // Add column tracking
+    size_t offset = 0; // byte offset of the first character
+    Symbol symbol = kNoSymbol; // interned value of IDENTIFIER tokens
 };
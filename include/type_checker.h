@@ -0,0 +1,80 @@
+#pragma once
+
+#include "ast_node.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Infers and verifies the types of all expressions against the `: type` and
+// `-> type` annotations, and records on every BinaryOperationNode which
+// operation it performs so the evaluator does not have to guess at run time.
+// Parameters declared without a type are dynamic; operations on them keep
+// the interpreter's runtime behaviour. So does `+` on a string that was not
+// declared as one (a literal, a builtin's result or an untyped `let`): the
+// runtime adds it to an int if it reads as one.
+class TypeChecker
+{
+public:
+    bool check(ASTNode *program);
+    // Checks a body that check() skipped because it had not been parsed yet;
+    // errors_ then only holds the errors of that body
+    bool checkBody(const std::string &module, FunctionNode &function);
+
+    const std::vector<std::string> &getErrors() const { return errors_; }
+    // Start offset of the function (or module) each error was found in
+    const std::vector<size_t> &getErrorOffsets() const { return errorOffsets_; }
+
+    // Type of a parameter or local of a checked function ("int", "string",
+    // "bool" or "dynamic"); empty if the function has no such variable
+    std::string variableType(const FunctionNode &function, const std::string &name) const;
+
+private:
+    enum class Type
+    {
+        Dynamic,
+        Void,
+        Int,
+        String,
+        // A string only known from inference; "string" to everything but `+`
+        Text,
+        Bool
+    };
+
+    struct Signature
+    {
+        std::vector<Type> parameters;
+        Type returnType = Type::Dynamic;
+    };
+
+    void checkGlobals(ModuleNode &module);
+    void checkFunction(const std::string &module, FunctionNode &function);
+    // Returns the types the block can produce as its value
+    std::vector<Type> checkBlock(std::vector<std::unique_ptr<ASTNode>> &statements);
+    std::vector<Type> checkStatement(ASTNode *statement);
+    void checkDeclaration(VariableDeclarationNode &declaration, std::map<std::string, Type> &scope);
+
+    Type checkExpression(ASTNode *node);
+    Type checkLiteral(LiteralNode &literal);
+    Type checkBinary(BinaryOperationNode &node);
+    Type checkCall(FunctionCallNode &node);
+
+    Type parseType(const std::string &name, bool allowVoid);
+    static bool isAssignable(Type from, Type to);
+    static const char *typeName(Type type);
+    void error(const std::string &message);
+
+    std::map<std::string, Signature> functions_; // keyed by "Module.function"
+    std::map<std::string, Type> globals_;
+
+    // State of the function being checked
+    std::string module_;
+    std::string function_;
+    std::map<std::string, Type> parameters_;
+    std::map<std::string, Type> locals_;
+    size_t offset_ = 0;
+
+    std::map<const FunctionNode *, std::map<std::string, Type>> variables_;
+    std::vector<std::string> errors_;
+    std::vector<size_t> errorOffsets_;
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+// Contiguous buffer behind a std.array value. Exactly one of the vectors is
+// used, depending on the kind. Young arrays allocate from the Heap's
+// nursery, older ones from the default resource.
+struct TypedArray
+{
+    enum class Kind
+    {
+        Int64,
+        Double
+    };
+
+    explicit TypedArray(Kind kind = Kind::Int64, std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : kind(kind), ints(resource), doubles(resource)
+    {
+    }
+
+    Kind kind = Kind::Int64;
+    std::pmr::vector<int64_t> ints;
+    std::pmr::vector<double> doubles;
+
+    size_t size() const { return kind == Kind::Int64 ? ints.size() : doubles.size(); }
+    size_t capacity() const { return kind == Kind::Int64 ? ints.capacity() : doubles.capacity(); }
+    void reserve(size_t count) { kind == Kind::Int64 ? ints.reserve(count) : doubles.reserve(count); }
+    // The element as script text, e.g. "3" or "0.5"
+    std::string format(size_t index) const;
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <utility>
+
+// A string as the interpreter holds it in variables and on the frame stack.
+// Values are never modified in place, so long strings are shared by
+// reference count: binding an argument, reading a variable or returning a
+// result does not copy the characters. Short strings are stored inline,
+// where copying them is cheaper than counting references. Frames hold many
+// values, so the count lives with the string rather than in a shared_ptr.
+class Value
+{
+public:
+    // Longer strings are shared
+    static constexpr size_t kInlineLength = 256;
+
+    Value() = default;
+    Value(std::string text)
+    {
+        if (text.length() > kInlineLength)
+            shared_ = new Shared{{1}, std::move(text)};
+        else
+            inline_ = std::move(text);
+    }
+    Value(const char *text) : Value(std::string(text)) {}
+
+    Value(const Value &other) : inline_(other.inline_), shared_(other.shared_)
+    {
+        if (shared_)
+            shared_->references.fetch_add(1, std::memory_order_relaxed);
+    }
+    Value(Value &&other) noexcept : inline_(std::move(other.inline_)), shared_(std::exchange(other.shared_, nullptr)) {}
+    Value &operator=(const Value &other)
+    {
+        if (other.shared_)
+            other.shared_->references.fetch_add(1, std::memory_order_relaxed);
+        unshare();
+        inline_ = other.inline_;
+        shared_ = other.shared_;
+        return *this;
+    }
+    Value &operator=(Value &&other) noexcept
+    {
+        if (this != &other)
+        {
+            unshare();
+            inline_ = std::move(other.inline_);
+            shared_ = std::exchange(other.shared_, nullptr);
+        }
+        return *this;
+    }
+    ~Value() { unshare(); }
+
+    const std::string &str() const { return shared_ ? shared_->text : inline_; }
+    bool empty() const { return str().empty(); }
+
+    // The string for a caller that consumes it: moved out when no other
+    // Value shares it, copied otherwise
+    std::string release() &&
+    {
+        if (!shared_)
+            return std::move(inline_);
+        std::string text = shared_->references.load(std::memory_order_acquire) == 1 ? std::move(shared_->text)
+                                                                                    : shared_->text;
+        unshare();
+        return text;
+    }
+
+private:
+    struct Shared
+    {
+        std::atomic<size_t> references;
+        std::string text;
+    };
+
+    void unshare()
+    {
+        if (shared_ && shared_->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete shared_;
+        shared_ = nullptr;
+    }
+
+    std::string inline_;
+    Shared *shared_ = nullptr;
+};
@@ -0,0 +1,364 @@
+#include "json.h"
+
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+namespace
+{
+    const JsonValue nullValue;
+    const std::string emptyString;
+    const JsonValue::Array emptyArray;
+    const JsonValue::Object emptyObject;
+
+    class JsonParser
+    {
+    public:
+        explicit JsonParser(const std::string &text) : text_(text) {}
+
+        JsonValue parseDocument()
+        {
+            JsonValue value = parseValue();
+            skipWhitespace();
+            if (pos_ != text_.size())
+                fail("Trailing characters");
+            return value;
+        }
+
+    private:
+        [[noreturn]] void fail(const std::string &message) const
+        {
+            throw std::runtime_error("JSON error at offset " + std::to_string(pos_) + ": " + message);
+        }
+
+        void skipWhitespace()
+        {
+            while (pos_ < text_.size() && (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' || text_[pos_] == '\r'))
+                pos_++;
+        }
+
+        bool consumeLiteral(const char *literal)
+        {
+            size_t length = std::char_traits<char>::length(literal);
+            if (text_.compare(pos_, length, literal) != 0)
+                return false;
+            pos_ += length;
+            return true;
+        }
+
+        JsonValue parseValue()
+        {
+            skipWhitespace();
+            if (pos_ >= text_.size())
+                fail("Unexpected end of input");
+
+            char c = text_[pos_];
+            if (c == '{')
+                return parseObject();
+            if (c == '[')
+                return parseArray();
+            if (c == '"')
+                return JsonValue(parseString());
+            if (consumeLiteral("true"))
+                return JsonValue(true);
+            if (consumeLiteral("false"))
+                return JsonValue(false);
+            if (consumeLiteral("null"))
+                return JsonValue();
+            return parseNumber();
+        }
+
+        JsonValue parseObject()
+        {
+            pos_++; // '{'
+            JsonValue::Object object;
+            skipWhitespace();
+            if (pos_ < text_.size() && text_[pos_] == '}')
+            {
+                pos_++;
+                return JsonValue(std::move(object));
+            }
+            while (true)
+            {
+                skipWhitespace();
+                if (pos_ >= text_.size() || text_[pos_] != '"')
+                    fail("Expected object key");
+                std::string key = parseString();
+                skipWhitespace();
+                if (pos_ >= text_.size() || text_[pos_] != ':')
+                    fail("Expected ':'");
+                pos_++;
+                object[key] = parseValue();
+                skipWhitespace();
+                if (pos_ < text_.size() && text_[pos_] == ',')
+                {
+                    pos_++;
+                    continue;
+                }
+                if (pos_ < text_.size() && text_[pos_] == '}')
+                {
+                    pos_++;
+                    return JsonValue(std::move(object));
+                }
+                fail("Expected ',' or '}'");
+            }
+        }
+
+        JsonValue parseArray()
+        {
+            pos_++; // '['
+            JsonValue::Array array;
+            skipWhitespace();
+            if (pos_ < text_.size() && text_[pos_] == ']')
+            {
+                pos_++;
+                return JsonValue(std::move(array));
+            }
+            while (true)
+            {
+                array.push_back(parseValue());
+                skipWhitespace();
+                if (pos_ < text_.size() && text_[pos_] == ',')
+                {
+                    pos_++;
+                    continue;
+                }
+                if (pos_ < text_.size() && text_[pos_] == ']')
+                {
+                    pos_++;
+                    return JsonValue(std::move(array));
+                }
+                fail("Expected ',' or ']'");
+            }
+        }
+
+        static void appendUtf8(std::string &out, unsigned codepoint)
+        {
+            if (codepoint < 0x80)
+                out += static_cast<char>(codepoint);
+            else if (codepoint < 0x800)
+            {
+                out += static_cast<char>(0xC0 | (codepoint >> 6));
+                out += static_cast<char>(0x80 | (codepoint & 0x3F));
+            }
+            else if (codepoint < 0x10000)
+            {
+                out += static_cast<char>(0xE0 | (codepoint >> 12));
+                out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (codepoint & 0x3F));
+            }
+            else
+            {
+                out += static_cast<char>(0xF0 | (codepoint >> 18));
+                out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (codepoint & 0x3F));
+            }
+        }
+
+        unsigned parseHex4()
+        {
+            if (pos_ + 4 > text_.size())
+                fail("Truncated \\u escape");
+            unsigned value = 0;
+            for (int i = 0; i < 4; i++)
+            {
+                char c = text_[pos_++];
+                value <<= 4;
+                if (c >= '0' && c <= '9')
+                    value |= static_cast<unsigned>(c - '0');
+                else if (c >= 'a' && c <= 'f')
+                    value |= static_cast<unsigned>(c - 'a' + 10);
+                else if (c >= 'A' && c <= 'F')
+                    value |= static_cast<unsigned>(c - 'A' + 10);
+                else
+                    fail("Invalid \\u escape");
+            }
+            return value;
+        }
+
+        std::string parseString()
+        {
+            pos_++; // opening quote
+            std::string out;
+            while (pos_ < text_.size())
+            {
+                char c = text_[pos_++];
+                if (c == '"')
+                    return out;
+                if (c != '\\')
+                {
+                    out += c;
+                    continue;
+                }
+                if (pos_ >= text_.size())
+                    break;
+                char escape = text_[pos_++];
+                switch (escape)
+                {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u':
+                {
+                    unsigned codepoint = parseHex4();
+                    if (codepoint >= 0xD800 && codepoint < 0xDC00 && consumeLiteral("\\u"))
+                    {
+                        unsigned low = parseHex4();
+                        codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(out, codepoint);
+                    break;
+                }
+                default:
+                    fail("Invalid escape");
+                }
+            }
+            fail("Unterminated string");
+        }
+
+        JsonValue parseNumber()
+        {
+            size_t start = pos_;
+            if (pos_ < text_.size() && text_[pos_] == '-')
+                pos_++;
+            while (pos_ < text_.size() && (isdigit(static_cast<unsigned char>(text_[pos_])) || text_[pos_] == '.' ||
+                                           text_[pos_] == 'e' || text_[pos_] == 'E' || text_[pos_] == '+' || text_[pos_] == '-'))
+                pos_++;
+            if (start == pos_)
+                fail("Unexpected character");
+            try
+            {
+                return JsonValue(std::stod(text_.substr(start, pos_ - start)));
+            }
+            catch (...)
+            {
+                fail("Invalid number");
+            }
+        }
+
+        const std::string &text_;
+        size_t pos_ = 0;
+    };
+
+    void dumpString(std::string &out, const std::string &value)
+    {
+        out += '"';
+        for (char c : value)
+        {
+            switch (c)
+            {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    char buffer[8];
+                    std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                    out += buffer;
+                }
+                else
+                {
+                    out += c;
+                }
+            }
+        }
+        out += '"';
+    }
+}
+
+JsonValue JsonValue::parse(const std::string &text)
+{
+    return JsonParser(text).parseDocument();
+}
+
+std::string JsonValue::dump() const
+{
+    std::string out;
+    dumpTo(out);
+    return out;
+}
+
+void JsonValue::dumpTo(std::string &out) const
+{
+    switch (type_)
+    {
+    case Type::Null:
+        out += "null";
+        break;
+    case Type::Boolean:
+        out += boolean_ ? "true" : "false";
+        break;
+    case Type::Number:
+        if (std::floor(number_) == number_ && std::fabs(number_) < 1e15)
+            out += std::to_string(static_cast<int64_t>(number_));
+        else
+            out += std::to_string(number_);
+        break;
+    case Type::String:
+        dumpString(out, string_);
+        break;
+    case Type::Array:
+        out += '[';
+        for (size_t i = 0; i < array_->size(); i++)
+        {
+            if (i > 0)
+                out += ',';
+            (*array_)[i].dumpTo(out);
+        }
+        out += ']';
+        break;
+    case Type::Object:
+    {
+        out += '{';
+        bool first = true;
+        for (const auto &member : *object_)
+        {
+            if (!first)
+                out += ',';
+            first = false;
+            dumpString(out, member.first);
+            out += ':';
+            member.second.dumpTo(out);
+        }
+        out += '}';
+        break;
+    }
+    }
+}
+
+const std::string &JsonValue::asString() const
+{
+    return type_ == Type::String ? string_ : emptyString;
+}
+
+const JsonValue::Array &JsonValue::asArray() const
+{
+    return type_ == Type::Array ? *array_ : emptyArray;
+}
+
+const JsonValue::Object &JsonValue::asObject() const
+{
+    return type_ == Type::Object ? *object_ : emptyObject;
+}
+
+const JsonValue &JsonValue::operator[](const std::string &key) const
+{
+    if (type_ != Type::Object)
+        return nullValue;
+    auto it = object_->find(key);
+    return it != object_->end() ? it->second : nullValue;
+}
+
+bool JsonValue::has(const std::string &key) const
+{
+    return type_ == Type::Object && object_->count(key) > 0;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Minimal JSON value used for the LSP transport
+class JsonValue
+{
+public:
+    enum class Type
+    {
+        Null,
+        Boolean,
+        Number,
+        String,
+        Array,
+        Object
+    };
+
+    using Array = std::vector<JsonValue>;
+    using Object = std::map<std::string, JsonValue>;
+
+    JsonValue() = default;
+    JsonValue(std::nullptr_t) {}
+    JsonValue(bool value) : type_(Type::Boolean), boolean_(value) {}
+    JsonValue(int value) : type_(Type::Number), number_(value) {}
+    JsonValue(int64_t value) : type_(Type::Number), number_(static_cast<double>(value)) {}
+    JsonValue(size_t value) : type_(Type::Number), number_(static_cast<double>(value)) {}
+    JsonValue(double value) : type_(Type::Number), number_(value) {}
+    JsonValue(const char *value) : type_(Type::String), string_(value) {}
+    JsonValue(std::string value) : type_(Type::String), string_(std::move(value)) {}
+    JsonValue(Array value) : type_(Type::Array), array_(std::make_shared<Array>(std::move(value))) {}
+    JsonValue(Object value) : type_(Type::Object), object_(std::make_shared<Object>(std::move(value))) {}
+
+    // Throws std::runtime_error on malformed input
+    static JsonValue parse(const std::string &text);
+    std::string dump() const;
+
+    Type type() const { return type_; }
+    bool isNull() const { return type_ == Type::Null; }
+    bool isString() const { return type_ == Type::String; }
+    bool isNumber() const { return type_ == Type::Number; }
+    bool isArray() const { return type_ == Type::Array; }
+    bool isObject() const { return type_ == Type::Object; }
+
+    bool asBool() const { return type_ == Type::Boolean && boolean_; }
+    double asNumber() const { return type_ == Type::Number ? number_ : 0; }
+    int64_t asInt() const { return static_cast<int64_t>(asNumber()); }
+    const std::string &asString() const;
+    const Array &asArray() const;
+    const Object &asObject() const;
+
+    // Object member access; missing members (or non-objects) yield null
+    const JsonValue &operator[](const std::string &key) const;
+    bool has(const std::string &key) const;
+
+private:
+    void dumpTo(std::string &out) const;
+
+    Type type_ = Type::Null;
+    bool boolean_ = false;
+    double number_ = 0;
+    std::string string_;
+    std::shared_ptr<Array> array_;
+    std::shared_ptr<Object> object_;
+};
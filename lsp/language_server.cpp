@@ -0,0 +1,404 @@
+#include "language_server.h"
+#include "module_manager.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+
+namespace
+{
+    bool isWordChar(char c)
+    {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.';
+    }
+
+    // Dotted identifier under the cursor, e.g. "Math.square"
+    std::string wordAt(const std::string &text, size_t offset, size_t &start)
+    {
+        start = std::min(offset, text.size());
+        while (start > 0 && isWordChar(text[start - 1]))
+            start--;
+        size_t end = std::min(offset, text.size());
+        while (end < text.size() && isWordChar(text[end]))
+            end++;
+
+        std::string word = text.substr(start, end - start);
+        while (!word.empty() && word.back() == '.')
+            word.pop_back();
+        while (!word.empty() && word.front() == '.')
+        {
+            word.erase(0, 1);
+            start++;
+        }
+        return word;
+    }
+
+    std::string signatureOf(const FunctionNode &fn)
+    {
+        std::string signature = "func " + fn.name + "(";
+        for (size_t i = 0; i < fn.parameters.size(); i++)
+        {
+            if (i > 0)
+                signature += ", ";
+            signature += fn.parameters[i].name;
+            if (!fn.parameters[i].type.empty())
+                signature += ": " + fn.parameters[i].type;
+        }
+        return signature + ") -> " + fn.returnType;
+    }
+
+    // UTF-16 code units of the UTF-8 character starting with `lead`: two for
+    // the four-byte sequences outside the Basic Multilingual Plane
+    size_t utf16Units(unsigned char lead)
+    {
+        return lead >= 0xF0 ? 2 : 1;
+    }
+
+    bool isContinuationByte(unsigned char c)
+    {
+        return (c & 0xC0) == 0x80;
+    }
+
+    JsonValue markdown(const std::string &code)
+    {
+        return JsonValue(JsonValue::Object{
+            {"contents", JsonValue::Object{{"kind", "markdown"}, {"value", "```nexis\n" + code + "\n```"}}}});
+    }
+}
+
+LanguageServer::LanguageServer(std::istream &in, std::ostream &out) : in_(in), out_(out) {}
+
+int LanguageServer::run()
+{
+    std::string body;
+    while (readMessage(body))
+    {
+        JsonValue message;
+        try
+        {
+            message = JsonValue::parse(body);
+        }
+        catch (const std::exception &e)
+        {
+            replyError(JsonValue(), -32700, e.what());
+            continue;
+        }
+
+        if (message["method"].asString() == "exit")
+            return shutdownRequested_ ? 0 : 1;
+        handle(message);
+    }
+    return shutdownRequested_ ? 0 : 1;
+}
+
+bool LanguageServer::readMessage(std::string &body)
+{
+    size_t contentLength = 0;
+    bool haveLength = false;
+    std::string line;
+    while (std::getline(in_, line))
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line.empty())
+        {
+            if (haveLength)
+                break;
+            continue;
+        }
+        const std::string header = "Content-Length:";
+        if (line.compare(0, header.size(), header) == 0)
+        {
+            // A length that does not parse drops the message
+            const char *first = line.data() + header.size();
+            const char *last = line.data() + line.size();
+            while (first < last && *first == ' ')
+                first++;
+            auto parsed = std::from_chars(first, last, contentLength);
+            haveLength = parsed.ec == std::errc() && parsed.ptr == last;
+        }
+    }
+    if (!haveLength)
+        return false;
+
+    body.resize(contentLength);
+    in_.read(&body[0], static_cast<std::streamsize>(contentLength));
+    return static_cast<size_t>(in_.gcount()) == contentLength;
+}
+
+void LanguageServer::send(const JsonValue &message)
+{
+    std::string payload = message.dump();
+    out_ << "Content-Length: " << payload.size() << "\r\n\r\n" << payload;
+    out_.flush();
+}
+
+void LanguageServer::reply(const JsonValue &id, JsonValue result)
+{
+    send(JsonValue::Object{{"jsonrpc", "2.0"}, {"id", id}, {"result", std::move(result)}});
+}
+
+void LanguageServer::replyError(const JsonValue &id, int code, const std::string &message)
+{
+    send(JsonValue::Object{
+        {"jsonrpc", "2.0"}, {"id", id}, {"error", JsonValue::Object{{"code", code}, {"message", message}}}});
+}
+
+void LanguageServer::handle(const JsonValue &message)
+{
+    const std::string &method = message["method"].asString();
+    const JsonValue &params = message["params"];
+    bool isRequest = message.has("id");
+
+    try
+    {
+        if (method == "initialize")
+            reply(message["id"], onInitialize(params));
+        else if (method == "shutdown")
+        {
+            shutdownRequested_ = true;
+            reply(message["id"], JsonValue());
+        }
+        else if (method == "textDocument/didOpen")
+            onDidOpen(params);
+        else if (method == "textDocument/didChange")
+            onDidChange(params);
+        else if (method == "textDocument/didClose")
+            onDidClose(params);
+        else if (method == "textDocument/definition")
+            reply(message["id"], onDefinition(params));
+        else if (method == "textDocument/hover")
+            reply(message["id"], onHover(params));
+        else if (isRequest)
+            replyError(message["id"], -32601, "Method not found: " + method);
+    }
+    catch (const std::exception &e)
+    {
+        if (isRequest)
+            replyError(message["id"], -32603, e.what());
+    }
+}
+
+JsonValue LanguageServer::onInitialize(const JsonValue &params)
+{
+    // Byte columns when the client can take them, UTF-16 code units (the
+    // protocol's default) otherwise
+    const JsonValue &encodings = params["capabilities"]["general"]["positionEncodings"];
+    if (encodings.isArray())
+    {
+        utf8Positions_ = std::any_of(encodings.asArray().begin(), encodings.asArray().end(),
+                                     [](const JsonValue &encoding) { return encoding.isString() && encoding.asString() == "utf-8"; });
+    }
+    return JsonValue::Object{
+        {"capabilities", JsonValue::Object{
+                             {"positionEncoding", utf8Positions_ ? "utf-8" : "utf-16"},
+                             {"textDocumentSync", JsonValue::Object{{"openClose", true}, {"change", 2}}},
+                             {"definitionProvider", true},
+                             {"hoverProvider", true},
+                         }},
+        {"serverInfo", JsonValue::Object{{"name", "nexis-lsp"}}},
+    };
+}
+
+void LanguageServer::onDidOpen(const JsonValue &params)
+{
+    const JsonValue &item = params["textDocument"];
+    const std::string &uri = item["uri"].asString();
+
+    OpenDocument &open = documents_[uri];
+    open.document = std::make_unique<IncrementalDocument>(item["text"].asString());
+    open.version = item["version"].asInt();
+    publishDiagnostics(uri);
+}
+
+void LanguageServer::onDidChange(const JsonValue &params)
+{
+    const std::string &uri = params["textDocument"]["uri"].asString();
+    auto it = documents_.find(uri);
+    if (it == documents_.end())
+        return;
+
+    OpenDocument &open = it->second;
+    for (const auto &change : params["contentChanges"].asArray())
+    {
+        if (!change.has("range"))
+        {
+            open.document = std::make_unique<IncrementalDocument>(change["text"].asString());
+            continue;
+        }
+        size_t start = toOffset(*open.document, change["range"]["start"]);
+        size_t end = toOffset(*open.document, change["range"]["end"]);
+        open.document->applyEdit({start, end >= start ? end - start : 0, change["text"].asString()});
+    }
+    open.version = params["textDocument"]["version"].asInt();
+    publishDiagnostics(uri);
+}
+
+void LanguageServer::onDidClose(const JsonValue &params)
+{
+    auto it = documents_.find(params["textDocument"]["uri"].asString());
+    if (it == documents_.end())
+        return;
+
+    // Destroying the document unregisters its functions; a function it
+    // shared with another open document goes back to that one
+    documents_.erase(it);
+    for (const auto &entry : documents_)
+        entry.second.document->registerFunctions();
+}
+
+JsonValue LanguageServer::onDefinition(const JsonValue &params)
+{
+    const std::string &uri = params["textDocument"]["uri"].asString();
+    auto it = documents_.find(uri);
+    if (it == documents_.end())
+        return JsonValue();
+
+    const IncrementalDocument &document = *it->second.document;
+    size_t start = 0;
+    std::string word = wordAt(document.getText(), toOffset(document, params["position"]), start);
+    if (word.find('.') == std::string::npos)
+        return JsonValue();
+
+    FunctionLocation target = findFunction(word);
+    if (!target.node)
+        return JsonValue();
+
+    return JsonValue::Object{{"uri", *target.uri},
+                             {"range", toRange(*target.document, target.node->startOffset, target.node->endOffset)}};
+}
+
+JsonValue LanguageServer::onHover(const JsonValue &params)
+{
+    const std::string &uri = params["textDocument"]["uri"].asString();
+    auto it = documents_.find(uri);
+    if (it == documents_.end())
+        return JsonValue();
+
+    const IncrementalDocument &document = *it->second.document;
+    size_t offset = toOffset(document, params["position"]);
+    size_t start = 0;
+    std::string word = wordAt(document.getText(), offset, start);
+    if (word.empty())
+        return JsonValue();
+
+    if (word.find('.') != std::string::npos)
+    {
+        if (FunctionLocation function = findFunction(word); function.node)
+            return markdown(signatureOf(*function.node));
+        std::string builtin = ModuleManager::getInstance().builtinName(word);
+        if (!builtin.empty())
+            return markdown("builtin " + builtin);
+        return JsonValue();
+    }
+
+    // Function around the cursor: its own name, a parameter or a local
+    const FunctionNode *function = document.functionAt(offset);
+    if (!function)
+        return JsonValue();
+
+    std::string type = it->second.checker.variableType(*function, word);
+    if (type.empty())
+        return function->name == word ? markdown(signatureOf(*function)) : JsonValue();
+    return markdown(word + ": " + type);
+}
+
+// Syntax errors, or type errors once the document parses cleanly; until
+// then they would mostly be echoes of the syntax errors
+void LanguageServer::publishDiagnostics(const std::string &uri)
+{
+    OpenDocument &open = documents_[uri];
+    IncrementalDocument &document = *open.document;
+    JsonValue::Array diagnostics;
+    auto add = [&](size_t start, size_t end, const std::string &message) {
+        diagnostics.push_back(JsonValue::Object{
+            {"range", toRange(document, start, end)},
+            {"severity", 1},
+            {"source", "nexis"},
+            {"message", message},
+        });
+    };
+    for (const auto &diagnostic : document.getDiagnostics())
+        add(diagnostic.offset, diagnostic.offset + 1, diagnostic.message);
+
+    open.checker.check(document.getProgram());
+    if (diagnostics.empty())
+    {
+        const auto &errors = open.checker.getErrors();
+        const auto &offsets = open.checker.getErrorOffsets();
+        for (size_t i = 0; i < errors.size(); i++)
+        {
+            // The whole first line of the function or module
+            size_t end = document.getText().find('\n', offsets[i]);
+            add(offsets[i], end == std::string::npos ? document.getText().size() : end, errors[i]);
+        }
+    }
+
+    send(JsonValue::Object{
+        {"jsonrpc", "2.0"},
+        {"method", "textDocument/publishDiagnostics"},
+        {"params", JsonValue::Object{{"uri", uri}, {"version", documents_[uri].version}, {"diagnostics", diagnostics}}},
+    });
+}
+
+LanguageServer::FunctionLocation LanguageServer::findFunction(const std::string &qualifiedName) const
+{
+    size_t dotPos = qualifiedName.find_last_of('.');
+    if (dotPos == std::string::npos)
+        return {};
+
+    std::string module = qualifiedName.substr(0, dotPos);
+    std::string name = qualifiedName.substr(dotPos + 1);
+    for (const auto &entry : documents_)
+    {
+        if (const FunctionNode *node = entry.second.document->findFunction(module, name))
+            return {&entry.first, entry.second.document.get(), node};
+    }
+    return {};
+}
+
+size_t LanguageServer::toOffset(const IncrementalDocument &document, const JsonValue &position) const
+{
+    int line = static_cast<int>(position["line"].asInt()) + 1;
+    int64_t character = std::max<int64_t>(position["character"].asInt(), 0);
+    if (utf8Positions_)
+        return document.offsetOf(line, static_cast<int>(character) + 1);
+
+    // Walk the line counting UTF-16 code units; a column past its end
+    // clamps to the newline
+    const std::string &text = document.getText();
+    size_t offset = document.offsetOf(line, 1);
+    for (int64_t units = 0; offset < text.size() && text[offset] != '\n';)
+    {
+        units += static_cast<int64_t>(utf16Units(static_cast<unsigned char>(text[offset])));
+        if (units > character)
+            break;
+        offset++;
+        while (offset < text.size() && isContinuationByte(static_cast<unsigned char>(text[offset])))
+            offset++;
+    }
+    return offset;
+}
+
+JsonValue LanguageServer::toRange(const IncrementalDocument &document, size_t start, size_t end) const
+{
+    auto toPosition = [&](size_t offset) {
+        auto position = document.positionOf(offset);
+        size_t character = static_cast<size_t>(position.second - 1);
+        if (!utf8Positions_)
+        {
+            const std::string &text = document.getText();
+            character = 0;
+            for (size_t i = offset - static_cast<size_t>(position.second - 1); i < offset; i++)
+            {
+                if (!isContinuationByte(static_cast<unsigned char>(text[i])))
+                    character += utf16Units(static_cast<unsigned char>(text[i]));
+            }
+        }
+        return JsonValue::Object{{"line", position.first - 1}, {"character", character}};
+    };
+    return JsonValue::Object{
+        {"start", toPosition(start)},
+        {"end", toPosition(std::min(end, document.getText().size()))},
+    };
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "json.h"
+#include "incremental_parser.h"
+#include "type_checker.h"
+
+#include <istream>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Language Server Protocol front end over stdio. Open documents stay parsed
+// (and registered with the ModuleManager) until they are closed and are
+// updated incrementally on every change; definition and hover queries are
+// answered from each document's declaration index and type checker.
+class LanguageServer
+{
+public:
+    LanguageServer(std::istream &in, std::ostream &out);
+
+    // Serves requests until `exit`; returns the process exit code
+    int run();
+
+private:
+    struct OpenDocument
+    {
+        std::unique_ptr<IncrementalDocument> document;
+        // Checked after every change; its errors become diagnostics and its
+        // variable types answer hovers
+        TypeChecker checker;
+        int64_t version = 0;
+    };
+
+    struct FunctionLocation
+    {
+        const std::string *uri = nullptr;
+        const IncrementalDocument *document = nullptr;
+        const FunctionNode *node = nullptr;
+    };
+
+    bool readMessage(std::string &body);
+    void send(const JsonValue &message);
+    void reply(const JsonValue &id, JsonValue result);
+    void replyError(const JsonValue &id, int code, const std::string &message);
+    void handle(const JsonValue &message);
+
+    JsonValue onInitialize(const JsonValue &params);
+    void onDidOpen(const JsonValue &params);
+    void onDidChange(const JsonValue &params);
+    void onDidClose(const JsonValue &params);
+    JsonValue onDefinition(const JsonValue &params);
+    JsonValue onHover(const JsonValue &params);
+
+    void publishDiagnostics(const std::string &uri);
+    FunctionLocation findFunction(const std::string &qualifiedName) const;
+
+    // LSP positions are a line and a character, counted in UTF-16 code units
+    // unless initialize settled on UTF-8
+    size_t toOffset(const IncrementalDocument &document, const JsonValue &position) const;
+    JsonValue toRange(const IncrementalDocument &document, size_t start, size_t end) const;
+
+    std::istream &in_;
+    std::ostream &out_;
+    std::map<std::string, OpenDocument> documents_;
+    bool shutdownRequested_ = false;
+    bool utf8Positions_ = false;
+};
@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+"""Scripted LSP client that measures nexis-lsp response times.
+
+Opens a document (a .nx file, or a generated one with --functions N), then
+times keystroke edits (didChange until publishDiagnostics arrives),
+go-to-definition and hover requests, and prints latency percentiles.
+
+    lsp/lsp_client.py build/nexis-lsp --functions 5000 --rounds 200
+    lsp/lsp_client.py build/nexis-lsp example.nx
+"""
+
+import argparse
+import json
+import statistics
+import subprocess
+import sys
+import time
+
+
+class Client:
+    def __init__(self, server):
+        self.proc = subprocess.Popen([server], stdin=subprocess.PIPE, stdout=subprocess.PIPE)
+        self.next_id = 1
+
+    def send(self, message):
+        payload = json.dumps(message).encode()
+        self.proc.stdin.write(b"Content-Length: %d\r\n\r\n" % len(payload) + payload)
+        self.proc.stdin.flush()
+
+    def receive(self):
+        length = None
+        while True:
+            line = self.proc.stdout.readline()
+            if not line:
+                raise RuntimeError("server closed the connection")
+            line = line.strip()
+            if not line:
+                break
+            if line.lower().startswith(b"content-length:"):
+                length = int(line.split(b":")[1])
+        return json.loads(self.proc.stdout.read(length))
+
+    def request(self, method, params):
+        request_id = self.next_id
+        self.next_id += 1
+        self.send({"jsonrpc": "2.0", "id": request_id, "method": method, "params": params})
+        while True:
+            message = self.receive()
+            if message.get("id") == request_id:
+                return message
+
+    def notify(self, method, params):
+        self.send({"jsonrpc": "2.0", "method": method, "params": params})
+
+    def wait_for(self, method):
+        while True:
+            message = self.receive()
+            if message.get("method") == method:
+                return message
+
+    def close(self):
+        self.request("shutdown", None)
+        self.notify("exit", None)
+        self.proc.wait(timeout=5)
+
+
+def generate(functions):
+    lines = []
+    for m in range((functions + 99) // 100):
+        lines.append("module Gen%d {" % m)
+        lines.append("    import std.math;")
+        for f in range(m * 100, min(functions, (m + 1) * 100)):
+            lines.append("    func f%d(x: int, y: int) -> int {" % f)
+            lines.append("        let total: int = math.add(x, y);")
+            lines.append("        return total * %d;" % f)
+            lines.append("    }")
+        lines.append("}")
+    lines.append("module Main {")
+    lines.append("    import Gen0;")
+    lines.append("    func main() -> int {")
+    lines.append("        let value = Gen0.f1(2, 3);")
+    lines.append("        return value;")
+    lines.append("    }")
+    lines.append("}")
+    return "\n".join(lines) + "\n"
+
+
+def find(text, needle):
+    offset = text.index(needle)
+    line = text.count("\n", 0, offset)
+    character = offset - (text.rfind("\n", 0, offset) + 1)
+    return {"line": line, "character": character}
+
+
+def report(name, samples):
+    samples = sorted(samples)
+    p95 = samples[min(len(samples) - 1, int(len(samples) * 0.95))]
+    print("%-12s n=%-5d p50=%7.3f ms  p95=%7.3f ms  max=%7.3f ms"
+          % (name, len(samples), statistics.median(samples), p95, samples[-1]))
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("server")
+    parser.add_argument("source", nargs="?")
+    parser.add_argument("--functions", type=int, default=1000)
+    parser.add_argument("--rounds", type=int, default=100)
+    args = parser.parse_args()
+
+    text = open(args.source).read() if args.source else generate(args.functions)
+    uri = "file:///bench.nx"
+
+    client = Client(args.server)
+    client.request("initialize", {"processId": None, "rootUri": None, "capabilities": {}})
+    client.notify("initialized", {})
+
+    start = time.perf_counter()
+    client.notify("textDocument/didOpen",
+                  {"textDocument": {"uri": uri, "languageId": "nexis", "version": 1, "text": text}})
+    client.wait_for("textDocument/publishDiagnostics")
+    print("open        %.3f ms (%d bytes)" % ((time.perf_counter() - start) * 1000, len(text)))
+
+    edit_at = find(text, "return")
+    call_at = find(text, "Gen0.f1") if "Gen0.f1" in text else edit_at
+    local_at = find(text, "value") if "value" in text else edit_at
+
+    edits, definitions, hovers = [], [], []
+    version = 1
+    for _ in range(args.rounds):
+        for change in ({"range": {"start": edit_at, "end": edit_at}, "text": " "},
+                       {"range": {"start": edit_at, "end": dict(edit_at, character=edit_at["character"] + 1)},
+                        "text": ""}):
+            version += 1
+            start = time.perf_counter()
+            client.notify("textDocument/didChange",
+                          {"textDocument": {"uri": uri, "version": version}, "contentChanges": [change]})
+            client.wait_for("textDocument/publishDiagnostics")
+            edits.append((time.perf_counter() - start) * 1000)
+
+        start = time.perf_counter()
+        client.request("textDocument/definition", {"textDocument": {"uri": uri}, "position": call_at})
+        definitions.append((time.perf_counter() - start) * 1000)
+
+        start = time.perf_counter()
+        client.request("textDocument/hover", {"textDocument": {"uri": uri}, "position": local_at})
+        hovers.append((time.perf_counter() - start) * 1000)
+
+    report("edit", edits)
+    report("definition", definitions)
+    report("hover", hovers)
+    client.close()
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
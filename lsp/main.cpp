@@ -0,0 +1,15 @@
+#include "language_server.h"
+#include "standard_library.h"
+
+#include <iostream>
+
+int main()
+{
+    std::ios::sync_with_stdio(false);
+
+    // Builtins are registered once and stay resident for hover and import checks
+    registerStandardModules();
+
+    LanguageServer server(std::cin, std::cout);
+    return server.run();
+}
@@ -0,0 +1,245 @@
+#include "nexis_runtime.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* ---- string arena ---- */
+
+typedef struct nx_chunk
+{
+    struct nx_chunk *next;
+    size_t used;
+    size_t capacity;
+    char data[];
+} nx_chunk;
+
+enum { NX_CHUNK_SIZE = 1 << 20 };
+
+static nx_chunk *nx_chunks = NULL;
+
+static char *nx_allocate(size_t size)
+{
+    if (!nx_chunks || nx_chunks->capacity - nx_chunks->used < size)
+    {
+        size_t capacity = size > NX_CHUNK_SIZE ? size : NX_CHUNK_SIZE;
+        nx_chunk *chunk = malloc(sizeof(nx_chunk) + capacity);
+        if (!chunk)
+            nx_panic("out of memory");
+        chunk->next = nx_chunks;
+        chunk->used = 0;
+        chunk->capacity = capacity;
+        nx_chunks = chunk;
+    }
+    char *result = nx_chunks->data + nx_chunks->used;
+    nx_chunks->used += size;
+    return result;
+}
+
+void nx_runtime_reset(void)
+{
+    while (nx_chunks)
+    {
+        nx_chunk *next = nx_chunks->next;
+        free(nx_chunks);
+        nx_chunks = next;
+    }
+}
+
+/* ---- strings ---- */
+
+nx_string nx_concat(size_t count, const nx_string *parts)
+{
+    size_t length = 0;
+    for (size_t i = 0; i < count; i++)
+        length += parts[i].length;
+
+    char *data = nx_allocate(length);
+    char *cursor = data;
+    for (size_t i = 0; i < count; i++)
+    {
+        memcpy(cursor, parts[i].data, parts[i].length);
+        cursor += parts[i].length;
+    }
+    return (nx_string){data, length};
+}
+
+nx_string nx_int_to_string(int64_t value)
+{
+    char buffer[24];
+    char *end = buffer + sizeof(buffer);
+    char *cursor = end;
+    uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+    do
+    {
+        *--cursor = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    if (value < 0)
+        *--cursor = '-';
+
+    size_t length = (size_t)(end - cursor);
+    char *data = nx_allocate(length);
+    memcpy(data, cursor, length);
+    return (nx_string){data, length};
+}
+
+nx_string nx_bool_to_string(int value)
+{
+    return value ? NX_STR("true") : NX_STR("false");
+}
+
+int nx_string_equals(nx_string left, nx_string right)
+{
+    return left.length == right.length && memcmp(left.data, right.data, left.length) == 0;
+}
+
+int nx_truthy(nx_string value)
+{
+    if (nx_string_equals(value, NX_STR("true")))
+        return 1;
+    if (nx_string_equals(value, NX_STR("false")))
+        return 0;
+
+    size_t i = 0;
+    while (i < value.length && (value.data[i] == ' ' || (value.data[i] >= '\t' && value.data[i] <= '\r')))
+        i++;
+    if (i < value.length && (value.data[i] == '+' || value.data[i] == '-'))
+        i++;
+    if (i < value.length && value.data[i] >= '0' && value.data[i] <= '9')
+    {
+        for (; i < value.length && value.data[i] >= '0' && value.data[i] <= '9'; i++)
+        {
+            if (value.data[i] != '0')
+                return 1;
+        }
+        return 0;
+    }
+    return value.length != 0;
+}
+
+/* ---- integers ---- */
+
+int64_t nx_div(int64_t left, int64_t right)
+{
+    if (right == 0)
+        nx_panic("division by zero");
+    if (left == INT32_MIN && right == -1)
+        return INT32_MIN;
+    if (left == INT64_MIN && right == -1)
+        nx_panic("integer division overflows int64");
+    return left / right;
+}
+
+int64_t nx_wide_add(int64_t left, int64_t right)
+{
+    int64_t result;
+    if (__builtin_add_overflow(left, right, &result))
+        nx_panic("integer addition overflows int64");
+    return result;
+}
+
+int64_t nx_wide_sub(int64_t left, int64_t right)
+{
+    int64_t result;
+    if (__builtin_sub_overflow(left, right, &result))
+        nx_panic("integer subtraction overflows int64");
+    return result;
+}
+
+int64_t nx_wide_mul(int64_t left, int64_t right)
+{
+    int64_t result;
+    if (__builtin_mul_overflow(left, right, &result))
+        nx_panic("integer multiplication overflows int64");
+    return result;
+}
+
+/* ---- std.math ---- */
+
+int64_t nx_math_add(int64_t left, int64_t right)
+{
+    int64_t result;
+    if (__builtin_add_overflow(left, right, &result))
+        nx_panic("math.add overflows int64");
+    return result;
+}
+
+int64_t nx_math_subtract(int64_t left, int64_t right)
+{
+    int64_t result;
+    if (__builtin_sub_overflow(left, right, &result))
+        nx_panic("math.subtract overflows int64");
+    return result;
+}
+
+int64_t nx_math_multiply(int64_t left, int64_t right)
+{
+    int64_t result;
+    if (__builtin_mul_overflow(left, right, &result))
+        nx_panic("math.multiply overflows int64");
+    return result;
+}
+
+/* ---- std.io ---- */
+
+enum { NX_OUTPUT_CAPACITY = 64 * 1024 };
+
+static char nx_output[NX_OUTPUT_CAPACITY];
+static size_t nx_output_used = 0;
+static int nx_output_mode = -1; /* -1 unknown, 0 full, 1 line */
+
+static void nx_write_all(const char *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t written = write(STDOUT_FILENO, data, size);
+        if (written <= 0)
+            return;
+        data += written;
+        size -= (size_t)written;
+    }
+}
+
+void nx_io_flush(void)
+{
+    nx_write_all(nx_output, nx_output_used);
+    nx_output_used = 0;
+}
+
+static void nx_output_append(const char *data, size_t size)
+{
+    if (nx_output_used + size > NX_OUTPUT_CAPACITY)
+    {
+        nx_io_flush();
+        if (size >= NX_OUTPUT_CAPACITY)
+        {
+            nx_write_all(data, size);
+            return;
+        }
+    }
+    memcpy(nx_output + nx_output_used, data, size);
+    nx_output_used += size;
+}
+
+nx_string nx_io_write_line(nx_string text)
+{
+    if (nx_output_mode < 0)
+        nx_output_mode = isatty(STDOUT_FILENO) ? 1 : 0;
+
+    nx_output_append(text.data, text.length);
+    nx_output_append("\n", 1);
+    if (nx_output_mode == 1)
+        nx_io_flush();
+    return text;
+}
+
+/* ---- errors ---- */
+
+void nx_panic(const char *message)
+{
+    nx_io_flush();
+    fprintf(stderr, "Runtime error: %s\n", message);
+    exit(1);
+}
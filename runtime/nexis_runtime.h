@@ -0,0 +1,74 @@
+#ifndef NEXIS_RUNTIME_H
+#define NEXIS_RUNTIME_H
+
+/* Runtime support for C emitted by `nexis_compiler --emit-c`. Strings are
+ * immutable (pointer, length) pairs; every string built at run time lives in
+ * a process-wide arena that is only released by nx_runtime_reset(). */
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct
+{
+    const char *data;
+    size_t length;
+} nx_string;
+
+/* String literal with a compile-time length */
+#define NX_STR(literal) ((nx_string){(literal), sizeof(literal) - 1})
+
+nx_string nx_concat(size_t count, const nx_string *parts);
+nx_string nx_int_to_string(int64_t value);
+nx_string nx_bool_to_string(int value);
+int nx_string_equals(nx_string left, nx_string right);
+
+/* Same rules as the interpreter: "true"/"false", then a leading integer,
+ * then non-empty */
+int nx_truthy(nx_string value);
+
+/* Integer arithmetic wraps around at 32 bits like the interpreter's. Operands
+ * already wider than that (from std.math) are computed exactly, and the
+ * result panics where the interpreter would leave 64 bits. */
+static inline int nx_is_int32(int64_t value) { return value >= INT32_MIN && value <= INT32_MAX; }
+int64_t nx_wide_add(int64_t left, int64_t right);
+int64_t nx_wide_sub(int64_t left, int64_t right);
+int64_t nx_wide_mul(int64_t left, int64_t right);
+
+static inline int64_t nx_add(int64_t left, int64_t right)
+{
+    if (nx_is_int32(left) && nx_is_int32(right))
+        return (int32_t)((uint32_t)left + (uint32_t)right);
+    return nx_wide_add(left, right);
+}
+static inline int64_t nx_sub(int64_t left, int64_t right)
+{
+    if (nx_is_int32(left) && nx_is_int32(right))
+        return (int32_t)((uint32_t)left - (uint32_t)right);
+    return nx_wide_sub(left, right);
+}
+static inline int64_t nx_mul(int64_t left, int64_t right)
+{
+    if (nx_is_int32(left) && nx_is_int32(right))
+        return (int32_t)((uint32_t)left * (uint32_t)right);
+    return nx_wide_mul(left, right);
+}
+int64_t nx_div(int64_t left, int64_t right);
+
+/* std.math: exact int64 arithmetic. The interpreter continues with
+ * arbitrary precision; native code has none and panics instead */
+int64_t nx_math_add(int64_t left, int64_t right);
+int64_t nx_math_subtract(int64_t left, int64_t right);
+int64_t nx_math_multiply(int64_t left, int64_t right);
+
+/* std.io: io.print and io.println both end the line. Output is buffered like
+ * the interpreter's and line-buffered on a TTY */
+nx_string nx_io_write_line(nx_string text);
+void nx_io_flush(void);
+
+/* Reports a runtime error, flushes pending output and exits with status 1 */
+void nx_panic(const char *message);
+
+/* Frees every string allocated so far */
+void nx_runtime_reset(void);
+
+#endif
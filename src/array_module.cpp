@@ -0,0 +1,265 @@
+#include "typed_array.h"
+#include "heap.h"
+#include "standard_library.h"
+#include "module_manager.h"
+#include "evaluator.h"
+#include "simd_kernels.h"
+
+#include <charconv>
+#include <stdexcept>
+
+namespace
+{
+    using Arguments = std::vector<std::unique_ptr<ASTNode>>;
+
+    [[noreturn]] void fail(const std::string &function, const std::string &message)
+    {
+        throw std::runtime_error("array." + function + ": " + message);
+    }
+
+    void expectArguments(const std::string &function, const Arguments &args, size_t count)
+    {
+        if (args.size() != count)
+            fail(function, "expects " + std::to_string(count) + " arguments, got " + std::to_string(args.size()));
+    }
+
+    int64_t toInt(const std::string &function, const std::string &text)
+    {
+        int64_t value;
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (error != std::errc() || end != text.data() + text.size())
+            fail(function, "'" + text + "' is not an int64");
+        return value;
+    }
+
+    double toDouble(const std::string &function, const std::string &text)
+    {
+        double value;
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (error != std::errc() || end != text.data() + text.size())
+            fail(function, "'" + text + "' is not a number");
+        return value;
+    }
+
+    // Shortest text that reads back as the same double
+    std::string formatDouble(double value)
+    {
+        char buffer[32];
+        auto result = std::to_chars(buffer, buffer + sizeof buffer, value);
+        return std::string(buffer, result.ptr);
+    }
+
+    const TypedArray &argumentArray(const std::string &function, const Arguments &args, size_t index)
+    {
+        std::string handle = evaluateNode(args[index].get());
+        const TypedArray *array = Heap::getInstance().findArray(handle);
+        if (!array)
+            fail(function, "'" + handle + "' is not an array");
+        return *array;
+    }
+
+    const TypedArray &nonEmptyArray(const std::string &function, const Arguments &args)
+    {
+        expectArguments(function, args, 1);
+        const TypedArray &array = argumentArray(function, args, 0);
+        if (array.size() == 0)
+            fail(function, "empty array");
+        return array;
+    }
+
+    simd::Arithmetic parseArithmetic(const std::string &function, const std::string &op)
+    {
+        if (op == "+")
+            return simd::Arithmetic::Add;
+        if (op == "-")
+            return simd::Arithmetic::Subtract;
+        if (op == "*")
+            return simd::Arithmetic::Multiply;
+        if (op == "/")
+            return simd::Arithmetic::Divide;
+        fail(function, "unknown operator '" + op + "'");
+    }
+
+    simd::Comparison parseComparison(const std::string &function, const std::string &op)
+    {
+        if (op == "<")
+            return simd::Comparison::Less;
+        if (op == "<=")
+            return simd::Comparison::LessEqual;
+        if (op == ">")
+            return simd::Comparison::Greater;
+        if (op == ">=")
+            return simd::Comparison::GreaterEqual;
+        if (op == "==")
+            return simd::Comparison::Equal;
+        if (op == "!=")
+            return simd::Comparison::NotEqual;
+        fail(function, "unknown comparison '" + op + "'");
+    }
+
+    std::string fromArguments(const Arguments &args, TypedArray::Kind kind)
+    {
+        auto [handle, array] = Heap::getInstance().newArray(kind, args.size());
+        for (const auto &arg : args)
+        {
+            std::string value = evaluateNode(arg.get());
+            if (kind == TypedArray::Kind::Int64)
+                array->ints.push_back(toInt("ints", value));
+            else
+                array->doubles.push_back(toDouble("doubles", value));
+        }
+        return handle;
+    }
+}
+
+std::string TypedArray::format(size_t index) const
+{
+    return kind == Kind::Int64 ? std::to_string(ints[index]) : formatDouble(doubles[index]);
+}
+
+void registerArrayModule()
+{
+    auto &mm = ModuleManager::getInstance();
+
+    // array.range(start, end): the int64s start, start + 1, ..., end - 1
+    mm.registerFunction("std.array", "range", [](const Arguments &args) {
+        expectArguments("range", args, 2);
+        int64_t start = toInt("range", evaluateNode(args[0].get()));
+        int64_t end = toInt("range", evaluateNode(args[1].get()));
+        uint64_t count = end > start ? static_cast<uint64_t>(end) - static_cast<uint64_t>(start) : 0;
+        auto [handle, array] = Heap::getInstance().newArray(TypedArray::Kind::Int64, count);
+        for (int64_t value = start; value < end; value++)
+            array->ints.push_back(value);
+        return handle;
+    });
+
+    mm.registerFunction("std.array", "ints", [](const Arguments &args) {
+        return fromArguments(args, TypedArray::Kind::Int64);
+    });
+
+    mm.registerFunction("std.array", "doubles", [](const Arguments &args) {
+        return fromArguments(args, TypedArray::Kind::Double);
+    });
+
+    mm.registerFunction("std.array", "length", [](const Arguments &args) {
+        expectArguments("length", args, 1);
+        return std::to_string(argumentArray("length", args, 0).size());
+    });
+
+    mm.registerFunction("std.array", "get", [](const Arguments &args) {
+        expectArguments("get", args, 2);
+        const TypedArray &array = argumentArray("get", args, 0);
+        int64_t index = toInt("get", evaluateNode(args[1].get()));
+        if (index < 0 || static_cast<uint64_t>(index) >= array.size())
+            fail("get", "index " + std::to_string(index) + " out of range for length " + std::to_string(array.size()));
+        return array.format(static_cast<size_t>(index));
+    });
+
+    mm.registerFunction("std.array", "toString", [](const Arguments &args) {
+        expectArguments("toString", args, 1);
+        const TypedArray &array = argumentArray("toString", args, 0);
+        std::string text = "[";
+        for (size_t i = 0; i < array.size(); i++)
+        {
+            if (i)
+                text += ", ";
+            text += array.format(i);
+        }
+        return text + "]";
+    });
+
+    mm.registerFunction("std.array", "sum", [](const Arguments &args) {
+        expectArguments("sum", args, 1);
+        const TypedArray &array = argumentArray("sum", args, 0);
+        if (array.kind == TypedArray::Kind::Int64)
+            return std::to_string(simd::sum(array.ints.data(), array.ints.size()));
+        return formatDouble(simd::sum(array.doubles.data(), array.doubles.size()));
+    });
+
+    mm.registerFunction("std.array", "dot", [](const Arguments &args) {
+        expectArguments("dot", args, 2);
+        const TypedArray &left = argumentArray("dot", args, 0);
+        const TypedArray &right = argumentArray("dot", args, 1);
+        if (left.kind != right.kind || left.size() != right.size())
+            fail("dot", "arrays differ in kind or length");
+        if (left.kind == TypedArray::Kind::Int64)
+            return std::to_string(simd::dot(left.ints.data(), right.ints.data(), left.ints.size()));
+        return formatDouble(simd::dot(left.doubles.data(), right.doubles.data(), left.doubles.size()));
+    });
+
+    mm.registerFunction("std.array", "min", [](const Arguments &args) {
+        const TypedArray &array = nonEmptyArray("min", args);
+        if (array.kind == TypedArray::Kind::Int64)
+            return std::to_string(simd::min(array.ints.data(), array.ints.size()));
+        return formatDouble(simd::min(array.doubles.data(), array.doubles.size()));
+    });
+
+    mm.registerFunction("std.array", "max", [](const Arguments &args) {
+        const TypedArray &array = nonEmptyArray("max", args);
+        if (array.kind == TypedArray::Kind::Int64)
+            return std::to_string(simd::max(array.ints.data(), array.ints.size()));
+        return formatDouble(simd::max(array.doubles.data(), array.doubles.size()));
+    });
+
+    // array.map(a, "*", 3): a new array with every element combined with 3
+    mm.registerFunction("std.array", "map", [](const Arguments &args) {
+        expectArguments("map", args, 3);
+        const TypedArray &array = argumentArray("map", args, 0);
+        simd::Arithmetic operation = parseArithmetic("map", evaluateNode(args[1].get()));
+        std::string operand = evaluateNode(args[2].get());
+
+        if (array.kind == TypedArray::Kind::Int64)
+        {
+            int64_t value = toInt("map", operand);
+            if (operation == simd::Arithmetic::Divide && value == 0)
+                fail("map", "division by zero");
+            auto [handle, result] = Heap::getInstance().newArray(array.kind, array.size());
+            result->ints.resize(array.ints.size());
+            simd::map(operation, array.ints.data(), value, result->ints.data(), array.ints.size());
+            return handle;
+        }
+        double value = toDouble("map", operand);
+        auto [handle, result] = Heap::getInstance().newArray(array.kind, array.size());
+        result->doubles.resize(array.doubles.size());
+        simd::map(operation, array.doubles.data(), value, result->doubles.data(), array.doubles.size());
+        return handle;
+    });
+
+    // array.filter(a, ">", 10): a new array of the elements greater than 10
+    mm.registerFunction("std.array", "filter", [](const Arguments &args) {
+        expectArguments("filter", args, 3);
+        const TypedArray &array = argumentArray("filter", args, 0);
+        simd::Comparison comparison = parseComparison("filter", evaluateNode(args[1].get()));
+        std::string operand = evaluateNode(args[2].get());
+
+        // The kernels store four lanes at a time past the last match
+        if (array.kind == TypedArray::Kind::Int64)
+        {
+            int64_t value = toInt("filter", operand);
+            auto [handle, result] = Heap::getInstance().newArray(array.kind, array.size() + 4);
+            result->ints.resize(array.ints.size() + 4);
+            result->ints.resize(
+                simd::filter(comparison, array.ints.data(), value, result->ints.data(), array.ints.size()));
+            return handle;
+        }
+        double value = toDouble("filter", operand);
+        auto [handle, result] = Heap::getInstance().newArray(array.kind, array.size() + 4);
+        result->doubles.resize(array.doubles.size() + 4);
+        result->doubles.resize(
+            simd::filter(comparison, array.doubles.data(), value, result->doubles.data(), array.doubles.size()));
+        return handle;
+    });
+
+    mm.registerFunction("std.array", "sort", [](const Arguments &args) {
+        expectArguments("sort", args, 1);
+        const TypedArray &array = argumentArray("sort", args, 0);
+        auto [handle, result] = Heap::getInstance().newArray(array.kind, array.size());
+        result->ints = array.ints;
+        result->doubles = array.doubles;
+        if (result->kind == TypedArray::Kind::Int64)
+            simd::sort(result->ints.data(), result->ints.size());
+        else
+            simd::sort(result->doubles.data(), result->doubles.size());
+        return handle;
+    });
+}
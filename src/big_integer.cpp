@@ -0,0 +1,386 @@
+#include "big_integer.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace
+{
+    constexpr uint32_t kDecimalChunk = 1000000000; // 10^9 fits in a limb
+    constexpr int kDecimalChunkDigits = 9;
+
+    // limbs = limbs * factor + addend
+    void multiplyAdd(std::vector<uint32_t> &limbs, uint32_t factor, uint32_t addend)
+    {
+        uint64_t carry = addend;
+        for (uint32_t &limb : limbs)
+        {
+            uint64_t value = uint64_t(limb) * factor + carry;
+            limb = static_cast<uint32_t>(value);
+            carry = value >> 32;
+        }
+        if (carry)
+            limbs.push_back(static_cast<uint32_t>(carry));
+    }
+
+    // limbs /= divisor, returning the remainder
+    uint32_t divideSmall(std::vector<uint32_t> &limbs, uint32_t divisor)
+    {
+        uint64_t remainder = 0;
+        for (size_t i = limbs.size(); i-- > 0;)
+        {
+            uint64_t value = (remainder << 32) | limbs[i];
+            limbs[i] = static_cast<uint32_t>(value / divisor);
+            remainder = value % divisor;
+        }
+        while (!limbs.empty() && limbs.back() == 0)
+            limbs.pop_back();
+        return static_cast<uint32_t>(remainder);
+    }
+
+    // result += value << (32 * shift); result is large enough for the sum
+    void addShifted(std::vector<uint32_t> &result, const std::vector<uint32_t> &value, size_t shift)
+    {
+        uint64_t carry = 0;
+        size_t i = 0;
+        for (; i < value.size(); i++)
+        {
+            uint64_t sum = uint64_t(result[i + shift]) + value[i] + carry;
+            result[i + shift] = static_cast<uint32_t>(sum);
+            carry = sum >> 32;
+        }
+        for (i += shift; carry; i++)
+        {
+            uint64_t sum = uint64_t(result[i]) + carry;
+            result[i] = static_cast<uint32_t>(sum);
+            carry = sum >> 32;
+        }
+    }
+
+    // Like std::stoll without the exceptions: false when there are no
+    // digits or the value does not fit
+    bool parseInt64(const std::string &text, int64_t &value)
+    {
+        size_t i = 0;
+        while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i])))
+            i++;
+        bool negative = false;
+        if (i < text.size() && (text[i] == '+' || text[i] == '-'))
+            negative = text[i++] == '-';
+        if (i == text.size() || !std::isdigit(static_cast<unsigned char>(text[i])))
+            return false;
+
+        // Accumulate negatively so INT64_MIN is representable
+        int64_t result = 0;
+        for (; i < text.size() && std::isdigit(static_cast<unsigned char>(text[i])); i++)
+        {
+            if (__builtin_mul_overflow(result, 10, &result) || __builtin_sub_overflow(result, text[i] - '0', &result))
+                return false;
+        }
+        if (!negative && result == INT64_MIN)
+            return false;
+        value = negative ? result : -result;
+        return true;
+    }
+}
+
+BigInteger::BigInteger(int64_t value) : negative_(value < 0)
+{
+    uint64_t magnitude = negative_ ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    while (magnitude)
+    {
+        limbs_.push_back(static_cast<uint32_t>(magnitude));
+        magnitude >>= 32;
+    }
+}
+
+BigInteger::BigInteger(bool negative, Limbs limbs) : negative_(negative), limbs_(std::move(limbs))
+{
+    trim(limbs_);
+    if (limbs_.empty())
+        negative_ = false;
+}
+
+bool BigInteger::parse(std::string_view text, BigInteger &result)
+{
+    size_t i = 0;
+    while (i < text.size() && std::isspace(static_cast<unsigned char>(text[i])))
+        i++;
+    bool negative = false;
+    if (i < text.size() && (text[i] == '+' || text[i] == '-'))
+        negative = text[i++] == '-';
+
+    size_t end = i;
+    while (end < text.size() && std::isdigit(static_cast<unsigned char>(text[end])))
+        end++;
+    if (end == i)
+        return false;
+
+    // Nine digits at a time, the first chunk taking the remainder
+    Limbs limbs;
+    size_t chunk = (end - i) % kDecimalChunkDigits;
+    if (chunk == 0)
+        chunk = kDecimalChunkDigits;
+    while (i < end)
+    {
+        uint32_t value = 0;
+        uint32_t scale = 1;
+        for (size_t j = 0; j < chunk; j++)
+        {
+            value = value * 10 + (text[i + j] - '0');
+            scale *= 10;
+        }
+        multiplyAdd(limbs, scale, value);
+        i += chunk;
+        chunk = kDecimalChunkDigits;
+    }
+
+    result = BigInteger(negative, std::move(limbs));
+    return true;
+}
+
+std::string BigInteger::toString() const
+{
+    if (limbs_.empty())
+        return "0";
+
+    std::vector<uint32_t> chunks;
+    Limbs magnitude = limbs_;
+    while (!magnitude.empty())
+        chunks.push_back(divideSmall(magnitude, kDecimalChunk));
+
+    std::string text = negative_ ? "-" : "";
+    text += std::to_string(chunks.back());
+    for (size_t i = chunks.size() - 1; i-- > 0;)
+    {
+        std::string digits = std::to_string(chunks[i]);
+        text.append(kDecimalChunkDigits - digits.size(), '0');
+        text += digits;
+    }
+    return text;
+}
+
+bool BigInteger::toInt64(int64_t &value) const
+{
+    if (limbs_.size() > 2)
+        return false;
+    uint64_t magnitude = 0;
+    for (size_t i = limbs_.size(); i-- > 0;)
+        magnitude = (magnitude << 32) | limbs_[i];
+
+    if (negative_)
+    {
+        if (magnitude > uint64_t(1) << 63)
+            return false;
+        value = static_cast<int64_t>(0 - magnitude);
+        return true;
+    }
+    if (magnitude > uint64_t(INT64_MAX))
+        return false;
+    value = static_cast<int64_t>(magnitude);
+    return true;
+}
+
+BigInteger BigInteger::operator-() const
+{
+    return BigInteger(!negative_, limbs_);
+}
+
+BigInteger operator+(const BigInteger &left, const BigInteger &right)
+{
+    if (left.negative_ == right.negative_)
+        return BigInteger(left.negative_, BigInteger::addMagnitude(left.limbs_, right.limbs_));
+
+    // Opposite signs: the larger magnitude decides the sign
+    if (BigInteger::compareMagnitude(left.limbs_, right.limbs_) >= 0)
+        return BigInteger(left.negative_, BigInteger::subtractMagnitude(left.limbs_, right.limbs_));
+    return BigInteger(right.negative_, BigInteger::subtractMagnitude(right.limbs_, left.limbs_));
+}
+
+BigInteger operator-(const BigInteger &left, const BigInteger &right)
+{
+    return left + -right;
+}
+
+BigInteger operator*(const BigInteger &left, const BigInteger &right)
+{
+    return BigInteger(left.negative_ != right.negative_,
+                      BigInteger::multiplyMagnitude(left.limbs_.data(), left.limbs_.size(),
+                                                    right.limbs_.data(), right.limbs_.size()));
+}
+
+int BigInteger::compare(const BigInteger &left, const BigInteger &right)
+{
+    if (left.negative_ != right.negative_)
+        return left.negative_ ? -1 : 1;
+    int order = compareMagnitude(left.limbs_, right.limbs_);
+    return left.negative_ ? -order : order;
+}
+
+int BigInteger::compareMagnitude(const Limbs &left, const Limbs &right)
+{
+    if (left.size() != right.size())
+        return left.size() < right.size() ? -1 : 1;
+    for (size_t i = left.size(); i-- > 0;)
+    {
+        if (left[i] != right[i])
+            return left[i] < right[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+BigInteger::Limbs BigInteger::addMagnitude(const Limbs &left, const Limbs &right)
+{
+    const Limbs &longer = left.size() >= right.size() ? left : right;
+    const Limbs &shorter = left.size() >= right.size() ? right : left;
+
+    Limbs result(longer.size() + 1, 0);
+    uint64_t carry = 0;
+    for (size_t i = 0; i < longer.size(); i++)
+    {
+        uint64_t sum = uint64_t(longer[i]) + (i < shorter.size() ? shorter[i] : 0) + carry;
+        result[i] = static_cast<uint32_t>(sum);
+        carry = sum >> 32;
+    }
+    result[longer.size()] = static_cast<uint32_t>(carry);
+    trim(result);
+    return result;
+}
+
+BigInteger::Limbs BigInteger::subtractMagnitude(const Limbs &left, const Limbs &right)
+{
+    Limbs result(left.size(), 0);
+    int64_t borrow = 0;
+    for (size_t i = 0; i < left.size(); i++)
+    {
+        int64_t difference = int64_t(left[i]) - (i < right.size() ? right[i] : 0) - borrow;
+        borrow = difference < 0;
+        result[i] = static_cast<uint32_t>(difference + (borrow << 32));
+    }
+    trim(result);
+    return result;
+}
+
+BigInteger::Limbs BigInteger::multiplyMagnitude(const uint32_t *left, size_t leftSize, const uint32_t *right,
+                                                size_t rightSize)
+{
+    if (leftSize == 0 || rightSize == 0)
+        return {};
+    if (leftSize < rightSize)
+    {
+        std::swap(left, right);
+        std::swap(leftSize, rightSize);
+    }
+
+    if (rightSize < kKaratsubaThreshold)
+    {
+        Limbs result(leftSize + rightSize, 0);
+        for (size_t i = 0; i < rightSize; i++)
+        {
+            uint64_t carry = 0;
+            for (size_t j = 0; j < leftSize; j++)
+            {
+                uint64_t product = uint64_t(left[j]) * right[i] + result[i + j] + carry;
+                result[i + j] = static_cast<uint32_t>(product);
+                carry = product >> 32;
+            }
+            result[i + leftSize] = static_cast<uint32_t>(carry);
+        }
+        trim(result);
+        return result;
+    }
+
+    // left = high0 * B^half + low0, right = high1 * B^half + low1:
+    // left * right = z2 * B^2half + (z1 - z2 - z0) * B^half + z0 with
+    // z1 = (low0 + high0) * (low1 + high1), three half-size products
+    size_t half = leftSize / 2;
+    size_t rightLow = std::min(half, rightSize);
+    Limbs low0(left, left + half);
+    Limbs high0(left + half, left + leftSize);
+    Limbs low1(right, right + rightLow);
+    Limbs high1(right + rightLow, right + rightSize);
+    trim(low0);
+    trim(low1);
+
+    Limbs z0 = multiplyMagnitude(low0.data(), low0.size(), low1.data(), low1.size());
+    Limbs z2 = multiplyMagnitude(high0.data(), high0.size(), high1.data(), high1.size());
+    Limbs sum0 = addMagnitude(low0, high0);
+    Limbs sum1 = addMagnitude(low1, high1);
+    Limbs z1 = multiplyMagnitude(sum0.data(), sum0.size(), sum1.data(), sum1.size());
+    z1 = subtractMagnitude(subtractMagnitude(z1, z0), z2);
+
+    Limbs result(leftSize + rightSize + 1, 0);
+    addShifted(result, z0, 0);
+    addShifted(result, z1, half);
+    addShifted(result, z2, 2 * half);
+    trim(result);
+    return result;
+}
+
+void BigInteger::trim(Limbs &limbs)
+{
+    while (!limbs.empty() && limbs.back() == 0)
+        limbs.pop_back();
+}
+
+bool computeInteger(IntegerOperation operation, const std::string &left, const std::string &right, std::string &result)
+{
+    int64_t a, b, value = 0;
+    if (parseInt64(left, a) && parseInt64(right, b))
+    {
+        // An operation not handled here goes on to the exact path, which
+        // rejects it
+        bool overflow = true;
+        switch (operation)
+        {
+        case IntegerOperation::Add:
+            overflow = __builtin_add_overflow(a, b, &value);
+            break;
+        case IntegerOperation::Subtract:
+            overflow = __builtin_sub_overflow(a, b, &value);
+            break;
+        case IntegerOperation::Multiply:
+            overflow = __builtin_mul_overflow(a, b, &value);
+            break;
+        }
+        if (!overflow)
+        {
+            result = std::to_string(value);
+            return true;
+        }
+    }
+
+    BigInteger x, y;
+    if (!BigInteger::parse(left, x) || !BigInteger::parse(right, y))
+        return false;
+    switch (operation)
+    {
+    case IntegerOperation::Add:
+        result = (x + y).toString();
+        break;
+    case IntegerOperation::Subtract:
+        result = (x - y).toString();
+        break;
+    case IntegerOperation::Multiply:
+        result = (x * y).toString();
+        break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+bool compareIntegers(const std::string &left, const std::string &right, int &order)
+{
+    int64_t a, b;
+    if (parseInt64(left, a) && parseInt64(right, b))
+    {
+        order = (a > b) - (a < b);
+        return true;
+    }
+
+    BigInteger x, y;
+    if (!BigInteger::parse(left, x) || !BigInteger::parse(right, y))
+        return false;
+    order = BigInteger::compare(x, y);
+    return true;
+}
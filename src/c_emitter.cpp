@@ -0,0 +1,649 @@
+#include "c_emitter.h"
+
+#include <cerrno>
+#include <cstdlib>
+
+bool CEmitter::emit(const ASTNode *program, std::ostream &out, const std::string &sourceName)
+{
+    functions_.clear();
+    globals_.clear();
+    globalInitializers_.clear();
+    errors_.clear();
+    body_.str("");
+
+    auto root = dynamic_cast<const ModuleNode *>(program);
+    if (!root)
+    {
+        error("Program has no modules");
+        return false;
+    }
+
+    for (const auto &child : root->body)
+    {
+        if (auto module = dynamic_cast<const ModuleNode *>(child.get()))
+            collectSignatures(*module);
+    }
+    if (functions_.find("Main.main") == functions_.end())
+        error("Main.main not found");
+
+    // Module-level lets are globals, initialized in source order before Main.main
+    for (const auto &child : root->body)
+    {
+        if (auto module = dynamic_cast<const ModuleNode *>(child.get()))
+            collectGlobals(*module);
+    }
+
+    for (const auto &child : root->body)
+    {
+        auto module = dynamic_cast<const ModuleNode *>(child.get());
+        if (!module)
+            continue;
+        for (const auto &member : module->body)
+        {
+            if (auto function = dynamic_cast<const FunctionNode *>(member.get()))
+                emitFunction(module->name, *function);
+        }
+    }
+
+    if (!errors_.empty())
+        return false;
+
+    out << "/* Generated by nexis_compiler" << (sourceName.empty() ? "" : " from " + sourceName) << " */\n"
+        << "#include \"nexis_runtime.h\"\n\n";
+
+    for (const auto &entry : functions_)
+    {
+        const Signature &signature = entry.second;
+        out << "static " << cType(signature.returnType) << " " << signature.cName << "(";
+        for (size_t i = 0; i < signature.parameters.size(); i++)
+            out << (i ? ", " : "") << cType(signature.parameters[i]);
+        out << (signature.parameters.empty() ? "void" : "") << ");\n";
+    }
+    out << "\n";
+
+    for (const auto &entry : globals_)
+        out << "static " << cType(entry.second.type) << " " << entry.second.cName << ";\n";
+    if (!globals_.empty())
+        out << "\n";
+
+    out << body_.str();
+
+    // nexis_main returns the value of Main.main as a string, the same thing
+    // ModuleManager::callFunction hands back to the interpreter
+    const Signature &entry = functions_["Main.main"];
+    Expression result{entry.cName + "()", entry.returnType, {}};
+    out << "nx_string nexis_main(void)\n{\n";
+    for (const auto &initializer : globalInitializers_)
+        out << line(1) << initializer << "\n";
+    if (entry.returnType == Type::Void)
+        out << line(1) << result.code << ";\n" << line(1) << "nx_string result = NX_STR(\"\");\n";
+    else
+        out << line(1) << "nx_string result = " << convert(result, Type::String, "") << ";\n";
+    out << line(1) << "nx_io_flush();\n"
+        << line(1) << "return result;\n"
+        << "}\n\n"
+        << "#ifndef NEXIS_NO_MAIN\n"
+        << "int main(void)\n{\n"
+        << line(1) << "nexis_main();\n"
+        << line(1) << "return 0;\n"
+        << "}\n"
+        << "#endif\n";
+    return true;
+}
+
+void CEmitter::collectSignatures(const ModuleNode &module)
+{
+    for (const auto &member : module.body)
+    {
+        auto function = dynamic_cast<const FunctionNode *>(member.get());
+        if (!function)
+            continue;
+
+        module_ = module.name;
+        function_ = function->name;
+        std::string qualifiedName = module.name + "." + function->name;
+        if (functions_.count(qualifiedName))
+        {
+            error("duplicate definition");
+            continue;
+        }
+
+        Signature signature;
+        signature.cName = mangle(module.name, function->name);
+        for (const auto &parameter : function->parameters)
+        {
+            // A parameter with a bad type stays void so the arity still matches
+            Type type = Type::Void;
+            parseType(parameter.type, type, "parameter '" + parameter.name + "'");
+            signature.parameters.push_back(type);
+        }
+        if (function->returnType.empty() || function->returnType == "void")
+            signature.returnType = Type::Void;
+        else
+            parseType(function->returnType, signature.returnType, "return type");
+        functions_[qualifiedName] = signature;
+    }
+    module_.clear();
+    function_.clear();
+}
+
+void CEmitter::collectGlobals(const ModuleNode &module)
+{
+    module_ = module.name;
+    for (const auto &member : module.body)
+    {
+        auto declaration = dynamic_cast<const VariableDeclarationNode *>(member.get());
+        if (!declaration || !declaration->initializer)
+            continue;
+
+        Expression value = emitExpression(declaration->initializer.get());
+        Type type = value.type;
+        if (!declaration->type.empty() && !parseType(declaration->type, type, "global '" + declaration->name + "'"))
+            continue;
+        if (type == Type::Void)
+        {
+            if (!value.code.empty())
+                error("cannot infer the type of global '" + declaration->name + "'");
+            continue;
+        }
+
+        auto existing = globals_.find(declaration->name);
+        if (existing != globals_.end() && existing->second.type != type)
+        {
+            error("global '" + declaration->name + "' redeclared as " + typeName(type));
+            continue;
+        }
+        std::string code = convert(value, type, "global '" + declaration->name + "'");
+        Variable &global = globals_[declaration->name];
+        global = {"g_" + declaration->name, type};
+        globalInitializers_.push_back(global.cName + " = " + code + ";");
+    }
+    module_.clear();
+}
+
+void CEmitter::emitFunction(const std::string &module, const FunctionNode &function)
+{
+    module_ = module;
+    function_ = function.name;
+    const Signature &signature = functions_[module + "." + function.name];
+    returnType_ = signature.returnType;
+    scopes_.assign(1, {});
+    localNames_.clear();
+
+    body_ << "static " << cType(returnType_) << " " << signature.cName << "(";
+    for (size_t i = 0; i < function.parameters.size(); i++)
+    {
+        const std::string &name = function.parameters[i].name;
+        if (scopes_.back().count(name))
+            error("duplicate parameter '" + name + "'");
+        body_ << (i ? ", " : "") << cType(signature.parameters[i]) << " " << declareLocal(name, signature.parameters[i]);
+    }
+    body_ << (function.parameters.empty() ? "void" : "") << ")\n{\n";
+
+    // The value of a function is the value of its last statement, so the
+    // tail statement of every path returns and falling off the end yields
+    // the zero value
+    bool returns = emitBlock(function.body, true, 1);
+    if (returnType_ != Type::Void && !returns)
+        body_ << line(1) << "return " << zeroValue(returnType_) << ";\n";
+    body_ << "}\n\n";
+
+    scopes_.clear();
+    module_.clear();
+    function_.clear();
+}
+
+bool CEmitter::emitBlock(const std::vector<std::unique_ptr<ASTNode>> &statements, bool tail, int indent)
+{
+    size_t last = statements.size();
+    while (last > 0 && !statements[last - 1])
+        last--;
+
+    bool returns = false;
+    for (size_t i = 0; i < statements.size(); i++)
+        returns = emitStatement(statements[i].get(), tail && i + 1 == last, indent) || returns;
+    return returns;
+}
+
+bool CEmitter::emitStatement(const ASTNode *statement, bool tail, int indent)
+{
+    if (!statement)
+        return false;
+
+    if (auto declaration = dynamic_cast<const VariableDeclarationNode *>(statement))
+    {
+        emitDeclaration(*declaration, indent);
+    }
+    else if (auto ifNode = dynamic_cast<const IfStatementNode *>(statement))
+    {
+        Expression value = emitExpression(ifNode->condition.get());
+        body_ << line(indent) << "if (" << condition(value) << ")\n" << line(indent) << "{\n";
+        scopes_.emplace_back();
+        bool returns = emitBlock(ifNode->thenBranch, tail, indent + 1);
+        scopes_.pop_back();
+        body_ << line(indent) << "}\n";
+        if (ifNode->elseBranch.empty())
+            return false;
+
+        body_ << line(indent) << "else\n" << line(indent) << "{\n";
+        scopes_.emplace_back();
+        returns = emitBlock(ifNode->elseBranch, tail, indent + 1) && returns;
+        scopes_.pop_back();
+        body_ << line(indent) << "}\n";
+        return returns;
+    }
+    else if (dynamic_cast<const FunctionNode *>(statement))
+    {
+        error("nested functions are not supported");
+    }
+    else
+    {
+        bool isReturn = false;
+        if (auto returnNode = dynamic_cast<const ReturnStatementNode *>(statement))
+        {
+            statement = returnNode->expression.get();
+            isReturn = true;
+        }
+
+        Expression value = emitExpression(statement);
+        if ((tail || isReturn) && returnType_ != Type::Void && value.type != Type::Void)
+        {
+            body_ << line(indent) << "return " << convert(value, returnType_, "return value") << ";\n";
+            return true;
+        }
+
+        std::string code = codeOf(value);
+        if (dynamic_cast<const FunctionCallNode *>(statement))
+            body_ << line(indent) << code << ";\n";
+        else if (!code.empty())
+            body_ << line(indent) << "(void)(" << code << ");\n";
+        if (isReturn)
+        {
+            body_ << line(indent) << "return" << (returnType_ == Type::Void ? "" : " " + zeroValue(returnType_)) << ";\n";
+            return true;
+        }
+    }
+    return false;
+}
+
+void CEmitter::emitDeclaration(const VariableDeclarationNode &declaration, int indent)
+{
+    std::string context = "variable '" + declaration.name + "'";
+    Type type = Type::Void;
+    Expression value;
+    if (declaration.initializer)
+    {
+        value = emitExpression(declaration.initializer.get());
+        type = value.type;
+    }
+    if (!declaration.type.empty() && !parseType(declaration.type, type, context))
+        return;
+    if (type == Type::Void)
+    {
+        // An initializer that failed to emit has already been reported
+        if (!declaration.initializer || !value.code.empty())
+            error("cannot infer the type of " + context);
+        return;
+    }
+
+    std::string initializer = declaration.initializer ? convert(value, type, context) : zeroValue(type);
+    body_ << line(indent) << cType(type) << " " << declareLocal(declaration.name, type) << " = " << initializer << ";\n";
+}
+
+CEmitter::Expression CEmitter::emitExpression(const ASTNode *node)
+{
+    if (!node)
+    {
+        error("missing expression");
+        return {};
+    }
+
+    if (auto literal = dynamic_cast<const LiteralNode *>(node))
+    {
+        if (literal->type == "identifier")
+        {
+            if (const Variable *variable = lookup(literal->value))
+                return {variable->cName, variable->type, {}};
+            error("undefined variable '" + literal->value + "'");
+            return {};
+        }
+        if (literal->type == "string")
+            return {stringLiteral(literal->value), Type::String, {}};
+        if (literal->type == "boolean")
+            return {literal->value == "true" ? "1" : "0", Type::Bool, {}};
+
+        errno = 0;
+        char *end = nullptr;
+        long long number = std::strtoll(literal->value.c_str(), &end, 10);
+        if (literal->value.empty() || *end != '\0')
+        {
+            error("unsupported number literal '" + literal->value + "'");
+            return {};
+        }
+        if (errno == ERANGE)
+        {
+            error("integer literal '" + literal->value + "' does not fit in 64 bits");
+            return {};
+        }
+        return {"INT64_C(" + std::to_string(number) + ")", Type::Int, {}};
+    }
+    if (auto binary = dynamic_cast<const BinaryOperationNode *>(node))
+        return emitBinary(*binary);
+    if (auto call = dynamic_cast<const FunctionCallNode *>(node))
+        return emitCall(*call);
+
+    error("unsupported expression");
+    return {};
+}
+
+CEmitter::Expression CEmitter::emitBinary(const BinaryOperationNode &node)
+{
+    Expression left = emitExpression(node.left.get());
+    Expression right = emitExpression(node.right.get());
+    if (left.type == Type::Void || right.type == Type::Void)
+    {
+        // Operands that failed to emit have already been reported
+        auto emitted = [](const Expression &value) { return !value.code.empty() || !value.parts.empty(); };
+        if (emitted(left) && emitted(right))
+            error("operator '" + node.op + "' applied to an expression without a value");
+        return {};
+    }
+
+    const std::string &op = node.op;
+    if (op == "+" && (left.type != Type::Int || right.type != Type::Int))
+    {
+        // Same as the interpreter: '+' concatenates unless both sides are ints
+        Expression result;
+        result.type = Type::String;
+        if (!left.parts.empty())
+            result.parts = std::move(left.parts);
+        else
+            result.parts.push_back(convert(left, Type::String, "concatenation"));
+        if (!right.parts.empty())
+            result.parts.insert(result.parts.end(), right.parts.begin(), right.parts.end());
+        else
+            result.parts.push_back(convert(right, Type::String, "concatenation"));
+        return result;
+    }
+
+    static const std::map<std::string, const char *> arithmetic = {
+        {"+", "nx_add"}, {"-", "nx_sub"}, {"*", "nx_mul"}, {"/", "nx_div"}};
+    auto arithmeticIt = arithmetic.find(op);
+    if (arithmeticIt != arithmetic.end())
+    {
+        if (left.type != Type::Int || right.type != Type::Int)
+        {
+            error("operator '" + op + "' expects int operands, got " + typeName(left.type) + " and " +
+                  typeName(right.type));
+            return {};
+        }
+        return {std::string(arithmeticIt->second) + "(" + left.code + ", " + right.code + ")", Type::Int, {}};
+    }
+
+    if (op == "==")
+    {
+        if (left.type == Type::String && right.type == Type::String)
+            return {"nx_string_equals(" + codeOf(left) + ", " + codeOf(right) + ")", Type::Bool, {}};
+        if (left.type != Type::String && right.type != Type::String)
+            return {"(" + left.code + " == " + right.code + ")", Type::Bool, {}};
+    }
+    else if (op == "<" || op == "<=" || op == ">" || op == ">=")
+    {
+        if (left.type == Type::Int && right.type == Type::Int)
+            return {"(" + left.code + " " + op + " " + right.code + ")", Type::Bool, {}};
+    }
+    else
+    {
+        error("operator '" + op + "' is not supported");
+        return {};
+    }
+
+    error("operator '" + op + "' cannot compare " + typeName(left.type) + " and " + typeName(right.type));
+    return {};
+}
+
+CEmitter::Expression CEmitter::emitCall(const FunctionCallNode &node)
+{
+    std::vector<Expression> arguments;
+    for (const auto &argument : node.arguments)
+        arguments.push_back(emitExpression(argument.get()));
+
+    // Builtins shadow user modules, as in ModuleManager::callFunction. The
+    // io functions are statements here; their results are not values
+    if (node.name == "io.print" || node.name == "io.println")
+    {
+        Expression line;
+        line.type = Type::String;
+        for (const auto &argument : arguments)
+        {
+            if (!argument.parts.empty())
+                line.parts.insert(line.parts.end(), argument.parts.begin(), argument.parts.end());
+            else
+                line.parts.push_back(convert(argument, Type::String, node.name + " argument"));
+        }
+        std::string text = line.parts.empty() ? "NX_STR(\"\")" : codeOf(line);
+        return {"nx_io_write_line(" + text + ")", Type::Void, {}};
+    }
+    if (node.name == "io.flush")
+        return {"nx_io_flush()", Type::Void, {}};
+    if (node.name == "math.add" || node.name == "math.subtract" || node.name == "math.multiply")
+    {
+        if (arguments.size() != 2)
+        {
+            error(node.name + " expects 2 arguments");
+            return {};
+        }
+        std::string a = convert(arguments[0], Type::Int, node.name + " argument");
+        std::string b = convert(arguments[1], Type::Int, node.name + " argument");
+        return {"nx_math_" + node.name.substr(5) + "(" + a + ", " + b + ")", Type::Int, {}};
+    }
+
+    // Unqualified calls resolve within the current module
+    std::string qualifiedName = node.name.find('.') == std::string::npos ? module_ + "." + node.name : node.name;
+    auto it = functions_.find(qualifiedName);
+    if (it == functions_.end())
+    {
+        error("undefined function '" + node.name + "'");
+        return {};
+    }
+
+    const Signature &signature = it->second;
+    if (arguments.size() != signature.parameters.size())
+    {
+        error(qualifiedName + " expects " + std::to_string(signature.parameters.size()) + " arguments, got " +
+              std::to_string(arguments.size()));
+        return {};
+    }
+
+    std::string code = signature.cName + "(";
+    for (size_t i = 0; i < arguments.size(); i++)
+        code += (i ? ", " : "") + convert(arguments[i], signature.parameters[i], qualifiedName + " argument " + std::to_string(i + 1));
+    code += ")";
+    return {code, signature.returnType, {}};
+}
+
+std::string CEmitter::convert(const Expression &value, Type target, const std::string &context)
+{
+    if (value.type == target)
+        return codeOf(value);
+
+    switch (value.type)
+    {
+    case Type::Int:
+        if (target == Type::String)
+            return "nx_int_to_string(" + value.code + ")";
+        if (target == Type::Bool)
+            return "(" + value.code + " != 0)";
+        break;
+    case Type::Bool:
+        if (target == Type::String)
+            return "nx_bool_to_string(" + value.code + ")";
+        if (target == Type::Int)
+            return "(int64_t)" + value.code;
+        break;
+    default:
+        break;
+    }
+
+    // Only report values that were well-formed; an invalid one (or a void
+    // parameter) already has an error
+    if ((!value.code.empty() || !value.parts.empty()) && target != Type::Void)
+        error(std::string("cannot use ") + typeName(value.type) + " as " + typeName(target) + " in " + context);
+    return zeroValue(target);
+}
+
+std::string CEmitter::condition(const Expression &value)
+{
+    switch (value.type)
+    {
+    case Type::Int:
+        return value.code + " != 0";
+    case Type::Bool:
+        return value.code;
+    case Type::String:
+        return "nx_truthy(" + codeOf(value) + ")";
+    default:
+        if (!value.code.empty())
+            error("condition has no value");
+        return "0";
+    }
+}
+
+bool CEmitter::parseType(const std::string &name, Type &type, const std::string &context)
+{
+    if (name == "int")
+        type = Type::Int;
+    else if (name == "string")
+        type = Type::String;
+    else if (name == "bool" || name == "boolean")
+        type = Type::Bool;
+    else
+    {
+        error("unsupported type '" + name + "' for " + context);
+        return false;
+    }
+    return true;
+}
+
+const CEmitter::Variable *CEmitter::lookup(const std::string &name) const
+{
+    for (auto scope = scopes_.rbegin(); scope != scopes_.rend(); ++scope)
+    {
+        auto it = scope->find(name);
+        if (it != scope->end())
+            return &it->second;
+    }
+    auto it = globals_.find(name);
+    return it != globals_.end() ? &it->second : nullptr;
+}
+
+std::string CEmitter::declareLocal(const std::string &name, Type type)
+{
+    // A redeclaration shadows the previous variable under a fresh C name
+    int &count = localNames_[name];
+    std::string cName = "v_" + name + (count ? "_" + std::to_string(count) : "");
+    count++;
+    scopes_.back()[name] = {cName, type};
+    return cName;
+}
+
+void CEmitter::error(const std::string &message)
+{
+    if (function_.empty())
+        errors_.push_back(module_.empty() ? message : module_ + ": " + message);
+    else
+        errors_.push_back(module_ + "." + function_ + ": " + message);
+}
+
+const char *CEmitter::cType(Type type)
+{
+    switch (type)
+    {
+    case Type::Int:
+        return "int64_t";
+    case Type::Bool:
+        return "int";
+    case Type::String:
+        return "nx_string";
+    default:
+        return "void";
+    }
+}
+
+const char *CEmitter::typeName(Type type)
+{
+    switch (type)
+    {
+    case Type::Int:
+        return "int";
+    case Type::Bool:
+        return "bool";
+    case Type::String:
+        return "string";
+    default:
+        return "void";
+    }
+}
+
+std::string CEmitter::zeroValue(Type type)
+{
+    switch (type)
+    {
+    case Type::Int:
+        return "INT64_C(0)";
+    case Type::Bool:
+        return "0";
+    case Type::String:
+        return "NX_STR(\"\")";
+    default:
+        return "";
+    }
+}
+
+std::string CEmitter::codeOf(const Expression &value)
+{
+    if (value.parts.empty())
+        return value.code;
+    if (value.parts.size() == 1)
+        return value.parts.front();
+
+    std::string code = "nx_concat(" + std::to_string(value.parts.size()) + ", (nx_string[]){";
+    for (size_t i = 0; i < value.parts.size(); i++)
+        code += (i ? ", " : "") + value.parts[i];
+    return code + "})";
+}
+
+std::string CEmitter::stringLiteral(const std::string &text)
+{
+    static const char digits[] = "01234567";
+    std::string literal = "NX_STR(\"";
+    for (unsigned char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            literal += '\\';
+            literal += static_cast<char>(c);
+        }
+        else if (c == '\n')
+            literal += "\\n";
+        else if (c == '\t')
+            literal += "\\t";
+        else if (c < 0x20 || c >= 0x7f || c == '?')
+        {
+            // Three octal digits so a following digit is never absorbed; '?'
+            // is escaped to stay clear of trigraphs
+            literal += '\\';
+            literal += digits[(c >> 6) & 7];
+            literal += digits[(c >> 3) & 7];
+            literal += digits[c & 7];
+        }
+        else
+            literal += static_cast<char>(c);
+    }
+    return literal + "\")";
+}
+
+std::string CEmitter::mangle(const std::string &module, const std::string &function)
+{
+    return "nx_" + std::to_string(module.size()) + module + std::to_string(function.size()) + function;
+}
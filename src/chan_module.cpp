@@ -0,0 +1,197 @@
+#include "channel.h"
+#include "heap.h"
+#include "tasks.h"
+#include "standard_library.h"
+#include "module_manager.h"
+#include "evaluator.h"
+
+#include <charconv>
+#include <stdexcept>
+
+namespace
+{
+    using Arguments = std::vector<std::unique_ptr<ASTNode>>;
+
+    // The message of the last chan.select on this thread, pinned until the
+    // next one
+    thread_local Value selectedMessage;
+
+    [[noreturn]] void fail(const std::string &function, const std::string &message)
+    {
+        throw std::runtime_error("chan." + function + ": " + message);
+    }
+
+    void expectArguments(const std::string &function, const Arguments &args, size_t minimum, size_t maximum)
+    {
+        if (args.size() < minimum || args.size() > maximum)
+        {
+            std::string expected = minimum == maximum ? std::to_string(minimum)
+                                                      : std::to_string(minimum) + " to " + std::to_string(maximum);
+            fail(function, "expects " + expected + " arguments, got " + std::to_string(args.size()));
+        }
+    }
+
+    Channel &argumentChannel(const std::string &function, const std::string &handle)
+    {
+        Channel *channel = Heap::getInstance().findChannel(handle);
+        if (!channel)
+            fail(function, "'" + handle + "' is not a channel");
+        return *channel;
+    }
+
+    // Waiting is only allowed while a task could still wake us
+    void expectRunningTasks(const std::string &function, const std::string &what)
+    {
+        if (!Tasks::getInstance().hasRunningTasks())
+            fail(function, what + " and no task is running");
+    }
+}
+
+void registerChanModule()
+{
+    auto &mm = ModuleManager::getInstance();
+
+    // chan.new() is unbounded; chan.new(n) holds at most n messages
+    mm.registerFunction("std.chan", "new", [](const Arguments &args) {
+        expectArguments("new", args, 0, 1);
+        size_t capacity = 0;
+        if (args.size() == 1)
+        {
+            std::string text = evaluateNode(args[0].get());
+            auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), capacity);
+            if (error != std::errc() || end != text.data() + text.size() || capacity == 0)
+                fail("new", "capacity '" + text + "' is not a positive integer");
+        }
+        return Heap::getInstance().newChannel(capacity).first;
+    });
+
+    // Waits while a bounded channel is full. A message that is a handle
+    // keeps its object alive until it is received.
+    mm.registerFunction("std.chan", "send", [](const Arguments &args) {
+        expectArguments("send", args, 2, 2);
+        std::string handle = evaluateNode(args[0].get());
+        Channel &channel = argumentChannel("send", handle);
+        Value message = evaluateNode(args[1].get());
+        Heap::Pin inFlight(message.str());
+        Channel::Status status = channel.trySend(message);
+        if (status == Channel::Status::WouldBlock)
+        {
+            expectRunningTasks("send", "the channel is full");
+            Heap::Pin waitingOn(handle);
+            Heap::Parked parked;
+            Tasks::Unlocked unlocked;
+            status = channel.send(std::move(message)) ? Channel::Status::Done : Channel::Status::Closed;
+        }
+        if (status == Channel::Status::Closed)
+            fail("send", "the channel is closed");
+        inFlight.keep();
+        return std::string();
+    });
+
+    // chan.recv(c) waits for a message and fails once c is closed and
+    // drained; chan.recv(c, value) returns value then instead
+    mm.registerFunction("std.chan", "recv", [](const Arguments &args) {
+        expectArguments("recv", args, 1, 2);
+        std::string handle = evaluateNode(args[0].get());
+        Channel &channel = argumentChannel("recv", handle);
+        Value message;
+        Channel::Status status = channel.tryReceive(message);
+        if (status == Channel::Status::WouldBlock)
+        {
+            expectRunningTasks("recv", "the channel is empty");
+            Heap::Pin waitingOn(handle);
+            Heap::Parked parked;
+            Tasks::Unlocked unlocked;
+            status = channel.receive(message) ? Channel::Status::Done : Channel::Status::Closed;
+        }
+        if (status == Channel::Status::Done)
+        {
+            Heap::getInstance().unpin(message.str());
+            return std::move(message).release();
+        }
+        if (args.size() == 1)
+            fail("recv", "the channel is closed");
+        return evaluateNode(args[1].get());
+    });
+
+    // chan.try_recv(c) is "" and chan.try_recv(c, value) is value when c
+    // has no message
+    mm.registerFunction("std.chan", "try_recv", [](const Arguments &args) {
+        expectArguments("try_recv", args, 1, 2);
+        Channel &channel = argumentChannel("try_recv", evaluateNode(args[0].get()));
+        Value message;
+        if (channel.tryReceive(message) == Channel::Status::Done)
+        {
+            Heap::getInstance().unpin(message.str());
+            return std::move(message).release();
+        }
+        return args.size() == 2 ? evaluateNode(args[1].get()) : std::string();
+    });
+
+    mm.registerFunction("std.chan", "close", [](const Arguments &args) {
+        expectArguments("close", args, 1, 1);
+        argumentChannel("close", evaluateNode(args[0].get())).close();
+        return std::string();
+    });
+
+    // chan.select(c1, c2, ...) waits for a message on any of the channels
+    // and returns its position; chan.selected() is the message. -1 once all
+    // of them are closed and drained.
+    mm.registerFunction("std.chan", "select", [](const Arguments &args) {
+        std::vector<std::string> handles;
+        std::vector<Channel *> channels;
+        for (const auto &arg : args)
+        {
+            handles.push_back(evaluateNode(arg.get()));
+            channels.push_back(&argumentChannel("select", handles.back()));
+        }
+        Value message;
+        int index = Channel::trySelect(channels, message);
+        if (index == Channel::kWouldBlock)
+        {
+            expectRunningTasks("select", "every channel is empty");
+            std::vector<Heap::Pin> waitingOn;
+            for (const std::string &handle : handles)
+                waitingOn.emplace_back(handle);
+            Heap::Parked parked;
+            Tasks::Unlocked unlocked;
+            index = Channel::select(channels, message);
+        }
+        Heap::getInstance().unpin(selectedMessage.str());
+        selectedMessage = index >= 0 ? std::move(message) : Value();
+        return std::to_string(index);
+    });
+
+    mm.registerFunction("std.chan", "selected", [](const Arguments &args) {
+        expectArguments("selected", args, 0, 0);
+        return selectedMessage.str();
+    });
+
+    // chan.spawn("Module.function", arguments...) runs the call as a task
+    mm.registerFunction("std.chan", "spawn", [](const Arguments &args) {
+        if (args.empty())
+            fail("spawn", "expects a function name");
+        std::string name = evaluateNode(args[0].get());
+        auto &mm = ModuleManager::getInstance();
+        if (!mm.hasFunction(name))
+            fail("spawn", "'" + name + "' is not a function");
+        std::vector<Value> arguments;
+        for (size_t i = 1; i < args.size(); i++)
+            arguments.push_back(evaluateNode(args[i].get()));
+        return Tasks::getInstance().spawn(intern(name), std::move(arguments));
+    });
+
+    // Waits for a task and returns its result, or fails with its error
+    mm.registerFunction("std.chan", "join", [](const Arguments &args) {
+        expectArguments("join", args, 1, 1);
+        std::string handle = evaluateNode(args[0].get());
+        try
+        {
+            return Tasks::getInstance().join(handle);
+        }
+        catch (const std::runtime_error &e)
+        {
+            fail("join", e.what());
+        }
+    });
+}
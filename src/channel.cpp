@@ -0,0 +1,460 @@
+#include "channel.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+
+namespace
+{
+    // Slots per segment of an unbounded channel
+    constexpr size_t kSegmentSize = 64;
+
+    // Attempts before a waiting operation goes to sleep
+    constexpr int kSpins = 64;
+}
+
+struct Channel::Waiter
+{
+    std::mutex mutex;
+    std::condition_variable ready;
+    bool woken = false;
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        ready.wait(lock, [this] { return woken; });
+        woken = false;
+    }
+};
+
+struct Channel::Cell
+{
+    std::atomic<size_t> sequence;
+    Value value;
+};
+
+struct Channel::Segment
+{
+    enum : uint8_t
+    {
+        Empty,
+        Full,
+        Taken // a receiver gave up on the slot before its sender filled it
+    };
+
+    struct Slot
+    {
+        std::atomic<uint8_t> state{Empty};
+        Value value;
+    };
+
+    alignas(64) std::atomic<size_t> sendIndex{0};
+    alignas(64) std::atomic<size_t> receiveIndex{0};
+    std::atomic<Segment *> next{nullptr};
+    Segment *retiredNext = nullptr;
+    Slot slots[kSegmentSize];
+};
+
+Channel::Channel(size_t capacity) : capacity_(capacity), cellCount_(capacity ? std::max<size_t>(capacity, 2) : 0)
+{
+    if (capacity_)
+    {
+        cells_.reset(new Cell[cellCount_]);
+        for (size_t i = 0; i < cellCount_; i++)
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    else
+    {
+        Segment *segment = new Segment;
+        head_.store(segment, std::memory_order_relaxed);
+        tail_.store(segment, std::memory_order_relaxed);
+    }
+}
+
+Channel::~Channel()
+{
+    for (Segment *segment = head_.load(std::memory_order_relaxed); segment;)
+    {
+        Segment *next = segment->next.load(std::memory_order_relaxed);
+        delete segment;
+        segment = next;
+    }
+    for (Segment *segment = retired_.load(std::memory_order_relaxed); segment;)
+    {
+        Segment *next = segment->retiredNext;
+        delete segment;
+        segment = next;
+    }
+}
+
+// Only the first segment of an unbounded channel, since other threads may be
+// adding and freeing segments meanwhile
+size_t Channel::memoryBytes() const
+{
+    return sizeof(Channel) + (capacity_ ? cellCount_ * sizeof(Cell) : sizeof(Segment));
+}
+
+// The cell for `position` is free for it when its sequence equals the
+// position, and holds its message when the sequence is one more
+Channel::Status Channel::pushRing(Value &value)
+{
+    size_t position = sendPosition_.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        if (position & kClosedBit)
+            return Status::Closed;
+        Cell &cell = cells_[position % cellCount_];
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+        if (difference == 0)
+        {
+            // A ring with a spare cell is full before every cell is
+            if (cellCount_ != capacity_ &&
+                position - receivePosition_.load(std::memory_order_acquire) >= capacity_)
+                return Status::WouldBlock;
+            if (sendPosition_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                cell.value = std::move(value);
+                cell.sequence.store(position + 1, std::memory_order_release);
+                return Status::Done;
+            }
+        }
+        else if (difference < 0)
+        {
+            return Status::WouldBlock;
+        }
+        else
+        {
+            position = sendPosition_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool Channel::popRing(Value &value)
+{
+    size_t position = receivePosition_.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        Cell &cell = cells_[position % cellCount_];
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        auto difference = static_cast<std::ptrdiff_t>(sequence - (position + 1));
+        if (difference == 0)
+        {
+            if (receivePosition_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                value = std::move(cell.value);
+                cell.sequence.store(position + cellCount_, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (difference < 0)
+        {
+            return false;
+        }
+        else
+        {
+            position = receivePosition_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+// A sender registers in sending_ before it checks closed_, and close()
+// sets closed_ before receivers check sending_, so a receiver that finds
+// both closed_ and no sender in flight has seen every delivered message
+Channel::Status Channel::pushList(Value &value)
+{
+    sending_.fetch_add(1, std::memory_order_seq_cst);
+    if (closed_.load(std::memory_order_seq_cst))
+    {
+        sending_.fetch_sub(1, std::memory_order_release);
+        return Status::Closed;
+    }
+
+    listOperations_.fetch_add(1, std::memory_order_seq_cst);
+    for (;;)
+    {
+        Segment *tail = tail_.load(std::memory_order_acquire);
+        size_t index = tail->sendIndex.fetch_add(1, std::memory_order_relaxed);
+        if (index < kSegmentSize)
+        {
+            auto &slot = tail->slots[index];
+            slot.value = std::move(value);
+            uint8_t expected = Segment::Empty;
+            if (slot.state.compare_exchange_strong(expected, Segment::Full, std::memory_order_release,
+                                                   std::memory_order_relaxed))
+                break;
+            value = std::move(slot.value);
+            continue;
+        }
+
+        // The segment is full: append one with the message in its first slot
+        Segment *next = tail->next.load(std::memory_order_acquire);
+        if (!next)
+        {
+            Segment *segment;
+            try
+            {
+                segment = new Segment;
+            }
+            catch (...)
+            {
+                leaveList();
+                sending_.fetch_sub(1, std::memory_order_release);
+                throw;
+            }
+            segment->slots[0].value = std::move(value);
+            segment->slots[0].state.store(Segment::Full, std::memory_order_relaxed);
+            segment->sendIndex.store(1, std::memory_order_relaxed);
+            if (tail->next.compare_exchange_strong(next, segment, std::memory_order_release,
+                                                   std::memory_order_acquire))
+            {
+                tail_.compare_exchange_strong(tail, segment, std::memory_order_release);
+                break;
+            }
+            value = std::move(segment->slots[0].value);
+            delete segment;
+        }
+        tail_.compare_exchange_strong(tail, next, std::memory_order_release);
+    }
+    leaveList();
+    sending_.fetch_sub(1, std::memory_order_release);
+    return Status::Done;
+}
+
+bool Channel::popList(Value &value)
+{
+    listOperations_.fetch_add(1, std::memory_order_seq_cst);
+    bool received = false;
+    for (;;)
+    {
+        Segment *head = head_.load(std::memory_order_acquire);
+        if (head->receiveIndex.load(std::memory_order_relaxed) >= head->sendIndex.load(std::memory_order_relaxed) &&
+            !head->next.load(std::memory_order_acquire))
+            break;
+
+        size_t index = head->receiveIndex.fetch_add(1, std::memory_order_relaxed);
+        if (index < kSegmentSize)
+        {
+            auto &slot = head->slots[index];
+            if (slot.state.exchange(Segment::Taken, std::memory_order_acquire) == Segment::Full)
+            {
+                value = std::move(slot.value);
+                received = true;
+                break;
+            }
+            // Its sender is still writing and will take another slot
+            continue;
+        }
+
+        // Drained: move on, making sure the tail does not point back here
+        Segment *next = head->next.load(std::memory_order_acquire);
+        if (!next)
+            break;
+        Segment *tail = head;
+        tail_.compare_exchange_strong(tail, next, std::memory_order_release);
+        if (head_.compare_exchange_strong(head, next, std::memory_order_release))
+        {
+            head->retiredNext = retired_.load(std::memory_order_relaxed);
+            while (!retired_.compare_exchange_weak(head->retiredNext, head, std::memory_order_release,
+                                                   std::memory_order_relaxed))
+            {
+            }
+        }
+    }
+    leaveList();
+    return received;
+}
+
+// Retired segments are unreachable from head_ and tail_, so only operations
+// that were already inside the list can still use one. The last operation
+// to leave frees them, unless another came in while it was taking them.
+void Channel::leaveList()
+{
+    if (retired_.load(std::memory_order_acquire) && listOperations_.load(std::memory_order_seq_cst) == 1)
+    {
+        Segment *segments = retired_.exchange(nullptr, std::memory_order_acq_rel);
+        bool alone = listOperations_.load(std::memory_order_seq_cst) == 1;
+        while (segments)
+        {
+            Segment *next = segments->retiredNext;
+            if (alone)
+            {
+                delete segments;
+            }
+            else
+            {
+                segments->retiredNext = retired_.load(std::memory_order_relaxed);
+                while (!retired_.compare_exchange_weak(segments->retiredNext, segments, std::memory_order_release,
+                                                       std::memory_order_relaxed))
+                {
+                }
+            }
+            segments = next;
+        }
+    }
+    listOperations_.fetch_sub(1, std::memory_order_release);
+}
+
+bool Channel::sendsFinished() const
+{
+    if (capacity_)
+    {
+        size_t position = sendPosition_.load(std::memory_order_acquire);
+        return (position & kClosedBit) &&
+               receivePosition_.load(std::memory_order_acquire) >= (position & ~kClosedBit);
+    }
+    return closed_.load(std::memory_order_seq_cst) && sending_.load(std::memory_order_seq_cst) == 0;
+}
+
+Channel::Status Channel::trySend(Value &value)
+{
+    Status status = capacity_ ? pushRing(value) : pushList(value);
+    // A failed send after close() may be what a receiver waits for before
+    // it reports the channel drained
+    if (status != Status::WouldBlock)
+        wakeWaiters();
+    return status;
+}
+
+Channel::Status Channel::tryReceive(Value &value)
+{
+    bool received = capacity_ ? popRing(value) : popList(value);
+    if (!received)
+    {
+        if (!sendsFinished())
+            return Status::WouldBlock;
+        // Messages sent before close() are still delivered
+        received = capacity_ ? popRing(value) : popList(value);
+        if (!received)
+            return Status::Closed;
+    }
+    // A sender may be waiting for room
+    if (capacity_)
+        wakeWaiters();
+    return Status::Done;
+}
+
+bool Channel::send(Value value)
+{
+    Status status = Status::WouldBlock;
+    for (int spin = 0; spin < kSpins && status == Status::WouldBlock; spin++)
+    {
+        status = trySend(value);
+        if (status == Status::WouldBlock)
+            std::this_thread::yield();
+    }
+    if (status == Status::WouldBlock)
+    {
+        Waiter waiter;
+        addWaiter(&waiter);
+        while ((status = trySend(value)) == Status::WouldBlock)
+            waiter.wait();
+        removeWaiter(&waiter);
+    }
+    return status == Status::Done;
+}
+
+bool Channel::receive(Value &value)
+{
+    Status status = Status::WouldBlock;
+    for (int spin = 0; spin < kSpins && status == Status::WouldBlock; spin++)
+    {
+        status = tryReceive(value);
+        if (status == Status::WouldBlock)
+            std::this_thread::yield();
+    }
+    if (status == Status::WouldBlock)
+    {
+        Waiter waiter;
+        addWaiter(&waiter);
+        while ((status = tryReceive(value)) == Status::WouldBlock)
+            waiter.wait();
+        removeWaiter(&waiter);
+    }
+    return status == Status::Done;
+}
+
+void Channel::close()
+{
+    if (capacity_)
+        sendPosition_.fetch_or(kClosedBit, std::memory_order_acq_rel);
+    closed_.store(true, std::memory_order_seq_cst);
+    wakeWaiters();
+}
+
+// Starts at a different channel each time, so that a busy one does not
+// starve the others
+int Channel::trySelect(const std::vector<Channel *> &channels, Value &value)
+{
+    thread_local size_t rotation = 0;
+    bool open = false;
+    size_t start = rotation++;
+    for (size_t i = 0; i < channels.size(); i++)
+    {
+        size_t index = (start + i) % channels.size();
+        Status status = channels[index]->tryReceive(value);
+        if (status == Status::Done)
+            return static_cast<int>(index);
+        open = open || status == Status::WouldBlock;
+    }
+    return open ? kWouldBlock : -1;
+}
+
+int Channel::select(const std::vector<Channel *> &channels, Value &value)
+{
+    int result = kWouldBlock;
+    for (int spin = 0; spin < kSpins && result == kWouldBlock; spin++)
+    {
+        result = trySelect(channels, value);
+        if (result == kWouldBlock)
+            std::this_thread::yield();
+    }
+    if (result == kWouldBlock)
+    {
+        Waiter waiter;
+        for (Channel *channel : channels)
+            channel->addWaiter(&waiter);
+        while ((result = trySelect(channels, value)) == kWouldBlock)
+            waiter.wait();
+        for (Channel *channel : channels)
+            channel->removeWaiter(&waiter);
+    }
+    return result;
+}
+
+// A waiter registers before it checks the channel a last time, and every
+// operation that can unblock one checks for waiters after it is done; the
+// fences order the two, so either the check sees the operation or the
+// operation sees the waiter
+void Channel::addWaiter(Waiter *waiter)
+{
+    {
+        std::lock_guard<std::mutex> lock(waitersMutex_);
+        waiters_.push_back(waiter);
+    }
+    waiterCount_.fetch_add(1, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void Channel::removeWaiter(Waiter *waiter)
+{
+    std::lock_guard<std::mutex> lock(waitersMutex_);
+    waiters_.erase(std::find(waiters_.begin(), waiters_.end(), waiter));
+    waiterCount_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void Channel::wakeWaiters()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiterCount_.load(std::memory_order_relaxed) == 0)
+        return;
+    std::lock_guard<std::mutex> lock(waitersMutex_);
+    for (Waiter *waiter : waiters_)
+    {
+        {
+            std::lock_guard<std::mutex> waiterLock(waiter->mutex);
+            waiter->woken = true;
+        }
+        waiter->ready.notify_one();
+    }
+}
@@ -1,7 +1,306 @@
 #include "evaluator.h"
 #include "symbol_table.h"
 #include "module_manager.h"
+#include "jit.h"
+#include "big_integer.h"
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
 #include <iostream>
+#include <stdexcept>
+#include <string_view>
+#include <typeinfo>
+#include <vector>
+
+namespace
+{
+    bool isComparison(const std::string &op)
+    {
+        return op == "==" || op == "<" || op == "<=" || op == ">" || op == ">=";
+    }
+
+    // `order` is <0, 0 or >0 as left compares to right
+    std::string comparisonResult(const std::string &op, int order)
+    {
+        bool result = op == "==" ? order == 0
+                    : op == "<"  ? order < 0
+                    : op == "<=" ? order <= 0
+                    : op == ">"  ? order > 0
+                                 : order >= 0;
+        return result ? "true" : "false";
+    }
+
+    // std::stoi without the exceptions: optional leading whitespace and
+    // sign, then the digits up to the first non-digit. False when there are
+    // no digits or the value does not fit an int.
+    bool toInt(const std::string &text, int &value)
+    {
+        const char *begin = text.c_str();
+        char *end;
+        errno = 0;
+        long number = std::strtol(begin, &end, 10);
+        if (end == begin || errno == ERANGE || number < INT_MIN || number > INT_MAX)
+            return false;
+        value = static_cast<int>(number);
+        return true;
+    }
+
+    // Runtime guess used for unchecked operations: both sides go through
+    // std::stoi, and '+' concatenates when that fails
+    std::string evaluateDynamic(const std::string &op, const std::string &left, const std::string &right)
+    {
+        int a, b;
+        if (!toInt(left, a) || !toInt(right, b)) {
+            // Integers wider than 32 bits (from std.math) are computed exactly
+            std::string wide;
+            int order;
+            if (op == "+" && computeInteger(IntegerOperation::Add, left, right, wide))
+                return wide;
+            if (op == "-" && computeInteger(IntegerOperation::Subtract, left, right, wide))
+                return wide;
+            if (op == "*" && computeInteger(IntegerOperation::Multiply, left, right, wide))
+                return wide;
+            if (isComparison(op) && compareIntegers(left, right, order))
+                return comparisonResult(op, order);
+            if (op == "+")
+                return left + right;
+            if (op == "*")
+                return "0";
+            if (op == "==")
+                return left == right ? "true" : "false";
+            return "";
+        }
+
+        if (op == "+")
+            return std::to_string(static_cast<int>(static_cast<unsigned>(a) + static_cast<unsigned>(b)));
+        if (op == "*")
+            return std::to_string(static_cast<int>(static_cast<unsigned>(a) * static_cast<unsigned>(b)));
+        if (op == "-")
+            return std::to_string(static_cast<int>(static_cast<unsigned>(a) - static_cast<unsigned>(b)));
+        if (op == "/") {
+            if (b == 0)
+                throw std::runtime_error("Division by zero");
+            return std::to_string(a == INT_MIN && b == -1 ? INT_MIN : a / b);
+        }
+        if (isComparison(op))
+            return comparisonResult(op, (a > b) - (a < b));
+        return "";
+    }
+
+    // Operand of an operation the TypeChecker resolved to int arithmetic.
+    // It stays unboxed unless a runtime value turns out not to be an int
+    // (e.g. "" from a function without a result).
+    struct Operand
+    {
+        bool isInt;
+        int number;
+        std::string text;
+
+        std::string toString() const { return isInt ? std::to_string(number) : text; }
+    };
+
+    bool isIntOperation(BinaryOperation operation)
+    {
+        return operation == BinaryOperation::IntAdd || operation == BinaryOperation::IntSubtract ||
+               operation == BinaryOperation::IntMultiply || operation == BinaryOperation::IntDivide;
+    }
+
+    Operand toOperand(std::string text)
+    {
+        Operand operand{false, 0, std::move(text)};
+        int64_t number;
+        if (jit::fromString(operand.text, number)) {
+            operand.isInt = true;
+            operand.number = static_cast<int>(number);
+        }
+        return operand;
+    }
+
+    Operand evaluateIntOperation(BinaryOperationNode *node);
+    Operand applyIntOperation(BinaryOperationNode *node, const Operand &left, const Operand &right);
+
+    Operand evaluateOperand(ASTNode *node)
+    {
+        // Exact type checks: both node classes are leaves of the hierarchy
+        const std::type_info &type = typeid(*node);
+        if (type == typeid(BinaryOperationNode)) {
+            auto binaryOpNode = static_cast<BinaryOperationNode *>(node);
+            if (isIntOperation(binaryOpNode->operation))
+                return evaluateIntOperation(binaryOpNode);
+        }
+        else if (type == typeid(LiteralNode)) {
+            auto literalNode = static_cast<LiteralNode *>(node);
+            if (literalNode->type == "int")
+                return {true, literalNode->intValue, {}};
+        }
+
+        return toOperand(evaluateNode(node));
+    }
+
+    Operand evaluateIntOperation(BinaryOperationNode *node)
+    {
+        Operand left = evaluateOperand(node->left.get());
+        Operand right = evaluateOperand(node->right.get());
+        return applyIntOperation(node, left, right);
+    }
+
+    Operand applyIntOperation(BinaryOperationNode *node, const Operand &left, const Operand &right)
+    {
+        if (!left.isInt || !right.isInt) {
+            std::string text = evaluateDynamic(node->op, left.toString(), right.toString());
+            return {false, 0, text};
+        }
+
+        // Wraps around like the interpreter's int arithmetic always has
+        unsigned a = static_cast<unsigned>(left.number);
+        unsigned b = static_cast<unsigned>(right.number);
+        switch (node->operation) {
+        case BinaryOperation::IntAdd:
+            return {true, static_cast<int>(a + b), {}};
+        case BinaryOperation::IntSubtract:
+            return {true, static_cast<int>(a - b), {}};
+        case BinaryOperation::IntMultiply:
+            return {true, static_cast<int>(a * b), {}};
+        default:
+            if (right.number == 0)
+                throw std::runtime_error("Division by zero");
+            if (left.number == INT_MIN && right.number == -1)
+                return {true, INT_MIN, {}};
+            return {true, left.number / right.number, {}};
+        }
+    }
+
+    BinaryOperationNode *asConcat(ASTNode *node)
+    {
+        if (typeid(*node) != typeid(BinaryOperationNode))
+            return nullptr;
+        auto binaryOpNode = static_cast<BinaryOperationNode *>(node);
+        return binaryOpNode->operation == BinaryOperation::Concat ? binaryOpNode : nullptr;
+    }
+
+    // Operands of a chain of Concat nodes, left to right. Chains lean left,
+    // so the left spine is walked iteratively.
+    void collectConcatOperands(BinaryOperationNode *node, std::vector<ASTNode *> &operands)
+    {
+        std::vector<ASTNode *> rights;
+        ASTNode *current = node;
+        while (auto concat = asConcat(current)) {
+            rights.push_back(concat->right.get());
+            current = concat->left.get();
+        }
+        operands.push_back(current);
+
+        for (auto it = rights.rbegin(); it != rights.rend(); ++it) {
+            if (auto concat = asConcat(*it))
+                collectConcatOperands(concat, operands);
+            else
+                operands.push_back(*it);
+        }
+    }
+
+    // Builds a whole `a + b + c ...` string chain in one pre-sized buffer
+    // instead of one temporary per '+'. String literals are copied straight
+    // from the AST.
+    std::string evaluateConcat(BinaryOperationNode *node)
+    {
+        std::vector<ASTNode *> operands;
+        collectConcatOperands(node, operands);
+
+        std::vector<Value> values(operands.size());
+        std::vector<std::string_view> parts(operands.size());
+        size_t length = 0;
+        for (size_t i = 0; i < operands.size(); i++) {
+            auto literalNode = typeid(*operands[i]) == typeid(LiteralNode) ? static_cast<LiteralNode *>(operands[i]) : nullptr;
+            if (literalNode && literalNode->type == "string") {
+                std::string_view text = literalNode->value;
+                if (text.length() >= 2 && text.front() == '"' && text.back() == '"')
+                    text = text.substr(1, text.length() - 2);
+                parts[i] = text;
+            }
+            else {
+                values[i] = evaluateValue(operands[i]);
+                parts[i] = values[i].str();
+            }
+            length += parts[i].length();
+        }
+
+        std::string result;
+        result.reserve(length);
+        for (std::string_view part : parts)
+            result.append(part);
+        return result;
+    }
+
+    std::string applyComparison(BinaryOperationNode *node, const Operand &left, const Operand &right)
+    {
+        if (!left.isInt || !right.isInt)
+            return evaluateDynamic(node->op, left.toString(), right.toString());
+
+        bool result = false;
+        switch (node->operation) {
+        case BinaryOperation::IntEquals:
+            result = left.number == right.number;
+            break;
+        case BinaryOperation::IntLess:
+            result = left.number < right.number;
+            break;
+        case BinaryOperation::IntLessEqual:
+            result = left.number <= right.number;
+            break;
+        case BinaryOperation::IntGreater:
+            result = left.number > right.number;
+            break;
+        default:
+            result = left.number >= right.number;
+            break;
+        }
+        return result ? "true" : "false";
+    }
+
+    std::string evaluateComparison(BinaryOperationNode *node)
+    {
+        Operand left = evaluateOperand(node->left.get());
+        Operand right = evaluateOperand(node->right.get());
+        return applyComparison(node, left, right);
+    }
+}
+
+std::string evaluateBinary(BinaryOperationNode *node, std::string left, std::string right)
+{
+    switch (node->operation)
+    {
+    case BinaryOperation::IntAdd:
+    case BinaryOperation::IntSubtract:
+    case BinaryOperation::IntMultiply:
+    case BinaryOperation::IntDivide:
+        return applyIntOperation(node, toOperand(std::move(left)), toOperand(std::move(right))).toString();
+    case BinaryOperation::IntEquals:
+    case BinaryOperation::IntLess:
+    case BinaryOperation::IntLessEqual:
+    case BinaryOperation::IntGreater:
+    case BinaryOperation::IntGreaterEqual:
+        return applyComparison(node, toOperand(std::move(left)), toOperand(std::move(right)));
+    case BinaryOperation::Concat:
+        return std::move(left) + right;
+    case BinaryOperation::ValueEquals:
+        return left == right ? "true" : "false";
+    case BinaryOperation::Dynamic:
+        break;
+    }
+    return evaluateDynamic(node->op, left, right);
+}
+
+bool isTrue(const std::string &condition)
+{
+    if (condition == "true")
+        return true;
+    if (condition == "false")
+        return false;
+    int number;
+    if (toInt(condition, number))
+        return number != 0;
+    return !condition.empty();
+}
 
 std::string evaluateNode(ASTNode *node)
 {
@@ -12,7 +311,7 @@ std::string evaluateNode(ASTNode *node)
     {
         if (literalNode->type == "identifier")
         {
-            std::string value = SymbolTable::getInstance().getValue(literalNode->value);
+            const std::string &value = SymbolTable::getInstance().getValue(literalNode->symbol);
             return value.empty() ? literalNode->value : value;
         }
         if (literalNode->type == "string") {
@@ -25,53 +324,46 @@ std::string evaluateNode(ASTNode *node)
     }
     else if (auto binaryOpNode = dynamic_cast<BinaryOperationNode *>(node))
     {
-        std::string left = evaluateNode(binaryOpNode->left.get());
-        std::string right = evaluateNode(binaryOpNode->right.get());
-
-        if (binaryOpNode->op == "+")
+        // Dispatch on the operation the TypeChecker resolved
+        switch (binaryOpNode->operation)
         {
-            try {
-                return std::to_string(std::stoi(left) + std::stoi(right));
-            } catch (...) {
-                return left + right;
-            }
-        }
-        else if (binaryOpNode->op == "*")
-        {
-            try {
-                return std::to_string(std::stoi(left) * std::stoi(right));
-            } catch (...) {
-                return "0";
-            }
+        case BinaryOperation::IntAdd:
+        case BinaryOperation::IntSubtract:
+        case BinaryOperation::IntMultiply:
+        case BinaryOperation::IntDivide:
+            return evaluateIntOperation(binaryOpNode).toString();
+        case BinaryOperation::IntEquals:
+        case BinaryOperation::IntLess:
+        case BinaryOperation::IntLessEqual:
+        case BinaryOperation::IntGreater:
+        case BinaryOperation::IntGreaterEqual:
+            return evaluateComparison(binaryOpNode);
+        case BinaryOperation::Concat:
+            return evaluateConcat(binaryOpNode);
+        case BinaryOperation::ValueEquals:
+            return evaluateValue(binaryOpNode->left.get()).str() == evaluateValue(binaryOpNode->right.get()).str() ? "true" : "false";
+        case BinaryOperation::Dynamic:
+            break;
         }
+
+        std::string left = evaluateNode(binaryOpNode->left.get());
+        std::string right = evaluateNode(binaryOpNode->right.get());
+        return evaluateDynamic(binaryOpNode->op, left, right);
     }
     else if (auto functionCallNode = dynamic_cast<FunctionCallNode *>(node))
     {
         auto& mm = ModuleManager::getInstance();
-        return mm.callFunction(functionCallNode->name, functionCallNode->arguments);
+        return mm.callFunction(functionCallNode->symbol, functionCallNode->arguments);
+    }
+    else if (auto varDeclNode = dynamic_cast<VariableDeclarationNode *>(node))
+    {
+        SymbolTable::getInstance().setValue(varDeclNode->symbol, evaluateValue(varDeclNode->initializer.get()));
+        return "";
     }
     else if (auto ifNode = dynamic_cast<IfStatementNode*>(node))
     {
-        std::string condValue = evaluateNode(ifNode->condition.get());
-        
-        // Convert condition to boolean
-        bool condBool = false;
-        if (condValue == "true") {
-            condBool = true;
-        }
-        else if (condValue == "false") {
-            condBool = false;
-        }
-        else {
-            try {
-                condBool = std::stoi(condValue) != 0;
-            } catch (...) {
-                condBool = !condValue.empty();
-            }
-        }
-        
         std::string result;
-        if (condBool) {
+        if (isTrue(evaluateNode(ifNode->condition.get()))) {
             for (const auto& stmt : ifNode->thenBranch) {
                 result = evaluateNode(stmt.get());
             }
@@ -84,3 +376,18 @@ std::string evaluateNode(ASTNode *node)
     }
     return "";
 }
+
+Value evaluateValue(ASTNode *node)
+{
+    if (node && typeid(*node) == typeid(LiteralNode))
+    {
+        auto literalNode = static_cast<LiteralNode *>(node);
+        if (literalNode->type == "identifier")
+        {
+            const Value &value = SymbolTable::getInstance().getShared(literalNode->symbol);
+            if (!value.empty())
+                return value;
+        }
+    }
+    return evaluateNode(node);
+}
@@ -0,0 +1,124 @@
+#include "frame_code.h"
+
+namespace
+{
+    using Op = FrameInstruction::Op;
+
+    class FrameCompiler
+    {
+    public:
+        explicit FrameCompiler(const IsUserCall &isUserCall) : isUserCall_(isUserCall) {}
+
+        std::vector<FrameInstruction> compile(const FunctionNode &function)
+        {
+            // The value of a function is the value of its last statement
+            compileStatements(function.body, true);
+            emit(Op::Return);
+            return std::move(code_);
+        }
+
+    private:
+        // Whether evaluating `node` can call a user function; such nodes
+        // are compiled instruction by instruction
+        bool reachesUserCall(const ASTNode *node) const
+        {
+            if (auto call = dynamic_cast<const FunctionCallNode *>(node))
+            {
+                if (isUserCall_(*call))
+                    return true;
+                for (const auto &argument : call->arguments)
+                {
+                    if (reachesUserCall(argument.get()))
+                        return true;
+                }
+                return false;
+            }
+            if (auto binary = dynamic_cast<const BinaryOperationNode *>(node))
+                return reachesUserCall(binary->left.get()) || reachesUserCall(binary->right.get());
+            if (auto declaration = dynamic_cast<const VariableDeclarationNode *>(node))
+                return reachesUserCall(declaration->initializer.get());
+            if (auto ifNode = dynamic_cast<const IfStatementNode *>(node))
+            {
+                if (reachesUserCall(ifNode->condition.get()))
+                    return true;
+                for (const auto *branch : {&ifNode->thenBranch, &ifNode->elseBranch})
+                {
+                    for (const auto &statement : *branch)
+                    {
+                        if (reachesUserCall(statement.get()))
+                            return true;
+                    }
+                }
+            }
+            return false;
+        }
+
+        // An empty list is worth "", like an if whose branch is empty
+        void compileStatements(const std::vector<std::unique_ptr<ASTNode>> &statements, bool tail)
+        {
+            if (statements.empty())
+            {
+                emit(Op::PushEmpty);
+                return;
+            }
+            for (size_t i = 0; i < statements.size(); i++)
+            {
+                if (i)
+                    emit(Op::Pop);
+                compile(statements[i].get(), tail && i + 1 == statements.size());
+            }
+        }
+
+        // `tail` is set for the value the function returns
+        void compile(ASTNode *node, bool tail)
+        {
+            if (!node || !reachesUserCall(node))
+            {
+                emit(Op::Evaluate, node);
+                return;
+            }
+
+            if (auto call = dynamic_cast<FunctionCallNode *>(node))
+            {
+                for (const auto &argument : call->arguments)
+                    compile(argument.get(), false);
+                emit(tail && isUserCall_(*call) ? Op::TailCall : Op::Call, node);
+            }
+            else if (auto binary = dynamic_cast<BinaryOperationNode *>(node))
+            {
+                compile(binary->left.get(), false);
+                compile(binary->right.get(), false);
+                emit(Op::Binary, node);
+            }
+            else if (auto declaration = dynamic_cast<VariableDeclarationNode *>(node))
+            {
+                compile(declaration->initializer.get(), false);
+                emit(Op::Store, node);
+            }
+            else if (auto ifNode = dynamic_cast<IfStatementNode *>(node))
+            {
+                compile(ifNode->condition.get(), false);
+                size_t toElse = emit(Op::JumpIfFalse);
+                compileStatements(ifNode->thenBranch, tail);
+                size_t toEnd = emit(Op::Jump);
+                code_[toElse].target = static_cast<uint32_t>(code_.size());
+                compileStatements(ifNode->elseBranch, tail);
+                code_[toEnd].target = static_cast<uint32_t>(code_.size());
+            }
+        }
+
+        size_t emit(Op op, ASTNode *node = nullptr)
+        {
+            code_.push_back({op, 0, node});
+            return code_.size() - 1;
+        }
+
+        const IsUserCall &isUserCall_;
+        std::vector<FrameInstruction> code_;
+    };
+}
+
+std::vector<FrameInstruction> compileFrameCode(const FunctionNode &function, const IsUserCall &isUserCall)
+{
+    return FrameCompiler(isUserCall).compile(function);
+}
@@ -0,0 +1,127 @@
+#include "mapped_file.h"
+#include "standard_library.h"
+#include "module_manager.h"
+#include "evaluator.h"
+
+#include <charconv>
+#include <stdexcept>
+
+namespace
+{
+    using Arguments = std::vector<std::unique_ptr<ASTNode>>;
+
+    [[noreturn]] void fail(const std::string &function, const std::string &message)
+    {
+        throw std::runtime_error("fs." + function + ": " + message);
+    }
+
+    void expectArguments(const std::string &function, const Arguments &args, size_t count)
+    {
+        if (args.size() != count)
+            fail(function, "expects " + std::to_string(count) + " arguments, got " + std::to_string(args.size()));
+    }
+
+    const MappedFile &argumentReader(const std::string &function, const Arguments &args)
+    {
+        std::string handle = evaluateNode(args[0].get());
+        const MappedFile *file = FileStore::getInstance().findReader(handle);
+        if (!file)
+            fail(function, "'" + handle + "' is not a file open for reading");
+        return *file;
+    }
+}
+
+void registerFsModule()
+{
+    auto &mm = ModuleManager::getInstance();
+
+    // fs.open(path) opens a file for reading; fs.open(path, "w") truncates
+    // it for writing and fs.open(path, "a") appends to it
+    mm.registerFunction("std.fs", "open", [](const Arguments &args) {
+        if (args.size() != 1 && args.size() != 2)
+            fail("open", "expects 1 or 2 arguments, got " + std::to_string(args.size()));
+        std::string path = evaluateNode(args[0].get());
+        std::string mode = args.size() == 2 ? evaluateNode(args[1].get()) : "r";
+        if (mode != "r" && mode != "w" && mode != "a")
+            fail("open", "unknown mode '" + mode + "'");
+        try
+        {
+            if (mode == "r")
+                return FileStore::getInstance().add(std::make_unique<MappedFile>(path));
+            return FileStore::getInstance().add(std::make_unique<FileWriter>(path, mode == "a"));
+        }
+        catch (const std::runtime_error &e)
+        {
+            fail("open", e.what());
+        }
+    });
+
+    mm.registerFunction("std.fs", "read_all", [](const Arguments &args) {
+        expectArguments("read_all", args, 1);
+        return std::string(argumentReader("read_all", args).contents());
+    });
+
+    // fs.lines(f) is the number of lines; fs.line(f, i) is line i, from 0,
+    // without its newline
+    mm.registerFunction("std.fs", "lines", [](const Arguments &args) {
+        expectArguments("lines", args, 1);
+        return std::to_string(argumentReader("lines", args).lineCount());
+    });
+
+    mm.registerFunction("std.fs", "line", [](const Arguments &args) {
+        expectArguments("line", args, 2);
+        const MappedFile &file = argumentReader("line", args);
+        std::string text = evaluateNode(args[1].get());
+        size_t index;
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), index);
+        if (error != std::errc() || end != text.data() + text.size() || index >= file.lineCount())
+            fail("line", "index '" + text + "' out of range for " + std::to_string(file.lineCount()) + " lines");
+        return std::string(file.line(index));
+    });
+
+    // fs.write(f, parts...) writes the parts one after another;
+    // fs.write_line(f, parts...) adds a newline
+    for (bool newline : {false, true})
+    {
+        std::string name = newline ? "write_line" : "write";
+        mm.registerFunction("std.fs", name, [name, newline](const Arguments &args) {
+            if (args.empty())
+                fail(name, "expects a file");
+            std::string handle = evaluateNode(args[0].get());
+            FileWriter *file = FileStore::getInstance().findWriter(handle);
+            if (!file)
+                fail(name, "'" + handle + "' is not a file open for writing");
+            std::string text;
+            for (size_t i = 1; i < args.size(); i++)
+                text += evaluateNode(args[i].get());
+            if (newline)
+                text += '\n';
+            try
+            {
+                file->write(text);
+            }
+            catch (const std::runtime_error &e)
+            {
+                fail(name, e.what());
+            }
+            return std::string();
+        });
+    }
+
+    mm.registerFunction("std.fs", "close", [](const Arguments &args) {
+        expectArguments("close", args, 1);
+        std::string handle = evaluateNode(args[0].get());
+        bool closed;
+        try
+        {
+            closed = FileStore::getInstance().close(handle);
+        }
+        catch (const std::runtime_error &e)
+        {
+            fail("close", e.what());
+        }
+        if (!closed)
+            fail("close", "'" + handle + "' is not an open file");
+        return std::string();
+    });
+}
@@ -0,0 +1,510 @@
+#include "heap.h"
+#include "channel.h"
+#include "string_map.h"
+
+#include <algorithm>
+#include <charconv>
+#include <new>
+
+namespace
+{
+    const std::string kPrefixes[] = {"array#", "map#", "chan#"};
+
+    size_t index(Heap::Kind kind)
+    {
+        return static_cast<size_t>(kind);
+    }
+
+    // What one more map entry costs besides its key and value
+    constexpr size_t kEntryBytes = sizeof(StringMap::Entry) + sizeof(uint32_t) + 1;
+
+    // The nursery grows in chunks and keeps a young generation's worth of
+    // them from one minor collection to the next
+    constexpr size_t kChunkBytes = size_t(1) << 20;
+    constexpr size_t kKeptChunks = Heap::kYoungBytes / kChunkBytes;
+}
+
+// Bump allocator behind young arrays. Deallocation does nothing; reset()
+// takes everything back at once.
+class Heap::Nursery : public std::pmr::memory_resource
+{
+public:
+    void reset()
+    {
+        chunks_.erase(std::remove_if(chunks_.begin(), chunks_.end(),
+                                     [](const Chunk &chunk) { return chunk.size != kChunkBytes; }),
+                      chunks_.end());
+        if (chunks_.size() > kKeptChunks)
+            chunks_.resize(kKeptChunks);
+        current_ = 0;
+        offset_ = 0;
+    }
+
+private:
+    struct Chunk
+    {
+        std::unique_ptr<std::byte[]> memory;
+        size_t size;
+    };
+
+    void *do_allocate(size_t bytes, size_t alignment) override
+    {
+        for (; current_ < chunks_.size(); current_++, offset_ = 0)
+        {
+            const Chunk &chunk = chunks_[current_];
+            uintptr_t base = reinterpret_cast<uintptr_t>(chunk.memory.get());
+            size_t start = ((base + offset_ + alignment - 1) & ~(alignment - 1)) - base;
+            if (start + bytes <= chunk.size)
+            {
+                offset_ = start + bytes;
+                return chunk.memory.get() + start;
+            }
+        }
+        size_t size = std::max(kChunkBytes, bytes + alignment);
+        chunks_.push_back({std::unique_ptr<std::byte[]>(new std::byte[size]), size});
+        current_ = chunks_.size() - 1;
+        return do_allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *, size_t, size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    std::vector<Chunk> chunks_;
+    size_t current_ = 0; // chunk being filled
+    size_t offset_ = 0;
+};
+
+// Makes a thread's Mutator known to the collector for as long as the thread
+// lives
+struct Heap::Registration
+{
+    Mutator mutator;
+
+    Registration()
+    {
+        Heap &heap = Heap::getInstance();
+        std::lock_guard<std::mutex> guard(heap.mutatorsMutex_);
+        heap.mutators_.push_back(&mutator);
+    }
+
+    ~Registration()
+    {
+        Heap &heap = Heap::getInstance();
+        std::lock_guard<std::mutex> guard(heap.mutatorsMutex_);
+        heap.mutators_.erase(std::remove(heap.mutators_.begin(), heap.mutators_.end(), &mutator),
+                             heap.mutators_.end());
+    }
+};
+
+Heap::Mutator &Heap::currentMutator()
+{
+    thread_local Registration registration;
+    return registration.mutator;
+}
+
+// Never destroyed: tasks still running when the program ends may use its
+// objects
+Heap &Heap::getInstance()
+{
+    static Heap *instance = new Heap;
+    return *instance;
+}
+
+Heap::Heap() : nursery_(std::make_unique<Nursery>()) {}
+
+std::pair<std::string, TypedArray *> Heap::newArray(TypedArray::Kind kind, size_t capacity)
+{
+    size_t bytes = sizeof(TypedArray) + capacity * sizeof(int64_t);
+    bool inNursery = bytes < kLargeArrayBytes;
+    TypedArray *array = inNursery ? new (nursery_->allocate(sizeof(TypedArray), alignof(TypedArray)))
+                                        TypedArray(kind, nursery_.get())
+                                  : new TypedArray(kind);
+    // Tracked first, so that it is collected if reserving fails
+    std::string handle = add(Kind::Array, array, bytes, inNursery);
+    array->reserve(capacity);
+    return {std::move(handle), array};
+}
+
+std::pair<std::string, StringMap *> Heap::newMap()
+{
+    auto map = new StringMap;
+    return {add(Kind::Map, map, map->memoryBytes(), false), map};
+}
+
+std::pair<std::string, Channel *> Heap::newChannel(size_t capacity)
+{
+    auto channel = new Channel(capacity);
+    return {add(Kind::Channel, channel, channel->memoryBytes(), false), channel};
+}
+
+std::string Heap::add(Kind kind, void *pointer, size_t bytes, bool inNursery)
+{
+    uint64_t id = nextId_[index(kind)]++;
+    Object &object = objects_[index(kind)][id];
+    object.pointer = pointer;
+    object.id = id;
+    object.kind = kind;
+    object.inNursery = inNursery;
+    young_.push_back(&object);
+    noteAllocation(bytes);
+    return kPrefixes[index(kind)] + std::to_string(id);
+}
+
+const TypedArray *Heap::findArray(const std::string &handle)
+{
+    Object *object = find(Kind::Array, handle);
+    return object ? static_cast<const TypedArray *>(object->pointer) : nullptr;
+}
+
+StringMap *Heap::findMap(const std::string &handle)
+{
+    Object *object = find(Kind::Map, handle);
+    return object ? static_cast<StringMap *>(object->pointer) : nullptr;
+}
+
+Channel *Heap::findChannel(const std::string &handle)
+{
+    Object *object = find(Kind::Channel, handle);
+    return object ? static_cast<Channel *>(object->pointer) : nullptr;
+}
+
+Heap::Object *Heap::find(const std::string &handle)
+{
+    if (handle.empty())
+        return nullptr;
+    switch (handle[0])
+    {
+    case 'a':
+        return find(Kind::Array, handle);
+    case 'm':
+        return find(Kind::Map, handle);
+    case 'c':
+        return find(Kind::Channel, handle);
+    default:
+        return nullptr;
+    }
+}
+
+Heap::Object *Heap::find(Kind kind, const std::string &handle)
+{
+    const std::string &prefix = kPrefixes[index(kind)];
+    if (handle.compare(0, prefix.size(), prefix) != 0)
+        return nullptr;
+    uint64_t id;
+    const char *begin = handle.data() + prefix.size();
+    const char *end = handle.data() + handle.size();
+    auto result = std::from_chars(begin, end, id);
+    if (result.ec != std::errc() || result.ptr != end)
+        return nullptr;
+    auto &table = objects_[index(kind)];
+    auto it = table.find(id);
+    return it != table.end() ? &it->second : nullptr;
+}
+
+void Heap::noteAllocation(size_t bytes)
+{
+    stats_.allocatedBytes += bytes;
+    youngBytes_ += bytes;
+    if (youngBytes_ >= kYoungBytes)
+    {
+        collectionDue_ = true;
+        if (requestSafepoint_)
+            requestSafepoint_();
+    }
+}
+
+void Heap::storedInMap(const std::string &map, const std::string &key, const std::string &value)
+{
+    size_t bytes = key.size() + value.size() + kEntryBytes;
+    noteAllocation(bytes);
+    Object *object = find(Kind::Map, map);
+    if (!object || !object->old)
+        return;
+    oldBytes_ += bytes;
+    // The write barrier: minor collections trace old maps only from here
+    if (!object->remembered && (find(key) || find(value)))
+    {
+        object->remembered = true;
+        remembered_.push_back(object);
+    }
+}
+
+bool Heap::pin(const std::string &value)
+{
+    Object *object = find(value);
+    if (!object)
+        return false;
+    if (object->pins++ == 0)
+        pinned_.insert(object);
+    return true;
+}
+
+void Heap::unpin(const std::string &value)
+{
+    Object *object = find(value);
+    if (object && object->pins && --object->pins == 0)
+        pinned_.erase(object);
+}
+
+// Only handles are copied, so pinning a long message costs nothing
+Heap::Pin::Pin(const std::string &value)
+{
+    if (Heap::getInstance().pin(value))
+        value_ = value;
+}
+
+Heap::Pin::~Pin()
+{
+    if (!value_.empty())
+        Heap::getInstance().unpin(value_);
+}
+
+void Heap::addThreadRoots(RootScanner scanner)
+{
+    Mutator &mutator = currentMutator();
+    std::lock_guard<std::mutex> guard(mutatorsMutex_);
+    mutator.roots.push_back(std::move(scanner));
+}
+
+void Heap::addRoots(RootScanner scanner)
+{
+    std::lock_guard<std::mutex> guard(mutatorsMutex_);
+    roots_.push_back(std::move(scanner));
+}
+
+void Heap::detachThread()
+{
+    Mutator &mutator = currentMutator();
+    std::lock_guard<std::mutex> guard(mutatorsMutex_);
+    mutators_.erase(std::remove(mutators_.begin(), mutators_.end(), &mutator), mutators_.end());
+    mutator.roots.clear();
+}
+
+// Only the owning thread changes its count, so a plain store will do
+Heap::Busy::Busy() : busy_(currentMutator().busy)
+{
+    busy_.store(busy_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+Heap::Busy::~Busy()
+{
+    busy_.store(busy_.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+}
+
+Heap::Parked::Parked() : busy_(currentMutator().busy), saved_(busy_.load(std::memory_order_relaxed))
+{
+    busy_.store(0, std::memory_order_relaxed);
+}
+
+Heap::Parked::~Parked()
+{
+    busy_.store(saved_, std::memory_order_relaxed);
+}
+
+bool Heap::allThreadsAtSafepoints()
+{
+    if (currentMutator().busy.load(std::memory_order_relaxed))
+        return false;
+    std::lock_guard<std::mutex> guard(mutatorsMutex_);
+    for (const Mutator *mutator : mutators_)
+    {
+        if (mutator->busy.load(std::memory_order_relaxed))
+            return false;
+    }
+    return true;
+}
+
+void Heap::safepoint()
+{
+    if (collectionDue_ && allThreadsAtSafepoints())
+        collect(oldBytes_ >= majorThreshold_);
+}
+
+void Heap::collect()
+{
+    if (allThreadsAtSafepoints())
+        collect(true);
+}
+
+void Heap::collect(bool major)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    {
+        std::lock_guard<std::mutex> guard(mutatorsMutex_);
+        RootVisitor visit = [this, major](const std::string &value) { markValue(value, major); };
+        for (const Mutator *mutator : mutators_)
+        {
+            for (const RootScanner &scan : mutator->roots)
+                scan(visit);
+        }
+        for (const RootScanner &scan : roots_)
+            scan(visit);
+    }
+    for (Object *object : pinned_)
+        mark(object, major);
+    if (!major)
+    {
+        for (Object *object : remembered_)
+            traceMap(object, major);
+    }
+    while (!gray_.empty())
+    {
+        Object *object = gray_.back();
+        gray_.pop_back();
+        traceMap(object, major);
+    }
+    for (Object *object : remembered_)
+        object->remembered = false;
+    remembered_.clear();
+
+    std::vector<Channel *> channels;
+    if (major)
+    {
+        oldBytes_ = 0;
+        for (auto &table : objects_)
+        {
+            for (auto it = table.begin(); it != table.end();)
+            {
+                Object &object = it->second;
+                if (!object.marked)
+                {
+                    destroy(object, channels);
+                    it = table.erase(it);
+                    continue;
+                }
+                object.marked = false;
+                if (object.old)
+                    oldBytes_ += measure(object);
+                else
+                    promote(object);
+                ++it;
+            }
+        }
+        majorThreshold_ = std::max(kMinMajorBytes, 2 * oldBytes_);
+        stats_.majorCollections++;
+    }
+    else
+    {
+        for (Object *object : young_)
+        {
+            if (object->marked)
+            {
+                object->marked = false;
+                promote(*object);
+                continue;
+            }
+            Kind kind = object->kind;
+            uint64_t id = object->id;
+            destroy(*object, channels);
+            objects_[index(kind)].erase(id);
+        }
+        stats_.minorCollections++;
+    }
+    young_.clear();
+    nursery_->reset();
+    youngBytes_ = 0;
+    collectionDue_ = false;
+
+    // Messages left in a dead channel no longer keep their objects alive
+    for (Channel *channel : channels)
+    {
+        Value message;
+        while (channel->tryReceive(message) == Channel::Status::Done)
+            unpin(message.str());
+        delete channel;
+    }
+
+    stats_.liveObjects = 0;
+    for (const auto &table : objects_)
+        stats_.liveObjects += table.size();
+    auto pause = std::chrono::steady_clock::now() - start;
+    stats_.totalPause += pause;
+    stats_.maxPause = std::max<std::chrono::nanoseconds>(stats_.maxPause, pause);
+}
+
+void Heap::mark(Object *object, bool major)
+{
+    if (object->marked || (object->old && !major))
+        return;
+    object->marked = true;
+    if (object->kind == Kind::Map)
+        gray_.push_back(object);
+}
+
+void Heap::markValue(const std::string &value, bool major)
+{
+    if (Object *object = find(value))
+        mark(object, major);
+}
+
+void Heap::traceMap(Object *object, bool major)
+{
+    const StringMap &map = *static_cast<const StringMap *>(object->pointer);
+    for (size_t i = 0; i < map.size(); i++)
+    {
+        const StringMap::Entry &entry = map.entryAt(i);
+        markValue(entry.key, major);
+        if (!entry.value.isInt)
+            markValue(entry.value.text, major);
+    }
+}
+
+void Heap::promote(Object &object)
+{
+    if (object.inNursery)
+    {
+        auto young = static_cast<TypedArray *>(object.pointer);
+        auto array = new TypedArray(young->kind);
+        array->ints.assign(young->ints.begin(), young->ints.end());
+        array->doubles.assign(young->doubles.begin(), young->doubles.end());
+        young->~TypedArray();
+        object.pointer = array;
+        object.inNursery = false;
+    }
+    object.old = true;
+    size_t bytes = measure(object);
+    oldBytes_ += bytes;
+    stats_.promotedBytes += bytes;
+}
+
+void Heap::destroy(Object &object, std::vector<Channel *> &channels)
+{
+    stats_.collectedObjects++;
+    stats_.collectedBytes += measure(object);
+    switch (object.kind)
+    {
+    case Kind::Array: {
+        auto array = static_cast<TypedArray *>(object.pointer);
+        if (object.inNursery)
+            array->~TypedArray();
+        else
+            delete array;
+        break;
+    }
+    case Kind::Map:
+        delete static_cast<StringMap *>(object.pointer);
+        break;
+    case Kind::Channel:
+        channels.push_back(static_cast<Channel *>(object.pointer));
+        break;
+    }
+}
+
+size_t Heap::measure(const Object &object)
+{
+    switch (object.kind)
+    {
+    case Kind::Array:
+        return sizeof(TypedArray) + static_cast<const TypedArray *>(object.pointer)->capacity() * sizeof(int64_t);
+    case Kind::Map:
+        return static_cast<const StringMap *>(object.pointer)->memoryBytes();
+    case Kind::Channel:
+        return static_cast<const Channel *>(object.pointer)->memoryBytes();
+    }
+    return 0;
+}
@@ -0,0 +1,353 @@
+#include "incremental_parser.h"
+#include "lexer.h"
+#include "parser.h"
+#include "module_manager.h"
+
+#include <algorithm>
+
+namespace
+{
+    struct RegionParse
+    {
+        std::unique_ptr<ASTNode> node;
+        std::vector<Diagnostic> diagnostics;
+        bool complete = false; // parser stopped exactly at the end of the region
+    };
+
+    template <typename ParseFn>
+    RegionParse parseRegion(const std::string &text, size_t begin, size_t end, int line, const void *owner,
+                            ParseFn parse)
+    {
+        Lexer lexer(text, begin, end, line);
+        lexer.setQuiet(true);
+        Parser parser(lexer, text);
+        parser.setQuiet(true);
+        parser.setFunctionOwner(owner);
+
+        RegionParse result;
+        result.node = parse(parser);
+        result.complete = parser.atEnd();
+        result.diagnostics = lexer.getDiagnostics();
+        const auto &parserDiagnostics = parser.getDiagnostics();
+        result.diagnostics.insert(result.diagnostics.end(), parserDiagnostics.begin(), parserDiagnostics.end());
+        return result;
+    }
+
+    void unregisterFunctions(const ModuleNode &module, const void *owner)
+    {
+        auto &mm = ModuleManager::getInstance();
+        for (const auto &member : module.body)
+        {
+            if (auto fn = dynamic_cast<const FunctionNode *>(member.get()))
+                mm.unregisterUserDefinedFunction(module.name, fn->name, owner);
+        }
+    }
+
+    void shiftOffset(size_t &value, size_t oldOffset, ptrdiff_t delta)
+    {
+        if (value >= oldOffset)
+            value = static_cast<size_t>(static_cast<ptrdiff_t>(value) + delta);
+    }
+}
+
+IncrementalDocument::IncrementalDocument(std::string text) : text_(std::move(text))
+{
+    lineStarts_.push_back(0);
+    for (size_t i = 0; i < text_.size(); i++)
+    {
+        if (text_[i] == '\n')
+            lineStarts_.push_back(i + 1);
+    }
+    reparseAll();
+}
+
+IncrementalDocument::~IncrementalDocument()
+{
+    for (const auto &span : spans_)
+        unregisterFunctions(*span.module, this);
+}
+
+void IncrementalDocument::registerFunctions() const
+{
+    auto &mm = ModuleManager::getInstance();
+    for (const auto &span : spans_)
+    {
+        for (const FunctionNode *fn : span.functions)
+            mm.registerUserDefinedFunction(span.module->name, fn->name, fn->parameters, fn->returnType, fn->clone(),
+                                           this);
+    }
+}
+
+bool IncrementalDocument::applyEdit(const TextEdit &edit)
+{
+    if (edit.offset > text_.size() || edit.length > text_.size() - edit.offset)
+        return false;
+
+    size_t editEnd = edit.offset + edit.length;
+    ptrdiff_t delta = static_cast<ptrdiff_t>(edit.text.size()) - static_cast<ptrdiff_t>(edit.length);
+    text_.replace(edit.offset, edit.length, edit.text);
+    updateLineIndex(edit);
+
+    // Offsets in the tree are still pre-edit here; the closing brace of the
+    // enclosing declaration must survive the edit
+    auto startsAfter = [](size_t offset, const auto *node) { return offset < node->startOffset; };
+    auto moduleIt = std::upper_bound(spans_.begin(), spans_.end(), edit.offset,
+                                     [&](size_t offset, const ModuleSpan &span) { return startsAfter(offset, span.module); });
+    if (moduleIt != spans_.begin())
+    {
+        size_t moduleIndex = static_cast<size_t>(moduleIt - spans_.begin()) - 1;
+        const ModuleSpan &span = spans_[moduleIndex];
+        if (editEnd < span.module->endOffset)
+        {
+            auto fnIt = std::upper_bound(span.functions.begin(), span.functions.end(), edit.offset,
+                                         [&](size_t offset, const FunctionNode *fn) { return startsAfter(offset, fn); });
+            if (fnIt != span.functions.begin() && editEnd < (*(fnIt - 1))->endOffset)
+            {
+                size_t functionIndex = static_cast<size_t>(fnIt - span.functions.begin()) - 1;
+                if (reparseFunction(moduleIndex, functionIndex, delta))
+                    return true;
+            }
+            if (reparseModule(moduleIndex, delta))
+                return true;
+        }
+    }
+
+    reparseAll();
+    return true;
+}
+
+IncrementalDocument::ModuleSpan IncrementalDocument::indexModule(size_t slot, ModuleNode *module)
+{
+    ModuleSpan span;
+    span.slot = slot;
+    span.module = module;
+    for (size_t i = 0; i < module->body.size(); i++)
+    {
+        if (auto fn = dynamic_cast<FunctionNode *>(module->body[i].get()))
+        {
+            span.functionSlots.push_back(i);
+            span.functions.push_back(fn);
+        }
+    }
+    return span;
+}
+
+void IncrementalDocument::rebuildIndex()
+{
+    spans_.clear();
+    for (size_t i = 0; i < program_->body.size(); i++)
+    {
+        if (auto module = dynamic_cast<ModuleNode *>(program_->body[i].get()))
+            spans_.push_back(indexModule(i, module));
+    }
+}
+
+bool IncrementalDocument::reparseFunction(size_t moduleIndex, size_t functionIndex, ptrdiff_t delta)
+{
+    ModuleSpan &span = spans_[moduleIndex];
+    FunctionNode &old = *span.functions[functionIndex];
+    size_t begin = old.startOffset;
+    size_t oldEnd = old.endOffset;
+    size_t end = static_cast<size_t>(static_cast<ptrdiff_t>(oldEnd) + delta);
+    if (diagnosticAtBoundary(begin, oldEnd))
+        return false;
+
+    auto region = parseRegion(text_, begin, end, positionOf(begin).first, this,
+                              [](Parser &parser) { return parser.parseFunctionDeclaration(); });
+    auto fn = dynamic_cast<FunctionNode *>(region.node.get());
+    if (!fn || !region.complete || !region.diagnostics.empty() || fn->endOffset != end)
+        return false;
+
+    auto &mm = ModuleManager::getInstance();
+    mm.unregisterUserDefinedFunction(span.module->name, old.name, this);
+    mm.registerUserDefinedFunction(span.module->name, fn->name, fn->parameters, fn->returnType, fn->clone(), this);
+
+    shiftFrom(moduleIndex, oldEnd, delta);
+    span.module->body[span.functionSlots[functionIndex]] = std::move(region.node);
+    span.functions[functionIndex] = fn;
+    replaceDiagnostics(begin, oldEnd, delta, {});
+    stats_.functionReparses++;
+    return true;
+}
+
+bool IncrementalDocument::reparseModule(size_t moduleIndex, ptrdiff_t delta)
+{
+    ModuleSpan &span = spans_[moduleIndex];
+    size_t begin = span.module->startOffset;
+    size_t oldEnd = span.module->endOffset;
+    size_t end = static_cast<size_t>(static_cast<ptrdiff_t>(oldEnd) + delta);
+    if (diagnosticAtBoundary(begin, oldEnd))
+        return false;
+
+    unregisterFunctions(*span.module, this);
+    auto region = parseRegion(text_, begin, end, positionOf(begin).first, this,
+                              [](Parser &parser) { return parser.parseModule(); });
+    auto module = dynamic_cast<ModuleNode *>(region.node.get());
+    if (!module || !region.complete || module->endOffset != end)
+        return false;
+    // A string or comment left open at the end of the region would have
+    // continued past it in the whole text
+    for (const Diagnostic &diagnostic : region.diagnostics)
+    {
+        if (diagnostic.offset >= end)
+            return false;
+    }
+
+    shiftFrom(moduleIndex + 1, oldEnd, delta);
+    program_->body[span.slot] = std::move(region.node);
+    span = indexModule(span.slot, module);
+    replaceDiagnostics(begin, oldEnd, delta, std::move(region.diagnostics));
+    stats_.moduleReparses++;
+    return true;
+}
+
+void IncrementalDocument::reparseAll()
+{
+    if (program_)
+    {
+        for (const auto &span : spans_)
+            unregisterFunctions(*span.module, this);
+    }
+
+    auto region = parseRegion(text_, 0, text_.size(), 1, this, [](Parser &parser) { return parser.parseProgram(); });
+    program_.reset(static_cast<ModuleNode *>(region.node.release()));
+    rebuildIndex();
+    diagnostics_ = std::move(region.diagnostics);
+    std::stable_sort(diagnostics_.begin(), diagnostics_.end(),
+              [](const Diagnostic &a, const Diagnostic &b) { return a.offset < b.offset; });
+    stats_.fullReparses++;
+}
+
+void IncrementalDocument::shiftFrom(size_t moduleIndex, size_t oldOffset, ptrdiff_t delta)
+{
+    if (delta == 0)
+        return;
+
+    for (size_t i = moduleIndex; i < spans_.size(); i++)
+    {
+        ModuleSpan &span = spans_[i];
+        shiftOffset(span.module->startOffset, oldOffset, delta);
+        shiftOffset(span.module->endOffset, oldOffset, delta);
+
+        // Only functions at or after the edit move
+        auto fnIt = std::lower_bound(span.functions.begin(), span.functions.end(), oldOffset,
+                                     [](const FunctionNode *fn, size_t offset) { return fn->endOffset < offset; });
+        for (; fnIt != span.functions.end(); ++fnIt)
+        {
+            shiftOffset((*fnIt)->startOffset, oldOffset, delta);
+            shiftOffset((*fnIt)->endOffset, oldOffset, delta);
+        }
+    }
+}
+
+// A diagnostic strictly inside a declaration came from parsing it. One on
+// its first or last byte may also have come from the enclosing parse, e.g.
+// a missing ';' reported at the next 'func', so only a wider reparse may
+// replace it.
+bool IncrementalDocument::diagnosticAtBoundary(size_t begin, size_t end) const
+{
+    return std::any_of(diagnostics_.begin(), diagnostics_.end(), [&](const Diagnostic &diagnostic) {
+        return diagnostic.offset == begin || diagnostic.offset == end || diagnostic.offset + 1 == end;
+    });
+}
+
+void IncrementalDocument::replaceDiagnostics(size_t begin, size_t oldEnd, ptrdiff_t delta,
+                                             std::vector<Diagnostic> fresh)
+{
+    std::vector<Diagnostic> merged;
+    for (auto &diagnostic : diagnostics_)
+    {
+        if (diagnostic.offset > begin && diagnostic.offset < oldEnd)
+            continue;
+        shiftOffset(diagnostic.offset, oldEnd, delta);
+        merged.push_back(std::move(diagnostic));
+    }
+    for (auto &diagnostic : fresh)
+        merged.push_back(std::move(diagnostic));
+
+    std::stable_sort(merged.begin(), merged.end(),
+              [](const Diagnostic &a, const Diagnostic &b) { return a.offset < b.offset; });
+    diagnostics_ = std::move(merged);
+}
+
+void IncrementalDocument::updateLineIndex(const TextEdit &edit)
+{
+    size_t editEnd = edit.offset + edit.length;
+    ptrdiff_t delta = static_cast<ptrdiff_t>(edit.text.size()) - static_cast<ptrdiff_t>(edit.length);
+
+    // Line starts created by newlines inside the replaced range disappear
+    auto first = std::upper_bound(lineStarts_.begin(), lineStarts_.end(), edit.offset);
+    auto last = std::upper_bound(first, lineStarts_.end(), editEnd);
+    first = lineStarts_.erase(first, last);
+
+    for (auto it = first; it != lineStarts_.end(); ++it)
+        *it = static_cast<size_t>(static_cast<ptrdiff_t>(*it) + delta);
+
+    std::vector<size_t> inserted;
+    for (size_t i = 0; i < edit.text.size(); i++)
+    {
+        if (edit.text[i] == '\n')
+            inserted.push_back(edit.offset + i + 1);
+    }
+    lineStarts_.insert(first, inserted.begin(), inserted.end());
+}
+
+const FunctionNode *IncrementalDocument::findFunction(const std::string &module, const std::string &name) const
+{
+    for (const auto &span : spans_)
+    {
+        if (span.module->name != module)
+            continue;
+        for (const FunctionNode *fn : span.functions)
+        {
+            if (fn->name == name)
+                return fn;
+        }
+    }
+    return nullptr;
+}
+
+const FunctionNode *IncrementalDocument::functionAt(size_t offset) const
+{
+    auto moduleIt = std::upper_bound(spans_.begin(), spans_.end(), offset,
+                                     [](size_t value, const ModuleSpan &span) { return value < span.module->startOffset; });
+    if (moduleIt == spans_.begin())
+        return nullptr;
+
+    const ModuleSpan &span = *(moduleIt - 1);
+    auto fnIt = std::upper_bound(span.functions.begin(), span.functions.end(), offset,
+                                 [](size_t value, const FunctionNode *fn) { return value < fn->startOffset; });
+    if (fnIt == span.functions.begin() || offset >= (*(fnIt - 1))->endOffset)
+        return nullptr;
+    return *(fnIt - 1);
+}
+
+std::vector<Diagnostic> IncrementalDocument::getDiagnostics() const
+{
+    std::vector<Diagnostic> result = diagnostics_;
+    for (auto &diagnostic : result)
+    {
+        auto position = positionOf(diagnostic.offset);
+        diagnostic.line = position.first;
+        diagnostic.column = position.second;
+    }
+    return result;
+}
+
+std::pair<int, int> IncrementalDocument::positionOf(size_t offset) const
+{
+    auto it = std::upper_bound(lineStarts_.begin(), lineStarts_.end(), offset);
+    size_t line = static_cast<size_t>(it - lineStarts_.begin()); // 1-based
+    return {static_cast<int>(line), static_cast<int>(offset - lineStarts_[line - 1] + 1)};
+}
+
+size_t IncrementalDocument::offsetOf(int line, int column) const
+{
+    if (line < 1)
+        return 0;
+    if (static_cast<size_t>(line) > lineStarts_.size())
+        return text_.size();
+
+    size_t offset = lineStarts_[line - 1] + static_cast<size_t>(std::max(column, 1) - 1);
+    return std::min(offset, text_.size());
+}
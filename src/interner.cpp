@@ -0,0 +1,31 @@
+#include "interner.h"
+
+Interner &Interner::getInstance()
+{
+    static Interner instance;
+    return instance;
+}
+
+Interner::Interner()
+{
+    names_.emplace_back();
+    symbols_.emplace(names_.back(), kNoSymbol);
+}
+
+Symbol Interner::intern(std::string_view name)
+{
+    auto it = symbols_.find(name);
+    if (it != symbols_.end())
+        return it->second;
+
+    Symbol symbol = static_cast<Symbol>(names_.size());
+    names_.emplace_back(name);
+    symbols_.emplace(names_.back(), symbol);
+    return symbol;
+}
+
+Symbol Interner::find(std::string_view name) const
+{
+    auto it = symbols_.find(name);
+    return it != symbols_.end() ? it->second : kNoSymbol;
+}
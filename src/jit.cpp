@@ -0,0 +1,725 @@
+#include "jit.h"
+
+#include <climits>
+#include <csetjmp>
+#include <cstring>
+#include <unordered_map>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace jit
+{
+#if defined(__x86_64__)
+    bool isAvailable() { return true; }
+#else
+    bool isAvailable() { return false; }
+#endif
+
+    namespace
+    {
+        thread_local jmp_buf *bailoutTarget = nullptr;
+
+        thread_local bool outOfStack = false;
+
+        // Lowest stack address compiled code may call at. Compiled code reads
+        // it through its address, so unlike the bailout state it is shared by
+        // all threads.
+        uintptr_t stackLimit = 0;
+
+        // Calls left before Budget::refill is asked, counted down by code
+        // compiled with countCalls; shared like stackLimit
+        uint64_t callsLeft = UINT64_MAX;
+        thread_local CompiledCode::Budget *currentBudget = nullptr;
+        thread_local bool outOfBudget = false;
+
+        // Called from compiled code; unwinds straight back into invoke()
+        [[noreturn]] void bailout()
+        {
+            longjmp(*bailoutTarget, 1);
+        }
+
+        [[noreturn]] void stackExhausted()
+        {
+            outOfStack = true;
+            longjmp(*bailoutTarget, 1);
+        }
+
+        // Called from compiled code when callsLeft ran out; the call that
+        // found it empty is charged to the refill
+        void callsExhausted()
+        {
+            uint64_t calls = 0;
+            if (!currentBudget->refill || !currentBudget->refill(calls))
+            {
+                outOfBudget = true;
+                longjmp(*bailoutTarget, 1);
+            }
+            callsLeft = calls;
+        }
+
+        enum Register
+        {
+            RAX = 0,
+            RCX = 1,
+            RDX = 2,
+            RSI = 6,
+            RDI = 7,
+            R8 = 8,
+            R9 = 9,
+        };
+
+        // System V integer argument registers
+        const Register argumentRegisters[kMaxParameters] = {RDI, RSI, RDX, RCX, R8, R9};
+
+        // Just enough of an x86-64 encoder for the code generator below
+        class Assembler
+        {
+        public:
+            using Label = size_t;
+
+            Label newLabel()
+            {
+                labels_.push_back(-1);
+                return labels_.size() - 1;
+            }
+
+            void bind(Label label) { labels_[label] = static_cast<int64_t>(code_.size()); }
+
+            void bytes(std::initializer_list<uint8_t> values) { code_.insert(code_.end(), values); }
+
+            void imm32(int32_t value)
+            {
+                for (int i = 0; i < 4; i++)
+                    code_.push_back(static_cast<uint8_t>(static_cast<uint32_t>(value) >> (8 * i)));
+            }
+
+            void imm64(int64_t value)
+            {
+                for (int i = 0; i < 8; i++)
+                    code_.push_back(static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i)));
+            }
+
+            void push(Register reg)
+            {
+                if (reg >= R8)
+                    bytes({0x41});
+                bytes({static_cast<uint8_t>(0x50 + (reg & 7))});
+            }
+
+            void pop(Register reg)
+            {
+                if (reg >= R8)
+                    bytes({0x41});
+                bytes({static_cast<uint8_t>(0x58 + (reg & 7))});
+            }
+
+            // mov rax, imm
+            void loadImmediate(int64_t value)
+            {
+                if (value >= INT32_MIN && value <= INT32_MAX)
+                {
+                    bytes({0x48, 0xC7, 0xC0});
+                    imm32(static_cast<int32_t>(value));
+                }
+                else
+                {
+                    bytes({0x48, 0xB8});
+                    imm64(value);
+                }
+            }
+
+            // mov [rbp - 8 * (slot + 1)], reg
+            void storeLocal(int slot, Register reg)
+            {
+                bytes({static_cast<uint8_t>(0x48 | (reg >= R8 ? 0x04 : 0)), 0x89,
+                       static_cast<uint8_t>(0x45 | ((reg & 7) << 3)), static_cast<uint8_t>(-8 * (slot + 1))});
+            }
+
+            // mov rax, [rbp - 8 * (slot + 1)]
+            void loadLocal(int slot) { bytes({0x48, 0x8B, 0x45, static_cast<uint8_t>(-8 * (slot + 1))}); }
+
+            // cmp rax, kEmpty / cmp rcx, kEmpty (through r11)
+            void compareEmpty(Register reg)
+            {
+                bytes({0x49, 0xBB});
+                imm64(kEmpty);
+                bytes({0x4C, 0x39, static_cast<uint8_t>(0xD8 | reg)});
+            }
+
+            void jump(Label target) { branch({0xE9}, target); }
+            void jumpIfEqual(Label target) { branch({0x0F, 0x84}, target); }
+            void jumpIfNotEqual(Label target) { branch({0x0F, 0x85}, target); }
+            void jumpIfNoOverflow(Label target) { branch({0x0F, 0x81}, target); }
+            void jumpIfBelow(Label target) { branch({0x0F, 0x82}, target); }
+            void call(Label target) { branch({0xE8}, target); }
+
+            // mov r11, imm64; cmp rsp, [r11]
+            void compareStackPointer(const void *limit)
+            {
+                bytes({0x49, 0xBB});
+                imm64(static_cast<int64_t>(reinterpret_cast<uintptr_t>(limit)));
+                bytes({0x49, 0x3B, 0x23});
+            }
+
+            // mov r11, imm64; sub qword [r11], 1 (CF set when it was 0)
+            void decrementCounter(const void *counter)
+            {
+                bytes({0x49, 0xBB});
+                imm64(static_cast<int64_t>(reinterpret_cast<uintptr_t>(counter)));
+                bytes({0x49, 0x83, 0x2B, 0x01});
+            }
+
+            // mov rax, imm64; call rax
+            void callAbsolute(const void *function)
+            {
+                bytes({0x48, 0xB8});
+                imm64(static_cast<int64_t>(reinterpret_cast<uintptr_t>(function)));
+                bytes({0xFF, 0xD0});
+            }
+
+            std::vector<uint8_t> finish()
+            {
+                for (const auto &fixup : fixups_)
+                {
+                    int32_t relative = static_cast<int32_t>(labels_[fixup.second] - static_cast<int64_t>(fixup.first + 4));
+                    std::memcpy(&code_[fixup.first], &relative, sizeof(relative));
+                }
+                return code_;
+            }
+
+        private:
+            void branch(std::initializer_list<uint8_t> opcode, Label target)
+            {
+                bytes(opcode);
+                fixups_.emplace_back(code_.size(), target);
+                imm32(0);
+            }
+
+            std::vector<uint8_t> code_;
+            std::vector<int64_t> labels_;
+            std::vector<std::pair<size_t, Label>> fixups_;
+        };
+
+        // Stack-machine code generator: every expression leaves its value in
+        // rax, intermediate values live on the machine stack
+        class Compiler
+        {
+        public:
+            Compiler(const Resolver &resolve, bool countCalls) : resolve_(resolve), countCalls_(countCalls) {}
+
+            bool compile(const FunctionNode &root, std::vector<uint8_t> &code)
+            {
+                outOfStack_ = assembler_.newLabel();
+                refillCalls_ = assembler_.newLabel();
+                labelFor(root);
+                for (size_t i = 0; i < queue_.size(); i++)
+                {
+                    if (!compileFunction(*queue_[i]))
+                        return false;
+                }
+
+                // Shared by every prologue, entered with an aligned stack
+                assembler_.bind(outOfStack_);
+                assembler_.callAbsolute(reinterpret_cast<const void *>(&stackExhausted));
+
+                // Called from prologues before the arguments are stored, so
+                // it keeps the argument registers; six pushes, the return
+                // address and 8 bytes of padding keep the stack aligned
+                if (countCalls_)
+                {
+                    assembler_.bind(refillCalls_);
+                    for (Register reg : argumentRegisters)
+                        assembler_.push(reg);
+                    assembler_.bytes({0x48, 0x83, 0xEC, 0x08}); // sub rsp, 8
+                    assembler_.callAbsolute(reinterpret_cast<const void *>(&callsExhausted));
+                    assembler_.bytes({0x48, 0x83, 0xC4, 0x08}); // add rsp, 8
+                    for (size_t i = kMaxParameters; i-- > 0;)
+                        assembler_.pop(argumentRegisters[i]);
+                    assembler_.bytes({0xC3});
+                }
+                code = assembler_.finish();
+                return true;
+            }
+
+        private:
+            Assembler::Label labelFor(const FunctionNode &function)
+            {
+                auto it = labels_.find(&function);
+                if (it != labels_.end())
+                    return it->second;
+                Assembler::Label label = assembler_.newLabel();
+                labels_[&function] = label;
+                queue_.push_back(&function);
+                return label;
+            }
+
+            static bool isCompilable(const FunctionNode &function)
+            {
+                if (function.parameters.size() > kMaxParameters)
+                    return false;
+                for (const auto &parameter : function.parameters)
+                {
+                    if (parameter.type != "int")
+                        return false;
+                }
+                return true;
+            }
+
+            bool compileFunction(const FunctionNode &function)
+            {
+                if (!isCompilable(function))
+                    return false;
+
+                function_ = &function;
+                assembler_.bind(labels_[&function]);
+
+                // push rbp; mov rbp, rsp; sub rsp, frame (kept 16-byte aligned)
+                size_t slots = (function.parameters.size() + 1) & ~size_t(1);
+                assembler_.bytes({0x55, 0x48, 0x89, 0xE5});
+                assembler_.compareStackPointer(&stackLimit);
+                assembler_.jumpIfBelow(outOfStack_);
+                if (countCalls_)
+                {
+                    // Tail calls jump here too, so they are counted as well
+                    assembler_.decrementCounter(&callsLeft);
+                    assembler_.bytes({0x73, 0x05}); // jae over the call
+                    assembler_.call(refillCalls_);
+                }
+                if (slots)
+                {
+                    assembler_.bytes({0x48, 0x81, 0xEC});
+                    assembler_.imm32(static_cast<int32_t>(slots * 8));
+                }
+                for (size_t i = 0; i < function.parameters.size(); i++)
+                    assembler_.storeLocal(static_cast<int>(i), argumentRegisters[i]);
+                depth_ = 0;
+
+                bool maybeEmpty = false;
+                if (!compileStatements(function.body, maybeEmpty, true))
+                    return false;
+
+                // leave; ret
+                assembler_.bytes({0xC9, 0xC3});
+                return true;
+            }
+
+            // The value of a statement list is the value of its last statement.
+            // `tail` is set when that value is what the function returns.
+            bool compileStatements(const std::vector<std::unique_ptr<ASTNode>> &statements, bool &maybeEmpty,
+                                   bool tail = false)
+            {
+                bool hasValue = false;
+                for (size_t i = 0; i < statements.size(); i++)
+                {
+                    if (!statements[i])
+                        continue;
+                    if (!compileNode(statements[i].get(), maybeEmpty, tail && i + 1 == statements.size()))
+                        return false;
+                    hasValue = true;
+                }
+                if (!hasValue)
+                {
+                    assembler_.loadImmediate(kEmpty);
+                    maybeEmpty = true;
+                }
+                return true;
+            }
+
+            bool compileNode(const ASTNode *node, bool &maybeEmpty, bool tail = false)
+            {
+                maybeEmpty = false;
+                if (!node)
+                    return false;
+
+                if (auto literal = dynamic_cast<const LiteralNode *>(node))
+                    return compileLiteral(*literal);
+                if (auto binary = dynamic_cast<const BinaryOperationNode *>(node))
+                    return compileBinary(*binary, maybeEmpty);
+                if (auto call = dynamic_cast<const FunctionCallNode *>(node))
+                    return compileCall(*call, maybeEmpty, tail);
+                if (auto ifNode = dynamic_cast<const IfStatementNode *>(node))
+                    return compileIf(*ifNode, maybeEmpty, tail);
+                return false;
+            }
+
+            bool compileLiteral(const LiteralNode &literal)
+            {
+                if (literal.type == "identifier")
+                {
+                    // Only parameters; locals and globals stay interpreted
+                    for (size_t i = 0; i < function_->parameters.size(); i++)
+                    {
+                        if (function_->parameters[i].name == literal.value)
+                        {
+                            assembler_.loadLocal(static_cast<int>(i));
+                            return true;
+                        }
+                    }
+                    return false;
+                }
+
+                int64_t value;
+                if (literal.type != "int" || !fromString(literal.value, value))
+                    return false;
+                assembler_.loadImmediate(value);
+                return true;
+            }
+
+            bool compileBinary(const BinaryOperationNode &binary, bool &maybeEmpty)
+            {
+                // Checked string and comparison operations stay interpreted
+                bool dynamic = binary.operation == BinaryOperation::Dynamic;
+                if (!(binary.op == "+" && (dynamic || binary.operation == BinaryOperation::IntAdd)) &&
+                    !(binary.op == "*" && (dynamic || binary.operation == BinaryOperation::IntMultiply)))
+                    return false;
+
+                bool leftEmpty = false;
+                bool rightEmpty = false;
+                if (!compileNode(binary.left.get(), leftEmpty))
+                    return false;
+                pushValue();
+                if (!compileNode(binary.right.get(), rightEmpty))
+                    return false;
+                assembler_.bytes({0x48, 0x89, 0xC1}); // mov rcx, rax
+                popValue(RAX);
+
+                Assembler::Label done = assembler_.newLabel();
+                if (binary.op == "+")
+                {
+                    // "" + x concatenates to x, and x + "" to x
+                    if (leftEmpty)
+                    {
+                        Assembler::Label leftHasValue = assembler_.newLabel();
+                        assembler_.compareEmpty(RAX);
+                        assembler_.jumpIfNotEqual(leftHasValue);
+                        assembler_.bytes({0x48, 0x89, 0xC8}); // mov rax, rcx
+                        assembler_.jump(done);
+                        assembler_.bind(leftHasValue);
+                    }
+                    if (rightEmpty)
+                    {
+                        assembler_.compareEmpty(RCX);
+                        assembler_.jumpIfEqual(done);
+                    }
+                    assembler_.bytes({0x01, 0xC8}); // add eax, ecx
+                    maybeEmpty = leftEmpty && rightEmpty;
+                }
+                else
+                {
+                    // stoi failing on "" makes the interpreter's product "0"
+                    if (leftEmpty || rightEmpty)
+                    {
+                        Assembler::Label multiply = assembler_.newLabel();
+                        Assembler::Label zero = assembler_.newLabel();
+                        if (leftEmpty)
+                        {
+                            assembler_.compareEmpty(RAX);
+                            assembler_.jumpIfEqual(zero);
+                        }
+                        if (rightEmpty)
+                        {
+                            assembler_.compareEmpty(RCX);
+                            assembler_.jumpIfEqual(zero);
+                        }
+                        assembler_.jump(multiply);
+                        assembler_.bind(zero);
+                        assembler_.bytes({0x31, 0xC0}); // xor eax, eax
+                        assembler_.jump(done);
+                        assembler_.bind(multiply);
+                    }
+                    assembler_.bytes({0x0F, 0xAF, 0xC1}); // imul eax, ecx
+                }
+                assembler_.bytes({0x48, 0x63, 0xC0}); // movsxd rax, eax
+                assembler_.bind(done);
+                return true;
+            }
+
+            bool compileCall(const FunctionCallNode &call, bool &maybeEmpty, bool tail)
+            {
+                // Unqualified calls never resolve and evaluate to ""
+                if (call.name.find('.') == std::string::npos)
+                {
+                    assembler_.loadImmediate(kEmpty);
+                    maybeEmpty = true;
+                    return true;
+                }
+
+                CallTarget target = resolve_(call.name);
+                if (target.builtin == "std.math.add")
+                    return compileMath(call, {0x01, 0xC8}); // add eax, ecx
+                if (target.builtin == "std.math.subtract")
+                    return compileMath(call, {0x29, 0xC8}); // sub eax, ecx
+                if (target.builtin == "std.math.multiply")
+                    return compileMath(call, {0x0F, 0xAF, 0xC1}); // imul eax, ecx
+                if (!target.builtin.empty() || !target.function)
+                    return false;
+
+                const FunctionNode &callee = *target.function;
+                if (callee.parameters.size() != call.arguments.size() || !isCompilable(callee))
+                    return false;
+
+                // A "" argument would read back as the parameter's own name
+                for (const auto &argument : call.arguments)
+                {
+                    bool argumentEmpty = false;
+                    if (!compileNode(argument.get(), argumentEmpty))
+                        return false;
+                    if (argumentEmpty)
+                        bailoutIfEmpty(RAX);
+                    pushValue();
+                }
+                for (size_t i = call.arguments.size(); i-- > 0;)
+                    popValue(argumentRegisters[i]);
+
+                maybeEmpty = true;
+                if (tail)
+                {
+                    // leave; jmp: the callee returns straight to our caller
+                    assembler_.bytes({0xC9});
+                    assembler_.jump(labelFor(callee));
+                    return true;
+                }
+                alignedCall([&] { assembler_.call(labelFor(callee)); });
+                return true;
+            }
+
+            // `operation` computes eax op ecx and sets OF when the exact
+            // result does not fit in 32 bits, which std.math would return
+            // in full
+            bool compileMath(const FunctionCallNode &call, std::initializer_list<uint8_t> operation)
+            {
+                // Wrong arity returns "0" without evaluating anything
+                if (call.arguments.size() != 2)
+                {
+                    assembler_.loadImmediate(0);
+                    return true;
+                }
+
+                bool leftEmpty = false;
+                bool rightEmpty = false;
+                if (!compileNode(call.arguments[0].get(), leftEmpty))
+                    return false;
+                if (leftEmpty)
+                    bailoutIfEmpty(RAX);
+                pushValue();
+                if (!compileNode(call.arguments[1].get(), rightEmpty))
+                    return false;
+                if (rightEmpty)
+                    bailoutIfEmpty(RAX);
+                assembler_.bytes({0x48, 0x89, 0xC1}); // mov rcx, rax
+                popValue(RAX);
+                assembler_.bytes(operation);
+                Assembler::Label fits = assembler_.newLabel();
+                assembler_.jumpIfNoOverflow(fits);
+                alignedCall([&] { assembler_.callAbsolute(reinterpret_cast<const void *>(&bailout)); });
+                assembler_.bind(fits);
+                assembler_.bytes({0x48, 0x63, 0xC0}); // movsxd rax, eax
+                return true;
+            }
+
+            bool compileIf(const IfStatementNode &ifNode, bool &maybeEmpty, bool tail)
+            {
+                bool conditionEmpty = false;
+                if (!compileNode(ifNode.condition.get(), conditionEmpty))
+                    return false;
+
+                // "0" and "" are false
+                Assembler::Label elseBranch = assembler_.newLabel();
+                Assembler::Label done = assembler_.newLabel();
+                assembler_.bytes({0x48, 0x85, 0xC0}); // test rax, rax
+                assembler_.jumpIfEqual(elseBranch);
+                if (conditionEmpty)
+                {
+                    assembler_.compareEmpty(RAX);
+                    assembler_.jumpIfEqual(elseBranch);
+                }
+
+                bool thenEmpty = false;
+                bool elseEmpty = false;
+                if (!compileStatements(ifNode.thenBranch, thenEmpty, tail))
+                    return false;
+                assembler_.jump(done);
+                assembler_.bind(elseBranch);
+                if (!compileStatements(ifNode.elseBranch, elseEmpty, tail))
+                    return false;
+                assembler_.bind(done);
+                maybeEmpty = thenEmpty || elseEmpty;
+                return true;
+            }
+
+            // Abandons the whole compiled call so the interpreter can redo it
+            void bailoutIfEmpty(Register reg)
+            {
+                Assembler::Label ok = assembler_.newLabel();
+                assembler_.compareEmpty(reg);
+                assembler_.jumpIfNotEqual(ok);
+                alignedCall([&] { assembler_.callAbsolute(reinterpret_cast<const void *>(&bailout)); });
+                assembler_.bind(ok);
+            }
+
+            template <typename EmitCall>
+            void alignedCall(EmitCall emitCall)
+            {
+                bool pad = depth_ % 2 != 0;
+                if (pad)
+                    assembler_.bytes({0x48, 0x83, 0xEC, 0x08}); // sub rsp, 8
+                emitCall();
+                if (pad)
+                    assembler_.bytes({0x48, 0x83, 0xC4, 0x08}); // add rsp, 8
+            }
+
+            void pushValue()
+            {
+                assembler_.push(RAX);
+                depth_++;
+            }
+
+            void popValue(Register reg)
+            {
+                assembler_.pop(reg);
+                depth_--;
+            }
+
+            const Resolver &resolve_;
+            Assembler assembler_;
+            std::unordered_map<const FunctionNode *, Assembler::Label> labels_;
+            std::vector<const FunctionNode *> queue_;
+            const FunctionNode *function_ = nullptr;
+            int depth_ = 0;
+            bool countCalls_;
+            Assembler::Label outOfStack_ = 0;
+            Assembler::Label refillCalls_ = 0;
+        };
+    }
+
+    CompiledCode::CompiledCode(const std::vector<uint8_t> &code, size_t arity) : arity_(arity)
+    {
+        size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_ = (code.size() + pageSize - 1) / pageSize * pageSize;
+        void *memory = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED)
+            return;
+
+        // Written while writable, then flipped to executable: never both
+        std::memcpy(memory, code.data(), code.size());
+        if (mprotect(memory, size_, PROT_READ | PROT_EXEC) != 0)
+        {
+            munmap(memory, size_);
+            return;
+        }
+        memory_ = memory;
+    }
+
+    CompiledCode::~CompiledCode()
+    {
+        if (memory_)
+            munmap(memory_, size_);
+    }
+
+    CompiledCode::Outcome CompiledCode::invoke(const std::vector<int64_t> &arguments, int64_t &result) const
+    {
+        Budget budget;
+        return invoke(arguments, result, budget);
+    }
+
+    CompiledCode::Outcome CompiledCode::invoke(const std::vector<int64_t> &arguments, int64_t &result,
+                                               Budget &budget) const
+    {
+        if (!memory_ || arguments.size() != arity_)
+            return Outcome::BailedOut;
+
+        char stackTop;
+        uintptr_t previousLimit = stackLimit;
+        stackLimit = reinterpret_cast<uintptr_t>(&stackTop) - budget.stackBytes;
+        outOfStack = false;
+        uint64_t previousCalls = callsLeft;
+        Budget *previousBudget = currentBudget;
+        callsLeft = budget.calls;
+        currentBudget = &budget;
+        outOfBudget = false;
+
+        jmp_buf target;
+        jmp_buf *previous = bailoutTarget;
+        bailoutTarget = &target;
+        auto restore = [&] {
+            bailoutTarget = previous;
+            stackLimit = previousLimit;
+            budget.calls = callsLeft;
+            callsLeft = previousCalls;
+            currentBudget = previousBudget;
+        };
+        if (setjmp(target) != 0)
+        {
+            restore();
+            return outOfBudget ? Outcome::OutOfBudget : outOfStack ? Outcome::OutOfStack : Outcome::BailedOut;
+        }
+
+        const int64_t *a = arguments.data();
+        void *entry = memory_;
+        using I = int64_t;
+        switch (arity_)
+        {
+        case 0:
+            result = reinterpret_cast<I (*)()>(entry)();
+            break;
+        case 1:
+            result = reinterpret_cast<I (*)(I)>(entry)(a[0]);
+            break;
+        case 2:
+            result = reinterpret_cast<I (*)(I, I)>(entry)(a[0], a[1]);
+            break;
+        case 3:
+            result = reinterpret_cast<I (*)(I, I, I)>(entry)(a[0], a[1], a[2]);
+            break;
+        case 4:
+            result = reinterpret_cast<I (*)(I, I, I, I)>(entry)(a[0], a[1], a[2], a[3]);
+            break;
+        case 5:
+            result = reinterpret_cast<I (*)(I, I, I, I, I)>(entry)(a[0], a[1], a[2], a[3], a[4]);
+            break;
+        default:
+            result = reinterpret_cast<I (*)(I, I, I, I, I, I)>(entry)(a[0], a[1], a[2], a[3], a[4], a[5]);
+            break;
+        }
+        restore();
+        return Outcome::Returned;
+    }
+
+    std::shared_ptr<CompiledCode> compile(const FunctionNode &function, const Resolver &resolve, bool countCalls)
+    {
+        if (!isAvailable())
+            return nullptr;
+
+        std::vector<uint8_t> code;
+        Compiler compiler(resolve, countCalls);
+        if (!compiler.compile(function, code))
+            return nullptr;
+
+        auto compiled = std::make_shared<CompiledCode>(code, function.parameters.size());
+        return compiled->isValid() ? compiled : nullptr;
+    }
+
+    bool fromString(const std::string &text, int64_t &value)
+    {
+        if (text.empty() || text.size() > 11)
+            return false;
+
+        size_t i = text[0] == '-' ? 1 : 0;
+        if (i == text.size() || (text[i] == '0' && text.size() > i + 1) || (i == 1 && text == "-0"))
+            return false;
+        int64_t result = 0;
+        for (; i < text.size(); i++)
+        {
+            if (text[i] < '0' || text[i] > '9')
+                return false;
+            result = result * 10 + (text[i] - '0');
+        }
+        value = text[0] == '-' ? -result : result;
+        return value >= INT_MIN && value <= INT_MAX;
+    }
+
+    std::string toString(int64_t value)
+    {
+        return value == kEmpty ? std::string() : std::to_string(value);
+    }
+}
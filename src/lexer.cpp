@@ -1,11 +1,135 @@
 #include "lexer.h"
 
+#include <algorithm>
+#include <cerrno>
 #include <unordered_map>
 #include <iostream>
+#include <unistd.h>
 
 Lexer::Lexer(const std::string &source) : source_(source), current_(0), line_(1), column_(1), length_(source.length()) {}
 
+Lexer::Lexer(int fd, size_t chunkSize)
+    : current_(0), line_(1), column_(1), length_(0), fd_(fd),
+      chunkSize_(chunkSize ? chunkSize : kDefaultChunkSize), eof_(false)
+{
+    source_.reserve(chunkSize_ + 16);
+}
+
+Lexer::Lexer(const std::string &source, size_t begin, size_t end, int line)
+    : source_(source, begin, end > begin ? end - begin : 0), current_(0), line_(line), column_(1),
+      windowStart_(begin)
+{
+    length_ = source_.length();
+}
+
+bool Lexer::refill(size_t needed)
+{
+    if (fd_ < 0 || eof_)
+        return false;
+
+    // Drop everything before the cursor. Token text is copied out character
+    // by character, so at most a couple of lookahead bytes survive here.
+    size_t consumed = std::min(current_, source_.size());
+    source_.erase(0, consumed);
+    windowStart_ += consumed;
+    needed -= consumed;
+    current_ -= consumed;
+
+    while (source_.size() < needed && !eof_)
+    {
+        size_t oldSize = source_.size();
+        source_.resize(oldSize + chunkSize_);
+        ssize_t bytesRead = ::read(fd_, &source_[oldSize], chunkSize_);
+        if (bytesRead < 0 && errno == EINTR)
+        {
+            source_.resize(oldSize);
+            continue;
+        }
+        if (bytesRead <= 0)
+        {
+            if (bytesRead < 0)
+                lexicalError("Failed to read source");
+            eof_ = true;
+            bytesRead = 0;
+        }
+        source_.resize(oldSize + static_cast<size_t>(bytesRead));
+    }
+
+    length_ = source_.size();
+    return current_ < length_ && needed <= length_;
+}
+
 Token Lexer::getNextToken()
+{
+    skipWhitespace();
+    size_t start = getOffset();
+    Token token = scanToken();
+    token.offset = start;
+    return token;
+}
+
+size_t Lexer::skipBlock()
+{
+    int depth = 1;
+    while (hasChar())
+    {
+        char c = charAt();
+        if (c == '"')
+        {
+            if (stringLiteral().type == END_OF_FILE)
+                break;
+            continue;
+        }
+        if (c == '/' && hasChar(1) && charAt(1) == '/')
+        {
+            singleLineComment();
+            continue;
+        }
+        if (c == '/' && hasChar(1) && charAt(1) == '*')
+        {
+            multiLineComment();
+            continue;
+        }
+
+        if (c == '\n')
+        {
+            advanceLine();
+            current_++;
+            continue;
+        }
+        if (c == '{')
+        {
+            depth++;
+        }
+        else if (c == '}' && --depth == 0)
+        {
+            size_t offset = getOffset();
+            current_++;
+            column_++;
+            return offset;
+        }
+        current_++;
+        column_++;
+    }
+    return std::string::npos;
+}
+
+void Lexer::lexicalError(const std::string &message)
+{
+    Diagnostic diagnostic;
+    diagnostic.line = line_;
+    diagnostic.column = column_;
+    diagnostic.offset = getOffset();
+    diagnostic.message = message;
+    diagnostics_.push_back(diagnostic);
+
+    if (!quiet_)
+    {
+        std::cerr << "Lexical error at line " << line_ << ": " << message << std::endl;
+    }
+}
+
+Token Lexer::scanToken()
 {
     skipWhitespace();
 
@@ -13,7 +137,7 @@ Token Lexer::getNextToken()
     token.line = line_;
     token.column = column_;
 
-    if (current_ >= source_.length())
+    if (!hasChar())
     {
         token.type = END_OF_FILE;
         return token;
@@ -22,7 +146,7 @@ Token Lexer::getNextToken()
     // Save the starting position before consuming any characters
     int startColumn = column_;
 
-    char c = source_[current_];
+    char c = charAt();
 
     if (isalpha(c) || c == '_')
     {
@@ -36,11 +160,11 @@ Token Lexer::getNextToken()
     {
         return stringLiteral();
     }
-    else if (c == '/' && current_ + 1 < source_.length() && source_[current_ + 1] == '/')
+    else if (c == '/' && hasChar(1) && charAt(1) == '/')
     {
         return singleLineComment();
     }
-    else if (c == '/' && current_ + 1 < source_.length() && source_[current_ + 1] == '*')
+    else if (c == '/' && hasChar(1) && charAt(1) == '*')
     {
         return multiLineComment();
     }
@@ -52,7 +176,7 @@ Token Lexer::getNextToken()
         case '*':
         case '/':
         case '=':
-            if (current_ + 1 < source_.length() && source_[current_ + 1] == '=') {
+            if (hasChar(1) && charAt(1) == '=') {
                 current_ += 2;
                 column_ += 2;
                 return {OPERATOR, "==", line_};
@@ -61,7 +185,7 @@ Token Lexer::getNextToken()
             column_++;
             return {OPERATOR, std::string(1, c), line_};
         case '-':
-            if (current_ + 1 < source_.length() && source_[current_ + 1] == '>')
+            if (hasChar(1) && charAt(1) == '>')
             {
                 current_ += 2;
                 column_ += 2;
@@ -106,7 +230,7 @@ Token Lexer::getNextToken()
             column_++;
             return {COLON, ":", line_};
         case '<':
-            if (current_ + 1 < source_.length() && source_[current_ + 1] == '=') {
+            if (hasChar(1) && charAt(1) == '=') {
                 current_ += 2;
                 column_ += 2;
                 return {OPERATOR, "<=", line_};
@@ -116,7 +240,7 @@ Token Lexer::getNextToken()
                 return {OPERATOR, "<", line_};
             }
         case '>':
-            if (current_ + 1 < source_.length() && source_[current_ + 1] == '=') {
+            if (hasChar(1) && charAt(1) == '=') {
                 current_ += 2;
                 column_ += 2;
                 return {OPERATOR, ">=", line_};
@@ -126,7 +250,7 @@ Token Lexer::getNextToken()
                 return {OPERATOR, ">", line_};
             }
         default:
-            std::cerr << "Lexical error at line " << line_ << ": Unexpected character '" << c << "'" << std::endl;
+            lexicalError(std::string("Unexpected character '") + c + "'");
             return {END_OF_FILE, "", line_};
         }
     }
@@ -138,9 +262,9 @@ Token Lexer::getNextToken()
 
 void Lexer::skipWhitespace()
 {
-    while (current_ < source_.length())
+    while (hasChar())
     {
-        char c = source_[current_];
+        char c = charAt();
         if (c == ' ' || c == '\t')
         {
             column_++;
@@ -159,13 +283,13 @@ void Lexer::skipWhitespace()
     }
 
     // Handle comments after code
-    if (current_ < source_.length() && source_[current_] == '/')
+    if (hasChar() && charAt() == '/')
     {
-        if (current_ + 1 < source_.length() && source_[current_ + 1] == '/')
+        if (hasChar(1) && charAt(1) == '/')
         {
             singleLineComment();
         }
-        else if (current_ + 1 < source_.length() && source_[current_ + 1] == '*')
+        else if (hasChar(1) && charAt(1) == '*')
         {
             multiLineComment();
         }
@@ -175,9 +299,9 @@ void Lexer::skipWhitespace()
 Token Lexer::identifier()
 {
     std::string id;
-    while (current_ < source_.length() && (isalnum(source_[current_]) || source_[current_] == '_'))
+    while (hasChar() && (isalnum(charAt()) || charAt() == '_'))
     {
-        id += source_[current_];
+        id += charAt();
         current_++;
         column_++;
     }
@@ -210,15 +334,17 @@ Token Lexer::identifier()
     if (id == "false")
         return {BOOLEAN, "false", line_};
 
-    return {IDENTIFIER, id, line_};
+    Token token{IDENTIFIER, id, line_};
+    token.symbol = intern(id);
+    return token;
 }
 
 Token Lexer::number()
 {
     std::string num;
-    while (current_ < source_.length() && isdigit(source_[current_]))
+    while (hasChar() && isdigit(charAt()))
     {
-        num += source_[current_];
+        num += charAt();
         current_++;
         column_++;
     }
@@ -231,14 +357,14 @@ Token Lexer::stringLiteral()
     current_++; // Skip the opening quote
     column_++;
     std::string str;
-    while (current_ < source_.length() && source_[current_] != '"')
+    while (hasChar() && charAt() != '"')
     {
-        str += source_[current_];
+        str += charAt();
         current_++;
         column_++;
     }
 
-    if (current_ < source_.length() && source_[current_] == '"')
+    if (hasChar() && charAt() == '"')
     {
         current_++; // Skip the closing quote
         column_++;
@@ -246,7 +372,7 @@ Token Lexer::stringLiteral()
     }
     else
     {
-        std::cerr << "Lexical error at line " << line_ << ": Unterminated string literal" << std::endl;
+        lexicalError("Unterminated string literal");
         return {END_OF_FILE, "", line_};
     }
 }
@@ -255,7 +381,7 @@ Token Lexer::singleLineComment()
 {
     current_ += 2; // Skip the "//"
     column_ += 2;
-    while (current_ < source_.length() && source_[current_] != '\n')
+    while (hasChar() && charAt() != '\n')
     {
         current_++;
         column_++;
@@ -268,9 +394,9 @@ Token Lexer::multiLineComment()
 {
     current_ += 2; // Skip the "/*"
     column_ += 2;
-    while (current_ + 1 < source_.length() && !(source_[current_] == '*' && source_[current_ + 1] == '/'))
+    while (hasChar(1) && !(charAt() == '*' && charAt(1) == '/'))
     {
-        if (source_[current_] == '\n')
+        if (charAt() == '\n')
         {
             line_++;
             column_ = 1;
@@ -281,6 +407,20 @@ Token Lexer::multiLineComment()
         }
         current_++;
     }
+    if (!hasChar(1))
+    {
+        // Unterminated: the comment runs to the end of the input
+        while (hasChar())
+        {
+            if (charAt() == '\n')
+                advanceLine();
+            else
+                column_++;
+            current_++;
+        }
+        lexicalError("Unterminated comment");
+        return {COMMENT, "", line_};
+    }
     current_ += 2; // Skip the "*/"
     column_ += 2;
     skipWhitespace();
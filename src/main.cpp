@@ -4,12 +4,28 @@
 #include "module_manager.h"
 #include "symbol_table.h"
 #include "evaluator.h"
+#include "output_buffer.h"
+#include "standard_library.h"
+#include "profiler.h"
+#include "phase_timer.h"
+#include "c_emitter.h"
+#include "native_build.h"
+#include "type_checker.h"
+#include "thread_pool.h"
+#include "heap.h"
 
+#include <charconv>
+#include <chrono>
+#include <cstdint>
 #include <iostream>
 #include <vector>
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
 
 void traverse(ASTNode *node, bool registerOnly = true)
 {
@@ -28,22 +44,15 @@ void traverse(ASTNode *node, bool registerOnly = true)
             traverse(child.get(), registerOnly);
         }
     }
-    else if (auto functionNode = dynamic_cast<FunctionNode *>(node))
+    else if (dynamic_cast<FunctionNode *>(node))
     {
-        // Only traverse function body if not in register-only mode
-        if (registerOnly) {
-            for (const auto &child : functionNode->body)
-            {
-                traverse(child.get(), registerOnly);
-            }
-        }
+        // Function bodies, including their lets, only run when called
     }
     else if (auto varDeclNode = dynamic_cast<VariableDeclarationNode *>(node))
     {
         if (registerOnly && varDeclNode->initializer)
         {
-            std::string value = evaluateNode(varDeclNode->initializer.get());
-            SymbolTable::getInstance().setValue(varDeclNode->name, value);
+            SymbolTable::getInstance().setValue(varDeclNode->symbol, evaluateValue(varDeclNode->initializer.get()));
         }
     }
     else if (auto functionCallNode = dynamic_cast<FunctionCallNode *>(node))
@@ -51,7 +60,7 @@ void traverse(ASTNode *node, bool registerOnly = true)
         if (!registerOnly) {
             auto& mm = ModuleManager::getInstance();
             if (mm.hasFunction(functionCallNode->name)) {
-                std::string result = mm.callFunction(functionCallNode->name, functionCallNode->arguments);
+                std::string result = mm.callFunction(functionCallNode->symbol, functionCallNode->arguments);
                 if (!result.empty()) {
                     SymbolTable::getInstance().setValue("_lastResult", result);
                 }
@@ -78,40 +87,36 @@ void traverse(ASTNode *node, bool registerOnly = true)
     }
 }
 
-void registerStandardModules() {
-    auto& mm = ModuleManager::getInstance();
-
-    // Register IO functions using full module path
-    mm.registerFunction("std.io", "print", [](const std::vector<std::unique_ptr<ASTNode>>& args) {
-        for (const auto& arg : args) {
-            std::cout << evaluateNode(arg.get());
-        }
-        std::cout << std::endl;
-        return "";
-    });
-
-    mm.registerFunction("std.io", "println", [](const std::vector<std::unique_ptr<ASTNode>>& args) {
-        std::string result;
-        for (const auto& arg : args) {
-            result += evaluateNode(arg.get());
-        }
-        std::cout << result << std::endl;
-        return result;
-    });
-
-    mm.registerFunction("std.math", "add", [](const std::vector<std::unique_ptr<ASTNode>>& args) {
-        if (args.size() != 2) return std::string("0");
-        int a = std::stoi(evaluateNode(args[0].get()));
-        int b = std::stoi(evaluateNode(args[1].get()));
-        return std::to_string(a + b);
-    });
-    
-    mm.registerFunction("std.math", "subtract", [](const std::vector<std::unique_ptr<ASTNode>>& args) {
-        if (args.size() != 2) return std::string("0");
-        int a = std::stoi(evaluateNode(args[0].get()));
-        int b = std::stoi(evaluateNode(args[1].get()));
-        return std::to_string(a - b);
-    });
+size_t countNodes(const ASTNode *node)
+{
+    if (!node)
+        return 0;
+
+    size_t count = 1;
+    auto countAll = [&count](const std::vector<std::unique_ptr<ASTNode>> &nodes) {
+        for (const auto &child : nodes)
+            count += countNodes(child.get());
+    };
+
+    if (auto moduleNode = dynamic_cast<const ModuleNode *>(node))
+        countAll(moduleNode->body);
+    else if (auto functionNode = dynamic_cast<const FunctionNode *>(node))
+        countAll(functionNode->body);
+    else if (auto varDeclNode = dynamic_cast<const VariableDeclarationNode *>(node))
+        count += countNodes(varDeclNode->initializer.get());
+    else if (auto binaryOpNode = dynamic_cast<const BinaryOperationNode *>(node))
+        count += countNodes(binaryOpNode->left.get()) + countNodes(binaryOpNode->right.get());
+    else if (auto functionCallNode = dynamic_cast<const FunctionCallNode *>(node))
+        countAll(functionCallNode->arguments);
+    else if (auto returnNode = dynamic_cast<const ReturnStatementNode *>(node))
+        count += countNodes(returnNode->expression.get());
+    else if (auto ifNode = dynamic_cast<const IfStatementNode *>(node))
+    {
+        count += countNodes(ifNode->condition.get());
+        countAll(ifNode->thenBranch);
+        countAll(ifNode->elseBranch);
+    }
+    return count;
 }
 
 std::string readFile(const std::string& filepath) {
@@ -125,39 +130,356 @@ std::string readFile(const std::string& filepath) {
     return buffer.str();
 }
 
+struct CommandLineOptions {
+    std::string sourceFile;
+    bool profile = false;
+    std::string profileOutput = "nexis-profile.folded";
+    bool timePhases = false;
+    bool timePhasesJson = false;
+    bool stream = false;
+    size_t chunkSize = Lexer::kDefaultChunkSize;
+    bool emitC = false;
+    std::string emitCOutput;  // empty writes the C source to stdout
+    std::string nativeOutput; // executable built from the emitted C
+    uint32_t jitThreshold = ModuleManager::kDefaultJitThreshold;
+    ExecutionLimits limits;
+    bool lazy = false;
+    uint64_t threads = 0; // 0 uses every hardware thread
+};
+
+// Accepts only plain decimal digits, e.g. "8"; not "-8", "+8" or "8k"
+bool parseCount(const std::string& text, uint64_t& value) {
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return !text.empty() && error == std::errc() && end == text.data() + text.size();
+}
+
+// In milliseconds; the run's deadline must still fit the steady clock
+constexpr uint64_t kMaxTimeLimit =
+    std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::duration::max()).count() / 2;
+
+bool parseCommandLine(int argc, char* argv[], CommandLineOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--profile") {
+            options.profile = true;
+        } else if (arg.rfind("--profile=", 0) == 0) {
+            options.profile = true;
+            options.profileOutput = arg.substr(std::string("--profile=").length());
+        } else if (arg == "--time-phases") {
+            options.timePhases = true;
+        } else if (arg == "--time-phases=json") {
+            options.timePhases = true;
+            options.timePhasesJson = true;
+        } else if (arg == "--stream") {
+            options.stream = true;
+        } else if (arg.rfind("--chunk-size=", 0) == 0) {
+            options.stream = true;
+            uint64_t chunkSize;
+            if (!parseCount(arg.substr(std::string("--chunk-size=").length()), chunkSize) || chunkSize > SIZE_MAX)
+                return false;
+            options.chunkSize = static_cast<size_t>(chunkSize);
+        } else if (arg == "--emit-c") {
+            options.emitC = true;
+        } else if (arg.rfind("--emit-c=", 0) == 0) {
+            options.emitC = true;
+            options.emitCOutput = arg.substr(std::string("--emit-c=").length());
+        } else if (arg.rfind("--native=", 0) == 0) {
+            options.nativeOutput = arg.substr(std::string("--native=").length());
+            if (options.nativeOutput.empty())
+                return false;
+        } else if (arg == "--lazy") {
+            options.lazy = true;
+        } else if (arg.rfind("--jit-threshold=", 0) == 0) {
+            uint64_t threshold;
+            if (!parseCount(arg.substr(std::string("--jit-threshold=").length()), threshold) || threshold > UINT32_MAX)
+                return false;
+            options.jitThreshold = static_cast<uint32_t>(threshold);
+        } else if (arg.rfind("--max-steps=", 0) == 0) {
+            if (!parseCount(arg.substr(std::string("--max-steps=").length()), options.limits.steps))
+                return false;
+        } else if (arg.rfind("--max-time=", 0) == 0) {
+            uint64_t milliseconds;
+            if (!parseCount(arg.substr(std::string("--max-time=").length()), milliseconds) ||
+                milliseconds > kMaxTimeLimit)
+                return false;
+            options.limits.time = std::chrono::milliseconds(milliseconds);
+        } else if (arg.rfind("--max-depth=", 0) == 0) {
+            uint64_t depth;
+            if (!parseCount(arg.substr(std::string("--max-depth=").length()), depth) || depth > SIZE_MAX)
+                return false;
+            options.limits.callDepth = static_cast<size_t>(depth);
+        } else if (arg.rfind("--max-heap=", 0) == 0) {
+            if (!parseCount(arg.substr(std::string("--max-heap=").length()), options.limits.heapBytes))
+                return false;
+        } else if (arg.rfind("--threads=", 0) == 0) {
+            if (!parseCount(arg.substr(std::string("--threads=").length()), options.threads) || options.threads == 0)
+                return false;
+        } else if (arg.rfind("--", 0) == 0 || !options.sourceFile.empty()) {
+            return false;
+        } else {
+            options.sourceFile = arg;
+        }
+    }
+    if (options.sourceFile == "-") {
+        options.stream = true;
+    }
+    // Lazy bodies are parsed from the source text later on, which streaming
+    // does not keep, and C generation needs every body
+    if (options.lazy && (options.stream || options.emitC || !options.nativeOutput.empty())) {
+        return false;
+    }
+    return !options.sourceFile.empty();
+}
+
+std::unique_ptr<ASTNode> parseFile(const CommandLineOptions& options, PhaseTimer& timer) {
+    timer.begin("read");
+    auto source = std::make_shared<const std::string>(readFile(options.sourceFile));
+    const std::string& sourceCode = *source;
+    timer.end();
+    timer.addCounter("bytes", sourceCode.size());
+
+    // The parser pulls tokens on demand, so lexing is timed in a
+    // separate pass and the parse phase includes a second lex
+    if (timer.isEnabled()) {
+        timer.begin("lex");
+        Lexer countingLexer(sourceCode);
+        uint64_t tokens = 0;
+        while (countingLexer.getNextToken().type != END_OF_FILE) {
+            tokens++;
+        }
+        timer.end();
+        timer.addCounter("tokens", tokens);
+    }
+
+    timer.begin("parse");
+    Lexer lexer(sourceCode);
+    Parser parser(lexer, sourceCode);
+    if (options.lazy) {
+        parser.setLazyBodies(source);
+    }
+    auto ast = parser.parse();
+    timer.end();
+    if (timer.isEnabled()) {
+        timer.addCounter("nodes", countNodes(ast.get()));
+    }
+    return ast;
+}
+
+// Lexes straight from the file descriptor so the source text is never held
+// in memory as a whole; reading and lexing happen inside the parse phase
+std::unique_ptr<ASTNode> parseStream(const CommandLineOptions& options, PhaseTimer& timer) {
+    bool useStdin = options.sourceFile == "-";
+    int fd = useStdin ? STDIN_FILENO : open(options.sourceFile.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Could not open file: " + options.sourceFile);
+    }
+
+    timer.begin("parse");
+    Lexer lexer(fd, options.chunkSize);
+    Parser parser(lexer);
+    auto ast = parser.parse();
+    timer.end();
+    if (timer.isEnabled()) {
+        timer.addCounter("bytes", lexer.getOffset());
+        timer.addCounter("nodes", countNodes(ast.get()));
+    }
+
+    if (!useStdin) {
+        close(fd);
+    }
+    return ast;
+}
+
+// Parses and checks a skipped function body when it is first called. Its
+// errors surface as runtime errors of that call.
+ModuleManager::BodyLoader lazyBodyLoader(std::shared_ptr<TypeChecker> checker) {
+    return [checker](const std::string& moduleName, FunctionNode& function) {
+        std::string name = moduleName + "." + function.name;
+        std::vector<Diagnostic> diagnostics;
+        if (!Parser::parseLazyBody(function, diagnostics)) {
+            const Diagnostic& first = diagnostics.front();
+            throw std::runtime_error("Syntax error in " + name + " at line " + std::to_string(first.line) + ": " +
+                                     first.message);
+        }
+        if (!checker->checkBody(moduleName, function)) {
+            throw std::runtime_error("Type error: " + checker->getErrors().front());
+        }
+    };
+}
+
+void writeProfile(const CommandLineOptions& options) {
+    if (!options.profile)
+        return;
+
+    OutputBuffer::getInstance().flush();
+    auto& profiler = Profiler::getInstance();
+    profiler.writeReport(std::cerr);
+    if (profiler.writeCollapsedStacks(options.profileOutput)) {
+        std::cerr << "Collapsed stacks written to " << options.profileOutput << std::endl;
+    } else {
+        std::cerr << "Error: Could not write profile to " << options.profileOutput << std::endl;
+    }
+}
+
+void addHeapCounters(PhaseTimer& timer) {
+    const Heap::Stats& stats = Heap::getInstance().stats();
+    if (!stats.minorCollections && !stats.majorCollections)
+        return;
+    timer.addCounter("gc_minor", stats.minorCollections);
+    timer.addCounter("gc_major", stats.majorCollections);
+    timer.addCounter("gc_pause_us", std::chrono::duration_cast<std::chrono::microseconds>(stats.totalPause).count());
+    timer.addCounter("gc_max_pause_us", std::chrono::duration_cast<std::chrono::microseconds>(stats.maxPause).count());
+    timer.addCounter("gc_collected_bytes", stats.collectedBytes);
+    timer.addCounter("gc_collected_objects", stats.collectedObjects);
+    timer.addCounter("gc_promoted_bytes", stats.promotedBytes);
+}
+
+void writePhaseTimes(const CommandLineOptions& options, const PhaseTimer& timer) {
+    if (!timer.isEnabled())
+        return;
+
+    OutputBuffer::getInstance().flush();
+    if (options.timePhasesJson) {
+        timer.writeJson(std::cerr);
+    } else {
+        timer.writeReport(std::cerr);
+    }
+}
+
+// Lowers the program to C instead of running it; with --native the C is
+// compiled straight into an executable
+int buildNative(const ASTNode* ast, const CommandLineOptions& options, PhaseTimer& timer) {
+    timer.begin("emit");
+    CEmitter emitter;
+    std::ostringstream code;
+    bool emitted = emitter.emit(ast, code, options.sourceFile == "-" ? "" : options.sourceFile);
+    timer.end();
+    if (!emitted) {
+        for (const auto& message : emitter.getErrors()) {
+            std::cerr << "Error: " << message << std::endl;
+        }
+        return 1;
+    }
+
+    if (options.emitC) {
+        if (options.emitCOutput.empty()) {
+            std::cout << code.str();
+        } else {
+            std::ofstream file(options.emitCOutput);
+            if (!(file << code.str())) {
+                std::cerr << "Error: Could not write " << options.emitCOutput << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    if (options.nativeOutput.empty()) {
+        return 0;
+    }
+
+    std::string cFile = options.emitCOutput;
+    bool temporary = cFile.empty();
+    if (temporary) {
+        char path[] = "/tmp/nexis-XXXXXX.c";
+        int fd = mkstemps(path, 2);
+        if (fd < 0) {
+            std::cerr << "Error: Could not create a temporary C file" << std::endl;
+            return 1;
+        }
+        close(fd);
+        cFile = path;
+        std::ofstream(cFile) << code.str();
+    }
+
+    timer.begin("cc");
+    bool built = compileNative(cFile, options.nativeOutput);
+    timer.end();
+    if (temporary) {
+        std::remove(cFile.c_str());
+    }
+    return built ? 0 : 1;
+}
+
 int main(int argc, char* argv[])
 {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <source-file.nx>" << std::endl;
+    CommandLineOptions options;
+    if (!parseCommandLine(argc, argv, options)) {
+        std::cerr << "Usage: " << argv[0] << " [--profile[=<stacks-file>]] [--time-phases[=json]] [--stream] [--chunk-size=<bytes>] [--emit-c[=<file.c>]] [--native=<executable>] [--jit-threshold=<calls>] [--lazy] [--max-steps=<n>] [--max-time=<ms>] [--max-depth=<calls>] [--max-heap=<bytes>] [--threads=<n>] <source-file.nx | ->" << std::endl;
         return 1;
     }
 
+    // Program output goes through OutputBuffer; only diagnostics use iostreams
+    std::ios::sync_with_stdio(false);
+
+    if (options.profile) {
+        Profiler::getInstance().enable();
+    }
+
     registerStandardModules();
+    ModuleManager::getInstance().setJitThreshold(options.jitThreshold);
+    if (options.threads) {
+        ThreadPool::getInstance().setThreads(options.threads);
+    }
 
+    PhaseTimer timer(options.timePhases);
     try {
-        std::string sourceCode = readFile(argv[1]);
-        
-        Lexer lexer(sourceCode);
-        Parser parser(lexer, sourceCode);
-
-        auto ast = parser.parse();
+        auto ast = options.stream ? parseStream(options, timer) : parseFile(options, timer);
         if (!ast) {
             std::cerr << "Failed to parse program" << std::endl;
             return 1;
         }
 
-        traverse(ast.get());
+        timer.begin("check");
+        auto checker = std::make_shared<TypeChecker>();
+        bool typed = checker->check(ast.get());
+        timer.end();
+        if (!typed) {
+            for (const auto& message : checker->getErrors()) {
+                std::cerr << "Type error: " << message << std::endl;
+            }
+            return 1;
+        }
+        // The parser registered the functions before they were annotated
+        ModuleManager::getInstance().registerProgram(ast.get());
+        if (options.lazy) {
+            ModuleManager::getInstance().setBodyLoader(lazyBodyLoader(checker));
+        }
+
+        if (options.emitC || !options.nativeOutput.empty()) {
+            int status = buildNative(ast.get(), options, timer);
+            writePhaseTimes(options, timer);
+            return status;
+        }
+
+        // Limits apply to the script, not to compiling it
+        ModuleManager::getInstance().setLimits(options.limits);
+        timer.begin("register");
+        {
+            // Module-level lets are evaluated outside frame code, where the
+            // collector cannot see every value
+            Heap::Busy busy;
+            traverse(ast.get());
+        }
+        timer.end();
 
         auto& mm = ModuleManager::getInstance();
         if (mm.hasFunction("Main.main")) {
+            timer.begin("execute");
             mm.callFunction("Main.main", {});
+            timer.end();
+            addHeapCounters(timer);
+            writeProfile(options);
+            writePhaseTimes(options, timer);
         } else {
             std::cerr << "Error: Main function not found" << std::endl;
             return 1;
         }
 
     } catch (const std::exception& e) {
+        // Keep program output ahead of the diagnostic
+        OutputBuffer::getInstance().flush();
         std::cerr << "Error: " << e.what() << std::endl;
+        writeProfile(options);
         return 1;
     }
 
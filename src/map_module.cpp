@@ -0,0 +1,154 @@
+#include "string_map.h"
+#include "heap.h"
+#include "standard_library.h"
+#include "module_manager.h"
+#include "evaluator.h"
+#include "big_integer.h"
+
+#include <charconv>
+#include <stdexcept>
+
+namespace
+{
+    using Arguments = std::vector<std::unique_ptr<ASTNode>>;
+
+    [[noreturn]] void fail(const std::string &function, const std::string &message)
+    {
+        throw std::runtime_error("map." + function + ": " + message);
+    }
+
+    void expectArguments(const std::string &function, const Arguments &args, size_t count)
+    {
+        if (args.size() != count)
+            fail(function, "expects " + std::to_string(count) + " arguments, got " + std::to_string(args.size()));
+    }
+
+    StringMap &argumentMap(const std::string &function, const std::string &handle)
+    {
+        StringMap *map = Heap::getInstance().findMap(handle);
+        if (!map)
+            fail(function, "'" + handle + "' is not a map");
+        return *map;
+    }
+
+    StringMap &argumentMap(const std::string &function, const Arguments &args)
+    {
+        return argumentMap(function, evaluateNode(args[0].get()));
+    }
+
+    const StringMap::Entry &argumentEntry(const std::string &function, const Arguments &args)
+    {
+        expectArguments(function, args, 2);
+        const StringMap &map = argumentMap(function, args);
+        std::string text = evaluateNode(args[1].get());
+        size_t index;
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), index);
+        if (error != std::errc() || end != text.data() + text.size() || index >= map.size())
+            fail(function, "index '" + text + "' out of range for size " + std::to_string(map.size()));
+        return map.entryAt(index);
+    }
+}
+
+void registerMapModule()
+{
+    auto &mm = ModuleManager::getInstance();
+
+    mm.registerFunction("std.map", "new", [](const Arguments &args) {
+        expectArguments("new", args, 0);
+        return Heap::getInstance().newMap().first;
+    });
+
+    mm.registerFunction("std.map", "set", [](const Arguments &args) {
+        expectArguments("set", args, 3);
+        std::string handle = evaluateNode(args[0].get());
+        StringMap &map = argumentMap("set", handle);
+        std::string key = evaluateNode(args[1].get());
+        std::string value = evaluateNode(args[2].get());
+        map[key] = MapValue::from(value);
+        Heap::getInstance().storedInMap(handle, key, value);
+        return std::string();
+    });
+
+    // map.get(m, key) is "" for a missing key; map.get(m, key, fallback) is fallback
+    mm.registerFunction("std.map", "get", [](const Arguments &args) {
+        if (args.size() != 2 && args.size() != 3)
+            fail("get", "expects 2 or 3 arguments, got " + std::to_string(args.size()));
+        StringMap &map = argumentMap("get", args);
+        if (const MapValue *value = map.find(evaluateNode(args[1].get())))
+            return value->toString();
+        return args.size() == 3 ? evaluateNode(args[2].get()) : std::string();
+    });
+
+    mm.registerFunction("std.map", "has", [](const Arguments &args) {
+        expectArguments("has", args, 2);
+        StringMap &map = argumentMap("has", args);
+        return std::string(map.find(evaluateNode(args[1].get())) ? "true" : "false");
+    });
+
+    mm.registerFunction("std.map", "remove", [](const Arguments &args) {
+        expectArguments("remove", args, 2);
+        StringMap &map = argumentMap("remove", args);
+        return std::string(map.remove(evaluateNode(args[1].get())) ? "true" : "false");
+    });
+
+    mm.registerFunction("std.map", "size", [](const Arguments &args) {
+        expectArguments("size", args, 1);
+        return std::to_string(argumentMap("size", args).size());
+    });
+
+    // map.add(m, key, n): adds n to the integer under key (0 if missing)
+    // and returns the sum, which may grow past 64 bits
+    mm.registerFunction("std.map", "add", [](const Arguments &args) {
+        expectArguments("add", args, 3);
+        std::string handle = evaluateNode(args[0].get());
+        StringMap &map = argumentMap("add", handle);
+        std::string key = evaluateNode(args[1].get());
+        MapValue amount = MapValue::from(evaluateNode(args[2].get()));
+        MapValue *value = map.find(key);
+
+        // Missing keys are only inserted once the sum is known to be valid
+        int64_t number;
+        if (amount.isInt && (!value || value->isInt) &&
+            !__builtin_add_overflow(value ? value->number : 0, amount.number, &number))
+        {
+            MapValue &target = value ? *value : map[key];
+            target.isInt = true;
+            target.number = number;
+            target.text.clear();
+            if (!value)
+                Heap::getInstance().storedInMap(handle, key, std::string());
+            return std::to_string(number);
+        }
+
+        std::string current = value ? value->toString() : "0";
+        std::string sum;
+        if (!computeInteger(IntegerOperation::Add, current, amount.toString(), sum))
+            fail("add", "'" + current + "' and '" + amount.toString() + "' are not both integers");
+        (value ? *value : map[key]) = MapValue::from(sum);
+        Heap::getInstance().storedInMap(handle, key, sum);
+        return sum;
+    });
+
+    // Entries are numbered 0 to size - 1, in insertion order until a remove
+    // moves the last entry into the removed one's place
+    mm.registerFunction("std.map", "keyAt", [](const Arguments &args) {
+        return argumentEntry("keyAt", args).key;
+    });
+
+    mm.registerFunction("std.map", "valueAt", [](const Arguments &args) {
+        return argumentEntry("valueAt", args).value.toString();
+    });
+
+    mm.registerFunction("std.map", "toString", [](const Arguments &args) {
+        expectArguments("toString", args, 1);
+        const StringMap &map = argumentMap("toString", args);
+        std::string text = "{";
+        for (size_t i = 0; i < map.size(); i++)
+        {
+            if (i)
+                text += ", ";
+            text += map.entryAt(i).key + ": " + map.entryAt(i).value.toString();
+        }
+        return text + "}";
+    });
+}
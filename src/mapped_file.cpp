@@ -0,0 +1,245 @@
+#include "mapped_file.h"
+
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    const std::string kHandlePrefix = "file#";
+
+    [[noreturn]] void throwError(const std::string &what, const std::string &path)
+    {
+        throw std::runtime_error("cannot " + what + " '" + path + "': " + std::strerror(errno));
+    }
+}
+
+MappedFile::MappedFile(const std::string &path)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throwError("open", path);
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+    {
+        void *mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+        if (mapping != MAP_FAILED)
+        {
+            data_ = static_cast<const char *>(mapping);
+            size_ = mappedSize_ = static_cast<size_t>(info.st_size);
+            close(fd);
+            return;
+        }
+    }
+
+    // Pipes, devices and empty files (whose size says nothing)
+    char chunk[64 * 1024];
+    for (;;)
+    {
+        ssize_t count = read(fd, chunk, sizeof chunk);
+        if (count == 0)
+            break;
+        if (count < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            int error = errno;
+            close(fd);
+            errno = error;
+            throwError("read", path);
+        }
+        buffer_.append(chunk, static_cast<size_t>(count));
+    }
+    close(fd);
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+}
+
+MappedFile::~MappedFile()
+{
+    if (mappedSize_)
+        munmap(const_cast<char *>(data_), mappedSize_);
+}
+
+void MappedFile::indexLines() const
+{
+    std::call_once(indexed_, [this] {
+        if (size_ == 0)
+            return;
+        if (mappedSize_)
+            madvise(const_cast<char *>(data_), mappedSize_, MADV_SEQUENTIAL);
+        lineStarts_.push_back(0);
+        const char *end = data_ + size_;
+        for (const char *next = data_;;)
+        {
+            auto newline = static_cast<const char *>(std::memchr(next, '\n', static_cast<size_t>(end - next)));
+            if (!newline || newline + 1 == end)
+                break;
+            next = newline + 1;
+            lineStarts_.push_back(static_cast<uint64_t>(next - data_));
+        }
+        if (mappedSize_)
+            madvise(const_cast<char *>(data_), mappedSize_, MADV_NORMAL);
+    });
+}
+
+size_t MappedFile::lineCount() const
+{
+    indexLines();
+    return lineStarts_.size();
+}
+
+std::string_view MappedFile::line(size_t index) const
+{
+    indexLines();
+    size_t start = lineStarts_[index];
+    size_t end = index + 1 < lineStarts_.size() ? lineStarts_[index + 1] - 1
+                                                : size_ - (data_[size_ - 1] == '\n' ? 1 : 0);
+    return {data_ + start, end - start};
+}
+
+FileWriter::FileWriter(const std::string &path, bool append)
+    : path_(path), fd_(open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC), 0666))
+{
+    if (fd_ < 0)
+        throwError("open", path);
+    buffer_.reserve(kBufferSize);
+}
+
+FileWriter::~FileWriter()
+{
+    try
+    {
+        close();
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+}
+
+void FileWriter::write(std::string_view text)
+{
+    if (buffer_.size() + text.size() > kBufferSize)
+    {
+        flush();
+        // Text larger than the whole buffer bypasses it
+        if (text.size() >= kBufferSize)
+        {
+            writeAll(text.data(), text.size());
+            return;
+        }
+    }
+    buffer_.append(text);
+}
+
+void FileWriter::flush()
+{
+    // Cleared first, so a failed write is not retried by close()
+    std::string pending;
+    pending.swap(buffer_);
+    buffer_.reserve(kBufferSize);
+    writeAll(pending.data(), pending.size());
+}
+
+void FileWriter::close()
+{
+    if (fd_ < 0)
+        return;
+    try
+    {
+        flush();
+    }
+    catch (const std::runtime_error &)
+    {
+        ::close(fd_);
+        fd_ = -1;
+        throw;
+    }
+    int result = ::close(fd_);
+    fd_ = -1;
+    if (result != 0)
+        throwError("write", path_);
+}
+
+void FileWriter::writeAll(const char *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t written = ::write(fd_, data, size);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throwError("write", path_);
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+
+FileStore &FileStore::getInstance()
+{
+    // Destroyed at exit, which flushes the writers still open
+    static FileStore instance;
+    return instance;
+}
+
+std::string FileStore::add(std::unique_ptr<MappedFile> file)
+{
+    files_.push_back({std::move(file), nullptr});
+    return kHandlePrefix + std::to_string(files_.size() - 1);
+}
+
+std::string FileStore::add(std::unique_ptr<FileWriter> file)
+{
+    files_.push_back({nullptr, std::move(file)});
+    return kHandlePrefix + std::to_string(files_.size() - 1);
+}
+
+size_t FileStore::indexOf(const std::string &handle) const
+{
+    if (handle.compare(0, kHandlePrefix.size(), kHandlePrefix) != 0)
+        return files_.size();
+    size_t index;
+    const char *begin = handle.data() + kHandlePrefix.size();
+    const char *end = handle.data() + handle.size();
+    auto result = std::from_chars(begin, end, index);
+    if (result.ec != std::errc() || result.ptr != end || index >= files_.size())
+        return files_.size();
+    return index;
+}
+
+const MappedFile *FileStore::findReader(const std::string &handle) const
+{
+    size_t index = indexOf(handle);
+    return index < files_.size() ? files_[index].reader.get() : nullptr;
+}
+
+FileWriter *FileStore::findWriter(const std::string &handle)
+{
+    size_t index = indexOf(handle);
+    return index < files_.size() ? files_[index].writer.get() : nullptr;
+}
+
+bool FileStore::close(const std::string &handle)
+{
+    size_t index = indexOf(handle);
+    if (index == files_.size())
+        return false;
+    Entry &entry = files_[index];
+    if (!entry.reader && !entry.writer)
+        return false;
+    entry.reader.reset();
+    if (entry.writer)
+    {
+        std::unique_ptr<FileWriter> writer = std::move(entry.writer);
+        writer->close();
+    }
+    return true;
+}
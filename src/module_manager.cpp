@@ -1,51 +1,324 @@
 #include "module_manager.h"
 #include "symbol_table.h"
 #include "evaluator.h"
+#include "profiler.h"
+#include "tasks.h"
+#include "heap.h"
 
 #include <algorithm>
+#include <stdexcept>
+
+thread_local std::vector<ModuleManager::Frame> ModuleManager::frames;
+thread_local std::vector<Value> ModuleManager::values;
+thread_local size_t ModuleManager::jitPausedAbove = SIZE_MAX;
+thread_local uint64_t ModuleManager::steps = 0;
+thread_local uint64_t ModuleManager::reportedSteps = 0;
+thread_local uint64_t ModuleManager::nextCheck = 0;
+thread_local bool ModuleManager::parallelWorker = false;
+
+namespace {
+    // Calls `visit` for every call in the subtree of `node`
+    template <typename Visit>
+    void forEachCall(const ASTNode* node, const Visit& visit) {
+        if (!node) return;
+        if (auto call = dynamic_cast<const FunctionCallNode*>(node)) {
+            visit(*call);
+            for (const auto& argument : call->arguments) forEachCall(argument.get(), visit);
+        } else if (auto function = dynamic_cast<const FunctionNode*>(node)) {
+            for (const auto& statement : function->body) forEachCall(statement.get(), visit);
+        } else if (auto binary = dynamic_cast<const BinaryOperationNode*>(node)) {
+            forEachCall(binary->left.get(), visit);
+            forEachCall(binary->right.get(), visit);
+        } else if (auto declaration = dynamic_cast<const VariableDeclarationNode*>(node)) {
+            forEachCall(declaration->initializer.get(), visit);
+        } else if (auto returnNode = dynamic_cast<const ReturnStatementNode*>(node)) {
+            forEachCall(returnNode->expression.get(), visit);
+        } else if (auto ifNode = dynamic_cast<const IfStatementNode*>(node)) {
+            forEachCall(ifNode->condition.get(), visit);
+            for (const auto& statement : ifNode->thenBranch) forEachCall(statement.get(), visit);
+            for (const auto& statement : ifNode->elseBranch) forEachCall(statement.get(), visit);
+        }
+    }
+}
 
 ModuleManager& ModuleManager::getInstance() {
     static ModuleManager instance;
     return instance;
 }
 
+// A collection waits for the allocating thread's next interpreter step
+ModuleManager::ModuleManager() {
+    Heap::getInstance().setSafepointRequest([] { nextCheck = 0; });
+}
+
 void ModuleManager::registerModule(const std::string& moduleName) {
-    importedModules.insert(moduleName);
+    importedModules.insert(intern(moduleName));
     
     // Also register the last part of the module path
     size_t lastDot = moduleName.find_last_of('.');
     if (lastDot != std::string::npos) {
         std::string shortName = moduleName.substr(lastDot + 1);
-        importedModules.insert(shortName);
+        importedModules.insert(intern(shortName));
     }
 }
 
 bool ModuleManager::isModuleImported(const std::string& moduleName) const {
-    return importedModules.find(moduleName) != importedModules.end();
+    Symbol module = Interner::getInstance().find(moduleName);
+    return module != kNoSymbol && importedModules.count(module);
 }
 
 void ModuleManager::registerFunction(const std::string& moduleName, const std::string& functionName, ModuleFunction func) {
-    moduleFunctions[moduleName][functionName] = func;
+    moduleFunctions[intern(moduleName)][intern(functionName)] = func;
+    resolvedCalls.clear();
 }
 
 void ModuleManager::registerUserDefinedFunction(const std::string& moduleName, 
                                               const std::string& functionName,
                                               const std::vector<FunctionNode::Parameter>& params,
                                               const std::string& returnType,
-                                              std::unique_ptr<ASTNode> body) {
+                                              std::unique_ptr<ASTNode> body,
+                                              const void* owner) {
     UserFunction func;
+    func.module = intern(moduleName);
     func.parameters = params;
+    for (auto& param : func.parameters) {
+        if (param.symbol == kNoSymbol) param.symbol = intern(param.name);
+    }
     func.returnType = returnType;
     func.body = std::move(body);
-    userDefinedFunctions[moduleName][functionName] = std::move(func);
+    func.owner = owner;
+    userDefinedFunctions[intern(moduleName)][intern(functionName)] = std::move(func);
+    resolvedCalls.clear();
+    discardCompiledCode();
+}
+
+void ModuleManager::unregisterUserDefinedFunction(const std::string& moduleName, const std::string& functionName,
+                                                  const void* owner) {
+    auto moduleIt = userDefinedFunctions.find(Interner::getInstance().find(moduleName));
+    if (moduleIt != userDefinedFunctions.end()) {
+        auto funcIt = moduleIt->second.find(Interner::getInstance().find(functionName));
+        if (funcIt == moduleIt->second.end() || (owner && funcIt->second.owner != owner)) return;
+        moduleIt->second.erase(funcIt);
+    }
+    resolvedCalls.clear();
+    discardCompiledCode();
+}
+
+void ModuleManager::clearUserFunctions() {
+    userDefinedFunctions.clear();
+    resolvedCalls.clear();
+    hasRunFunctions = false;
+}
+
+void ModuleManager::setLimits(const ExecutionLimits& newLimits) {
+    limits = newLimits;
+    maxCallDepth = limits.callDepth ? limits.callDepth : kMaxCallDepth;
+    steps = 0;
+    reportedSteps = 0;
+    totalSteps = 0;
+    deadline = std::chrono::steady_clock::now() + limits.time;
+    exceededLimit();
+    AllocationStats::setHeapLimit(limits.heapBytes);
+    // Whether compiled code counts its calls is fixed when it is compiled
+    discardCompiledCode();
+}
+
+ModuleManager::Limit ModuleManager::exceededLimit() {
+    uint64_t total = totalSteps.fetch_add(steps - reportedSteps, std::memory_order_relaxed) + (steps - reportedSteps);
+    reportedSteps = steps;
+    if (limits.steps && total > limits.steps) return Limit::Steps;
+    if (limits.time.count() && std::chrono::steady_clock::now() >= deadline) return Limit::Time;
+
+    nextCheck = limits.steps ? steps + (limits.steps - total) : UINT64_MAX;
+    // Other threads use up the same steps meanwhile
+    if (limits.steps && parallelThreads.load(std::memory_order_relaxed)) {
+        nextCheck = std::min(nextCheck, steps + kStepsPerClockCheck);
+    }
+    if (limits.time.count()) {
+        nextCheck = std::min(nextCheck, steps + kStepsPerClockCheck);
+    }
+    if (switchingTasks) {
+        nextCheck = std::min(nextCheck, steps + kStepsPerTaskSwitch);
+    }
+    return Limit::None;
+}
+
+void ModuleManager::enableTaskSwitching() {
+    switchingTasks = true;
+    exceededLimit();
+}
+
+ModuleManager::ParallelWork::ParallelWork() {
+    auto& mm = ModuleManager::getInstance();
+    parallelWorker = true;
+    mm.parallelThreads.fetch_add(1, std::memory_order_relaxed);
+    // Check again soon, now that the steps are shared
+    if (mm.exceededLimit() != Limit::None) {
+        nextCheck = steps;
+    }
+}
+
+ModuleManager::ParallelWork::~ParallelWork() {
+    parallelWorker = false;
+    ModuleManager::getInstance().parallelThreads.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void ModuleManager::throwBudgetExceeded(Limit limit) const {
+    if (limit == Limit::Steps) {
+        throw BudgetExceeded("step limit of " + std::to_string(limits.steps) + " exceeded");
+    }
+    throw BudgetExceeded("time limit of " + std::to_string(limits.time.count()) + " ms exceeded");
+}
+
+void ModuleManager::setJitThreshold(uint32_t threshold) {
+    jitThreshold = threshold;
+    discardCompiledCode();
+}
+
+// Compiled code has its callees linked in, so any change to the set of user
+// functions invalidates all of it
+void ModuleManager::discardCompiledCode() {
+    // Registering a program must not be quadratic in its size
+    if (!hasRunFunctions) return;
+    hasRunFunctions = false;
+    for (auto& module : userDefinedFunctions) {
+        for (auto& entry : module.second) {
+            entry.second.callCount = 0;
+            entry.second.jitRejected = false;
+            entry.second.compiled.reset();
+            entry.second.code.clear();
+        }
+    }
+}
+
+bool ModuleManager::isBuiltinFunction(const std::string& qualifiedName) const {
+    return !builtinName(qualifiedName).empty();
+}
+
+std::string ModuleManager::builtinName(const std::string& qualifiedName) const {
+    return resolveCallTarget(qualifiedName).builtin;
+}
+
+void ModuleManager::registerProgram(const ASTNode* program) {
+    auto root = dynamic_cast<const ModuleNode*>(program);
+    if (!root) return;
+
+    for (const auto& child : root->body) {
+        auto module = dynamic_cast<const ModuleNode*>(child.get());
+        if (!module) continue;
+        for (const auto& member : module->body) {
+            if (auto function = dynamic_cast<const FunctionNode*>(member.get())) {
+                registerUserDefinedFunction(module->name, function->name, function->parameters,
+                                            function->returnType, function->clone());
+            }
+        }
+    }
+}
+
+const ModuleManager::ResolvedCall& ModuleManager::resolve(Symbol qualifiedName) const {
+    auto cached = resolvedCalls.find(qualifiedName);
+    if (cached != resolvedCalls.end()) return cached->second;
+
+    ResolvedCall& call = resolvedCalls[qualifiedName];
+    const std::string& name = Interner::getInstance().name(qualifiedName);
+    size_t dotPos = name.find_last_of('.');
+    if (dotPos == std::string::npos) return call;
+
+    // Names that were never interned cannot have been registered
+    auto& interner = Interner::getInstance();
+    std::string moduleName = name.substr(0, dotPos);
+    Symbol function = interner.find(std::string_view(name).substr(dotPos + 1));
+    if (function == kNoSymbol) return call;
+
+    // Builtins win over user modules: "std.<module>" first, then "<module>"
+    for (Symbol module : {interner.find("std." + moduleName), interner.find(moduleName)}) {
+        auto moduleIt = moduleFunctions.find(module);
+        if (moduleIt == moduleFunctions.end()) continue;
+        auto funcIt = moduleIt->second.find(function);
+        if (funcIt != moduleIt->second.end()) {
+            call.module = module;
+            call.function = function;
+            call.builtin = &funcIt->second;
+            return call;
+        }
+    }
+
+    auto userModuleIt = userDefinedFunctions.find(interner.find(moduleName));
+    if (userModuleIt != userDefinedFunctions.end()) {
+        auto funcIt = userModuleIt->second.find(function);
+        if (funcIt != userModuleIt->second.end()) {
+            // The cache is reset before any function is removed
+            call.user = const_cast<UserFunction*>(&funcIt->second);
+        }
+    }
+    return call;
+}
+
+jit::CallTarget ModuleManager::resolveCallTarget(const std::string& qualifiedName) const {
+    jit::CallTarget target;
+    const ResolvedCall& call = resolve(intern(qualifiedName));
+    if (call.builtin) {
+        auto& interner = Interner::getInstance();
+        target.builtin = interner.name(call.module) + "." + interner.name(call.function);
+    }
+    else if (call.user) {
+        target.function = dynamic_cast<const FunctionNode*>(call.user->body.get());
+    }
+    return target;
+}
+
+void ModuleManager::compileHotFunction(UserFunction& func) {
+    // Calls made inside compiled code would not show up in the profile
+    if (Profiler::getInstance().isEnabled()) {
+        func.jitRejected = true;
+        return;
+    }
+
+    // Callees are compiled along with the function, so their bodies are
+    // needed now. One that does not parse stays interpreted and reports its
+    // errors when it is called.
+    auto resolveLoaded = [this](const std::string& name) {
+        const ResolvedCall& call = resolve(intern(name));
+        if (call.user) {
+            loadBody(*call.user);
+        }
+        return resolveCallTarget(name);
+    };
+    auto function = dynamic_cast<const FunctionNode*>(func.body.get());
+    try {
+        loadBody(func);
+        if (function) {
+            func.compiled = jit::compile(*function, resolveLoaded, limits.countsSteps());
+        }
+    } catch (const std::exception&) {
+        func.compiled.reset();
+    }
+    func.jitRejected = !func.compiled;
+}
+
+void ModuleManager::loadBody(UserFunction& func) {
+    auto function = dynamic_cast<FunctionNode*>(func.body.get());
+    if (!function || !function->lazyBody) return;
+    if (!bodyLoader) {
+        throw std::runtime_error("no body loader for lazily parsed function '" + function->name + "'");
+    }
+
+    try {
+        bodyLoader(Interner::getInstance().name(func.module), *function);
+    } catch (...) {
+        function->body.clear();
+        throw;
+    }
+    function->lazyBody.reset();
 }
 
 std::unique_ptr<ASTNode> ModuleManager::getUserDefinedFunction(const std::string& qualifiedName) const {
     size_t dotPos = qualifiedName.find('.');
     if (dotPos == std::string::npos) return nullptr;
 
-    std::string moduleName = qualifiedName.substr(0, dotPos);
-    std::string functionName = qualifiedName.substr(dotPos + 1);
+    auto& interner = Interner::getInstance();
+    Symbol moduleName = interner.find(std::string_view(qualifiedName).substr(0, dotPos));
+    Symbol functionName = interner.find(std::string_view(qualifiedName).substr(dotPos + 1));
 
     auto moduleIt = userDefinedFunctions.find(moduleName);
     if (moduleIt != userDefinedFunctions.end()) {
@@ -59,93 +332,360 @@ std::unique_ptr<ASTNode> ModuleManager::getUserDefinedFunction(const std::string
 }
 
 bool ModuleManager::hasFunction(const std::string& qualifiedName) const {
-    size_t dotPos = qualifiedName.find_last_of('.');
-    if (dotPos == std::string::npos) return false;
+    const ResolvedCall& call = resolve(intern(qualifiedName));
+    return call.builtin || call.user;
+}
 
-    std::string moduleName = qualifiedName.substr(0, dotPos);
-    std::string functionName = qualifiedName.substr(dotPos + 1);
+std::string ModuleManager::callFunction(const std::string& qualifiedName, const std::vector<std::unique_ptr<ASTNode>>& args) {
+    return callFunction(intern(qualifiedName), args);
+}
 
-    // First check built-in functions
-    auto moduleIt = moduleFunctions.find("std." + moduleName);
-    if (moduleIt != moduleFunctions.end()) {
-        if (moduleIt->second.find(functionName) != moduleIt->second.end()) {
-            return true;
+// The heap limit is only enforced while a script runs, so that the host can
+// still allocate to report the error
+std::string ModuleManager::callWithHeapLimit(Symbol qualifiedName, const std::vector<std::unique_ptr<ASTNode>>& args) {
+    enforcingHeapLimit = true;
+    AllocationStats::enforceHeapLimit(true);
+    try {
+        std::string result = callFunction(qualifiedName, args);
+        AllocationStats::enforceHeapLimit(false);
+        enforcingHeapLimit = false;
+        return result;
+    } catch (const AllocationStats::HeapLimitExceeded& e) {
+        AllocationStats::enforceHeapLimit(false);
+        enforcingHeapLimit = false;
+        throw BudgetExceeded(e.what());
+    } catch (...) {
+        AllocationStats::enforceHeapLimit(false);
+        enforcingHeapLimit = false;
+        throw;
+    }
+}
+
+std::string ModuleManager::callFunction(Symbol qualifiedName, const std::vector<std::unique_ptr<ASTNode>>& args) {
+    if (limits.heapBytes && !enforcingHeapLimit) {
+        return callWithHeapLimit(qualifiedName, args);
+    }
+    ProfileScope profileScope(Interner::getInstance().name(qualifiedName));
+
+    const ResolvedCall& call = resolve(qualifiedName);
+    if (call.builtin) {
+        Heap::Busy busy;
+        return (*call.builtin)(args);
+    }
+    if (!call.user) return "";
+
+    UserFunction& func = *call.user;
+
+    // Evaluate arguments in the caller's scope before any parameter is bound
+    std::vector<Value> argValues;
+    {
+        Heap::Busy busy;
+        for (size_t i = 0; i < func.parameters.size() && i < args.size(); i++) {
+            argValues.push_back(evaluateValue(args[i].get()));
         }
     }
-    
-    moduleIt = moduleFunctions.find(moduleName);
-    if (moduleIt != moduleFunctions.end()) {
-        if (moduleIt->second.find(functionName) != moduleIt->second.end()) {
+    return execute(func, argValues, args.size());
+}
+
+std::string ModuleManager::callWithValues(Symbol qualifiedName, std::vector<Value> arguments) {
+    const ResolvedCall& call = resolve(qualifiedName);
+    if (!call.user) {
+        throw std::runtime_error("'" + Interner::getInstance().name(qualifiedName) + "' is not a user function");
+    }
+    ProfileScope profileScope(Interner::getInstance().name(qualifiedName));
+    size_t count = arguments.size();
+    if (arguments.size() > call.user->parameters.size()) {
+        arguments.resize(call.user->parameters.size());
+    }
+    return execute(*call.user, arguments, count);
+}
+
+void ModuleManager::prepareParallelCalls(Symbol qualifiedName,
+                                         const std::function<bool(const std::string&)>& isThreadSafe) {
+    auto& interner = Interner::getInstance();
+    const ResolvedCall& entry = resolve(qualifiedName);
+    if (!entry.user) {
+        throw std::runtime_error("'" + interner.name(qualifiedName) + "' is not a user function");
+    }
+
+    std::vector<UserFunction*> pending{entry.user};
+    std::unordered_set<UserFunction*> seen{entry.user};
+    while (!pending.empty()) {
+        UserFunction& func = *pending.back();
+        pending.pop_back();
+        buildFrameCode(func);
+        forEachCall(func.body.get(), [&](const FunctionCallNode& call) {
+            const ResolvedCall& target = resolve(call.symbol);
+            if (target.user) {
+                if (seen.insert(target.user).second) pending.push_back(target.user);
+                return;
+            }
+            if (!target.builtin) return;
+            std::string builtin = interner.name(target.module) + "." + interner.name(target.function);
+            if (!isThreadSafe(builtin)) {
+                auto function = dynamic_cast<const FunctionNode*>(func.body.get());
+                throw std::runtime_error(interner.name(func.module) + "." + (function ? function->name : "") +
+                                         " calls " + builtin + ", which cannot run in parallel");
+            }
+        });
+    }
+}
+
+bool ModuleManager::runCompiled(UserFunction& func, const Value* arguments, size_t count, std::string& result) {
+    if (parallelWorker) return false;
+    // Every user call passes here before any frame code is built
+    hasRunFunctions = true;
+    if (frames.size() > jitPausedAbove) return false;
+
+    if (jitThreshold && !func.compiled && !func.jitRejected && ++func.callCount >= jitThreshold) {
+        compileHotFunction(func);
+    }
+    if (!func.compiled || count != func.parameters.size()) return false;
+
+    // Only canonical int arguments; "" and anything else stays interpreted
+    std::vector<int64_t> numbers;
+    for (size_t i = 0; i < count; i++) {
+        int64_t number;
+        if (!jit::fromString(arguments[i].str(), number)) return false;
+        numbers.push_back(number);
+    }
+
+    // Native frames take at least kMinNativeFrameBytes, so compiled code
+    // cannot nest deeper than the call depth limit allows. When it runs out
+    // of stack the interpreter takes over and enforces the exact limit.
+    jit::CompiledCode::Budget budget;
+    budget.stackBytes = std::min(jit::kStackBudget, (maxCallDepth - frames.size()) * kMinNativeFrameBytes);
+    uint64_t granted = 0;
+    Limit exceeded = Limit::None;
+    if (limits.countsSteps()) {
+        granted = budget.calls = nextCheck > steps ? nextCheck - steps : 0;
+        budget.refill = [this, &granted, &exceeded](uint64_t& calls) {
+            // Everything granted was used, plus the call that asks
+            steps += granted + 1;
+            granted = 0;
+            exceeded = exceededLimit();
+            if (exceeded != Limit::None) return false;
+            granted = calls = nextCheck > steps ? nextCheck - steps : 0;
             return true;
-        }
+        };
     }
 
-    // Then check user-defined functions
-    auto userModuleIt = userDefinedFunctions.find(moduleName);
-    if (userModuleIt != userDefinedFunctions.end()) {
-        return userModuleIt->second.find(functionName) != userModuleIt->second.end();
+    int64_t value;
+    auto outcome = func.compiled->invoke(numbers, value, budget);
+    if (outcome != jit::CompiledCode::Outcome::OutOfBudget) {
+        steps += granted - budget.calls;
+    }
+    switch (outcome) {
+    case jit::CompiledCode::Outcome::Returned:
+        result = jit::toString(value);
+        return true;
+    case jit::CompiledCode::Outcome::OutOfStack:
+        jitPausedAbove = frames.size();
+        return false;
+    case jit::CompiledCode::Outcome::OutOfBudget:
+        throwBudgetExceeded(exceeded);
+    default:
+        return false;
     }
+}
 
-    return false;
+void ModuleManager::bindArguments(UserFunction& func, Value* arguments, size_t count) {
+    auto& symbols = SymbolTable::getInstance();
+    symbols.pushScope();
+    for (size_t i = 0; i < func.parameters.size() && i < count; i++) {
+        symbols.setValue(func.parameters[i].symbol, std::move(arguments[i]));
+    }
+    buildFrameCode(func);
 }
 
-std::string ModuleManager::callFunction(const std::string& qualifiedName, const std::vector<std::unique_ptr<ASTNode>>& args) {
-    size_t dotPos = qualifiedName.find_last_of('.');
-    if (dotPos == std::string::npos) return "";
+void ModuleManager::buildFrameCode(UserFunction& func) {
+    if (func.code.empty()) {
+        hasRunFunctions = true;
+        loadBody(func);
+        auto isUserCall = [this](const FunctionCallNode& call) { return resolve(call.symbol).user != nullptr; };
+        auto function = dynamic_cast<const FunctionNode*>(func.body.get());
+        func.code = function ? compileFrameCode(*function, isUserCall)
+                             : std::vector<FrameInstruction>{{FrameInstruction::Op::PushEmpty},
+                                                             {FrameInstruction::Op::Return}};
+    }
+}
 
-    std::string moduleName = qualifiedName.substr(0, dotPos);
-    std::string functionName = qualifiedName.substr(dotPos + 1);
+void ModuleManager::pushFrame(UserFunction& func, Value* arguments, size_t count) {
+    if (frames.size() >= maxCallDepth) {
+        throw BudgetExceeded("call depth limit of " + std::to_string(maxCallDepth) + " exceeded");
+    }
+    frames.push_back({&func, 0});
+    bindArguments(func, arguments, count);
+}
 
-    // First try built-in functions
-    auto moduleIt = moduleFunctions.find("std." + moduleName);
-    if (moduleIt != moduleFunctions.end()) {
-        auto funcIt = moduleIt->second.find(functionName);
-        if (funcIt != moduleIt->second.end()) {
-            return funcIt->second(args);
-        }
+std::string ModuleManager::execute(UserFunction& func, std::vector<Value>& arguments, size_t argumentCount) {
+    std::string result;
+    if (runCompiled(func, arguments.data(), argumentCount, result)) {
+        return result;
     }
 
-    moduleIt = moduleFunctions.find(moduleName);
-    if (moduleIt != moduleFunctions.end()) {
-        auto funcIt = moduleIt->second.find(functionName);
-        if (funcIt != moduleIt->second.end()) {
-            return funcIt->second(args);
+    // The collector finds this thread's objects through its variables and
+    // operands; parallel workers only run while nothing is collected
+    static thread_local bool heapRoots = false;
+    if (!heapRoots && !parallelWorker) {
+        Heap::getInstance().addThreadRoots([&symbols = SymbolTable::getInstance(), &stack = values](
+                                               const Heap::RootVisitor& visit) {
+            symbols.forEachValue([&](const Value& value) { visit(value.str()); });
+            for (const Value& value : stack) {
+                visit(value.str());
+            }
+        });
+        heapRoots = true;
+    }
+
+    size_t baseFrame = frames.size();
+    size_t baseValue = values.size();
+    pushFrame(func, arguments.data(), arguments.size());
+    try {
+        return run(baseFrame);
+    } catch (...) {
+        while (frames.size() > baseFrame) {
+            if (frames.size() > baseFrame + 1 && Profiler::getInstance().isEnabled()) {
+                Profiler::getInstance().exit();
+            }
+            SymbolTable::getInstance().popScope();
+            frames.pop_back();
         }
+        values.resize(baseValue);
+        throw;
     }
+}
 
-    // Then try user-defined functions
-    auto userModuleIt = userDefinedFunctions.find(moduleName);
-    if (userModuleIt != userDefinedFunctions.end()) {
-        auto funcIt = userModuleIt->second.find(functionName);
-        if (funcIt != userModuleIt->second.end()) {
-            const UserFunction& func = funcIt->second;
-            
-            // Create new symbol scope for function call
-            SymbolTable::getInstance().pushScope();
-            
-            // Bind arguments to parameters
-            for (size_t i = 0; i < func.parameters.size() && i < args.size(); i++) {
-                std::string argValue = evaluateNode(args[i].get());
-                SymbolTable::getInstance().setValue(func.parameters[i].name, argValue);
+std::string ModuleManager::run(size_t baseFrame) {
+    using Op = FrameInstruction::Op;
+    auto& symbols = SymbolTable::getInstance();
+    auto& profiler = Profiler::getInstance();
+
+    for (;;) {
+        if (++steps > nextCheck) {
+            Limit exceeded = exceededLimit();
+            if (exceeded != Limit::None) {
+                throwBudgetExceeded(exceeded);
+            }
+            if (!parallelWorker) {
+                if (switchingTasks) {
+                    Tasks::getInstance().yield();
+                }
+                Heap::getInstance().safepoint();
+            }
+        }
+        Frame& frame = frames.back();
+        const FrameInstruction& instruction = frame.function->code[frame.pc++];
+        switch (instruction.op) {
+        case Op::Evaluate:
+            values.push_back(evaluateValue(instruction.node));
+            break;
+
+        case Op::Binary: {
+            Value right = std::move(values.back());
+            values.pop_back();
+            values.back() = evaluateBinary(static_cast<BinaryOperationNode*>(instruction.node),
+                                           std::move(values.back()).release(), std::move(right).release());
+            break;
+        }
+
+        case Op::Call:
+        case Op::TailCall: {
+            auto call = static_cast<FunctionCallNode*>(instruction.node);
+            size_t count = call->arguments.size();
+            Value* arguments = values.data() + values.size() - count;
+            const ResolvedCall& target = resolve(call->symbol);
+
+            if (!target.user) {
+                // Builtins take syntax trees: hand them the values as literals
+                std::vector<std::unique_ptr<ASTNode>> literals;
+                for (size_t i = 0; i < count; i++) {
+                    auto literal = std::make_unique<LiteralNode>();
+                    literal->type = "value";
+                    literal->value = std::move(arguments[i]).release();
+                    literals.push_back(std::move(literal));
+                }
+                values.resize(values.size() - count);
+                values.push_back(callFunction(call->symbol, literals));
+                break;
             }
-            
-            // Execute function body
+
+            UserFunction& callee = *target.user;
             std::string result;
-            for (const auto& stmt : dynamic_cast<FunctionNode*>(func.body.get())->body) {
-                result = evaluateNode(stmt.get());
-                // If this is a return statement, break out
-                if (!SymbolTable::getInstance().getValue("_lastResult").empty()) {
-                    result = SymbolTable::getInstance().getValue("_lastResult");
-                    SymbolTable::getInstance().setValue("_lastResult", "");
-                    break;
+            if (runCompiled(callee, arguments, count, result)) {
+                values.resize(values.size() - count);
+                values.push_back(std::move(result));
+                break;
+            }
+
+            const std::string& name = Interner::getInstance().name(call->symbol);
+            if (instruction.op == Op::TailCall) {
+                // Nothing of the current frame is needed any more
+                if (profiler.isEnabled()) {
+                    profiler.exit();
+                    profiler.enter(name);
                 }
+                symbols.popScope();
+                frame.function = &callee;
+                frame.pc = 0;
+                bindArguments(callee, arguments, count);
             }
-            
-            // Restore previous scope
-            SymbolTable::getInstance().popScope();
-            return result;
+            else {
+                if (profiler.isEnabled()) {
+                    profiler.enter(name);
+                }
+                pushFrame(callee, arguments, count);
+            }
+            values.resize(values.size() - count);
+            break;
         }
-    }
 
-    return "";
+        case Op::Store:
+            symbols.setValue(static_cast<VariableDeclarationNode*>(instruction.node)->symbol, std::move(values.back()));
+            values.back() = Value();
+            break;
+
+        case Op::Pop:
+            values.pop_back();
+            break;
+
+        case Op::PushEmpty:
+            values.emplace_back();
+            break;
+
+        case Op::JumpIfFalse: {
+            bool condition = isTrue(values.back().str());
+            values.pop_back();
+            if (!condition) {
+                frame.pc = instruction.target;
+            }
+            break;
+        }
+
+        case Op::Jump:
+            frame.pc = instruction.target;
+            break;
+
+        case Op::Return: {
+            Value result = std::move(values.back());
+            values.pop_back();
+            symbols.popScope();
+            frames.pop_back();
+            if (frames.size() <= jitPausedAbove) {
+                jitPausedAbove = SIZE_MAX;
+            }
+            if (frames.size() == baseFrame) {
+                // Released after the scope is gone, so a result that was
+                // one of its variables is moved rather than copied
+                return std::move(result).release();
+            }
+            // The first frame is profiled by callFunction
+            if (profiler.isEnabled()) {
+                profiler.exit();
+            }
+            values.push_back(std::move(result));
+            break;
+        }
+        }
+    }
 }
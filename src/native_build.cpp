@@ -0,0 +1,56 @@
+#include "native_build.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <spawn.h>
+#include <sys/wait.h>
+
+extern char **environ;
+
+#ifndef NEXIS_RUNTIME_DIR
+#define NEXIS_RUNTIME_DIR "runtime"
+#endif
+
+std::string runtimeDirectory()
+{
+    const char *directory = std::getenv("NEXIS_RUNTIME_DIR");
+    return directory && *directory ? directory : NEXIS_RUNTIME_DIR;
+}
+
+bool compileNative(const std::string &cFile, const std::string &output, const std::vector<std::string> &extraFlags)
+{
+    // $CC may carry its own arguments, e.g. "ccache gcc"
+    std::vector<std::string> command;
+    const char *cc = std::getenv("CC");
+    std::istringstream compiler(cc && *cc ? cc : "cc");
+    for (std::string word; compiler >> word;)
+        command.push_back(word);
+
+    std::string runtime = runtimeDirectory();
+    for (const std::string &argument : {std::string("-std=c99"), std::string("-O2"), "-I" + runtime})
+        command.push_back(argument);
+    command.insert(command.end(), extraFlags.begin(), extraFlags.end());
+    for (const std::string &argument : {cFile, runtime + "/nexis_runtime.c", std::string("-o"), output})
+        command.push_back(argument);
+
+    std::vector<char *> argv;
+    for (auto &argument : command)
+        argv.push_back(&argument[0]);
+    argv.push_back(nullptr);
+
+    pid_t pid;
+    if (posix_spawnp(&pid, argv[0], nullptr, nullptr, argv.data(), environ) != 0)
+    {
+        std::cerr << "Error: Could not run C compiler '" << command.front() << "'" << std::endl;
+        return false;
+    }
+
+    int status = 0;
+    if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+        std::cerr << "Error: C compiler failed on " << cFile << std::endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,82 @@
+#include "output_buffer.h"
+
+#include <cerrno>
+#include <unistd.h>
+
+OutputBuffer &OutputBuffer::getInstance()
+{
+    // Destroyed at exit, which flushes whatever is still pending
+    static OutputBuffer instance(STDOUT_FILENO);
+    return instance;
+}
+
+OutputBuffer::OutputBuffer(int fd, size_t capacity)
+    : fd_(fd), capacity_(capacity ? capacity : kDefaultCapacity),
+      mode_(isatty(fd) ? Mode::Line : Mode::Full)
+{
+    buffer_.reserve(capacity_);
+}
+
+OutputBuffer::~OutputBuffer()
+{
+    flush();
+}
+
+void OutputBuffer::write(const std::string &text)
+{
+    append(text.data(), text.size());
+    if (mode_ == Mode::Line && text.find('\n') != std::string::npos)
+    {
+        flush();
+    }
+}
+
+void OutputBuffer::writeLine(const std::string &text)
+{
+    append(text.data(), text.size());
+    append("\n", 1);
+    if (mode_ == Mode::Line)
+    {
+        flush();
+    }
+}
+
+void OutputBuffer::flush()
+{
+    if (buffer_.empty())
+        return;
+
+    writeAll(buffer_.data(), buffer_.size());
+    buffer_.clear();
+}
+
+void OutputBuffer::append(const char *data, size_t size)
+{
+    if (buffer_.size() + size > capacity_)
+    {
+        flush();
+        // Payloads larger than the whole buffer bypass it
+        if (size >= capacity_)
+        {
+            writeAll(data, size);
+            return;
+        }
+    }
+    buffer_.append(data, size);
+}
+
+void OutputBuffer::writeAll(const char *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t written = ::write(fd_, data, size);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return; // Nothing sensible left to do with a broken stdout
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+}
@@ -0,0 +1,246 @@
+#include "thread_pool.h"
+#include "heap.h"
+#include "standard_library.h"
+#include "module_manager.h"
+#include "symbol_table.h"
+#include "evaluator.h"
+#include "big_integer.h"
+
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+#include <thread>
+#include <unordered_set>
+
+namespace
+{
+    using Arguments = std::vector<std::unique_ptr<ASTNode>>;
+
+    // Chunks per thread, so that threads that finish early can take over
+    // work from slow ones
+    constexpr size_t kChunksPerThread = 4;
+
+    // Builtins that only read: the function a parallel call runs and
+    // everything it calls may use these and no others
+    const std::unordered_set<std::string> kThreadSafeBuiltins = {
+        "std.math.add", "std.math.subtract", "std.math.multiply",
+        "std.array.length", "std.array.get", "std.array.toString", "std.array.sum", "std.array.dot",
+        "std.array.min", "std.array.max",
+        "std.map.get", "std.map.has", "std.map.size", "std.map.keyAt", "std.map.valueAt", "std.map.toString",
+        "std.fs.read_all", "std.fs.lines", "std.fs.line",
+        "std.string.length", "std.string.find", "std.string.contains", "std.string.count", "std.string.join",
+        "std.string.replace", "std.string.substring",
+    };
+
+    [[noreturn]] void fail(const std::string &function, const std::string &message)
+    {
+        throw std::runtime_error("parallel." + function + ": " + message);
+    }
+
+    enum class Reduction
+    {
+        Sum,
+        Min,
+        Max
+    };
+
+    Reduction parseReduction(const std::string &function, const std::string &name)
+    {
+        if (name == "sum")
+            return Reduction::Sum;
+        if (name == "min")
+            return Reduction::Min;
+        if (name == "max")
+            return Reduction::Max;
+        fail(function, "unknown reduction '" + name + "'");
+    }
+
+    // The reduction of one chunk's results. Stays on int64 while the
+    // results and the sum fit and continues on decimal strings otherwise.
+    struct Partial
+    {
+        bool empty = true;
+        int64_t small = 0;
+        std::string big; // the value, once it is not an int64
+        bool rejected = false;
+        std::string notInteger; // the result that was not an integer
+
+        std::string value() const { return big.empty() ? std::to_string(small) : big; }
+    };
+
+    bool parseInt64(const std::string &text, int64_t &value)
+    {
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return error == std::errc() && end == text.data() + text.size();
+    }
+
+    void setValue(Partial &partial, std::string text)
+    {
+        partial.empty = false;
+        if (parseInt64(text, partial.small))
+            partial.big.clear();
+        else
+            partial.big = std::move(text);
+    }
+
+    // Folds `result` into `partial`; false if it is not an integer
+    bool reduce(Reduction reduction, Partial &partial, const std::string &result)
+    {
+        int64_t number;
+        bool isInt64 = parseInt64(result, number);
+        if (partial.empty && isInt64)
+        {
+            partial.empty = false;
+            partial.small = number;
+            return true;
+        }
+        if (isInt64 && partial.big.empty())
+        {
+            int64_t sum;
+            switch (reduction)
+            {
+            case Reduction::Sum:
+                if (__builtin_add_overflow(partial.small, number, &sum))
+                    break;
+                partial.small = sum;
+                return true;
+            case Reduction::Min:
+                partial.small = std::min(partial.small, number);
+                return true;
+            case Reduction::Max:
+                partial.small = std::max(partial.small, number);
+                return true;
+            }
+        }
+
+        std::string current = partial.empty ? "0" : partial.value();
+        if (reduction == Reduction::Sum)
+        {
+            std::string sum;
+            if (!computeInteger(IntegerOperation::Add, current, result, sum))
+                return false;
+            setValue(partial, std::move(sum));
+            return true;
+        }
+        int order;
+        if (!compareIntegers(current, result, order))
+            return false;
+        if (partial.empty || (reduction == Reduction::Min ? order > 0 : order < 0))
+            setValue(partial, result);
+        return true;
+    }
+
+    // Calls `function` once for every index in [0, count) with the argument
+    // `argument(index)` followed by `extra`, spread over the thread pool,
+    // and reduces the results
+    template <typename Argument>
+    std::string parallelCall(const std::string &caller, const std::string &function, Reduction reduction,
+                             size_t count, const Argument &argument, const std::vector<Value> &extra)
+    {
+        auto &mm = ModuleManager::getInstance();
+        if (!mm.hasFunction(function))
+            fail(caller, "'" + function + "' is not a function");
+        Symbol symbol = intern(function);
+        try
+        {
+            mm.prepareParallelCalls(symbol, [](const std::string &builtin) {
+                return kThreadSafeBuiltins.count(builtin) != 0;
+            });
+        }
+        catch (const std::runtime_error &e)
+        {
+            fail(caller, e.what());
+        }
+
+        ThreadPool &pool = ThreadPool::getInstance();
+        size_t chunks = std::min(count, pool.threads() * kChunksPerThread);
+        std::vector<Partial> partials(chunks);
+        const auto &globals = SymbolTable::getInstance().globals();
+        std::thread::id callerThread = std::this_thread::get_id();
+
+        pool.run(chunks, [&](size_t chunk) {
+            if (std::this_thread::get_id() != callerThread)
+                SymbolTable::getInstance().setGlobals(globals);
+            ModuleManager::ParallelWork work;
+            size_t end = count * (chunk + 1) / chunks;
+            for (size_t index = count * chunk / chunks; index < end; index++)
+            {
+                std::vector<Value> arguments;
+                arguments.reserve(extra.size() + 1);
+                arguments.emplace_back(argument(index));
+                arguments.insert(arguments.end(), extra.begin(), extra.end());
+                std::string result = mm.callWithValues(symbol, std::move(arguments));
+                if (!reduce(reduction, partials[chunk], result))
+                {
+                    partials[chunk].rejected = true;
+                    partials[chunk].notInteger = std::move(result);
+                    return;
+                }
+            }
+        });
+
+        Partial total;
+        for (const Partial &partial : partials)
+        {
+            if (partial.rejected)
+                fail(caller, "'" + function + "' returned '" + partial.notInteger + "', which is not an integer");
+            if (!partial.empty)
+                reduce(reduction, total, partial.value());
+        }
+        if (total.empty && reduction != Reduction::Sum)
+            fail(caller, "nothing to reduce");
+        return total.value();
+    }
+
+    std::vector<Value> extraArguments(const Arguments &args, size_t first)
+    {
+        std::vector<Value> extra;
+        for (size_t i = first; i < args.size(); i++)
+            extra.emplace_back(evaluateNode(args[i].get()));
+        return extra;
+    }
+}
+
+void registerParallelModule()
+{
+    auto &mm = ModuleManager::getInstance();
+
+    // parallel.range(start, end, "Module.function", reduction, extra...)
+    // reduces function(i, extra...) over start <= i < end with "sum", "min"
+    // or "max"
+    mm.registerFunction("std.parallel", "range", [](const Arguments &args) {
+        if (args.size() < 4)
+            fail("range", "expects at least 4 arguments, got " + std::to_string(args.size()));
+        int64_t bounds[2];
+        for (size_t i = 0; i < 2; i++)
+        {
+            std::string text = evaluateNode(args[i].get());
+            if (!parseInt64(text, bounds[i]))
+                fail("range", "'" + text + "' is not an int64");
+        }
+        std::string function = evaluateNode(args[2].get());
+        Reduction reduction = parseReduction("range", evaluateNode(args[3].get()));
+        std::vector<Value> extra = extraArguments(args, 4);
+        int64_t start = bounds[0];
+        size_t count = bounds[1] > start ? static_cast<uint64_t>(bounds[1]) - static_cast<uint64_t>(start) : 0;
+        return parallelCall("range", function, reduction, count,
+                            [start](size_t index) { return std::to_string(start + static_cast<int64_t>(index)); },
+                            extra);
+    });
+
+    // parallel.each(array, "Module.function", reduction, extra...) does the
+    // same over the array's elements
+    mm.registerFunction("std.parallel", "each", [](const Arguments &args) {
+        if (args.size() < 3)
+            fail("each", "expects at least 3 arguments, got " + std::to_string(args.size()));
+        std::string handle = evaluateNode(args[0].get());
+        const TypedArray *array = Heap::getInstance().findArray(handle);
+        if (!array)
+            fail("each", "'" + handle + "' is not an array");
+        std::string function = evaluateNode(args[1].get());
+        Reduction reduction = parseReduction("each", evaluateNode(args[2].get()));
+        std::vector<Value> extra = extraArguments(args, 3);
+        return parallelCall("each", function, reduction, array->size(),
+                            [array](size_t index) { return array->format(index); }, extra);
+    });
+}
@@ -3,9 +3,15 @@
 #include <iostream>
 #include "module_manager.h"
 
+namespace {
+    const std::string noSource;
+}
+
 Parser::Parser(Lexer &lexer, const std::string& source) 
         : lexer_(lexer), current_token_(lexer.getNextToken()), source_(source) {}
 
+Parser::Parser(Lexer &lexer) : Parser(lexer, noSource) {}
+
 std::unique_ptr<ASTNode> Parser::parse()
 {
     return parseProgram();
@@ -36,14 +42,15 @@ std::unique_ptr<ASTNode> Parser::parseModule()
 {
     if (current_token_.type != MODULE)
     {
-        std::cerr << "Syntax error: Expected 'module' keyword" << std::endl;
+        syntaxError("Expected 'module' keyword");
         return nullptr;
     }
+    size_t startOffset = current_token_.offset;
     consume(MODULE);
 
     if (current_token_.type != IDENTIFIER)
     {
-        std::cerr << "Syntax error: Expected module name" << std::endl;
+        syntaxError("Expected module name");
         return nullptr;
     }
     std::string moduleName = current_token_.value;
@@ -51,18 +58,19 @@ std::unique_ptr<ASTNode> Parser::parseModule()
 
     if (current_token_.type != LBRACE)
     {
-        std::cerr << "Syntax error: Expected '{'" << std::endl;
+        syntaxError("Expected '{'");
         return nullptr;
     }
     consume(LBRACE);
 
     auto moduleNode = std::make_unique<ModuleNode>();
     moduleNode->name = moduleName;
+    moduleNode->startOffset = startOffset;
 
     // Register the module itself
     ModuleManager::getInstance().registerModule(moduleName);
 
-    while (current_token_.type != RBRACE)
+    while (current_token_.type != RBRACE && current_token_.type != END_OF_FILE)
     {
         if (current_token_.type == COMMENT)
         {
@@ -86,7 +94,8 @@ std::unique_ptr<ASTNode> Parser::parseModule()
                         fn->name,
                         fn->parameters,
                         fn->returnType,
-                        funcNode->clone()
+                        funcNode->clone(),
+                        functionOwner_
                     );
                 }
                 moduleNode->body.push_back(std::move(funcNode));
@@ -104,6 +113,7 @@ std::unique_ptr<ASTNode> Parser::parseModule()
         }
     }
 
+    moduleNode->endOffset = current_token_.offset + 1;
     consume(RBRACE);
     return moduleNode;
 }
@@ -128,7 +138,7 @@ void Parser::parseImportStatement()
     }
 
     if (modulePath.empty()) {
-        std::cerr << "Syntax error: Expected module name after 'import'" << std::endl;
+        syntaxError("Expected module name after 'import'");
         return;
     }
 
@@ -137,7 +147,7 @@ void Parser::parseImportStatement()
 
     if (current_token_.type != SEMICOLON)
     {
-        std::cerr << "Syntax error: Expected ';' after import statement" << std::endl;
+        syntaxError("Expected ';' after import statement");
         return;
     }
     consume(SEMICOLON);
@@ -184,11 +194,24 @@ std::unique_ptr<ASTNode> Parser::parseStatement()
             consume(COMMENT);
             return nullptr;
         }
-        std::cerr << "Syntax error: Unexpected token" << std::endl;
+        syntaxError("Unexpected token");
         return nullptr;
     }
 }
 
+std::unique_ptr<ASTNode> Parser::parseBlockStatement()
+{
+    size_t offset = current_token_.offset;
+    TokenType type = current_token_.type;
+    auto statement = parseStatement();
+    // Skip a token that no statement could start with, otherwise the
+    // enclosing block loop would never advance
+    if (!statement && current_token_.offset == offset && current_token_.type == type && type != END_OF_FILE) {
+        consume(type);
+    }
+    return statement;
+}
+
 std::unique_ptr<ASTNode> Parser::parseIfStatement()
 {
     consume(IF);
@@ -206,7 +229,7 @@ std::unique_ptr<ASTNode> Parser::parseIfStatement()
     ifNode->condition = std::move(condition);
     
     while (current_token_.type != RBRACE && current_token_.type != END_OF_FILE) {
-        auto statement = parseStatement();
+        auto statement = parseBlockStatement();
         if (statement) {
             ifNode->thenBranch.push_back(std::move(statement));
         }
@@ -219,7 +242,7 @@ std::unique_ptr<ASTNode> Parser::parseIfStatement()
         consume(LBRACE);
         
         while (current_token_.type != RBRACE && current_token_.type != END_OF_FILE) {
-            auto statement = parseStatement();
+            auto statement = parseBlockStatement();
             if (statement) {
                 ifNode->elseBranch.push_back(std::move(statement));
             }
@@ -238,7 +261,7 @@ std::unique_ptr<ASTNode> Parser::parseVariableDeclaration()
 
     if (current_token_.type != IDENTIFIER)
     {
-        std::cerr << "Syntax error: Expected variable name" << std::endl;
+        syntaxError("Expected variable name");
         return nullptr;
     }
     std::string variableName = current_token_.value;
@@ -250,7 +273,7 @@ std::unique_ptr<ASTNode> Parser::parseVariableDeclaration()
         consume(COLON);
         if (current_token_.type != IDENTIFIER)
         {
-            std::cerr << "Syntax error: Expected type" << std::endl;
+            syntaxError("Expected type");
             return nullptr;
         }
         type = current_token_.value;
@@ -259,6 +282,7 @@ std::unique_ptr<ASTNode> Parser::parseVariableDeclaration()
 
     auto variableDeclarationNode = std::make_unique<VariableDeclarationNode>();
     variableDeclarationNode->name = variableName;
+    variableDeclarationNode->symbol = intern(variableName);
     variableDeclarationNode->type = type;
     variableDeclarationNode->isMutable = isMutable;
 
@@ -274,11 +298,12 @@ std::unique_ptr<ASTNode> Parser::parseVariableDeclaration()
 
 std::unique_ptr<ASTNode> Parser::parseFunctionDeclaration()
 {
+    size_t startOffset = current_token_.offset;
     consume(FUNC);
 
     if (current_token_.type != IDENTIFIER)
     {
-        std::cerr << "Syntax error: Expected function name" << std::endl;
+        syntaxError("Expected function name");
         return nullptr;
     }
     std::string functionName = current_token_.value;
@@ -292,12 +317,13 @@ std::unique_ptr<ASTNode> Parser::parseFunctionDeclaration()
     {
         FunctionNode::Parameter param;
         param.name = current_token_.value;
+        param.symbol = current_token_.symbol;
         consume(IDENTIFIER);
         
         if (current_token_.type == COLON) {
             consume(COLON);
             if (current_token_.type != IDENTIFIER) {
-                std::cerr << "Syntax error: Expected parameter type" << std::endl;
+                syntaxError("Expected parameter type");
                 return nullptr;
             }
             param.type = current_token_.value;
@@ -310,7 +336,7 @@ std::unique_ptr<ASTNode> Parser::parseFunctionDeclaration()
         {
             consume(COMMA);
             if (current_token_.type != IDENTIFIER) {
-                std::cerr << "Syntax error: Expected parameter after comma" << std::endl;
+                syntaxError("Expected parameter after comma");
                 return nullptr;
             }
         }
@@ -318,29 +344,46 @@ std::unique_ptr<ASTNode> Parser::parseFunctionDeclaration()
     consume(RPAREN);
 
     if (current_token_.type != ARROW) {
-        std::cerr << "Syntax error: Expected '->' after parameters" << std::endl;
+        syntaxError("Expected '->' after parameters");
         return nullptr;
     }
     consume(ARROW);
 
     if (current_token_.type != IDENTIFIER)
     {
-        std::cerr << "Syntax error: Expected return type" << std::endl;
+        syntaxError("Expected return type");
         return nullptr;
     }
     std::string returnType = current_token_.value;
     consume(IDENTIFIER);
 
     if (current_token_.type != LBRACE) {
-        std::cerr << "Syntax error: Expected '{' after return type" << std::endl;
+        syntaxError("Expected '{' after return type");
         return nullptr;
     }
-    consume(LBRACE);
 
     auto funcNode = std::make_unique<FunctionNode>();
     funcNode->name = functionName;
     funcNode->parameters = parameters;
     funcNode->returnType = returnType;
+    funcNode->startOffset = startOffset;
+
+    if (lazySource_) {
+        auto lazyBody = std::make_shared<FunctionNode::LazyBody>();
+        lazyBody->source = lazySource_;
+        lazyBody->begin = current_token_.offset + 1;
+        lazyBody->line = current_token_.line;
+        lazyBody->end = lexer_.skipBlock();
+        current_token_ = lexer_.getNextToken();
+        if (lazyBody->end == std::string::npos) {
+            syntaxError("Expected '}' at end of function");
+            return nullptr;
+        }
+        funcNode->lazyBody = std::move(lazyBody);
+        funcNode->endOffset = funcNode->lazyBody->end + 1;
+        return funcNode;
+    }
+    consume(LBRACE);
 
     while (current_token_.type != RBRACE && current_token_.type != END_OF_FILE)
     {
@@ -350,7 +393,7 @@ std::unique_ptr<ASTNode> Parser::parseFunctionDeclaration()
             continue;
         }
         
-        auto statement = parseStatement();
+        auto statement = parseBlockStatement();
         if (statement)
         {
             funcNode->body.push_back(std::move(statement));
@@ -358,14 +401,46 @@ std::unique_ptr<ASTNode> Parser::parseFunctionDeclaration()
     }
 
     if (current_token_.type != RBRACE) {
-        std::cerr << "Syntax error: Expected '}' at end of function" << std::endl;
+        syntaxError("Expected '}' at end of function");
         return nullptr;
     }
+    funcNode->endOffset = current_token_.offset + 1;
     consume(RBRACE);
     
     return funcNode;
 }
 
+bool Parser::parseLazyBody(FunctionNode &function, std::vector<Diagnostic> &diagnostics)
+{
+    const FunctionNode::LazyBody &lazyBody = *function.lazyBody;
+    Lexer lexer(*lazyBody.source, lazyBody.begin, lazyBody.end, lazyBody.line);
+    lexer.setQuiet(true);
+    Parser parser(lexer, *lazyBody.source);
+    parser.setQuiet(true);
+
+    std::vector<std::unique_ptr<ASTNode>> body;
+    while (!parser.atEnd())
+    {
+        if (parser.current_token_.type == COMMENT)
+        {
+            parser.consume(COMMENT);
+            continue;
+        }
+        auto statement = parser.parseBlockStatement();
+        if (statement)
+        {
+            body.push_back(std::move(statement));
+        }
+    }
+
+    diagnostics = lexer.getDiagnostics();
+    diagnostics.insert(diagnostics.end(), parser.diagnostics_.begin(), parser.diagnostics_.end());
+    if (!diagnostics.empty())
+        return false;
+    function.body = std::move(body);
+    return true;
+}
+
 std::unique_ptr<ASTNode> Parser::parseReturnStatement()
 {
     consume(RETURN);
@@ -406,6 +481,7 @@ std::unique_ptr<ASTNode> Parser::parsePrimaryExpression()
     else if (current_token_.type == IDENTIFIER)
     {
         std::string identifier = current_token_.value;
+        Symbol symbol = current_token_.symbol;
         consume(IDENTIFIER);
 
         // Handle method calls (e.g., Math.square)
@@ -414,7 +490,7 @@ std::unique_ptr<ASTNode> Parser::parsePrimaryExpression()
             consume(DOT);
             if (current_token_.type != IDENTIFIER)
             {
-                std::cerr << "Syntax error: Expected method name after '.'" << std::endl;
+                syntaxError("Expected method name after '.'");
                 return nullptr;
             }
             std::string methodName = identifier + "." + current_token_.value;
@@ -437,10 +513,11 @@ std::unique_ptr<ASTNode> Parser::parsePrimaryExpression()
         auto literalNode = std::make_unique<LiteralNode>();
         literalNode->value = identifier;
         literalNode->type = "identifier";
+        literalNode->symbol = symbol;
         return literalNode;
     }
 
-    std::cerr << "Syntax error: Unexpected token '" << current_token_.value << "'" << std::endl;
+    syntaxError("Unexpected token '" + current_token_.value + "'");
     return nullptr;
 }
 
@@ -452,7 +529,10 @@ std::unique_ptr<ASTNode> Parser::parseFunctionCall(const std::string& functionNa
     if (dotPos != std::string::npos) {
         std::string moduleName = functionName.substr(0, dotPos);
         if (!mm.isModuleImported(moduleName) && !mm.isModuleImported("std." + moduleName)) {
-            std::cerr << "Error: Module '" << moduleName << "' not imported" << std::endl;
+            recordDiagnostic("Module '" + moduleName + "' not imported");
+            if (!quiet_) {
+                std::cerr << "Error: Module '" << moduleName << "' not imported" << std::endl;
+            }
             return nullptr;
         }
     }
@@ -461,6 +541,7 @@ std::unique_ptr<ASTNode> Parser::parseFunctionCall(const std::string& functionNa
     // This allows for forward declarations and runtime function registration
     auto functionCallNode = std::make_unique<FunctionCallNode>();
     functionCallNode->name = functionName;
+    functionCallNode->symbol = intern(functionName);
 
     consume(LPAREN);
 
@@ -474,7 +555,7 @@ std::unique_ptr<ASTNode> Parser::parseFunctionCall(const std::string& functionNa
         if (current_token_.type == COMMA) {
             consume(COMMA);
         } else if (current_token_.type != RPAREN) {
-            std::cerr << "Syntax error: Expected ',' or ')'" << std::endl;
+            syntaxError("Expected ',' or ')'");
             return nullptr;
         }
     }
@@ -520,9 +601,34 @@ std::string Parser::getSourceLine(int lineNumber) const {
     return line;
 }
 
+void Parser::recordDiagnostic(const std::string& message) {
+    Diagnostic diagnostic;
+    diagnostic.line = current_token_.line;
+    diagnostic.column = current_token_.column;
+    diagnostic.offset = current_token_.offset;
+    diagnostic.message = message;
+    diagnostics_.push_back(std::move(diagnostic));
+}
+
+void Parser::syntaxError(const std::string& message) {
+    recordDiagnostic(message);
+    if (!quiet_) {
+        std::cerr << "Syntax error: " << message << std::endl;
+    }
+}
+
 void Parser::reportError(const std::string& message) {
+    recordDiagnostic(message);
+    if (quiet_) {
+        return;
+    }
+
     std::cerr << "\033[1;31mError\033[0m at line " << current_token_.line 
               << ", column " << current_token_.column << ": " << message << std::endl;
+
+    if (source_.empty()) {
+        return;
+    }
     
     // Get and print the erroneous line
     std::string sourceLine = getSourceLine(current_token_.line);
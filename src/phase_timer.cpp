@@ -0,0 +1,93 @@
+#include "phase_timer.h"
+#include "profiler.h"
+
+#include <iomanip>
+#include <sys/resource.h>
+
+namespace
+{
+    long peakRssKb()
+    {
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) != 0)
+            return 0;
+        return usage.ru_maxrss;
+    }
+}
+
+void PhaseTimer::begin(const std::string &name)
+{
+    if (!enabled_)
+        return;
+
+    AllocationStats::setTracking(true);
+
+    Phase phase;
+    phase.name = name;
+    phases_.push_back(std::move(phase));
+
+    startAllocations_ = AllocationStats::count();
+    startBytes_ = AllocationStats::bytes();
+    start_ = std::chrono::steady_clock::now();
+}
+
+void PhaseTimer::end()
+{
+    auto end = std::chrono::steady_clock::now();
+    if (!enabled_ || phases_.empty())
+        return;
+
+    Phase &phase = phases_.back();
+    phase.elapsed = end - start_;
+    phase.allocations = AllocationStats::count() - startAllocations_;
+    phase.allocatedBytes = AllocationStats::bytes() - startBytes_;
+    phase.peakRssKb = peakRssKb();
+}
+
+void PhaseTimer::addCounter(const std::string &name, uint64_t value)
+{
+    if (enabled_ && !phases_.empty())
+        phases_.back().counters.emplace_back(name, value);
+}
+
+void PhaseTimer::writeReport(std::ostream &out) const
+{
+    out << std::left << std::setw(10) << "phase" << std::right << std::setw(12) << "time (ms)"
+        << std::setw(12) << "allocs" << std::setw(14) << "alloc bytes" << std::setw(14) << "peak RSS KB"
+        << "  counters\n";
+    out << std::fixed << std::setprecision(3);
+
+    std::chrono::nanoseconds total{0};
+    for (const auto &phase : phases_)
+    {
+        total += phase.elapsed;
+        out << std::left << std::setw(10) << phase.name << std::right << std::setw(12) << phase.elapsed.count() / 1e6
+            << std::setw(12) << phase.allocations << std::setw(14) << phase.allocatedBytes << std::setw(14)
+            << phase.peakRssKb << " ";
+        for (const auto &counter : phase.counters)
+            out << " " << counter.first << "=" << counter.second;
+        out << "\n";
+    }
+    out << std::left << std::setw(10) << "total" << std::right << std::setw(12) << total.count() / 1e6 << "\n";
+    out.flush();
+}
+
+void PhaseTimer::writeJson(std::ostream &out) const
+{
+    out << "{\"phases\":[";
+    for (size_t i = 0; i < phases_.size(); i++)
+    {
+        const Phase &phase = phases_[i];
+        if (i > 0)
+            out << ",";
+        out << "{\"name\":\"" << phase.name << "\""
+            << ",\"time_ns\":" << phase.elapsed.count()
+            << ",\"allocations\":" << phase.allocations
+            << ",\"allocated_bytes\":" << phase.allocatedBytes
+            << ",\"peak_rss_kb\":" << phase.peakRssKb;
+        for (const auto &counter : phase.counters)
+            out << ",\"" << counter.first << "\":" << counter.second;
+        out << "}";
+    }
+    out << "]}" << std::endl;
+}
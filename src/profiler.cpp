@@ -0,0 +1,199 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <new>
+
+#include <malloc.h>
+
+namespace
+{
+    std::atomic<bool> trackAllocations{false};
+    std::atomic<uint64_t> allocationCount{0};
+    std::atomic<uint64_t> allocationBytes{0};
+
+    std::atomic<bool> trackLiveBytes{false};
+    std::atomic<bool> enforceLimit{false};
+    std::atomic<int64_t> liveHeapBytes{0};
+    int64_t heapLimit = 0;
+    char heapLimitMessage[64];
+
+    void *allocate(std::size_t size)
+    {
+        if (trackAllocations.load(std::memory_order_relaxed))
+        {
+            allocationCount.fetch_add(1, std::memory_order_relaxed);
+            allocationBytes.fetch_add(size, std::memory_order_relaxed);
+        }
+        void *ptr = std::malloc(size ? size : 1);
+        if (!ptr)
+            throw std::bad_alloc();
+        if (trackLiveBytes.load(std::memory_order_relaxed))
+        {
+            // Usable sizes, so that frees can subtract exactly what was added
+            int64_t usable = static_cast<int64_t>(malloc_usable_size(ptr));
+            int64_t live = liveHeapBytes.fetch_add(usable, std::memory_order_relaxed) + usable;
+            if (live > heapLimit && enforceLimit.load(std::memory_order_relaxed))
+            {
+                liveHeapBytes.fetch_sub(usable, std::memory_order_relaxed);
+                std::free(ptr);
+                throw AllocationStats::HeapLimitExceeded();
+            }
+        }
+        return ptr;
+    }
+
+    void deallocate(void *ptr)
+    {
+        if (ptr && trackLiveBytes.load(std::memory_order_relaxed))
+            liveHeapBytes.fetch_sub(static_cast<int64_t>(malloc_usable_size(ptr)), std::memory_order_relaxed);
+        std::free(ptr);
+    }
+}
+
+void *operator new(std::size_t size) { return allocate(size); }
+void *operator new[](std::size_t size) { return allocate(size); }
+void operator delete(void *ptr) noexcept { deallocate(ptr); }
+void operator delete[](void *ptr) noexcept { deallocate(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { deallocate(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { deallocate(ptr); }
+
+namespace AllocationStats
+{
+    void setTracking(bool enabled) { trackAllocations.store(enabled, std::memory_order_relaxed); }
+    bool isTracking() { return trackAllocations.load(std::memory_order_relaxed); }
+    uint64_t count() { return allocationCount.load(std::memory_order_relaxed); }
+    uint64_t bytes() { return allocationBytes.load(std::memory_order_relaxed); }
+
+    void setHeapLimit(uint64_t bytes)
+    {
+        heapLimit = static_cast<int64_t>(bytes);
+        std::snprintf(heapLimitMessage, sizeof(heapLimitMessage), "heap limit of %llu bytes exceeded",
+                      static_cast<unsigned long long>(bytes));
+        liveHeapBytes.store(0, std::memory_order_relaxed);
+        trackLiveBytes.store(bytes != 0, std::memory_order_relaxed);
+    }
+
+    void enforceHeapLimit(bool enforce) { enforceLimit.store(enforce && heapLimit, std::memory_order_relaxed); }
+    int64_t liveBytes() { return liveHeapBytes.load(std::memory_order_relaxed); }
+
+    const char *HeapLimitExceeded::what() const noexcept { return heapLimitMessage; }
+}
+
+Profiler &Profiler::getInstance()
+{
+    static Profiler instance;
+    return instance;
+}
+
+void Profiler::enable()
+{
+    enabled_ = true;
+    thread_ = std::this_thread::get_id();
+    AllocationStats::setTracking(true);
+}
+
+void Profiler::enter(const std::string &functionName)
+{
+    auto entry = stats_.try_emplace(functionName).first;
+    Frame frame;
+    frame.stats = &entry->second;
+    uint32_t parent = frames_.empty() ? 0 : frames_.back().node;
+    auto [child, added] = stacks_[parent].children.try_emplace(frame.stats, static_cast<uint32_t>(stacks_.size()));
+    frame.node = child->second;
+    if (added)
+    {
+        stacks_.emplace_back();
+        stacks_.back().parent = parent;
+        stacks_.back().function = &entry->first;
+    }
+    frame.startAllocations = AllocationStats::count();
+    frame.stats->calls++;
+    activeDepth_[frame.stats]++;
+    frames_.push_back(std::move(frame));
+    // Taken last so the bookkeeping above is not billed to the callee
+    frames_.back().start = std::chrono::steady_clock::now();
+}
+
+void Profiler::exit()
+{
+    auto end = std::chrono::steady_clock::now();
+    if (frames_.empty())
+        return;
+
+    Frame frame = std::move(frames_.back());
+    frames_.pop_back();
+
+    auto elapsed = end - frame.start;
+    auto self = elapsed - frame.childTime;
+    uint64_t allocations = AllocationStats::count() - frame.startAllocations;
+
+    // Recursive activations only count once towards inclusive time
+    if (--activeDepth_[frame.stats] == 0)
+        frame.stats->inclusive += elapsed;
+    frame.stats->exclusive += self;
+    frame.stats->allocations += allocations - frame.childAllocations;
+    stacks_[frame.node].self += self;
+
+    if (!frames_.empty())
+    {
+        frames_.back().childTime += elapsed;
+        frames_.back().childAllocations += allocations;
+    }
+}
+
+void Profiler::writeReport(std::ostream &out) const
+{
+    std::vector<std::pair<std::string, const FunctionStats *>> rows;
+    for (const auto &entry : stats_)
+        rows.emplace_back(entry.first, &entry.second);
+    std::sort(rows.begin(), rows.end(), [](const auto &a, const auto &b) {
+        return a.second->exclusive > b.second->exclusive;
+    });
+
+    auto ms = [](std::chrono::nanoseconds ns) { return ns.count() / 1e6; };
+
+    out << "Profile (wall time in ms)\n";
+    out << std::setw(10) << "calls" << std::setw(14) << "inclusive" << std::setw(14) << "exclusive"
+        << std::setw(12) << "allocs" << "  function\n";
+    out << std::fixed << std::setprecision(3);
+    for (const auto &row : rows)
+    {
+        const FunctionStats &s = *row.second;
+        out << std::setw(10) << s.calls << std::setw(14) << ms(s.inclusive) << std::setw(14) << ms(s.exclusive)
+            << std::setw(12) << s.allocations << "  " << row.first << "\n";
+    }
+    out.flush();
+}
+
+bool Profiler::writeCollapsedStacks(const std::string &path) const
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+        return false;
+
+    // Depth-first, extending and truncating one stack name instead of keeping a
+    // string per stack
+    std::string stack;
+    std::vector<std::pair<uint32_t, size_t>> pending; // node, length of its caller's name
+    for (const auto &child : stacks_[0].children)
+        pending.emplace_back(child.second, 0);
+    while (!pending.empty())
+    {
+        auto [index, length] = pending.back();
+        pending.pop_back();
+        const StackNode &node = stacks_[index];
+        stack.resize(length);
+        if (length)
+            stack += ';';
+        stack += *node.function;
+        file << stack << " " << node.self.count() << "\n";
+        for (const auto &child : node.children)
+            pending.emplace_back(child.second, stack.size());
+    }
+    return true;
+}
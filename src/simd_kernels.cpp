@@ -0,0 +1,774 @@
+#include "simd_kernels.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define NEXIS_SIMD_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+#ifdef NEXIS_SIMD_AVX2
+    // Runs during static initialization, before the CPU model is set up
+    const bool cpuHasAvx2 = [] {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+    }();
+#else
+    const bool cpuHasAvx2 = false;
+#endif
+    bool enabled = true;
+
+    bool useAvx2() { return cpuHasAvx2 && enabled; }
+
+    // ---- Scalar loops, also used for the tails of the vector loops ----
+
+    int64_t wrappingAdd(int64_t left, int64_t right) { return static_cast<int64_t>(uint64_t(left) + uint64_t(right)); }
+    int64_t wrappingSubtract(int64_t left, int64_t right) { return static_cast<int64_t>(uint64_t(left) - uint64_t(right)); }
+    int64_t wrappingMultiply(int64_t left, int64_t right) { return static_cast<int64_t>(uint64_t(left) * uint64_t(right)); }
+
+    int64_t apply(simd::Arithmetic operation, int64_t value, int64_t operand)
+    {
+        switch (operation)
+        {
+        case simd::Arithmetic::Add:
+            return wrappingAdd(value, operand);
+        case simd::Arithmetic::Subtract:
+            return wrappingSubtract(value, operand);
+        case simd::Arithmetic::Multiply:
+            return wrappingMultiply(value, operand);
+        default:
+            return value == INT64_MIN && operand == -1 ? INT64_MIN : value / operand;
+        }
+    }
+
+    double apply(simd::Arithmetic operation, double value, double operand)
+    {
+        switch (operation)
+        {
+        case simd::Arithmetic::Add:
+            return value + operand;
+        case simd::Arithmetic::Subtract:
+            return value - operand;
+        case simd::Arithmetic::Multiply:
+            return value * operand;
+        default:
+            return value / operand;
+        }
+    }
+
+    template <typename T>
+    bool holds(simd::Comparison comparison, T value, T operand)
+    {
+        switch (comparison)
+        {
+        case simd::Comparison::Less:
+            return value < operand;
+        case simd::Comparison::LessEqual:
+            return value <= operand;
+        case simd::Comparison::Greater:
+            return value > operand;
+        case simd::Comparison::GreaterEqual:
+            return value >= operand;
+        case simd::Comparison::Equal:
+            return value == operand;
+        default:
+            return value != operand;
+        }
+    }
+
+    template <typename T>
+    size_t filterScalar(simd::Comparison comparison, const T *values, T operand, T *out, size_t count)
+    {
+        size_t kept = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            if (holds(comparison, values[i], operand))
+                out[kept++] = values[i];
+        }
+        return kept;
+    }
+
+#ifdef NEXIS_SIMD_AVX2
+    // ---- AVX2: four 64-bit lanes per register ----
+
+    // Low 64 bits of the lane-wise product, from 32x32-bit multiplies
+    __attribute__((target("avx2"))) __m256i multiply64(__m256i left, __m256i right)
+    {
+        __m256i low = _mm256_mul_epu32(left, right);
+        __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(left, 32), right),
+                                         _mm256_mul_epu32(left, _mm256_srli_epi64(right, 32)));
+        return _mm256_add_epi64(low, _mm256_slli_epi64(cross, 32));
+    }
+
+    __attribute__((target("avx2"))) int64_t horizontalSum(__m256i lanes)
+    {
+        alignas(32) int64_t values[4];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(values), lanes);
+        return wrappingAdd(wrappingAdd(values[0], values[1]), wrappingAdd(values[2], values[3]));
+    }
+
+    __attribute__((target("avx2"))) double horizontalSum(__m256d lanes)
+    {
+        alignas(32) double values[4];
+        _mm256_store_pd(values, lanes);
+        return (values[0] + values[1]) + (values[2] + values[3]);
+    }
+
+    __attribute__((target("avx2"))) int64_t sumAvx2(const int64_t *values, size_t count)
+    {
+        __m256i first = _mm256_setzero_si256();
+        __m256i second = _mm256_setzero_si256();
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            first = _mm256_add_epi64(first, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i)));
+            second = _mm256_add_epi64(second, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i + 4)));
+        }
+        int64_t total = horizontalSum(_mm256_add_epi64(first, second));
+        for (; i < count; i++)
+            total = wrappingAdd(total, values[i]);
+        return total;
+    }
+
+    __attribute__((target("avx2"))) double sumAvx2(const double *values, size_t count)
+    {
+        __m256d first = _mm256_setzero_pd();
+        __m256d second = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            first = _mm256_add_pd(first, _mm256_loadu_pd(values + i));
+            second = _mm256_add_pd(second, _mm256_loadu_pd(values + i + 4));
+        }
+        double total = horizontalSum(_mm256_add_pd(first, second));
+        for (; i < count; i++)
+            total += values[i];
+        return total;
+    }
+
+    __attribute__((target("avx2"))) int64_t dotAvx2(const int64_t *left, const int64_t *right, size_t count)
+    {
+        __m256i total = _mm256_setzero_si256();
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(left + i));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(right + i));
+            total = _mm256_add_epi64(total, multiply64(a, b));
+        }
+        int64_t result = horizontalSum(total);
+        for (; i < count; i++)
+            result = wrappingAdd(result, wrappingMultiply(left[i], right[i]));
+        return result;
+    }
+
+    __attribute__((target("avx2"))) double dotAvx2(const double *left, const double *right, size_t count)
+    {
+        __m256d total = _mm256_setzero_pd();
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+            total = _mm256_add_pd(total, _mm256_mul_pd(_mm256_loadu_pd(left + i), _mm256_loadu_pd(right + i)));
+        double result = horizontalSum(total);
+        for (; i < count; i++)
+            result += left[i] * right[i];
+        return result;
+    }
+
+    template <bool Minimum>
+    __attribute__((target("avx2"))) __m256i better(__m256i best, __m256i next)
+    {
+        __m256i replace = Minimum ? _mm256_cmpgt_epi64(best, next) : _mm256_cmpgt_epi64(next, best);
+        return _mm256_blendv_epi8(best, next, replace);
+    }
+
+    template <bool Minimum>
+    __attribute__((target("avx2"))) int64_t extremeAvx2(const int64_t *values, size_t count)
+    {
+        // Four independent accumulators hide the compare/blend latency
+        __m256i best[4];
+        for (auto &lanes : best)
+            lanes = _mm256_set1_epi64x(values[0]);
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16)
+        {
+            for (int j = 0; j < 4; j++)
+                best[j] = better<Minimum>(best[j], _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i + 4 * j)));
+        }
+        alignas(32) int64_t lanes[16];
+        for (int j = 0; j < 4; j++)
+            _mm256_store_si256(reinterpret_cast<__m256i *>(lanes + 4 * j), best[j]);
+        int64_t result = lanes[0];
+        for (int lane = 1; lane < 16; lane++)
+            result = Minimum ? std::min(result, lanes[lane]) : std::max(result, lanes[lane]);
+        for (; i < count; i++)
+            result = Minimum ? std::min(result, values[i]) : std::max(result, values[i]);
+        return result;
+    }
+
+    template <bool Minimum>
+    __attribute__((target("avx2"))) double extremeAvx2(const double *values, size_t count)
+    {
+        __m256d best[4];
+        for (auto &lanes : best)
+            lanes = _mm256_set1_pd(values[0]);
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16)
+        {
+            for (int j = 0; j < 4; j++)
+            {
+                __m256d next = _mm256_loadu_pd(values + i + 4 * j);
+                best[j] = Minimum ? _mm256_min_pd(best[j], next) : _mm256_max_pd(best[j], next);
+            }
+        }
+        alignas(32) double lanes[16];
+        for (int j = 0; j < 4; j++)
+            _mm256_store_pd(lanes + 4 * j, best[j]);
+        double result = lanes[0];
+        for (int lane = 1; lane < 16; lane++)
+            result = Minimum ? std::min(result, lanes[lane]) : std::max(result, lanes[lane]);
+        for (; i < count; i++)
+            result = Minimum ? std::min(result, values[i]) : std::max(result, values[i]);
+        return result;
+    }
+
+    __attribute__((target("avx2"))) void mapAvx2(simd::Arithmetic operation, const int64_t *values, int64_t operand,
+                                                 int64_t *out, size_t count)
+    {
+        __m256i broadcast = _mm256_set1_epi64x(operand);
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i));
+            __m256i result = operation == simd::Arithmetic::Add        ? _mm256_add_epi64(value, broadcast)
+                             : operation == simd::Arithmetic::Subtract ? _mm256_sub_epi64(value, broadcast)
+                                                                        : multiply64(value, broadcast);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), result);
+        }
+        for (; i < count; i++)
+            out[i] = apply(operation, values[i], operand);
+    }
+
+    __attribute__((target("avx2"))) void mapAvx2(simd::Arithmetic operation, const double *values, double operand,
+                                                 double *out, size_t count)
+    {
+        __m256d broadcast = _mm256_set1_pd(operand);
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m256d value = _mm256_loadu_pd(values + i);
+            __m256d result;
+            switch (operation)
+            {
+            case simd::Arithmetic::Add:
+                result = _mm256_add_pd(value, broadcast);
+                break;
+            case simd::Arithmetic::Subtract:
+                result = _mm256_sub_pd(value, broadcast);
+                break;
+            case simd::Arithmetic::Multiply:
+                result = _mm256_mul_pd(value, broadcast);
+                break;
+            default:
+                result = _mm256_div_pd(value, broadcast);
+                break;
+            }
+            _mm256_storeu_pd(out + i, result);
+        }
+        for (; i < count; i++)
+            out[i] = apply(operation, values[i], operand);
+    }
+
+    // For each 4-bit lane mask, the 32-bit permutation that moves the
+    // selected 64-bit lanes to the front
+    struct CompressTable
+    {
+        alignas(32) int32_t indices[16][8];
+
+        CompressTable()
+        {
+            for (int mask = 0; mask < 16; mask++)
+            {
+                int next = 0;
+                for (int lane = 0; lane < 4; lane++)
+                {
+                    if (mask & (1 << lane))
+                    {
+                        indices[mask][next++] = 2 * lane;
+                        indices[mask][next++] = 2 * lane + 1;
+                    }
+                }
+                while (next < 8)
+                    indices[mask][next++] = 0;
+            }
+        }
+    };
+    const CompressTable compressTable;
+
+    // One bit per 64-bit lane with its top bit set
+    __attribute__((target("avx2"))) int mask(__m256i lanes)
+    {
+        return _mm256_movemask_pd(_mm256_castsi256_pd(lanes));
+    }
+
+    // Lane mask of `value <comparison> operand`
+    __attribute__((target("avx2"))) int compareMask(simd::Comparison comparison, __m256i value, __m256i operand)
+    {
+        switch (comparison)
+        {
+        case simd::Comparison::Less:
+            return mask(_mm256_cmpgt_epi64(operand, value));
+        case simd::Comparison::LessEqual:
+            return ~mask(_mm256_cmpgt_epi64(value, operand)) & 0xF;
+        case simd::Comparison::Greater:
+            return mask(_mm256_cmpgt_epi64(value, operand));
+        case simd::Comparison::GreaterEqual:
+            return ~mask(_mm256_cmpgt_epi64(operand, value)) & 0xF;
+        case simd::Comparison::Equal:
+            return mask(_mm256_cmpeq_epi64(value, operand));
+        default:
+            return ~mask(_mm256_cmpeq_epi64(value, operand)) & 0xF;
+        }
+    }
+
+    __attribute__((target("avx2"))) int compareMask(simd::Comparison comparison, __m256d value, __m256d operand)
+    {
+        switch (comparison)
+        {
+        case simd::Comparison::Less:
+            return _mm256_movemask_pd(_mm256_cmp_pd(value, operand, _CMP_LT_OQ));
+        case simd::Comparison::LessEqual:
+            return _mm256_movemask_pd(_mm256_cmp_pd(value, operand, _CMP_LE_OQ));
+        case simd::Comparison::Greater:
+            return _mm256_movemask_pd(_mm256_cmp_pd(value, operand, _CMP_GT_OQ));
+        case simd::Comparison::GreaterEqual:
+            return _mm256_movemask_pd(_mm256_cmp_pd(value, operand, _CMP_GE_OQ));
+        case simd::Comparison::Equal:
+            return _mm256_movemask_pd(_mm256_cmp_pd(value, operand, _CMP_EQ_OQ));
+        default:
+            return _mm256_movemask_pd(_mm256_cmp_pd(value, operand, _CMP_NEQ_UQ));
+        }
+    }
+
+    // Compares four lanes at a time and compresses the matches to the front
+    // of the register, so every store writes four lanes and advances by the
+    // number of matches
+    __attribute__((target("avx2"))) size_t filterAvx2(simd::Comparison comparison, const int64_t *values,
+                                                      int64_t operand, int64_t *out, size_t count)
+    {
+        __m256i broadcast = _mm256_set1_epi64x(operand);
+        size_t kept = 0;
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i));
+            int mask = compareMask(comparison, value, broadcast);
+            __m256i permutation = _mm256_load_si256(reinterpret_cast<const __m256i *>(compressTable.indices[mask]));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + kept), _mm256_permutevar8x32_epi32(value, permutation));
+            kept += __builtin_popcount(mask);
+        }
+        return kept + filterScalar(comparison, values + i, operand, out + kept, count - i);
+    }
+
+    __attribute__((target("avx2"))) size_t filterAvx2(simd::Comparison comparison, const double *values,
+                                                      double operand, double *out, size_t count)
+    {
+        __m256d broadcast = _mm256_set1_pd(operand);
+        size_t kept = 0;
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m256d value = _mm256_loadu_pd(values + i);
+            int mask = compareMask(comparison, value, broadcast);
+            __m256i permutation = _mm256_load_si256(reinterpret_cast<const __m256i *>(compressTable.indices[mask]));
+            __m256 compressed = _mm256_permutevar8x32_ps(_mm256_castpd_ps(value), permutation);
+            _mm256_storeu_pd(out + kept, _mm256_castps_pd(compressed));
+            kept += __builtin_popcount(mask);
+        }
+        return kept + filterScalar(comparison, values + i, operand, out + kept, count - i);
+    }
+#endif
+
+    // ---- Byte search ----
+
+    size_t findByteScalar(const char *data, size_t size, char byte)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            if (data[i] == byte)
+                return i;
+        }
+        return size;
+    }
+
+    size_t findBytesScalar(const char *data, size_t size, char byte, size_t *positions, size_t capacity)
+    {
+        size_t found = 0;
+        for (size_t i = 0; i < size && found < capacity; i++)
+        {
+            if (data[i] == byte)
+                positions[found++] = i;
+        }
+        return found;
+    }
+
+    size_t countByteScalar(const char *data, size_t size, char byte)
+    {
+        size_t count = 0;
+        for (size_t i = 0; i < size; i++)
+            count += data[i] == byte;
+        return count;
+    }
+
+    size_t findScalar(const char *data, size_t size, const char *needle, size_t needleSize)
+    {
+        for (size_t i = 0; i + needleSize <= size; i++)
+        {
+            if (data[i] == needle[0] && std::memcmp(data + i + 1, needle + 1, needleSize - 1) == 0)
+                return i;
+        }
+        return size;
+    }
+
+#ifdef NEXIS_SIMD_AVX2
+    __attribute__((target("avx2"))) uint32_t byteMask(const char *data, __m256i byte)
+    {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+        return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, byte)));
+    }
+
+    __attribute__((target("avx2"))) size_t findByteAvx2(const char *data, size_t size, char byte)
+    {
+        __m256i broadcast = _mm256_set1_epi8(byte);
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32)
+        {
+            if (uint32_t mask = byteMask(data + i, broadcast))
+                return i + __builtin_ctz(mask);
+        }
+        return i + findByteScalar(data + i, size - i, byte);
+    }
+
+    __attribute__((target("avx2"))) size_t findBytesAvx2(const char *data, size_t size, char byte, size_t *positions,
+                                                         size_t capacity)
+    {
+        __m256i broadcast = _mm256_set1_epi8(byte);
+        size_t found = 0;
+        size_t i = 0;
+        for (; i + 32 <= size; i += 32)
+        {
+            for (uint32_t mask = byteMask(data + i, broadcast); mask; mask &= mask - 1)
+            {
+                if (found == capacity)
+                    return found;
+                positions[found++] = i + __builtin_ctz(mask);
+            }
+        }
+        size_t rest = findBytesScalar(data + i, size - i, byte, positions + found, capacity - found);
+        for (size_t j = found; j < found + rest; j++)
+            positions[j] += i;
+        return found + rest;
+    }
+
+    // Matches are subtracted from per-byte counters (a match is -1), which
+    // are summed into 64-bit lanes before they can overflow
+    __attribute__((target("avx2"))) size_t countByteAvx2(const char *data, size_t size, char byte)
+    {
+        __m256i broadcast = _mm256_set1_epi8(byte);
+        __m256i zero = _mm256_setzero_si256();
+        __m256i totals = zero;
+        size_t i = 0;
+        while (i + 32 <= size)
+        {
+            size_t blocks = std::min<size_t>((size - i) / 32, 255);
+            __m256i counters = zero;
+            for (size_t block = 0; block < blocks; block++, i += 32)
+            {
+                __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+                counters = _mm256_sub_epi8(counters, _mm256_cmpeq_epi8(chunk, broadcast));
+            }
+            totals = _mm256_add_epi64(totals, _mm256_sad_epu8(counters, zero));
+        }
+        alignas(32) uint64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), totals);
+        return lanes[0] + lanes[1] + lanes[2] + lanes[3] + countByteScalar(data + i, size - i, byte);
+    }
+
+    // Compares the needle's first and last bytes at 32 positions at once
+    // and checks only the positions where both match
+    __attribute__((target("avx2"))) size_t findAvx2(const char *data, size_t size, const char *needle,
+                                                    size_t needleSize)
+    {
+        __m256i first = _mm256_set1_epi8(needle[0]);
+        __m256i last = _mm256_set1_epi8(needle[needleSize - 1]);
+        size_t i = 0;
+        for (; i + needleSize - 1 + 32 <= size; i += 32)
+        {
+            for (uint32_t mask = byteMask(data + i, first) & byteMask(data + i + needleSize - 1, last); mask;
+                 mask &= mask - 1)
+            {
+                size_t position = i + __builtin_ctz(mask);
+                if (std::memcmp(data + position + 1, needle + 1, needleSize - 2) == 0)
+                    return position;
+            }
+        }
+        size_t rest = findScalar(data + i, size - i, needle, needleSize);
+        return rest == size - i ? size : i + rest;
+    }
+#endif
+
+    // ---- Radix sort on order-preserving 64-bit keys ----
+
+    constexpr int kDigitBits = 11;
+    constexpr int kDigits = (64 + kDigitBits - 1) / kDigitBits;
+    constexpr size_t kBuckets = size_t(1) << kDigitBits;
+    constexpr size_t kSmallSort = 64; // std::sort below this
+
+    uint64_t keyOf(int64_t value) { return uint64_t(value) ^ (uint64_t(1) << 63); }
+    int64_t valueOf(uint64_t key, int64_t) { return static_cast<int64_t>(key ^ (uint64_t(1) << 63)); }
+
+    uint64_t keyOf(double value)
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof bits);
+        return bits & (uint64_t(1) << 63) ? ~bits : bits ^ (uint64_t(1) << 63);
+    }
+    double valueOf(uint64_t key, double)
+    {
+        uint64_t bits = key & (uint64_t(1) << 63) ? key ^ (uint64_t(1) << 63) : ~key;
+        double value;
+        std::memcpy(&value, &bits, sizeof value);
+        return value;
+    }
+
+    template <typename T>
+    void radixSort(T *values, size_t count)
+    {
+        std::vector<uint64_t> keys(count);
+        std::vector<uint64_t> scratch(count);
+        std::vector<size_t> histograms(kDigits * kBuckets, 0);
+        for (size_t i = 0; i < count; i++)
+        {
+            keys[i] = keyOf(values[i]);
+            for (int digit = 0; digit < kDigits; digit++)
+                histograms[digit * kBuckets + ((keys[i] >> (digit * kDigitBits)) & (kBuckets - 1))]++;
+        }
+
+        for (int digit = 0; digit < kDigits; digit++)
+        {
+            size_t *histogram = &histograms[digit * kBuckets];
+            // Every key has the same digit here: the pass would not move anything
+            if (histogram[keys[0] >> (digit * kDigitBits) & (kBuckets - 1)] == count)
+                continue;
+
+            size_t offset = 0;
+            for (size_t bucket = 0; bucket < kBuckets; bucket++)
+            {
+                size_t size = histogram[bucket];
+                histogram[bucket] = offset;
+                offset += size;
+            }
+            for (uint64_t key : keys)
+                scratch[histogram[(key >> (digit * kDigitBits)) & (kBuckets - 1)]++] = key;
+            keys.swap(scratch);
+        }
+
+        for (size_t i = 0; i < count; i++)
+            values[i] = valueOf(keys[i], T());
+    }
+}
+
+namespace simd
+{
+    bool isAvailable() { return cpuHasAvx2; }
+    void setEnabled(bool value) { enabled = value; }
+
+    int64_t sum(const int64_t *values, size_t count)
+    {
+#ifdef NEXIS_SIMD_AVX2
+        if (useAvx2())
+            return sumAvx2(values, count);
+#endif
+        int64_t total = 0;
+        for (size_t i = 0; i < count; i++)
+            total = wrappingAdd(total, values[i]);
+        return total;
+    }
+
+    double sum(const double *values, size_t count)
+    {
+#ifdef NEXIS_SIMD_AVX2
+        if (useAvx2())
+            return sumAvx2(values, count);
+#endif
+        double total = 0;
+        for (size_t i = 0; i < count; i++)
+            total += values[i];
+        return total;
+    }
+
+    int64_t dot(const int64_t *left, const int64_t *right, size_t count)
+    {
+#ifdef NEXIS_SIMD_AVX2
+        if (useAvx2())
+            return dotAvx2(left, right, count);
+#endif
+        int64_t total = 0;
+        for (size_t i = 0; i < count; i++)
+            total = wrappingAdd(total, wrappingMultiply(left[i], right[i]));
+        return total;
+    }
+
+    double dot(const double *left, const double *right, size_t count)
+    {
+#ifdef NEXIS_SIMD_AVX2
+        if (useAvx2())
+            return dotAvx2(left, right, count);
+#endif
+        double total = 0;
+        for (size_t i = 0; i < count; i++)
+            total += left[i] * right[i];
+        return total;
+    }
+
+    int64_t min(const int64_t *values, size_t count)
+    {
+#ifdef NEXIS_SIMD_AVX2
+        if (useAvx2())
+            return extremeAvx2<true>(values, count);
+#endif
+        return *std::min_element(values, values + count);
+    }
+
+    int64_t max(const int64_t *values, size_t count)
+    {
+#ifdef NEXIS_SIMD_AVX2
+        if (useAvx2())
+            return extremeAvx2<false>(values, count);
+#endif
+        return *std::max_element(values, values + count);
+    }
+
+    double min(const double *values, size_t count)
+    {
+#ifdef NEXIS_SIMD_AVX2
+        if (useAvx2())
+            return extremeAvx2<true>(values, count);
+#endif
+        return *std::min_element(values, values + count);
+    }
+
+    double max(const double *values, size_t count)
+    {
+#ifdef NEXIS_SIMD_AVX2
+        if (useAvx2())
+            return extremeAvx2<false>(values, count);
+#endif
+        return *std::max_element(values, values + count);
+    }
+
+    void map(Arithmetic operation, const int64_t *values, int64_t operand, int64_t *out, size_t count)
+    {
+#ifdef NEXIS_SIMD_AVX2
+        // There is no vector integer division
+        if (useAvx2() && operation != Arithmetic::Divide)
+            return mapAvx2(operation, values, operand, out, count);
+#endif
+        for (size_t i = 0; i < count; i++)
+            out[i] = apply(operation, values[i], operand);
+    }
+
+    void map(Arithmetic operation, const double *values, double operand, double *out, size_t count)
+    {
+#ifdef NEXIS_SIMD_AVX2
+        if (useAvx2())
+            return mapAvx2(operation, values, operand, out, count);
+#endif
+        for (size_t i = 0; i < count; i++)
+            out[i] = apply(operation, values[i], operand);
+    }
+
+    size_t filter(Comparison comparison, const int64_t *values, int64_t operand, int64_t *out, size_t count)
+    {
+#ifdef NEXIS_SIMD_AVX2
+        if (useAvx2())
+            return filterAvx2(comparison, values, operand, out, count);
+#endif
+        return filterScalar(comparison, values, operand, out, count);
+    }
+
+    size_t filter(Comparison comparison, const double *values, double operand, double *out, size_t count)
+    {
+#ifdef NEXIS_SIMD_AVX2
+        if (useAvx2())
+            return filterAvx2(comparison, values, operand, out, count);
+#endif
+        return filterScalar(comparison, values, operand, out, count);
+    }
+
+    void sort(int64_t *values, size_t count)
+    {
+        if (count < kSmallSort)
+            std::sort(values, values + count);
+        else
+            radixSort(values, count);
+    }
+
+    void sort(double *values, size_t count)
+    {
+        if (count < kSmallSort)
+        {
+            // Same order as the radix sort
+            std::sort(values, values + count, [](double left, double right) { return keyOf(left) < keyOf(right); });
+        }
+        else
+        {
+            radixSort(values, count);
+        }
+    }
+
+    size_t findByte(const char *data, size_t size, char byte)
+    {
+#ifdef NEXIS_SIMD_AVX2
+        if (useAvx2())
+            return findByteAvx2(data, size, byte);
+#endif
+        return findByteScalar(data, size, byte);
+    }
+
+    size_t findBytes(const char *data, size_t size, char byte, size_t *positions, size_t capacity)
+    {
+#ifdef NEXIS_SIMD_AVX2
+        if (useAvx2())
+            return findBytesAvx2(data, size, byte, positions, capacity);
+#endif
+        return findBytesScalar(data, size, byte, positions, capacity);
+    }
+
+    size_t countByte(const char *data, size_t size, char byte)
+    {
+#ifdef NEXIS_SIMD_AVX2
+        if (useAvx2())
+            return countByteAvx2(data, size, byte);
+#endif
+        return countByteScalar(data, size, byte);
+    }
+
+    size_t find(const char *data, size_t size, const char *needle, size_t needleSize)
+    {
+        if (needleSize == 0)
+            return 0;
+        if (needleSize == 1)
+            return findByte(data, size, needle[0]);
+        if (needleSize > size)
+            return size;
+#ifdef NEXIS_SIMD_AVX2
+        if (useAvx2())
+            return findAvx2(data, size, needle, needleSize);
+#endif
+        return findScalar(data, size, needle, needleSize);
+    }
+}
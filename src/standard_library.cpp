@@ -0,0 +1,60 @@
+#include "standard_library.h"
+#include "module_manager.h"
+#include "evaluator.h"
+#include "output_buffer.h"
+#include "big_integer.h"
+
+#include <stdexcept>
+
+void registerStandardModules() {
+    auto& mm = ModuleManager::getInstance();
+
+    // Register IO functions using full module path
+    mm.registerFunction("std.io", "print", [](const std::vector<std::unique_ptr<ASTNode>>& args) {
+        auto& out = OutputBuffer::getInstance();
+        for (const auto& arg : args) {
+            out.write(evaluateNode(arg.get()));
+        }
+        out.writeLine("");
+        return "";
+    });
+
+    mm.registerFunction("std.io", "println", [](const std::vector<std::unique_ptr<ASTNode>>& args) {
+        std::string result;
+        for (const auto& arg : args) {
+            result += evaluateNode(arg.get());
+        }
+        OutputBuffer::getInstance().writeLine(result);
+        return result;
+    });
+
+    mm.registerFunction("std.io", "flush", [](const std::vector<std::unique_ptr<ASTNode>>&) {
+        OutputBuffer::getInstance().flush();
+        return std::string();
+    });
+
+    // Exact integer arithmetic: int64 while everything fits, bignums beyond
+    auto mathOperation = [](const char* name, IntegerOperation operation) {
+        return [name, operation](const std::vector<std::unique_ptr<ASTNode>>& args) {
+            if (args.size() != 2) return std::string("0");
+            std::string left = evaluateNode(args[0].get());
+            std::string right = evaluateNode(args[1].get());
+            std::string result;
+            if (!computeInteger(operation, left, right, result)) {
+                throw std::runtime_error(std::string("math.") + name + ": '" + left + "' and '" + right +
+                                         "' are not both integers");
+            }
+            return result;
+        };
+    };
+    mm.registerFunction("std.math", "add", mathOperation("add", IntegerOperation::Add));
+    mm.registerFunction("std.math", "subtract", mathOperation("subtract", IntegerOperation::Subtract));
+    mm.registerFunction("std.math", "multiply", mathOperation("multiply", IntegerOperation::Multiply));
+
+    registerArrayModule();
+    registerMapModule();
+    registerChanModule();
+    registerParallelModule();
+    registerFsModule();
+    registerStringModule();
+}
@@ -0,0 +1,213 @@
+#include "string_map.h"
+
+#include <charconv>
+#include <functional>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    constexpr int8_t kEmpty = -128;
+    constexpr int8_t kDeleted = -2;
+
+    // Low 7 bits of the hash go into the control byte, the rest pick the group
+    int8_t hashTag(size_t hash) { return static_cast<int8_t>(hash & 0x7F); }
+    size_t hashGroup(size_t hash) { return hash >> 7; }
+
+    // Bit i is set if group[i] == byte
+    uint32_t matchByte(const int8_t *group, int8_t byte)
+    {
+#ifdef __SSE2__
+        __m128i control = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(byte))));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < StringMap::kGroupWidth; i++)
+            mask |= static_cast<uint32_t>(group[i] == byte) << i;
+        return mask;
+#endif
+    }
+
+    // Bit i is set if group[i] is empty or deleted, the only negative bytes
+    uint32_t matchFree(const int8_t *group)
+    {
+#ifdef __SSE2__
+        __m128i control = _mm_loadu_si128(reinterpret_cast<const __m128i *>(group));
+        return static_cast<uint32_t>(_mm_movemask_epi8(control));
+#else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < StringMap::kGroupWidth; i++)
+            mask |= static_cast<uint32_t>(group[i] < 0) << i;
+        return mask;
+#endif
+    }
+
+    // Visits whole groups in triangular steps, which reaches every group
+    // when their number is a power of two
+    class ProbeSequence
+    {
+    public:
+        ProbeSequence(size_t hash, size_t mask) : group_(hashGroup(hash) & mask), mask_(mask) {}
+
+        size_t offset() const { return group_ * StringMap::kGroupWidth; }
+        void next() { group_ = (group_ + ++step_) & mask_; }
+
+    private:
+        size_t group_;
+        size_t mask_;
+        size_t step_ = 0;
+    };
+}
+
+MapValue MapValue::from(const std::string &value)
+{
+    MapValue result;
+    auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), result.number);
+    // Only canonical text becomes a number, so "007" reads back unchanged
+    if (error == std::errc() && end == value.data() + value.size() && std::to_string(result.number) == value)
+        result.isInt = true;
+    else
+        result.text = value;
+    return result;
+}
+
+StringMap::StringMap()
+{
+    rehash(kGroupWidth);
+}
+
+size_t StringMap::memoryBytes() const
+{
+    // Short strings live inside the entry
+    auto textBytes = [](const std::string &text) {
+        return text.capacity() > std::string().capacity() ? text.capacity() + 1 : 0;
+    };
+    size_t bytes = sizeof(StringMap) + control_.capacity() + slots_.capacity() * sizeof(uint32_t) +
+                   entries_.capacity() * sizeof(Entry);
+    for (const Entry &entry : entries_)
+        bytes += textBytes(entry.key) + textBytes(entry.value.text);
+    return bytes;
+}
+
+size_t StringMap::findSlot(const std::string &key, size_t hash) const
+{
+    int8_t tag = hashTag(hash);
+    for (ProbeSequence probe(hash, groupMask_);; probe.next())
+    {
+        const int8_t *group = control_.data() + probe.offset();
+        for (uint32_t match = matchByte(group, tag); match; match &= match - 1)
+        {
+            size_t slot = probe.offset() + __builtin_ctz(match);
+            const Entry &entry = entries_[slots_[slot]];
+            if (entry.hash == hash && entry.key == key)
+                return slot;
+        }
+        if (matchByte(group, kEmpty))
+            return kNotFound;
+    }
+}
+
+size_t StringMap::findFreeSlot(size_t hash) const
+{
+    for (ProbeSequence probe(hash, groupMask_);; probe.next())
+    {
+        if (uint32_t free = matchFree(control_.data() + probe.offset()))
+            return probe.offset() + __builtin_ctz(free);
+    }
+}
+
+bool StringMap::groupHasEmpty(size_t group) const
+{
+    return matchByte(control_.data() + group * kGroupWidth, kEmpty) != 0;
+}
+
+void StringMap::rehash(size_t capacity)
+{
+    control_.assign(capacity, kEmpty);
+    slots_.assign(capacity, 0);
+    groupMask_ = capacity / kGroupWidth - 1;
+    for (size_t i = 0; i < entries_.size(); i++)
+    {
+        size_t slot = findFreeSlot(entries_[i].hash);
+        control_[slot] = hashTag(entries_[i].hash);
+        slots_[slot] = static_cast<uint32_t>(i);
+    }
+    // At most 7/8 of the slots are ever in use, so every probe ends
+    growthLeft_ = capacity - capacity / 8 - entries_.size();
+}
+
+MapValue *StringMap::find(const std::string &key)
+{
+    size_t slot = findSlot(key, std::hash<std::string>{}(key));
+    return slot == kNotFound ? nullptr : &entries_[slots_[slot]].value;
+}
+
+MapValue &StringMap::operator[](const std::string &key)
+{
+    size_t hash = std::hash<std::string>{}(key);
+    size_t slot = findSlot(key, hash);
+    if (slot != kNotFound)
+        return entries_[slots_[slot]].value;
+
+    if (growthLeft_ == 0)
+    {
+        // Mostly deleted slots: clean up in place instead of growing
+        size_t capacity = control_.size();
+        rehash(entries_.size() * 16 < capacity * 7 ? capacity : capacity * 2);
+    }
+    slot = findFreeSlot(hash);
+    if (control_[slot] == kEmpty)
+        growthLeft_--;
+    control_[slot] = hashTag(hash);
+    slots_[slot] = static_cast<uint32_t>(entries_.size());
+    entries_.push_back({key, MapValue(), hash});
+    return entries_.back().value;
+}
+
+bool StringMap::remove(const std::string &key)
+{
+    size_t hash = std::hash<std::string>{}(key);
+    size_t slot = findSlot(key, hash);
+    if (slot == kNotFound)
+        return false;
+
+    // A group that still has an empty slot was never full, so no probe went
+    // past it and the slot can become empty again instead of a tombstone
+    if (groupHasEmpty(slot / kGroupWidth))
+    {
+        control_[slot] = kEmpty;
+        growthLeft_++;
+    }
+    else
+    {
+        control_[slot] = kDeleted;
+    }
+
+    // Keep entries_ dense by moving the last entry into the hole
+    uint32_t index = slots_[slot];
+    uint32_t last = static_cast<uint32_t>(entries_.size() - 1);
+    if (index != last)
+    {
+        int8_t tag = hashTag(entries_[last].hash);
+        for (ProbeSequence probe(entries_[last].hash, groupMask_);; probe.next())
+        {
+            uint32_t match = matchByte(control_.data() + probe.offset(), tag);
+            for (; match; match &= match - 1)
+            {
+                size_t candidate = probe.offset() + __builtin_ctz(match);
+                if (slots_[candidate] == last)
+                {
+                    slots_[candidate] = index;
+                    break;
+                }
+            }
+            if (match)
+                break;
+        }
+        entries_[index] = std::move(entries_[last]);
+    }
+    entries_.pop_back();
+    return true;
+}
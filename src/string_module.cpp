@@ -0,0 +1,223 @@
+#include "string_map.h"
+#include "heap.h"
+#include "standard_library.h"
+#include "module_manager.h"
+#include "evaluator.h"
+#include "simd_kernels.h"
+
+#include <charconv>
+#include <stdexcept>
+#include <string_view>
+
+namespace
+{
+    using Arguments = std::vector<std::unique_ptr<ASTNode>>;
+
+    [[noreturn]] void fail(const std::string &function, const std::string &message)
+    {
+        throw std::runtime_error("string." + function + ": " + message);
+    }
+
+    void expectArguments(const std::string &function, const Arguments &args, size_t minimum, size_t maximum)
+    {
+        if (args.size() < minimum || args.size() > maximum)
+        {
+            std::string expected = minimum == maximum ? std::to_string(minimum)
+                                                      : std::to_string(minimum) + " or " + std::to_string(maximum);
+            fail(function, "expects " + expected + " arguments, got " + std::to_string(args.size()));
+        }
+    }
+
+    size_t toPosition(const std::string &function, const std::string &text)
+    {
+        size_t value;
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (error != std::errc() || end != text.data() + text.size())
+            fail(function, "'" + text + "' is not a position");
+        return value;
+    }
+
+    std::string nonEmpty(const std::string &function, std::string text)
+    {
+        if (text.empty())
+            fail(function, "empty search string");
+        return text;
+    }
+
+    // Offset of the first `needle` at or after `from`, or text.size()
+    size_t findFrom(std::string_view text, std::string_view needle, size_t from = 0)
+    {
+        if (from > text.size())
+            return text.size();
+        size_t offset = simd::find(text.data() + from, text.size() - from, needle.data(), needle.size());
+        return from + offset;
+    }
+
+    // Calls piece(view) for every part of `text` between occurrences of the
+    // non-empty `separator`
+    template <typename Piece>
+    void forEachPiece(std::string_view text, std::string_view separator, const Piece &piece)
+    {
+        size_t start = 0;
+        if (separator.size() == 1)
+        {
+            // Separators are found a batch at a time
+            size_t positions[256];
+            for (;;)
+            {
+                size_t offset = start;
+                size_t found = simd::findBytes(text.data() + offset, text.size() - offset, separator[0], positions, 256);
+                for (size_t i = 0; i < found; i++)
+                {
+                    piece(text.substr(start, offset + positions[i] - start));
+                    start = offset + positions[i] + 1;
+                }
+                if (found < 256)
+                {
+                    piece(text.substr(start));
+                    return;
+                }
+            }
+        }
+        for (;;)
+        {
+            size_t end = findFrom(text, separator, start);
+            piece(text.substr(start, end - start));
+            if (end == text.size())
+                return;
+            start = end + separator.size();
+        }
+    }
+
+    size_t textLength(const MapValue &value)
+    {
+        if (!value.isInt)
+            return value.text.size();
+        char buffer[24];
+        return static_cast<size_t>(std::to_chars(buffer, buffer + sizeof buffer, value.number).ptr - buffer);
+    }
+}
+
+void registerStringModule()
+{
+    auto &mm = ModuleManager::getInstance();
+
+    // Positions and lengths count bytes
+    mm.registerFunction("std.string", "length", [](const Arguments &args) {
+        expectArguments("length", args, 1, 1);
+        return std::to_string(evaluateNode(args[0].get()).size());
+    });
+
+    // string.find(s, needle) is the position of the first needle in s, or
+    // -1; string.find(s, needle, from) starts looking at from
+    mm.registerFunction("std.string", "find", [](const Arguments &args) {
+        expectArguments("find", args, 2, 3);
+        std::string text = evaluateNode(args[0].get());
+        std::string needle = evaluateNode(args[1].get());
+        size_t from = args.size() == 3 ? toPosition("find", evaluateNode(args[2].get())) : 0;
+        size_t position = findFrom(text, needle, from);
+        if (from > text.size() || position + needle.size() > text.size())
+            return std::string("-1");
+        return std::to_string(position);
+    });
+
+    mm.registerFunction("std.string", "contains", [](const Arguments &args) {
+        expectArguments("contains", args, 2, 2);
+        std::string text = evaluateNode(args[0].get());
+        std::string needle = evaluateNode(args[1].get());
+        return std::string(findFrom(text, needle) + needle.size() <= text.size() ? "true" : "false");
+    });
+
+    // Occurrences that do not overlap, e.g. 2 for "aa" in "aaaaa"
+    mm.registerFunction("std.string", "count", [](const Arguments &args) {
+        expectArguments("count", args, 2, 2);
+        std::string text = evaluateNode(args[0].get());
+        std::string needle = nonEmpty("count", evaluateNode(args[1].get()));
+        if (needle.size() == 1)
+            return std::to_string(simd::countByte(text.data(), text.size(), needle[0]));
+        size_t count = 0;
+        for (size_t position = findFrom(text, needle); position < text.size();
+             position = findFrom(text, needle, position + needle.size()))
+            count++;
+        return std::to_string(count);
+    });
+
+    // string.split(s, separator) returns a new map from "0", "1", ... to the
+    // parts of s between the separators, so string.split("a,,b", ",") has
+    // the 3 entries "a", "" and "b"
+    mm.registerFunction("std.string", "split", [](const Arguments &args) {
+        expectArguments("split", args, 2, 2);
+        std::string text = evaluateNode(args[0].get());
+        std::string separator = nonEmpty("split", evaluateNode(args[1].get()));
+        auto [handle, map] = Heap::getInstance().newMap();
+        size_t index = 0;
+        forEachPiece(text, separator, [&](std::string_view piece) {
+            (*map)[std::to_string(index++)] = MapValue::from(std::string(piece));
+        });
+        // The map is young, so the collector only needs to know its size
+        Heap::getInstance().storedInMap(handle, "", text);
+        return handle;
+    });
+
+    // string.join(m, separator) joins the values of map m in entry order,
+    // which is the order string.split made them in
+    mm.registerFunction("std.string", "join", [](const Arguments &args) {
+        expectArguments("join", args, 2, 2);
+        std::string handle = evaluateNode(args[0].get());
+        const StringMap *map = Heap::getInstance().findMap(handle);
+        if (!map)
+            fail("join", "'" + handle + "' is not a map");
+        std::string separator = evaluateNode(args[1].get());
+        if (map->size() == 0)
+            return std::string();
+
+        size_t length = separator.size() * (map->size() - 1);
+        for (size_t i = 0; i < map->size(); i++)
+            length += textLength(map->entryAt(i).value);
+        std::string result;
+        result.reserve(length);
+        for (size_t i = 0; i < map->size(); i++)
+        {
+            if (i > 0)
+                result += separator;
+            const MapValue &value = map->entryAt(i).value;
+            if (value.isInt)
+                result += std::to_string(value.number);
+            else
+                result += value.text;
+        }
+        return result;
+    });
+
+    // Replaces every occurrence, left to right
+    mm.registerFunction("std.string", "replace", [](const Arguments &args) {
+        expectArguments("replace", args, 3, 3);
+        std::string text = evaluateNode(args[0].get());
+        std::string from = nonEmpty("replace", evaluateNode(args[1].get()));
+        std::string to = evaluateNode(args[2].get());
+        std::string result;
+        bool first = true;
+        forEachPiece(text, from, [&](std::string_view piece) {
+            if (!first)
+                result += to;
+            result += piece;
+            first = false;
+        });
+        return result;
+    });
+
+    // string.substring(s, start) is s from start on; string.substring(s,
+    // start, length) at most length bytes of it
+    mm.registerFunction("std.string", "substring", [](const Arguments &args) {
+        expectArguments("substring", args, 2, 3);
+        std::string text = evaluateNode(args[0].get());
+        size_t start = toPosition("substring", evaluateNode(args[1].get()));
+        size_t length = args.size() == 3 ? toPosition("substring", evaluateNode(args[2].get())) : text.size();
+        if (start > text.size())
+            fail("substring", "start " + std::to_string(start) + " is past the end of " +
+                                  std::to_string(text.size()) + " bytes");
+        if (start == 0 && length >= text.size())
+            return text;
+        return text.substr(start, length);
+    });
+}
@@ -0,0 +1,159 @@
+#include "tasks.h"
+#include "heap.h"
+#include "module_manager.h"
+#include "symbol_table.h"
+
+#include <charconv>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace
+{
+    const std::string kHandlePrefix = "task#";
+}
+
+// Never destroyed: tasks still running when the program ends wait on its
+// lock until the process is gone
+Tasks &Tasks::getInstance()
+{
+    static Tasks *instance = new Tasks;
+    return *instance;
+}
+
+// A task's arguments and globals until it starts, and its result for
+// every later join, may be the only values that reach an object
+Tasks::Tasks()
+{
+    Heap::getInstance().addRoots([this](const Heap::RootVisitor &visit) {
+        for (const auto &task : tasks_)
+        {
+            for (const Value &argument : task->arguments)
+                visit(argument.str());
+            for (const auto &global : task->globals)
+                visit(global.second.str());
+            visit(task->result);
+        }
+    });
+}
+
+void Tasks::lock()
+{
+    std::unique_lock<std::mutex> guard(mutex_);
+    size_t ticket = nextTicket_++;
+    if (ticket != serving_)
+    {
+        waiting_.fetch_add(1, std::memory_order_relaxed);
+        turn_.wait(guard, [&] { return serving_ == ticket; });
+        waiting_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+void Tasks::unlock()
+{
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        serving_++;
+    }
+    turn_.notify_all();
+}
+
+void Tasks::yield()
+{
+    if (active_ && waiting_.load(std::memory_order_relaxed))
+    {
+        unlock();
+        lock();
+    }
+}
+
+Tasks::Unlocked::Unlocked() : locked_(Tasks::getInstance().active_)
+{
+    if (locked_)
+        Tasks::getInstance().unlock();
+}
+
+Tasks::Unlocked::~Unlocked()
+{
+    if (locked_)
+        Tasks::getInstance().lock();
+}
+
+std::string Tasks::spawn(Symbol function, std::vector<Value> arguments)
+{
+    if (!active_)
+    {
+        lock();
+        active_ = true;
+        ModuleManager::getInstance().enableTaskSwitching();
+    }
+
+    auto task = std::make_shared<Task>();
+    task->arguments = std::move(arguments);
+    task->globals = SymbolTable::getInstance().globals();
+    tasks_.push_back(task);
+    running_.fetch_add(1, std::memory_order_release);
+
+    std::thread([this, task, function]() {
+        lock();
+        SymbolTable::getInstance().setGlobals(std::exchange(task->globals, {}));
+        std::vector<std::unique_ptr<ASTNode>> literals;
+        for (Value &argument : std::exchange(task->arguments, {}))
+        {
+            auto literal = std::make_unique<LiteralNode>();
+            literal->type = "value";
+            literal->value = std::move(argument).release();
+            literals.push_back(std::move(literal));
+        }
+
+        std::string result;
+        bool failed = false;
+        try
+        {
+            result = ModuleManager::getInstance().callFunction(function, literals);
+        }
+        catch (const std::exception &e)
+        {
+            result = e.what();
+            failed = true;
+        }
+        {
+            std::lock_guard<std::mutex> guard(task->mutex);
+            task->done = true;
+            task->failed = failed;
+            task->result = std::move(result);
+        }
+        task->finished.notify_all();
+        running_.fetch_sub(1, std::memory_order_release);
+        // Its variables are about to go away
+        Heap::getInstance().detachThread();
+        unlock();
+    }).detach();
+
+    return kHandlePrefix + std::to_string(tasks_.size() - 1);
+}
+
+std::string Tasks::join(const std::string &handle)
+{
+    size_t index = tasks_.size();
+    if (handle.compare(0, kHandlePrefix.size(), kHandlePrefix) == 0)
+    {
+        const char *end = handle.data() + handle.size();
+        auto result = std::from_chars(handle.data() + kHandlePrefix.size(), end, index);
+        if (result.ec != std::errc() || result.ptr != end)
+            index = tasks_.size();
+    }
+    if (index >= tasks_.size())
+        throw std::runtime_error("'" + handle + "' is not a task");
+
+    std::shared_ptr<Task> task = tasks_[index];
+    {
+        Heap::Parked parked;
+        Unlocked unlocked;
+        std::unique_lock<std::mutex> guard(task->mutex);
+        task->finished.wait(guard, [&] { return task->done; });
+    }
+    if (task->failed)
+        throw std::runtime_error("task " + handle + " failed: " + task->result);
+    return task->result;
+}
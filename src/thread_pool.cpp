@@ -0,0 +1,100 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <thread>
+
+// Never destroyed: its workers wait for jobs until the process exits
+ThreadPool &ThreadPool::getInstance()
+{
+    static ThreadPool *instance = new ThreadPool;
+    return *instance;
+}
+
+ThreadPool::ThreadPool() : threads_(std::max(1u, std::thread::hardware_concurrency()))
+{
+}
+
+void ThreadPool::setThreads(size_t count)
+{
+    std::lock_guard<std::mutex> job(jobMutex_);
+    threads_ = std::max<size_t>(count, 1);
+}
+
+void ThreadPool::startWorkers()
+{
+    for (; started_ + 1 < threads_; started_++)
+        std::thread([this] { workerLoop(); }).detach();
+}
+
+void ThreadPool::workerLoop()
+{
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;)
+    {
+        wake_.wait(lock, [&] { return work_ && job_ != seen; });
+        seen = job_;
+        const std::function<void(size_t)> &work = *work_;
+        busy_++;
+        lock.unlock();
+        runChunks(work);
+        lock.lock();
+        if (--busy_ == 0)
+            idle_.notify_all();
+    }
+}
+
+void ThreadPool::runChunks(const std::function<void(size_t)> &work)
+{
+    while (!failed_.load(std::memory_order_relaxed))
+    {
+        size_t chunk = nextChunk_.fetch_add(1, std::memory_order_relaxed);
+        if (chunk >= chunks_)
+            return;
+        try
+        {
+            work(chunk);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            if (!failed_.exchange(true))
+                error_ = std::current_exception();
+        }
+    }
+}
+
+void ThreadPool::run(size_t chunks, const std::function<void(size_t chunk)> &work)
+{
+    std::lock_guard<std::mutex> job(jobMutex_);
+    if (threads_ == 1 || chunks <= 1)
+    {
+        for (size_t chunk = 0; chunk < chunks; chunk++)
+            work(chunk);
+        return;
+    }
+
+    startWorkers();
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        work_ = &work;
+        job_++;
+        chunks_ = chunks;
+        nextChunk_ = 0;
+        failed_ = false;
+        error_ = nullptr;
+    }
+    wake_.notify_all();
+    runChunks(work);
+
+    std::exception_ptr error;
+    {
+        // Workers that have not woken up yet stay out of this job
+        std::unique_lock<std::mutex> lock(mutex_);
+        work_ = nullptr;
+        idle_.wait(lock, [&] { return busy_ == 0; });
+        error = std::move(error_);
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
@@ -0,0 +1,458 @@
+#include "type_checker.h"
+#include "module_manager.h"
+
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+
+namespace {
+    // Result types of builtins whose signature the checker knows; any other
+    // registered builtin returns a dynamic value
+    struct BuiltinSignature
+    {
+        const char *name;
+        int arity; // -1 for variadic
+        bool intArguments;
+        const char *returnType;
+    };
+
+    const BuiltinSignature builtinSignatures[] = {
+        {"io.print", -1, false, "void"},
+        {"io.println", -1, false, "string"},
+        {"io.flush", 0, false, "void"},
+        {"math.add", 2, true, "int"},
+        {"math.subtract", 2, true, "int"},
+        {"math.multiply", 2, true, "int"},
+        {"array.length", 1, false, "int"},
+        {"map.has", 2, false, "bool"},
+        {"map.remove", 2, false, "bool"},
+        {"map.size", 1, false, "int"},
+        {"chan.close", 1, false, "void"},
+        {"chan.select", -1, false, "int"},
+        {"parallel.range", -1, false, "int"},
+        {"parallel.each", -1, false, "int"},
+        {"fs.lines", 1, false, "int"},
+        {"fs.write", -1, false, "void"},
+        {"fs.write_line", -1, false, "void"},
+        {"fs.close", 1, false, "void"},
+        {"string.length", 1, false, "int"},
+        {"string.find", -1, false, "int"},
+        {"string.contains", 2, false, "bool"},
+        {"string.count", 2, false, "int"},
+    };
+}
+
+bool TypeChecker::check(ASTNode *program)
+{
+    functions_.clear();
+    globals_.clear();
+    variables_.clear();
+    errors_.clear();
+    errorOffsets_.clear();
+
+    auto root = dynamic_cast<ModuleNode *>(program);
+    if (!root)
+        return true;
+
+    for (const auto &child : root->body)
+    {
+        auto module = dynamic_cast<ModuleNode *>(child.get());
+        if (!module)
+            continue;
+        module_ = module->name;
+        offset_ = module->startOffset;
+        for (const auto &member : module->body)
+        {
+            auto function = dynamic_cast<FunctionNode *>(member.get());
+            if (!function)
+                continue;
+            function_ = function->name;
+            offset_ = function->startOffset;
+            Signature signature;
+            for (const auto &parameter : function->parameters)
+                signature.parameters.push_back(parseType(parameter.type, false));
+            signature.returnType = parseType(function->returnType, true);
+            functions_[module->name + "." + function->name] = signature;
+        }
+        function_.clear();
+    }
+
+    // Module-level lets are evaluated at registration, before any call
+    for (const auto &child : root->body)
+    {
+        if (auto module = dynamic_cast<ModuleNode *>(child.get()))
+            checkGlobals(*module);
+    }
+
+    for (const auto &child : root->body)
+    {
+        auto module = dynamic_cast<ModuleNode *>(child.get());
+        if (!module)
+            continue;
+        for (const auto &member : module->body)
+        {
+            auto function = dynamic_cast<FunctionNode *>(member.get());
+            if (function && !function->lazyBody)
+                checkFunction(module->name, *function);
+        }
+    }
+    module_.clear();
+    function_.clear();
+    return errors_.empty();
+}
+
+bool TypeChecker::checkBody(const std::string &module, FunctionNode &function)
+{
+    errors_.clear();
+    errorOffsets_.clear();
+    checkFunction(module, function);
+    module_.clear();
+    function_.clear();
+    return errors_.empty();
+}
+
+std::string TypeChecker::variableType(const FunctionNode &function, const std::string &name) const
+{
+    auto variables = variables_.find(&function);
+    if (variables == variables_.end())
+        return "";
+    auto it = variables->second.find(name);
+    return it != variables->second.end() ? typeName(it->second) : "";
+}
+
+void TypeChecker::checkGlobals(ModuleNode &module)
+{
+    module_ = module.name;
+    offset_ = module.startOffset;
+    for (const auto &member : module.body)
+    {
+        if (auto declaration = dynamic_cast<VariableDeclarationNode *>(member.get()))
+            checkDeclaration(*declaration, globals_);
+    }
+}
+
+void TypeChecker::checkFunction(const std::string &module, FunctionNode &function)
+{
+    module_ = module;
+    function_ = function.name;
+    offset_ = function.startOffset;
+    parameters_.clear();
+    locals_.clear();
+
+    const Signature &signature = functions_[module + "." + function.name];
+    for (size_t i = 0; i < function.parameters.size(); i++)
+    {
+        if (!parameters_.emplace(function.parameters[i].name, signature.parameters[i]).second)
+            error("duplicate parameter '" + function.parameters[i].name + "'");
+    }
+
+    // A function's value is that of its last statement; paths without one
+    // return "", which every return type allows
+    for (Type type : checkBlock(function.body))
+    {
+        if (!isAssignable(type, signature.returnType) && signature.returnType != Type::Void)
+            error(std::string("returns ") + typeName(type) + " but is declared to return " +
+                  typeName(signature.returnType));
+    }
+
+    // Locals shadow parameters, as in checkLiteral
+    auto &variables = variables_[&function];
+    variables = locals_;
+    variables.insert(parameters_.begin(), parameters_.end());
+}
+
+std::vector<TypeChecker::Type> TypeChecker::checkBlock(std::vector<std::unique_ptr<ASTNode>> &statements)
+{
+    std::vector<Type> result;
+    for (auto &statement : statements)
+    {
+        if (statement)
+            result = checkStatement(statement.get());
+    }
+    return result;
+}
+
+std::vector<TypeChecker::Type> TypeChecker::checkStatement(ASTNode *statement)
+{
+    if (auto declaration = dynamic_cast<VariableDeclarationNode *>(statement))
+    {
+        checkDeclaration(*declaration, locals_);
+        return {};
+    }
+    if (auto ifNode = dynamic_cast<IfStatementNode *>(statement))
+    {
+        if (checkExpression(ifNode->condition.get()) == Type::Void)
+            error("if condition has no value");
+        std::vector<Type> result = checkBlock(ifNode->thenBranch);
+        std::vector<Type> elseResult = checkBlock(ifNode->elseBranch);
+        result.insert(result.end(), elseResult.begin(), elseResult.end());
+        return result;
+    }
+    if (auto returnNode = dynamic_cast<ReturnStatementNode *>(statement))
+        statement = returnNode->expression.get();
+    if (dynamic_cast<FunctionNode *>(statement))
+    {
+        error("nested functions are not supported");
+        return {};
+    }
+
+    Type type = checkExpression(statement);
+    if (type == Type::Void)
+        return {};
+    return {type};
+}
+
+void TypeChecker::checkDeclaration(VariableDeclarationNode &declaration, std::map<std::string, Type> &scope)
+{
+    Type declared = declaration.type.empty() ? Type::Dynamic : parseType(declaration.type, false);
+    Type type = declared;
+    if (declaration.initializer)
+    {
+        Type value = checkExpression(declaration.initializer.get());
+        if (value == Type::Void)
+            error("initializer of '" + declaration.name + "' has no value");
+        else if (declaration.type.empty())
+            type = value;
+        else if (!isAssignable(value, declared))
+            error(std::string("cannot initialize ") + typeName(declared) + " '" + declaration.name + "' with " +
+                  typeName(value));
+    }
+    scope[declaration.name] = type;
+}
+
+TypeChecker::Type TypeChecker::checkExpression(ASTNode *node)
+{
+    if (auto literal = dynamic_cast<LiteralNode *>(node))
+        return checkLiteral(*literal);
+    if (auto binary = dynamic_cast<BinaryOperationNode *>(node))
+        return checkBinary(*binary);
+    if (auto call = dynamic_cast<FunctionCallNode *>(node))
+        return checkCall(*call);
+    if (node)
+        error("unsupported expression");
+    return Type::Dynamic;
+}
+
+TypeChecker::Type TypeChecker::checkLiteral(LiteralNode &literal)
+{
+    if (literal.type == "identifier")
+    {
+        for (const auto *scope : {&locals_, &parameters_, &globals_})
+        {
+            auto it = scope->find(literal.value);
+            if (it != scope->end())
+                return it->second;
+        }
+        error("undefined variable '" + literal.value + "'");
+        return Type::Dynamic;
+    }
+    if (literal.type == "string")
+        return Type::Text;
+    if (literal.type == "boolean")
+        return Type::Bool;
+
+    // Ints follow std::stoi, so anything wider than 32 bits never was one
+    errno = 0;
+    char *end = nullptr;
+    long value = std::strtol(literal.value.c_str(), &end, 10);
+    if (literal.value.empty() || *end != '\0' || errno == ERANGE || value < INT_MIN || value > INT_MAX)
+    {
+        error("integer literal '" + literal.value + "' is out of range");
+        return Type::Dynamic;
+    }
+    literal.intValue = static_cast<int>(value);
+    return Type::Int;
+}
+
+TypeChecker::Type TypeChecker::checkBinary(BinaryOperationNode &node)
+{
+    Type left = checkExpression(node.left.get());
+    Type right = checkExpression(node.right.get());
+    node.operation = BinaryOperation::Dynamic;
+
+    const std::string &op = node.op;
+    if (left == Type::Void || right == Type::Void)
+    {
+        error("operand of '" + op + "' has no value");
+        return Type::Dynamic;
+    }
+    if (op == "=")
+    {
+        error("assignment is not supported");
+        return Type::Dynamic;
+    }
+
+    bool ints = left == Type::Int && right == Type::Int;
+    if (op == "+")
+    {
+        if (ints)
+        {
+            node.operation = BinaryOperation::IntAdd;
+            return Type::Int;
+        }
+        // Concatenation as soon as one side is declared not to be an int;
+        // an inferred string such as "7" still adds at run time
+        bool textual = left == Type::String || left == Type::Bool || right == Type::String || right == Type::Bool;
+        if (textual)
+        {
+            node.operation = BinaryOperation::Concat;
+            return Type::String;
+        }
+        return Type::Dynamic;
+    }
+
+    // Dynamic operands stay with the runtime guess, where only '*' always
+    // produces an int
+    if (left == Type::Dynamic || right == Type::Dynamic)
+        return op == "*" ? Type::Int : Type::Dynamic;
+
+    if (op == "==" && !ints)
+    {
+        if (left == Type::Text)
+            left = Type::String;
+        if (right == Type::Text)
+            right = Type::String;
+        if (left != right)
+        {
+            error(std::string("cannot compare ") + typeName(left) + " with " + typeName(right));
+            return Type::Bool;
+        }
+        node.operation = BinaryOperation::ValueEquals;
+        return Type::Bool;
+    }
+
+    if (!ints)
+    {
+        error("operator '" + op + "' expects int operands, got " + typeName(left) + " and " + typeName(right));
+        return op == "-" || op == "*" || op == "/" ? Type::Int : Type::Bool;
+    }
+
+    static const std::map<std::string, std::pair<BinaryOperation, Type>> intOperations = {
+        {"-", {BinaryOperation::IntSubtract, Type::Int}},
+        {"*", {BinaryOperation::IntMultiply, Type::Int}},
+        {"/", {BinaryOperation::IntDivide, Type::Int}},
+        {"==", {BinaryOperation::IntEquals, Type::Bool}},
+        {"<", {BinaryOperation::IntLess, Type::Bool}},
+        {"<=", {BinaryOperation::IntLessEqual, Type::Bool}},
+        {">", {BinaryOperation::IntGreater, Type::Bool}},
+        {">=", {BinaryOperation::IntGreaterEqual, Type::Bool}},
+    };
+    auto it = intOperations.find(op);
+    if (it == intOperations.end())
+    {
+        error("operator '" + op + "' is not supported");
+        return Type::Dynamic;
+    }
+    node.operation = it->second.first;
+    return it->second.second;
+}
+
+TypeChecker::Type TypeChecker::checkCall(FunctionCallNode &node)
+{
+    std::vector<Type> arguments;
+    for (auto &argument : node.arguments)
+        arguments.push_back(checkExpression(argument.get()));
+    for (size_t i = 0; i < arguments.size(); i++)
+    {
+        if (arguments[i] == Type::Void)
+            error("argument " + std::to_string(i + 1) + " of " + node.name + " has no value");
+    }
+
+    if (node.name.find('.') == std::string::npos)
+    {
+        error("call to '" + node.name + "' must name its module");
+        return Type::Dynamic;
+    }
+
+    // Builtins win over user modules, as in ModuleManager::callFunction
+    if (ModuleManager::getInstance().isBuiltinFunction(node.name))
+    {
+        for (const auto &builtin : builtinSignatures)
+        {
+            if (node.name != builtin.name)
+                continue;
+            if (builtin.arity >= 0 && arguments.size() != static_cast<size_t>(builtin.arity))
+                error(node.name + " expects " + std::to_string(builtin.arity) + " arguments, got " +
+                      std::to_string(arguments.size()));
+            for (size_t i = 0; builtin.intArguments && i < arguments.size(); i++)
+            {
+                if (!isAssignable(arguments[i], Type::Int))
+                    error("argument " + std::to_string(i + 1) + " of " + node.name + " must be int, got " +
+                          typeName(arguments[i]));
+            }
+            Type type = parseType(builtin.returnType, true);
+            return type == Type::String ? Type::Text : type;
+        }
+        return Type::Dynamic;
+    }
+
+    auto it = functions_.find(node.name);
+    if (it == functions_.end())
+    {
+        error("undefined function '" + node.name + "'");
+        return Type::Dynamic;
+    }
+
+    const Signature &signature = it->second;
+    if (arguments.size() != signature.parameters.size())
+    {
+        error(node.name + " expects " + std::to_string(signature.parameters.size()) + " arguments, got " +
+              std::to_string(arguments.size()));
+    }
+    for (size_t i = 0; i < arguments.size() && i < signature.parameters.size(); i++)
+    {
+        if (arguments[i] != Type::Void && !isAssignable(arguments[i], signature.parameters[i]))
+            error("argument " + std::to_string(i + 1) + " of " + node.name + " must be " +
+                  typeName(signature.parameters[i]) + ", got " + typeName(arguments[i]));
+    }
+    return signature.returnType;
+}
+
+TypeChecker::Type TypeChecker::parseType(const std::string &name, bool allowVoid)
+{
+    if (name.empty())
+        return Type::Dynamic;
+    if (name == "int")
+        return Type::Int;
+    if (name == "string")
+        return Type::String;
+    if (name == "bool" || name == "boolean")
+        return Type::Bool;
+    if (name == "void" && allowVoid)
+        return Type::Void;
+    error("unknown type '" + name + "'");
+    return Type::Dynamic;
+}
+
+// Every value is stored as a string, so a string accepts anything
+bool TypeChecker::isAssignable(Type from, Type to)
+{
+    return from == to || from == Type::Dynamic || to == Type::Dynamic || (to == Type::String && from != Type::Void);
+}
+
+const char *TypeChecker::typeName(Type type)
+{
+    switch (type)
+    {
+    case Type::Void:
+        return "void";
+    case Type::Int:
+        return "int";
+    case Type::String:
+    case Type::Text:
+        return "string";
+    case Type::Bool:
+        return "bool";
+    default:
+        return "dynamic";
+    }
+}
+
+void TypeChecker::error(const std::string &message)
+{
+    errorOffsets_.push_back(offset_);
+    if (function_.empty())
+        errors_.push_back(module_.empty() ? message : module_ + ": " + message);
+    else
+        errors_.push_back(module_ + "." + function_ + ": " + message);
+}
@@ -0,0 +1,240 @@
+#include "big_integer.h"
+#include "test_util.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // Reference arithmetic on decimal strings, one digit at a time. A
+    // number is a sign and its digits, least significant first.
+    struct Decimal
+    {
+        bool negative = false;
+        std::vector<int> digits;
+    };
+
+    Decimal fromString(const std::string &text)
+    {
+        Decimal number;
+        size_t start = 0;
+        if (text[0] == '-')
+        {
+            number.negative = true;
+            start = 1;
+        }
+        for (size_t i = text.size(); i > start; i--)
+            number.digits.push_back(text[i - 1] - '0');
+        while (!number.digits.empty() && number.digits.back() == 0)
+            number.digits.pop_back();
+        if (number.digits.empty())
+            number.negative = false;
+        return number;
+    }
+
+    std::string toString(Decimal number)
+    {
+        while (!number.digits.empty() && number.digits.back() == 0)
+            number.digits.pop_back();
+        if (number.digits.empty())
+            return "0";
+        std::string text = number.negative ? "-" : "";
+        for (size_t i = number.digits.size(); i > 0; i--)
+            text += static_cast<char>('0' + number.digits[i - 1]);
+        return text;
+    }
+
+    int compareMagnitude(const std::vector<int> &left, const std::vector<int> &right)
+    {
+        if (left.size() != right.size())
+            return left.size() < right.size() ? -1 : 1;
+        for (size_t i = left.size(); i > 0; i--)
+        {
+            if (left[i - 1] != right[i - 1])
+                return left[i - 1] < right[i - 1] ? -1 : 1;
+        }
+        return 0;
+    }
+
+    std::vector<int> addMagnitude(const std::vector<int> &left, const std::vector<int> &right)
+    {
+        std::vector<int> sum;
+        int carry = 0;
+        for (size_t i = 0; i < std::max(left.size(), right.size()) || carry; i++)
+        {
+            int digit = carry + (i < left.size() ? left[i] : 0) + (i < right.size() ? right[i] : 0);
+            sum.push_back(digit % 10);
+            carry = digit / 10;
+        }
+        return sum;
+    }
+
+    // left >= right
+    std::vector<int> subtractMagnitude(const std::vector<int> &left, const std::vector<int> &right)
+    {
+        std::vector<int> difference;
+        int borrow = 0;
+        for (size_t i = 0; i < left.size(); i++)
+        {
+            int digit = left[i] - borrow - (i < right.size() ? right[i] : 0);
+            borrow = digit < 0;
+            difference.push_back(digit + 10 * borrow);
+        }
+        while (!difference.empty() && difference.back() == 0)
+            difference.pop_back();
+        return difference;
+    }
+
+    Decimal add(const Decimal &left, const Decimal &right)
+    {
+        Decimal sum;
+        if (left.negative == right.negative)
+        {
+            sum.negative = left.negative;
+            sum.digits = addMagnitude(left.digits, right.digits);
+        }
+        else if (compareMagnitude(left.digits, right.digits) >= 0)
+        {
+            sum.negative = left.negative;
+            sum.digits = subtractMagnitude(left.digits, right.digits);
+        }
+        else
+        {
+            sum.negative = right.negative;
+            sum.digits = subtractMagnitude(right.digits, left.digits);
+        }
+        if (sum.digits.empty())
+            sum.negative = false;
+        return sum;
+    }
+
+    Decimal negate(Decimal number)
+    {
+        number.negative = !number.negative && !number.digits.empty();
+        return number;
+    }
+
+    Decimal multiply(const Decimal &left, const Decimal &right)
+    {
+        Decimal product;
+        product.digits.assign(left.digits.size() + right.digits.size(), 0);
+        for (size_t i = 0; i < left.digits.size(); i++)
+        {
+            int carry = 0;
+            for (size_t j = 0; j < right.digits.size() || carry; j++)
+            {
+                int digit = product.digits[i + j] + carry + left.digits[i] * (j < right.digits.size() ? right.digits[j] : 0);
+                product.digits[i + j] = digit % 10;
+                carry = digit / 10;
+            }
+        }
+        while (!product.digits.empty() && product.digits.back() == 0)
+            product.digits.pop_back();
+        product.negative = !product.digits.empty() && left.negative != right.negative;
+        return product;
+    }
+
+    int compare(const Decimal &left, const Decimal &right)
+    {
+        if (left.negative != right.negative)
+            return left.negative ? -1 : 1;
+        int order = compareMagnitude(left.digits, right.digits);
+        return left.negative ? -order : order;
+    }
+
+    std::mt19937 random(1);
+
+    // Up to about 700 digits, past Karatsuba's 32 limbs (~300 digits), with
+    // int64-sized operands and powers of ten near the limb boundaries
+    std::string randomInteger()
+    {
+        std::string text;
+        switch (std::uniform_int_distribution<int>(0, 5)(random))
+        {
+        case 0:
+            text = std::to_string(std::uniform_int_distribution<int64_t>(INT64_MIN, INT64_MAX)(random));
+            break;
+        case 1:
+            text = "1" + std::string(std::uniform_int_distribution<size_t>(0, 40)(random), '0');
+            break;
+        case 2:
+            text = std::string(std::uniform_int_distribution<size_t>(1, 40)(random), '9');
+            break;
+        default:
+        {
+            size_t length = std::uniform_int_distribution<size_t>(1, 700)(random);
+            for (size_t i = 0; i < length; i++)
+                text += static_cast<char>('0' + std::uniform_int_distribution<int>(i == 0 ? 1 : 0, 9)(random));
+            break;
+        }
+        }
+        if (text[0] != '-' && std::uniform_int_distribution<int>(0, 1)(random))
+            text = "-" + text;
+        return text == "-0" ? "0" : text;
+    }
+
+    void checkPair(const std::string &left, const std::string &right)
+    {
+        const std::string operands = " of " + left + " and " + right;
+        Decimal a = fromString(left), b = fromString(right);
+        BigInteger x, y;
+        if (!test::check(BigInteger::parse(left, x) && BigInteger::parse(right, y), "parse" + operands))
+            return;
+        test::check(x.toString() == left, "round trip of " + left + " gave " + x.toString());
+
+        const std::string sum = toString(add(a, b));
+        const std::string difference = toString(add(a, negate(b)));
+        const std::string product = toString(multiply(a, b));
+        test::check((x + y).toString() == sum, "sum" + operands);
+        test::check((x - y).toString() == difference, "difference" + operands);
+        test::check((x * y).toString() == product, "product" + operands);
+        test::check((-x).toString() == toString(negate(a)), "negation of " + left);
+        test::check(BigInteger::compare(x, y) == compare(a, b), "comparison" + operands);
+
+        // The std.math entry point, which stays on int64 where it can
+        std::string result;
+        test::check(computeInteger(IntegerOperation::Add, left, right, result) && result == sum,
+                    "computeInteger sum" + operands);
+        test::check(computeInteger(IntegerOperation::Subtract, left, right, result) && result == difference,
+                    "computeInteger difference" + operands);
+        test::check(computeInteger(IntegerOperation::Multiply, left, right, result) && result == product,
+                    "computeInteger product" + operands);
+        int order = 2;
+        test::check(compareIntegers(left, right, order) && order == compare(a, b), "compareIntegers" + operands);
+    }
+}
+
+// Checks BigInteger and computeInteger against a digit-by-digit reference
+int main()
+{
+    const std::vector<std::string> edges = {"0",
+                                            "1",
+                                            "-1",
+                                            "2147483647",
+                                            "-2147483648",
+                                            "9223372036854775807",
+                                            "-9223372036854775808",
+                                            "9223372036854775808",
+                                            "4294967295",
+                                            "4294967296",
+                                            "18446744073709551616"};
+    for (const auto &left : edges)
+    {
+        for (const auto &right : edges)
+            checkPair(left, right);
+    }
+    for (int i = 0; i < 3000; i++)
+    {
+        std::string left = randomInteger();
+        // Equal magnitudes exercise cancellation and the comparison ties
+        std::string right = i % 10 == 0 ? left : randomInteger();
+        checkPair(left, right);
+    }
+
+    std::string result;
+    test::check(!computeInteger(IntegerOperation::Add, "x", "1", result), "computeInteger accepted x");
+    test::check(!computeInteger(IntegerOperation::Multiply, "1", "", result), "computeInteger accepted an empty operand");
+    return test::failures();
+}
@@ -0,0 +1,122 @@
+#include "channel.h"
+#include "test_util.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // A capacity-1 channel still holds exactly one message, although its
+    // ring has two cells
+    void checkCapacityOne()
+    {
+        Channel channel(1);
+        Value a("a"), b("b"), received;
+        test::check(channel.trySend(a) == Channel::Status::Done, "first send to Channel(1)");
+        test::check(channel.trySend(b) == Channel::Status::WouldBlock, "second send to a full Channel(1)");
+        test::check(channel.tryReceive(received) == Channel::Status::Done && received.str() == "a",
+                    "receive from Channel(1)");
+        test::check(channel.tryReceive(received) == Channel::Status::WouldBlock, "receive from an empty Channel(1)");
+
+        test::check(channel.trySend(b) == Channel::Status::Done, "send to Channel(1) after it drained");
+        channel.close();
+        Value c("c");
+        test::check(channel.trySend(c) == Channel::Status::Closed, "trySend after close");
+        test::check(!channel.send(Value("d")), "send after close");
+        test::check(channel.tryReceive(received) == Channel::Status::Done && received.str() == "b",
+                    "receive of a message sent before close");
+        test::check(channel.tryReceive(received) == Channel::Status::Closed, "receive from a closed, drained channel");
+        test::check(!channel.receive(received), "blocking receive from a closed, drained channel");
+    }
+
+    // Producers and consumers race with close(). Every send that succeeds
+    // must be received exactly once, each producer's messages in order, and
+    // sends after close() must fail.
+    void checkCloseRace(size_t capacity, int round)
+    {
+        const int kProducers = 3, kConsumers = 3, kMessages = 2000;
+        const std::string where = "Channel(" + std::to_string(capacity) + ") round " + std::to_string(round);
+        Channel channel(capacity);
+        std::vector<int> sent(kProducers, 0);
+        std::vector<std::vector<int>> received(kProducers);
+        std::vector<std::vector<std::vector<int>>> receivedBy(kConsumers, received);
+        std::atomic<bool> closed{false};
+        std::atomic<int> lateSends{0};
+        // close() lands after a different number of messages each round
+        std::atomic<int> receivedCount{0};
+        const int closeAfter = round * 997 % (kProducers * kMessages);
+
+        std::vector<std::thread> threads;
+        for (int p = 0; p < kProducers; p++)
+        {
+            threads.emplace_back([&, p] {
+                for (int i = 0; i < kMessages; i++)
+                {
+                    if (!channel.send(Value(std::to_string(p) + ":" + std::to_string(i))))
+                        break;
+                    sent[p]++;
+                }
+                if (closed.load() && channel.send(Value("late")))
+                    lateSends++;
+            });
+        }
+        for (int c = 0; c < kConsumers; c++)
+        {
+            threads.emplace_back([&, c] {
+                Value value;
+                while (channel.receive(value))
+                {
+                    const std::string &text = value.str();
+                    size_t colon = text.find(':');
+                    if (colon == std::string::npos)
+                        continue;
+                    receivedBy[c][std::stoi(text.substr(0, colon))].push_back(std::stoi(text.substr(colon + 1)));
+                    receivedCount++;
+                }
+            });
+        }
+        threads.emplace_back([&] {
+            while (receivedCount < closeAfter)
+                std::this_thread::yield();
+            channel.close();
+            closed = true;
+        });
+        for (auto &thread : threads)
+            thread.join();
+
+        test::check(lateSends == 0, where + ": a send after close succeeded");
+        for (int p = 0; p < kProducers; p++)
+        {
+            size_t total = 0;
+            for (int c = 0; c < kConsumers; c++)
+            {
+                const auto &values = receivedBy[c][p];
+                total += values.size();
+                for (size_t i = 1; i < values.size(); i++)
+                {
+                    if (!test::check(values[i - 1] < values[i], where + ": producer " + std::to_string(p) +
+                                                                    "'s messages arrived out of order"))
+                        break;
+                }
+            }
+            test::check(total == static_cast<size_t>(sent[p]), where + ": producer " + std::to_string(p) + " sent " +
+                                                                   std::to_string(sent[p]) + ", consumers got " +
+                                                                   std::to_string(total));
+        }
+    }
+}
+
+// Channel(1) semantics, then many producers and consumers racing close()
+// on capacity-1 and other channels
+int main()
+{
+    checkCapacityOne();
+    for (size_t capacity : {1, 0, 2, 7})
+    {
+        for (int round = 0; round < (capacity == 1 ? 200 : 50); round++)
+            checkCloseRace(capacity, round);
+    }
+    return test::failures();
+}
@@ -0,0 +1,91 @@
+#include "incremental_parser.h"
+#include "test_util.h"
+
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const char *kDocument = R"(module Main {
+    import std.io;
+
+    func add(a: int, b: int) -> int {
+        return a + b;
+    }
+
+    func main() -> int {
+        let x: int = Main.add(1, 2);
+        io.println(x);
+        return 0;
+    }
+}
+
+module Util {
+    func twice(s: string) -> string {
+        return s + s;
+    }
+}
+)";
+
+    // Fragments that open, close and break declarations as well as harmless ones
+    const std::vector<std::string> kFragments = {"{", "}", "(", ")", ";", "func f() -> int { return 1; }", "let", "x",
+                                                 " ", "\n", "\"", "/*", "*/", "module M {", "return 2;", "@", ""};
+
+    // Offset and message of every diagnostic, plus the declarations with
+    // their source ranges
+    std::string describe(const IncrementalDocument &document)
+    {
+        std::ostringstream out;
+        for (const auto &diagnostic : document.getDiagnostics())
+            out << diagnostic.line << ":" << diagnostic.column << "@" << diagnostic.offset << " " << diagnostic.message
+                << "\n";
+        for (const auto &node : document.getProgram()->body)
+        {
+            auto module = dynamic_cast<const ModuleNode *>(node.get());
+            if (!module)
+                continue;
+            out << "module " << module->name << " " << module->startOffset << "-" << module->endOffset << "\n";
+            for (const auto &member : module->body)
+            {
+                if (auto fn = dynamic_cast<const FunctionNode *>(member.get()))
+                    out << "  func " << fn->name << " " << fn->startOffset << "-" << fn->endOffset << "\n";
+            }
+        }
+        return out.str();
+    }
+}
+
+// Applies random edits to a document and checks after each one that the
+// incrementally maintained diagnostics and declarations match a fresh parse
+// of the same text
+int main()
+{
+    const int kRuns = 200;
+    const int kEditsPerRun = 30;
+    for (int run = 0; run < kRuns; run++)
+    {
+        std::mt19937 random(run);
+        IncrementalDocument document(kDocument);
+        for (int i = 0; i < kEditsPerRun; i++)
+        {
+            const std::string &text = document.getText();
+            TextEdit edit;
+            edit.offset = std::uniform_int_distribution<size_t>(0, text.size())(random);
+            size_t maximum = std::min<size_t>(8, text.size() - edit.offset);
+            edit.length = std::uniform_int_distribution<size_t>(0, maximum)(random);
+            edit.text = kFragments[std::uniform_int_distribution<size_t>(0, kFragments.size() - 1)(random)];
+            document.applyEdit(edit);
+
+            IncrementalDocument fresh(document.getText());
+            std::string incremental = describe(document);
+            std::string expected = describe(fresh);
+            if (!test::check(incremental == expected, "run " + std::to_string(run) + " edit " + std::to_string(i) +
+                                                          " differs from a fresh parse of\n" + document.getText() +
+                                                          "\nincremental:\n" + incremental + "fresh:\n" + expected))
+                break;
+        }
+    }
+    return test::failures();
+}
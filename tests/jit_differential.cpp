@@ -0,0 +1,32 @@
+#include "test_util.h"
+
+#include <string>
+
+// Runs each program with the JIT compiling every function before its first
+// call (--jit-threshold=0), after one call and after 100, and expects the
+// output and exit status of the interpreter alone. The last is the default.
+//
+//     nexis_test_jit <nexis_compiler> <program.nx>...
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "usage: " << argv[0] << " <nexis_compiler> <program.nx>...\n";
+        return 2;
+    }
+    const std::string compiler = test::quote(argv[1]);
+    for (int i = 2; i < argc; i++)
+    {
+        const std::string program = test::quote(argv[i]);
+        // A threshold larger than any call count never compiles anything
+        test::CommandResult interpreted = test::run(compiler + " --jit-threshold=4294967295 " + program);
+        for (const char *threshold : {"0", "1", "100"})
+        {
+            test::CommandResult jit = test::run(compiler + " --jit-threshold=" + threshold + " " + program);
+            test::check(jit.output == interpreted.output && jit.status == interpreted.status,
+                        std::string(argv[i]) + " with --jit-threshold=" + threshold + " printed\n" + jit.output +
+                            "the interpreter printed\n" + interpreted.output);
+        }
+    }
+    return test::failures();
+}
@@ -0,0 +1,235 @@
+#include "simd_kernels.h"
+#include "test_util.h"
+
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    std::mt19937_64 random(1);
+
+    size_t pick(size_t low, size_t high) { return std::uniform_int_distribution<size_t>(low, high)(random); }
+
+    // Mostly small values so comparisons hit all outcomes, with the
+    // extremes mixed in for the wrap-around paths
+    int64_t randomInt()
+    {
+        switch (pick(0, 9))
+        {
+        case 0:
+            return std::numeric_limits<int64_t>::min();
+        case 1:
+            return std::numeric_limits<int64_t>::max();
+        case 2:
+            return static_cast<int64_t>(random());
+        default:
+            return static_cast<int64_t>(pick(0, 40)) - 20;
+        }
+    }
+
+    double randomDouble() { return std::uniform_real_distribution<double>(-1000, 1000)(random); }
+
+    // Runs the kernel with the AVX2 and the scalar implementation
+    template <typename Result> void compare(const std::string &what, const std::function<Result()> &kernel)
+    {
+        simd::setEnabled(true);
+        Result vector = kernel();
+        simd::setEnabled(false);
+        Result scalar = kernel();
+        simd::setEnabled(true);
+        test::check(vector == scalar, what + " differs between AVX2 and scalar");
+    }
+
+    bool sameBits(double left, double right) { return std::memcmp(&left, &right, sizeof(double)) == 0; }
+
+    bool sameBits(const std::vector<double> &left, const std::vector<double> &right)
+    {
+        return left.size() == right.size() &&
+               (left.empty() || std::memcmp(left.data(), right.data(), left.size() * sizeof(double)) == 0);
+    }
+
+    // Sums and dot products add in a different order, so allow for rounding
+    void compareApproximately(const std::string &what, const std::function<double()> &kernel, double magnitude)
+    {
+        simd::setEnabled(true);
+        double vector = kernel();
+        simd::setEnabled(false);
+        double scalar = kernel();
+        simd::setEnabled(true);
+        test::check(std::fabs(vector - scalar) <= 1e-9 * magnitude,
+                    what + " differs between AVX2 (" + std::to_string(vector) + ") and scalar (" +
+                        std::to_string(scalar) + ")");
+    }
+
+    // `count` values starting `offset` elements into the buffer, so the
+    // kernels see every alignment
+    template <typename T> struct Buffer
+    {
+        std::vector<T> storage;
+        T *data;
+
+        Buffer(size_t offset, size_t count) : storage(offset + count + 4), data(storage.data() + offset) {}
+    };
+
+    void checkIntegers(size_t count, size_t offset)
+    {
+        const std::string size = " of " + std::to_string(count) + " at +" + std::to_string(offset);
+        Buffer<int64_t> left(offset, count), right(offset, count);
+        for (size_t i = 0; i < count; i++)
+        {
+            left.data[i] = randomInt();
+            right.data[i] = randomInt();
+        }
+
+        compare<int64_t>("int sum" + size, [&] { return simd::sum(left.data, count); });
+        compare<int64_t>("int dot" + size, [&] { return simd::dot(left.data, right.data, count); });
+        if (count > 0)
+        {
+            compare<int64_t>("int min" + size, [&] { return simd::min(left.data, count); });
+            compare<int64_t>("int max" + size, [&] { return simd::max(left.data, count); });
+        }
+
+        int64_t operand = randomInt();
+        for (auto operation : {simd::Arithmetic::Add, simd::Arithmetic::Subtract, simd::Arithmetic::Multiply,
+                               simd::Arithmetic::Divide})
+        {
+            if (operation == simd::Arithmetic::Divide && operand == 0)
+                operand = 3;
+            compare<std::vector<int64_t>>("int map " + std::to_string(static_cast<int>(operation)) + size, [&] {
+                std::vector<int64_t> out(count);
+                simd::map(operation, left.data, operand, out.data(), count);
+                return out;
+            });
+        }
+        for (int comparison = 0; comparison <= static_cast<int>(simd::Comparison::NotEqual); comparison++)
+        {
+            compare<std::vector<int64_t>>("int filter " + std::to_string(comparison) + size, [&] {
+                std::vector<int64_t> out(count + 4);
+                out.resize(
+                    simd::filter(static_cast<simd::Comparison>(comparison), left.data, operand, out.data(), count));
+                return out;
+            });
+        }
+        compare<std::vector<int64_t>>("int sort" + size, [&] {
+            std::vector<int64_t> values(left.data, left.data + count);
+            simd::sort(values.data(), count);
+            return values;
+        });
+    }
+
+    void checkDoubles(size_t count, size_t offset)
+    {
+        const std::string size = " of " + std::to_string(count) + " at +" + std::to_string(offset);
+        Buffer<double> left(offset, count), right(offset, count);
+        double magnitude = 1;
+        for (size_t i = 0; i < count; i++)
+        {
+            left.data[i] = randomDouble();
+            right.data[i] = randomDouble();
+            magnitude += std::fabs(left.data[i]) * 1000;
+        }
+
+        compareApproximately("double sum" + size, [&] { return simd::sum(left.data, count); }, magnitude);
+        compareApproximately("double dot" + size, [&] { return simd::dot(left.data, right.data, count); }, magnitude);
+        if (count > 0)
+        {
+            simd::setEnabled(false);
+            double scalarMin = simd::min(left.data, count), scalarMax = simd::max(left.data, count);
+            simd::setEnabled(true);
+            test::check(sameBits(simd::min(left.data, count), scalarMin), "double min" + size + " differs");
+            test::check(sameBits(simd::max(left.data, count), scalarMax), "double max" + size + " differs");
+        }
+
+        double operand = randomDouble();
+        for (auto operation : {simd::Arithmetic::Add, simd::Arithmetic::Subtract, simd::Arithmetic::Multiply,
+                               simd::Arithmetic::Divide})
+        {
+            std::vector<double> vector(count), scalar(count);
+            simd::map(operation, left.data, operand, vector.data(), count);
+            simd::setEnabled(false);
+            simd::map(operation, left.data, operand, scalar.data(), count);
+            simd::setEnabled(true);
+            test::check(sameBits(vector, scalar), "double map " + std::to_string(static_cast<int>(operation)) + size +
+                                                      " differs between AVX2 and scalar");
+        }
+        for (int comparison = 0; comparison <= static_cast<int>(simd::Comparison::NotEqual); comparison++)
+        {
+            std::vector<double> vector(count + 4), scalar(count + 4);
+            auto compared = static_cast<simd::Comparison>(comparison);
+            vector.resize(simd::filter(compared, left.data, operand, vector.data(), count));
+            simd::setEnabled(false);
+            scalar.resize(simd::filter(compared, left.data, operand, scalar.data(), count));
+            simd::setEnabled(true);
+            test::check(sameBits(vector, scalar),
+                        "double filter " + std::to_string(comparison) + size + " differs between AVX2 and scalar");
+        }
+        std::vector<double> vector(left.data, left.data + count), scalar = vector;
+        simd::sort(vector.data(), count);
+        simd::setEnabled(false);
+        simd::sort(scalar.data(), count);
+        simd::setEnabled(true);
+        test::check(sameBits(vector, scalar), "double sort" + size + " differs between AVX2 and scalar");
+    }
+
+    // Text over a small alphabet so the needles match often, including
+    // matches that straddle 32-byte blocks
+    void checkBytes(size_t size, size_t offset)
+    {
+        const std::string where = " in " + std::to_string(size) + " bytes at +" + std::to_string(offset);
+        std::string storage(offset + size, 'x');
+        for (size_t i = offset; i < storage.size(); i++)
+            storage[i] = "abc\n"[pick(0, 3)];
+        const char *data = storage.data() + offset;
+        char byte = "abcz"[pick(0, 3)];
+
+        compare<size_t>("findByte" + where, [&] { return simd::findByte(data, size, byte); });
+        compare<size_t>("countByte" + where, [&] { return simd::countByte(data, size, byte); });
+        size_t capacity = pick(0, size + 1);
+        compare<std::vector<size_t>>("findBytes" + where, [&] {
+            std::vector<size_t> positions(capacity);
+            size_t found = simd::findBytes(data, size, byte, positions.data(), capacity);
+            positions.resize(std::min(found, capacity));
+            positions.push_back(found);
+            return positions;
+        });
+
+        std::string needle;
+        if (size > 0 && pick(0, 1))
+        {
+            // A substring of the text, so there is at least one match
+            size_t start = pick(0, size - 1);
+            needle.assign(data + start, pick(1, std::min<size_t>(size - start, 40)));
+        }
+        else
+        {
+            for (size_t i = pick(0, 6); i > 0; i--)
+                needle += "abcz"[pick(0, 3)];
+        }
+        compare<size_t>("find '" + needle + "'" + where,
+                        [&] { return simd::find(data, size, needle.data(), needle.size()); });
+    }
+}
+
+// Runs every kernel with AVX2 and with the scalar loops on random inputs
+// of random sizes and alignments and expects the same results
+int main()
+{
+    if (!simd::isAvailable())
+    {
+        std::cerr << "no AVX2, skipping\n";
+        return test::kSkipped;
+    }
+    for (int run = 0; run < 2000; run++)
+    {
+        size_t count = run < 40 ? run : pick(0, run < 1000 ? 64 : 5000);
+        checkIntegers(count, pick(0, 3));
+        checkDoubles(count, pick(0, 3));
+        checkBytes(count, pick(0, 31));
+    }
+    return test::failures();
+}
@@ -0,0 +1,41 @@
+#include "test_util.h"
+
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+// Runs each program with the interpreter and as a --native executable and
+// expects the same output and exit status.
+//
+//     nexis_test_native <nexis_compiler> <program.nx>...
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "usage: " << argv[0] << " <nexis_compiler> <program.nx>...\n";
+        return 2;
+    }
+    const char *cc = std::getenv("CC");
+    if (test::run(std::string(cc && *cc ? cc : "cc") + " --version").status != 0)
+    {
+        std::cerr << "no C compiler, skipping\n";
+        return test::kSkipped;
+    }
+
+    const std::string compiler = test::quote(argv[1]);
+    const std::string executable = "./nexis_test_native_" + std::to_string(getpid());
+    for (int i = 2; i < argc; i++)
+    {
+        const std::string program = test::quote(argv[i]);
+        test::CommandResult build = test::run(compiler + " --native=" + executable + " " + program);
+        if (!test::check(build.status == 0, std::string(argv[i]) + " does not build:\n" + build.output))
+            continue;
+        test::CommandResult native = test::run(executable);
+        test::CommandResult interpreted = test::run(compiler + " " + program);
+        test::check(native.output == interpreted.output && native.status == interpreted.status,
+                    std::string(argv[i]) + ": native printed\n" + native.output + "the interpreter printed\n" +
+                        interpreted.output);
+        std::remove(executable.c_str());
+    }
+    return test::failures();
+}
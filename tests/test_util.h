@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <sys/wait.h>
+
+namespace test
+{
+    // Counts failed checks; main() returns failures() so ctest sees them
+    inline int &failures()
+    {
+        static int count = 0;
+        return count;
+    }
+
+    inline bool check(bool condition, const std::string &what)
+    {
+        if (!condition)
+        {
+            std::cerr << "FAIL: " << what << "\n";
+            failures()++;
+        }
+        return condition;
+    }
+
+    // Returned by a test that cannot run here, e.g. without a C compiler;
+    // ctest reports it as skipped (SKIP_RETURN_CODE)
+    constexpr int kSkipped = 77;
+
+    // Output (stdout and stderr) and exit status of a shell command
+    struct CommandResult
+    {
+        std::string output;
+        int status = -1;
+    };
+
+    inline CommandResult run(const std::string &command)
+    {
+        CommandResult result;
+        FILE *pipe = popen((command + " 2>&1").c_str(), "r");
+        if (!pipe)
+            return result;
+        char buffer[4096];
+        size_t length;
+        while ((length = fread(buffer, 1, sizeof(buffer), pipe)) > 0)
+            result.output.append(buffer, length);
+        int status = pclose(pipe);
+        result.status = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+        return result;
+    }
+
+    // Single-quoted for the shell
+    inline std::string quote(const std::string &text)
+    {
+        std::string quoted = "'";
+        for (char c : text)
+            quoted += c == '\'' ? std::string("'\\''") : std::string(1, c);
+        return quoted + "'";
+    }
+}